@@ -0,0 +1,188 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "andpostingiterator.h"
+#include "orpostingiterator.h"
+#include "vectorpostingiterator.h"
+#include "postingcodec.h"
+
+#include <QTest>
+
+using namespace Baloo;
+
+namespace {
+/*
+ * Hides the skipTo of the wrapped iterator, so the linear default
+ * implementation is used
+ */
+class LinearPostingIterator : public PostingIterator
+{
+public:
+    explicit LinearPostingIterator(const QVector<quint64>& values)
+        : m_it(values)
+    {
+    }
+
+    quint64 next() override {
+        return m_it.next();
+    }
+    quint64 docId() const override {
+        return m_it.docId();
+    }
+
+private:
+    VectorPostingIterator m_it;
+};
+}
+
+class PostingIteratorBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void benchSkewedAnd_data();
+    void benchSkewedAnd();
+    void benchUnion_data();
+    void benchUnion();
+};
+
+void PostingIteratorBenchmark::benchSkewedAnd_data()
+{
+    QTest::addColumn<int>("rareSize");
+    QTest::addColumn<int>("commonSize");
+    QTest::addColumn<bool>("linear");
+
+    for (bool linear : {true, false}) {
+        const char* name = linear ? "linear" : "gallop";
+        QTest::addRow("%s 1:10", name) << 10000 << 100000 << linear;
+        QTest::addRow("%s 1:1000", name) << 100 << 100000 << linear;
+        QTest::addRow("%s 1:100000", name) << 10 << 1000000 << linear;
+    }
+}
+
+void PostingIteratorBenchmark::benchSkewedAnd()
+{
+    QFETCH(int, rareSize);
+    QFETCH(int, commonSize);
+    QFETCH(bool, linear);
+
+    QVector<quint64> common;
+    common.reserve(commonSize);
+    for (int i = 1; i <= commonSize; i++) {
+        common << i;
+    }
+
+    // Spread evenly over the common list
+    QVector<quint64> rare;
+    rare.reserve(rareSize);
+    const int stride = commonSize / rareSize;
+    for (int i = 1; i <= rareSize; i++) {
+        rare << static_cast<quint64>(i) * stride;
+    }
+
+    int matches = 0;
+    QBENCHMARK {
+        PostingIterator* commonIt = linear ? static_cast<PostingIterator*>(new LinearPostingIterator(common))
+                                           : new VectorPostingIterator(common);
+        AndPostingIterator it({new VectorPostingIterator(rare), commonIt});
+
+        matches = 0;
+        while (it.next()) {
+            matches++;
+        }
+    }
+    QCOMPARE(matches, rareSize);
+}
+
+/*
+ * Compares the two ways PostingDB unites the lists of an expansion: a
+ * lazy merge of one iterator per term, and copying all the lists into
+ * one buffer which is then sorted. The rows where "eager" becomes faster
+ * place the thresholds in PostingDB.
+ */
+void PostingIteratorBenchmark::benchUnion_data()
+{
+    QTest::addColumn<int>("terms");
+    QTest::addColumn<int>("listSize");
+    QTest::addColumn<bool>("eager");
+
+    for (int listSize : {16, 256, 4096}) {
+        for (int terms : {4, 16, 64, 256, 1024}) {
+            for (bool eager : {false, true}) {
+                QTest::addRow("%d terms of %d %s", terms, listSize, eager ? "eager" : "streaming")
+                        << terms << listSize << eager;
+            }
+        }
+    }
+}
+
+void PostingIteratorBenchmark::benchUnion()
+{
+    QFETCH(int, terms);
+    QFETCH(int, listSize);
+    QFETCH(bool, eager);
+
+    // The lists are kept encoded, as they are stored in the PostingDB.
+    // Every term gets every terms-th id, so the lists interleave.
+    PostingCodec codec;
+    QVector<QByteArray> lists;
+    lists.reserve(terms);
+    for (int t = 0; t < terms; t++) {
+        QVector<quint64> list;
+        list.reserve(listSize);
+        for (int i = 0; i < listSize; i++) {
+            list << static_cast<quint64>(i) * terms + t + 1;
+        }
+        lists << codec.encode(list);
+    }
+
+    int count = 0;
+    QBENCHMARK {
+        PostingIterator* it;
+        if (eager) {
+            QVector<quint64> ids;
+            ids.reserve(terms * listSize);
+            for (const QByteArray& arr : qAsConst(lists)) {
+                const int size = ids.size();
+                ids.resize(size + arr.size() / sizeof(quint64));
+                memcpy(ids.data() + size, arr.constData(), arr.size());
+            }
+            it = new VectorPostingIterator(OrPostingIterator::sortUnique(std::move(ids)));
+        } else {
+            QVector<PostingIterator*> iterators;
+            iterators.reserve(terms);
+            for (const QByteArray& arr : qAsConst(lists)) {
+                iterators << new VectorPostingIterator(codec.decode(arr));
+            }
+            it = new OrPostingIterator(iterators);
+        }
+
+        count = 0;
+        while (it->next()) {
+            count++;
+        }
+        delete it;
+    }
+    QCOMPARE(count, terms * listSize);
+}
+
+QTEST_MAIN(PostingIteratorBenchmark)
+
+#include "postingiteratorbenchmark.moc"
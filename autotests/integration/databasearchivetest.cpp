@@ -0,0 +1,155 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "databasearchive.h"
+#include "dbstate.h"
+#include "database.h"
+#include "idutils.h"
+
+#include <QBuffer>
+#include <QTest>
+#include <QTemporaryDir>
+
+using namespace Baloo;
+
+class DatabaseArchiveTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init() {
+        dir = new QTemporaryDir();
+        QDir().mkpath(dir->path() + "/src");
+        QDir().mkpath(dir->path() + "/dst");
+        db = new Database(dir->path() + "/src");
+        db->open(Database::CreateDatabase);
+    }
+
+    void cleanup() {
+        delete db;
+        delete dir;
+    }
+
+    void testRoundTrip();
+    void testCorruptArchive();
+    void testNonEmptyDatabase();
+
+private:
+    QByteArray populateAndExport();
+
+    QTemporaryDir* dir;
+    Database* db;
+};
+
+static void touchFile(const QString& path) {
+    QFile file(path);
+    file.open(QIODevice::WriteOnly);
+    file.write("data");
+    file.close();
+}
+
+QByteArray DatabaseArchiveTest::populateAndExport()
+{
+    const QString url1(dir->path() + "/file1");
+    const QString url2(dir->path() + "/file2");
+    touchFile(url1);
+    touchFile(url2);
+
+    Transaction tr(db, Transaction::ReadWrite);
+    int pos = 1;
+    for (const QString& url : {url1, url2}) {
+        Document doc;
+        const QByteArray path = QFile::encodeName(url);
+        doc.setId(filePathToId(path));
+        doc.setUrl(path);
+        doc.addTerm("a");
+        doc.addPositionTerm("power", pos++);
+        doc.addFileNameTerm(path.mid(path.lastIndexOf('/') + 1));
+        doc.addXattrTerm("system");
+        doc.setMTime(pos);
+        doc.setCTime(pos);
+        doc.setData("data");
+        tr.addDocument(doc);
+    }
+    tr.commit();
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    DatabaseArchive archive(db);
+    if (!archive.exportTo(&buffer)) {
+        qWarning() << archive.errorString();
+    }
+    return buffer.data();
+}
+
+void DatabaseArchiveTest::testRoundTrip()
+{
+    QByteArray data = populateAndExport();
+    QVERIFY(!data.isEmpty());
+
+    Database db2(dir->path() + "/dst");
+    QVERIFY(db2.open(Database::CreateDatabase));
+
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+    DatabaseArchive archive(&db2);
+    QVERIFY2(archive.importFrom(&buffer), qPrintable(archive.errorString()));
+    QVERIFY(archive.deviceIdMap().isEmpty());
+
+    Transaction tr1(db, Transaction::ReadOnly);
+    Transaction tr2(&db2, Transaction::ReadOnly);
+    QVERIFY(DBState::debugCompare(DBState::fromTransaction(&tr2), DBState::fromTransaction(&tr1)));
+
+    const QByteArray url1 = QFile::encodeName(dir->path() + "/file1");
+    QCOMPARE(tr2.documentUrl(filePathToId(url1)), url1);
+}
+
+void DatabaseArchiveTest::testCorruptArchive()
+{
+    QByteArray data = populateAndExport();
+    QVERIFY(!data.isEmpty());
+
+    // Flip a byte in the checksum
+    data[data.size() - 1] = data[data.size() - 1] ^ 0xff;
+
+    Database db2(dir->path() + "/dst");
+    QVERIFY(db2.open(Database::CreateDatabase));
+
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+    DatabaseArchive archive(&db2);
+    QVERIFY(!archive.importFrom(&buffer));
+
+    Transaction tr(&db2, Transaction::ReadOnly);
+    QCOMPARE(tr.size(), 0u);
+}
+
+void DatabaseArchiveTest::testNonEmptyDatabase()
+{
+    QByteArray data = populateAndExport();
+
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+    DatabaseArchive archive(db);
+    QVERIFY(!archive.importFrom(&buffer));
+}
+
+QTEST_MAIN(DatabaseArchiveTest)
+
+#include "databasearchivetest.moc"
@@ -23,6 +23,7 @@
 
 #include "transaction.h"
 #include "postingdb.h"
+#include "prefixdb.h"
 #include "documentdb.h"
 #include "documenturldb.h"
 #include "documentiddb.h"
@@ -36,6 +37,8 @@ class DBState {
 public:
     QMap<QByteArray, PostingList> postingDb;
     QMap<QByteArray, QVector<PositionInfo>> positionDb;
+    // Derived from the postingDb, so it is not compared
+    QMap<QByteArray, PostingList> prefixDb;
 
     QMap<quint64, QVector<QByteArray>> docTermsDb;
     QMap<quint64, QVector<QByteArray>> docFileNameTermsDb;
@@ -67,8 +70,8 @@ DBState DBState::fromTransaction(Baloo::Transaction* tr)
     auto dbis = tr->m_dbis;
     MDB_txn* txn = tr->m_txn;
 
-    PostingDB postingDB(dbis.postingDbi, txn);
-    PositionDB positionDB(dbis.positionDBi, txn);
+    PostingDB postingDB(dbis.postingDbi, dbis.postingDeltaDbi, txn);
+    PositionDB positionDB(dbis.positionDBi, dbis.postingDeltaDbi, txn);
     DocumentDB documentTermsDB(dbis.docTermsDbi, txn);
     DocumentDB documentXattrTermsDB(dbis.docXattrTermsDbi, txn);
     DocumentDB documentFileNameTermsDB(dbis.docFilenameTermsDbi, txn);
@@ -82,6 +85,9 @@ DBState DBState::fromTransaction(Baloo::Transaction* tr)
     DBState state;
     state.postingDb = postingDB.toTestMap();
     state.positionDb = positionDB.toTestMap();
+    if (dbis.prefixDbi) {
+        state.prefixDb = PrefixDB(dbis.prefixDbi, dbis.prefixDeltaDbi, txn).toTestMap();
+    }
     state.docTermsDb = documentTermsDB.toTestMap();
     state.docXAttrTermsDb = documentXattrTermsDB.toTestMap();
     state.docFileNameTermsDb = documentFileNameTermsDB.toTestMap();
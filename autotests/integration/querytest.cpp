@@ -24,12 +24,31 @@
 #include "termgenerator.h"
 #include "enginequery.h"
 #include "idutils.h"
-
+#include "global.h"
+#include "overlayindex.h"
+#include "postingiterator.h"
+#include "query.h"
+#include "querycache.h"
+#include "resultiterator.h"
+#include "searchstore.h"
+#include "term.h"
+
+#include <QDir>
 #include <QTest>
 #include <QTemporaryDir>
 
 using namespace Baloo;
 
+static quint64 touchFile(const QString& path)
+{
+    QFile file(path);
+    file.open(QIODevice::WriteOnly);
+    file.write("data");
+    file.close();
+
+    return filePathToId(QFile::encodeName(path));
+}
+
 class QueryTest : public QObject
 {
     Q_OBJECT
@@ -37,14 +56,10 @@ private Q_SLOTS:
     void initTestCase() {
         dir.reset(new QTemporaryDir());
 
-        auto touchFile = [](const QString& path) {
-            QFile file(path);
-            file.open(QIODevice::WriteOnly);
-            file.write("data");
-            file.close();
-
-            return filePathToId(QFile::encodeName(path));
-        };
+        // Read by the SearchStore, before anything opens the global database
+        storeDir.reset(new QTemporaryDir());
+        qputenv("BALOO_DB_PATH", QFile::encodeName(storeDir->path()));
+        QVERIFY(QDir(dir->path()).mkdir(QStringLiteral("store")));
 
         m_id1 = touchFile(dir->path() + "/file1");
         m_id2 = touchFile(dir->path() + "/file2");
@@ -70,6 +85,7 @@ private Q_SLOTS:
 
     void testTermEqual();
     void testTermStartsWith();
+    void testTermFuzzy();
     void testTermAnd();
     void testTermOr();
     void testTermPhrase();
@@ -79,6 +95,13 @@ private Q_SLOTS:
     void testTagTermPhrase_data();
     void testTagTermPhrase();
 
+    void testStoreNewestMatches();
+    void testStoreCacheWithOverlay();
+    void testStoreOffsetAndLimit();
+    void testStoreSortedOnDemand();
+    void testResultIteratorCopy();
+    void testStoreNegation();
+
 private:
     QScopedPointer<QTemporaryDir> dir;
     QTemporaryDir* dbDir;
@@ -129,8 +152,65 @@ private:
     quint64 m_id4;
     quint64 m_id5;
     quint64 m_id6;
+
+    // The SearchStore reads the global database, which is emptied by
+    // resetStore() for each test using it
+    QScopedPointer<QTemporaryDir> storeDir;
+
+    void resetStore();
+    QString storePath(const QString& name) const {
+        return dir->path() + QStringLiteral("/store/") + name;
+    }
+    Document storeDocument(const QString& name, const QString& text, quint32 mtime);
+    void addStoreDocuments(const QVector<Document>& docs);
 };
 
+void QueryTest::resetStore()
+{
+    Database* storeDb = globalDatabaseInstance();
+    QVERIFY(storeDb->open(Database::CreateDatabase));
+
+    Transaction tr(storeDb, Transaction::ReadWrite);
+    QVector<quint64> ids;
+    {
+        QScopedPointer<PostingIterator> it(tr.mTimeIter(0, MTimeDB::GreaterEqual));
+        while (it && it->next()) {
+            ids << it->docId();
+        }
+    }
+    for (quint64 id : qAsConst(ids)) {
+        tr.removeDocument(id);
+    }
+    tr.commit();
+
+    QueryCache::instance()->clear();
+}
+
+Document QueryTest::storeDocument(const QString& name, const QString& text, quint32 mtime)
+{
+    const QString url = storePath(name);
+
+    Document doc;
+    doc.setUrl(QFile::encodeName(url));
+    doc.setId(touchFile(url));
+
+    TermGenerator tg(doc);
+    tg.indexText(text);
+    tg.indexFileNameText(name);
+    doc.setMTime(mtime);
+    doc.setCTime(mtime);
+    return doc;
+}
+
+void QueryTest::addStoreDocuments(const QVector<Document>& docs)
+{
+    Transaction tr(globalDatabaseInstance(), Transaction::ReadWrite);
+    for (const Document& doc : docs) {
+        tr.addDocument(doc);
+    }
+    tr.commit();
+}
+
 
 void QueryTest::insertDocuments()
 {
@@ -168,6 +248,18 @@ void QueryTest::testTermStartsWith()
     QCOMPARE(tr.exec(q), result);
 }
 
+void QueryTest::testTermFuzzy()
+{
+    EngineQuery q("", "crazzy", 1);
+
+    QVector<quint64> result = {m_id1, m_id4};
+    Transaction tr(db, Transaction::ReadOnly);
+    QCOMPARE(tr.exec(q), result);
+    QCOMPARE(tr.documentCount(q), static_cast<quint64>(2));
+
+    QVERIFY(tr.exec(EngineQuery("", "crazzzy", 1)).isEmpty());
+}
+
 void QueryTest::testTermAnd()
 {
     QVector<EngineQuery> queries;
@@ -274,6 +366,240 @@ void QueryTest::testTagTermPhrase()
     QCOMPARE(res, matchIds);
 }
 
+void QueryTest::testStoreNewestMatches()
+{
+    resetStore();
+
+    // Every other document has "apple", the newer ones have higher numbers
+    QVector<Document> docs;
+    for (int i = 0; i < 20; i++) {
+        docs << storeDocument(QStringLiteral("doc%1").arg(i), i % 2 ? QStringLiteral("banana common") : QStringLiteral("apple common"), 100 + 2 * i);
+    }
+    addStoreDocuments(docs);
+
+    // A new document, and a new version of doc2 which no longer has "apple"
+    OverlayIndex overlay(fileIndexDbPath());
+    QVERIFY(overlay.add(storeDocument(QStringLiteral("fresh"), QStringLiteral("apple"), 1000)));
+    QVERIFY(overlay.add(storeDocument(QStringLiteral("middle"), QStringLiteral("apple"), 130)));
+    QVERIFY(overlay.add(storeDocument(QStringLiteral("doc2"), QStringLiteral("banana"), 50)));
+
+    const QStringList expected = {
+        storePath(QStringLiteral("fresh")),
+        storePath(QStringLiteral("doc18")),
+        storePath(QStringLiteral("doc16")),
+        storePath(QStringLiteral("middle")),
+        storePath(QStringLiteral("doc14")),
+        storePath(QStringLiteral("doc12")),
+        storePath(QStringLiteral("doc10")),
+        storePath(QStringLiteral("doc8")),
+        storePath(QStringLiteral("doc6")),
+        storePath(QStringLiteral("doc4")),
+        storePath(QStringLiteral("doc0")),
+    };
+
+    const Term term(QString(), QStringLiteral("apple"), Term::Contains);
+    SearchStore store;
+
+    // Sorted with the heap
+    QCOMPARE(store.exec(term, 0, -1, true), expected);
+
+    // The MTimeDB walk returns the same top k
+    const QVector<QPair<int, int>> ranges = {{0, 3}, {2, 3}, {3, 2}, {5, 4}, {9, 5}};
+    for (const auto& range : ranges) {
+        QVERIFY(store.explain(term, range.first, range.second, true).contains(QStringLiteral("walking the mtimes")));
+        QCOMPARE(store.exec(term, range.first, range.second, true), expected.mid(range.first, range.second));
+    }
+
+    overlay.clear();
+}
+
+void QueryTest::testStoreCacheWithOverlay()
+{
+    resetStore();
+
+    const QVector<Document> docs = {
+        storeDocument(QStringLiteral("a"), QStringLiteral("apple"), 1),
+        storeDocument(QStringLiteral("b"), QStringLiteral("banana"), 2),
+        storeDocument(QStringLiteral("c"), QStringLiteral("apple"), 3),
+    };
+    addStoreDocuments(docs);
+
+    OverlayIndex overlay(fileIndexDbPath());
+    QVERIFY(overlay.add(storeDocument(QStringLiteral("d"), QStringLiteral("apple"), 4)));
+
+    const Term term(QString(), QStringLiteral("apple"), Term::Contains);
+    const QStringList withOverlay = {storePath(QStringLiteral("d")), storePath(QStringLiteral("c")), storePath(QStringLiteral("a"))};
+    SearchStore store;
+    QCOMPARE(store.exec(term, 0, -1, true), withOverlay);
+
+    // Only the results of the database are cached
+    QVector<quint64> dbIds = {docs[0].id(), docs[2].id()};
+    std::sort(dbIds.begin(), dbIds.end());
+    QVector<quint64> cachedIds;
+    auto unknownChanges = [](quint64, QVector<QByteArray>*, bool*) {
+        return false;
+    };
+    QVERIFY(QueryCache::instance()->lookup(QueryCache::key(term), globalDatabaseInstance()->lastTxnId(), unknownChanges, &cachedIds));
+    QCOMPARE(cachedIds, dbIds);
+
+    // The overlay is merged into the cached results
+    QCOMPARE(store.exec(term, 0, -1, true), withOverlay);
+
+    overlay.clear();
+    QCOMPARE(store.exec(term, 0, -1, true), withOverlay.mid(1));
+}
+
+void QueryTest::testStoreOffsetAndLimit()
+{
+    resetStore();
+
+    QVector<Document> docs;
+    for (int i = 0; i < 10; i++) {
+        docs << storeDocument(QStringLiteral("doc%1").arg(i), QStringLiteral("apple"), i + 1);
+    }
+    addStoreDocuments(docs);
+
+    const Term term(QString(), QStringLiteral("apple"), Term::Contains);
+    SearchStore store;
+    const QStringList all = store.exec(term, 0, -1, false);
+    QCOMPARE(all.size(), docs.size());
+
+    const QVector<QPair<int, int>> ranges = {{0, 3}, {4, 3}, {8, 5}, {12, 2}};
+    for (const auto& range : ranges) {
+        QCOMPARE(store.exec(term, range.first, range.second, false), all.mid(range.first, range.second));
+    }
+    QVERIFY(!store.start(term, 0, 0, false));
+
+    // The offset is only skipped when the first result is asked for
+    QVERIFY(store.start(term, 4, 2, false));
+    QVERIFY(store.filePath().isEmpty());
+    QVERIFY(store.next());
+    QCOMPARE(store.filePath(), all[4]);
+    QVERIFY(store.next());
+    QCOMPARE(store.filePath(), all[5]);
+    QVERIFY(!store.next());
+
+    QVERIFY(store.start(term, 12, 2, false));
+    QVERIFY(!store.next());
+}
+
+void QueryTest::testStoreSortedOnDemand()
+{
+    resetStore();
+
+    QVector<Document> docs;
+    QStringList sorted;
+    for (int i = 0; i < 10; i++) {
+        const QString name = QStringLiteral("doc%1").arg(i);
+        docs << storeDocument(name, QStringLiteral("apple"), i + 1);
+        sorted.prepend(storePath(name));
+    }
+    addStoreDocuments(docs);
+
+    const Term term(QString(), QStringLiteral("apple"), Term::Contains);
+    SearchStore store;
+    QCOMPARE(store.exec(term, 0, -1, true), sorted);
+
+    // Ranked up front, but each path is only looked up by next()
+    QVERIFY(store.start(term, 2, 3, true));
+    QVERIFY(store.filePath().isEmpty());
+    for (int i = 2; i < 5; i++) {
+        QVERIFY(store.next());
+        QCOMPARE(store.filePath(), sorted[i]);
+    }
+    QVERIFY(!store.next());
+    QVERIFY(store.filePath().isEmpty());
+}
+
+void QueryTest::testResultIteratorCopy()
+{
+    resetStore();
+
+    QVector<Document> docs;
+    QStringList sorted;
+    for (int i = 0; i < 5; i++) {
+        const QString name = QStringLiteral("doc%1").arg(i);
+        docs << storeDocument(name, QStringLiteral("apple"), i + 1);
+        sorted.prepend(storePath(name));
+    }
+    addStoreDocuments(docs);
+
+    Query query;
+    query.setSearchString(QStringLiteral("apple"));
+
+    ResultIterator it = query.exec();
+    QVERIFY(it.next());
+    QCOMPARE(it.filePath(), sorted[0]);
+
+    // The copy fetches all the remaining results, which both then share
+    QT_WARNING_PUSH
+    QT_WARNING_DISABLE_DEPRECATED
+    ResultIterator copy(it);
+    QT_WARNING_POP
+    QCOMPARE(copy.filePath(), sorted[0]);
+
+    for (int i = 1; i < sorted.size(); i++) {
+        QVERIFY(it.next());
+        QCOMPARE(it.filePath(), sorted[i]);
+        QVERIFY(copy.next());
+        QCOMPARE(copy.filePath(), sorted[i]);
+    }
+    QVERIFY(!it.next());
+    QVERIFY(!copy.next());
+}
+
+void QueryTest::testStoreNegation()
+{
+    resetStore();
+
+    const QVector<Document> docs = {
+        storeDocument(QStringLiteral("d1"), QStringLiteral("apple banana"), 1),
+        storeDocument(QStringLiteral("d2"), QStringLiteral("apple"), 2),
+        storeDocument(QStringLiteral("d3"), QStringLiteral("banana cherry"), 3),
+        storeDocument(QStringLiteral("d4"), QStringLiteral("apple banana cherry"), 4),
+        storeDocument(QStringLiteral("d5"), QStringLiteral("cherry"), 5),
+    };
+    addStoreDocuments(docs);
+
+    const Term apple(QString(), QStringLiteral("apple"), Term::Contains);
+    const Term banana(QString(), QStringLiteral("banana"), Term::Contains);
+    const Term cherry(QString(), QStringLiteral("cherry"), Term::Contains);
+
+    // NOT apple, all the documents without it
+    const Term notApple = !apple;
+    // apple -banana
+    const Term appleNotBanana(Term::And, QList<Term>({apple, !banana}));
+    // -(apple banana) cherry
+    const Term cherryNotBoth(Term::And, QList<Term>({!(apple && banana), cherry}));
+
+    auto paths = [this](const QStringList& names) {
+        QStringList list;
+        for (const QString& name : names) {
+            list << storePath(name);
+        }
+        return list;
+    };
+
+    SearchStore store;
+    QCOMPARE(store.exec(notApple, 0, -1, true), paths({QStringLiteral("d5"), QStringLiteral("d3")}));
+    QCOMPARE(store.exec(appleNotBanana, 0, -1, true), paths({QStringLiteral("d2")}));
+    QCOMPARE(store.exec(cherryNotBoth, 0, -1, true), paths({QStringLiteral("d5"), QStringLiteral("d3")}));
+
+    // The documents which have not been committed yet are excluded the
+    // same way, and a new version of d2 now has "banana"
+    OverlayIndex overlay(fileIndexDbPath());
+    QVERIFY(overlay.add(storeDocument(QStringLiteral("o6"), QStringLiteral("apple"), 6)));
+    QVERIFY(overlay.add(storeDocument(QStringLiteral("o7"), QStringLiteral("apple banana cherry"), 7)));
+    QVERIFY(overlay.add(storeDocument(QStringLiteral("o8"), QStringLiteral("cherry"), 8)));
+    QVERIFY(overlay.add(storeDocument(QStringLiteral("d2"), QStringLiteral("apple banana"), 9)));
+
+    QCOMPARE(store.exec(notApple, 0, -1, true), paths({QStringLiteral("o8"), QStringLiteral("d5"), QStringLiteral("d3")}));
+    QCOMPARE(store.exec(appleNotBanana, 0, -1, true), paths({QStringLiteral("o6")}));
+    QCOMPARE(store.exec(cherryNotBoth, 0, -1, true), paths({QStringLiteral("o8"), QStringLiteral("d5"), QStringLiteral("d3")}));
+
+    overlay.clear();
+}
+
 QTEST_MAIN(QueryTest)
 
 #include "querytest.moc"
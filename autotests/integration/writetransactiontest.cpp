@@ -22,6 +22,7 @@
 #include "dbstate.h"
 #include "database.h"
 #include "idutils.h"
+#include "enginequery.h"
 
 #include <QTest>
 #include <QTemporaryDir>
@@ -48,10 +49,19 @@ private Q_SLOTS:
     void testAddAndRemoveOneDocument();
     void testAddAndReplaceOneDocument();
     void testIdempotentDocumentChange();
+    void testReplaceDocumentTerms();
 
     void testRemoveRecursively();
+    void testRemoveRecursivelyWithFilter();
     void testDocumentId();
     void testTermPositions();
+    void testManyDocumentsOneTerm();
+    void testMemoryBudget();
+    void testPostingDeltas();
+    void testPositionDeltas();
+    void testPrefixPostings();
+    void testPrefixBackfill();
+    void testChangeLog();
 private:
     QTemporaryDir* dir;
     Database* db;
@@ -269,6 +279,66 @@ void WriteTransactionTest::testRemoveRecursively()
     QVERIFY(DBState::debugCompare(actualState, DBState()));
 }
 
+void WriteTransactionTest::testRemoveRecursivelyWithFilter()
+{
+    const QString path = dir->path();
+    const QString dirPath(path + "/dir");
+    const QString subDirPath(dirPath + "/sub");
+    const QString url1(dirPath + "/file1");
+    const QString url2(dirPath + "/file2");
+    const QString url3(subDirPath + "/file3");
+
+    QDir().mkpath(subDirPath);
+    touchFile(url1);
+    touchFile(url2);
+    touchFile(url3);
+
+    Document doc1 = createDocument(url1, 5, 1, {"a", "abc"}, {"file1"}, {});
+    Document doc2 = createDocument(url2, 6, 2, {"a", "dab"}, {"file2"}, {});
+    Document doc3 = createDocument(url3, 7, 3, {"a", "abc"}, {"file3"}, {});
+    Document doc4 = createDocument(subDirPath, 8, 4, {"a"}, {"sub"}, {});
+    doc1.addPositionTerm("abc", 1);
+    doc3.addPositionTerm("abc", 2);
+
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        tr.addDocument(doc1);
+        tr.addDocument(doc2);
+        tr.addDocument(doc3);
+        tr.commit();
+    }
+
+    // The pending operations of doc4 are written before the subtree goes
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        tr.addDocument(doc4);
+        const quint64 id1 = doc1.id();
+        const bool removed = tr.removeRecursively(filePathToId(QFile::encodeName(dirPath)), [id1](quint64 id) {
+            return id != id1;
+        });
+        QVERIFY(!removed);
+        tr.commit();
+    }
+
+    const quint64 id = doc1.id();
+
+    DBState state;
+    state.postingDb = {{"a", {id}}, {"abc", {id}}, {"file1", {id}}};
+    state.positionDb = {{"abc", {PositionInfo(id, {1})}}};
+    state.docTermsDb = {{id, {"a", "abc"} }};
+    state.docFileNameTermsDb = {{id, {"file1"} }};
+    state.docTimeDb = {{id, DocumentTimeDB::TimeInfo(5, 1)}};
+    state.mtimeDb = {{5, id}};
+
+    Transaction tr(db, Transaction::ReadOnly);
+    DBState actualState = DBState::fromTransaction(&tr);
+    QVERIFY(DBState::debugCompare(actualState, state));
+
+    QCOMPARE(tr.documentUrl(id), QFile::encodeName(url1));
+    QCOMPARE(tr.documentId(QFile::encodeName(url2)), quint64(0));
+    QCOMPARE(tr.documentId(QFile::encodeName(subDirPath)), quint64(0));
+}
+
 void WriteTransactionTest::testDocumentId()
 {
     const QString url1(dir->path() + "/file1");
@@ -445,6 +515,518 @@ void WriteTransactionTest::testIdempotentDocumentChange()
 
 }
 
+void WriteTransactionTest::testReplaceDocumentTerms()
+{
+    const QString url1(dir->path() + "/file1");
+    const QString url2(dir->path() + "/file2");
+    touchFile(url1);
+    touchFile(url2);
+
+    Document doc1 = createDocument(url1, 5, 1, {}, {"file1"}, {});
+    doc1.addPositionTerm("same", 1);
+    doc1.addPositionTerm("moved", 2);
+    doc1.addPositionTerm("gone", 3);
+    Document doc2 = createDocument(url2, 6, 2, {}, {"file2"}, {});
+    doc2.addPositionTerm("same", 1);
+    doc2.addPositionTerm("moved", 2);
+
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        tr.addDocument(doc1);
+        tr.addDocument(doc2);
+        tr.commit();
+    }
+
+    Document newDoc1 = createDocument(url1, 5, 1, {}, {"file1"}, {});
+    newDoc1.addPositionTerm("same", 1);
+    newDoc1.addPositionTerm("moved", 4);
+    newDoc1.addPositionTerm("new", 3);
+
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        tr.replaceDocument(newDoc1, DocumentOperation::DocumentTerms);
+        tr.commit();
+    }
+
+    const quint64 id1 = doc1.id();
+    const quint64 id2 = doc2.id();
+    PostingList both = {id1, id2};
+    std::sort(both.begin(), both.end());
+
+    Transaction tr(db, Transaction::ReadOnly);
+    DBState state = DBState::fromTransaction(&tr);
+    QCOMPARE(state.postingDb.value("same"), both);
+    QCOMPARE(state.postingDb.value("moved"), both);
+    QCOMPARE(state.postingDb.value("new"), PostingList{id1});
+    QVERIFY(!state.postingDb.contains("gone"));
+    QVERIFY(!state.positionDb.contains("gone"));
+    QCOMPARE(state.docTermsDb.value(id1), QVector<QByteArray>({"moved", "new", "same"}));
+
+    auto positionsOf = [&state](const QByteArray& term, quint64 id) {
+        const QVector<PositionInfo> list = state.positionDb.value(term);
+        for (const PositionInfo& info : list) {
+            if (info.docId == id) {
+                return info.positions;
+            }
+        }
+        return QVector<uint>();
+    };
+    QCOMPARE(positionsOf("same", id1), QVector<uint>({1}));
+    QCOMPARE(positionsOf("moved", id1), QVector<uint>({4}));
+    QCOMPARE(positionsOf("moved", id2), QVector<uint>({2}));
+    QCOMPARE(positionsOf("new", id1), QVector<uint>({3}));
+}
+
+void WriteTransactionTest::testManyDocumentsOneTerm()
+{
+    QVector<Document> docs;
+    for (int i = 0; i < 50; i++) {
+        const QString url(dir->path() + QStringLiteral("/file%1").arg(i));
+        touchFile(url);
+        Document doc = createDocument(url, 5, 1, {"common"}, {}, {});
+        doc.addPositionTerm("common", i + 1);
+        docs.append(doc);
+    }
+
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        for (int i = 0; i < 40; i++) {
+            tr.addDocument(docs[i]);
+        }
+        tr.commit();
+    }
+
+    // Remove, add and replace documents in a single batch
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        for (int i = 0; i < 10; i++) {
+            tr.removeDocument(docs[i].id());
+        }
+        for (int i = 40; i < 50; i++) {
+            tr.addDocument(docs[i]);
+        }
+        for (int i = 10; i < 20; i++) {
+            Document doc = docs[i];
+            doc.addPositionTerm("common", 100 + i);
+            tr.replaceDocument(doc, DocumentOperation::Everything);
+        }
+        tr.commit();
+    }
+
+    PostingList expectedIds;
+    QVector<PositionInfo> expectedPositions;
+    for (int i = 10; i < 50; i++) {
+        expectedIds.append(docs[i].id());
+        QVector<uint> positions = {static_cast<uint>(i + 1)};
+        if (i < 20) {
+            positions.append(100 + i);
+        }
+        expectedPositions.append(PositionInfo(docs[i].id(), positions));
+    }
+    std::sort(expectedIds.begin(), expectedIds.end());
+    std::sort(expectedPositions.begin(), expectedPositions.end());
+
+    Transaction tr(db, Transaction::ReadOnly);
+    DBState actualState = DBState::fromTransaction(&tr);
+    QCOMPARE(actualState.postingDb.value("common"), expectedIds);
+
+    const QVector<PositionInfo> actualPositions = actualState.positionDb.value("common");
+    QCOMPARE(actualPositions.size(), expectedPositions.size());
+    for (int i = 0; i < actualPositions.size(); i++) {
+        QCOMPARE(actualPositions[i].docId, expectedPositions[i].docId);
+        QCOMPARE(actualPositions[i].positions, expectedPositions[i].positions);
+    }
+}
+
+void WriteTransactionTest::testMemoryBudget()
+{
+    const QString url1(dir->path() + "/file1");
+    const QString url2(dir->path() + "/file2");
+    touchFile(url1);
+    touchFile(url2);
+
+    Document doc1 = createDocument(url1, 5, 1, {"a", "abc", "dab"}, {"file1"}, {});
+    Document doc2 = createDocument(url2, 6, 2, {"a", "abcd", "dab"}, {"file2"}, {});
+
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        tr.setMemoryBudget(1);
+        QCOMPARE(tr.pendingBytes(), qint64(0));
+
+        tr.addDocument(doc1);
+        // Over budget, so everything has been written into the transaction
+        QCOMPARE(tr.pendingBytes(), qint64(0));
+        QVERIFY(!tr.hasChanges());
+        QVERIFY(tr.uncommittedBytes() > 0);
+
+        tr.setMemoryBudget(0);
+        tr.addDocument(doc2);
+        QVERIFY(tr.pendingBytes() > 0);
+        QVERIFY(tr.hasChanges());
+        tr.commit();
+    }
+
+    quint64 id1 = doc1.id();
+    quint64 id2 = doc2.id();
+    PostingList both = {id1, id2};
+    std::sort(both.begin(), both.end());
+
+    Transaction tr(db, Transaction::ReadOnly);
+    DBState actualState = DBState::fromTransaction(&tr);
+    QCOMPARE(actualState.postingDb.value("a"), both);
+    QCOMPARE(actualState.postingDb.value("dab"), both);
+    QCOMPARE(actualState.postingDb.value("abc"), PostingList{id1});
+    QCOMPARE(actualState.postingDb.value("abcd"), PostingList{id2});
+}
+
+void WriteTransactionTest::testPostingDeltas()
+{
+    // Enough documents for "common" to get its small changes written as deltas
+    const int count = 1100;
+    QVector<Document> docs;
+    for (int i = 0; i < count; i++) {
+        const QString url(dir->path() + QStringLiteral("/file%1").arg(i));
+        touchFile(url);
+        docs.append(createDocument(url, 5, 1, {"common"}, {}, {}));
+    }
+
+    PostingList expected;
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        for (int i = 0; i < count - 2; i++) {
+            tr.addDocument(docs[i]);
+            expected.append(docs[i].id());
+        }
+        tr.commit();
+    }
+
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        tr.addDocument(docs[count - 2]);
+        tr.addDocument(docs[count - 1]);
+        tr.removeDocument(docs[0].id());
+        tr.commit();
+    }
+    expected.removeOne(docs[0].id());
+    expected.append(docs[count - 2].id());
+    expected.append(docs[count - 1].id());
+    std::sort(expected.begin(), expected.end());
+
+    {
+        Transaction tr(db, Transaction::ReadOnly);
+        QCOMPARE(tr.postingDeltaCount(), 1u);
+
+        DBState state = DBState::fromTransaction(&tr);
+        QCOMPARE(state.postingDb.value("common"), expected);
+        QCOMPARE(tr.exec(EngineQuery("common")).size(), expected.size());
+    }
+
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        QVERIFY(!tr.compactPostingDeltas(10));
+        tr.commit();
+    }
+
+    Transaction tr(db, Transaction::ReadOnly);
+    QCOMPARE(tr.postingDeltaCount(), 0u);
+    DBState state = DBState::fromTransaction(&tr);
+    QCOMPARE(state.postingDb.value("common"), expected);
+}
+
+void WriteTransactionTest::testPositionDeltas()
+{
+    // Enough documents for the positions of "hello world" to be changed
+    // through deltas
+    const int count = 1100;
+    QVector<Document> docs;
+    for (int i = 0; i < count; i++) {
+        const QString url(dir->path() + QStringLiteral("/file%1").arg(i));
+        touchFile(url);
+        Document doc = createDocument(url, 5, 1, {}, {}, {});
+        doc.addPositionTerm("hello", 1);
+        doc.addPositionTerm("world", 2);
+        docs.append(doc);
+    }
+
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        for (int i = 0; i < count - 1; i++) {
+            tr.addDocument(docs[i]);
+        }
+        tr.commit();
+    }
+
+    // Only the positions of the first document change
+    Document moved = createDocument(dir->path() + QStringLiteral("/file0"), 5, 1, {}, {}, {});
+    moved.addPositionTerm("hello", 1);
+    moved.addPositionTerm("world", 3);
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        tr.replaceDocument(moved, DocumentOperation::DocumentTerms);
+        tr.addDocument(docs[count - 1]);
+        tr.commit();
+    }
+
+    const EngineQuery phrase({EngineQuery("hello", 1), EngineQuery("world", 2)}, EngineQuery::Phrase);
+    auto positionsOf = [](const DBState& state, const QByteArray& term, quint64 id) {
+        const QVector<PositionInfo> list = state.positionDb.value(term);
+        for (const PositionInfo& info : list) {
+            if (info.docId == id) {
+                return info.positions;
+            }
+        }
+        return QVector<uint>();
+    };
+
+    DBState deltaState;
+    {
+        Transaction tr(db, Transaction::ReadOnly);
+        QCOMPARE(tr.postingDeltaCount(), 2u);
+
+        deltaState = DBState::fromTransaction(&tr);
+        QCOMPARE(positionsOf(deltaState, "world", docs[0].id()), QVector<uint>({3}));
+        QCOMPARE(positionsOf(deltaState, "world", docs[count - 1].id()), QVector<uint>({2}));
+        QCOMPARE(deltaState.positionDb.value("world").size(), count);
+
+        const QVector<quint64> result = tr.exec(phrase);
+        QCOMPARE(result.size(), count - 1);
+        QVERIFY(!result.contains(docs[0].id()));
+        QVERIFY(result.contains(docs[count - 1].id()));
+    }
+
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        QVERIFY(!tr.compactPostingDeltas(10));
+        tr.commit();
+    }
+
+    {
+        Transaction tr(db, Transaction::ReadOnly);
+        QCOMPARE(tr.postingDeltaCount(), 0u);
+        DBState state = DBState::fromTransaction(&tr);
+        QCOMPARE(state.positionDb, deltaState.positionDb);
+        QCOMPARE(positionsOf(state, "world", docs[0].id()), QVector<uint>({3}));
+        QCOMPARE(tr.exec(phrase).size(), count - 1);
+    }
+
+    // The same positions again do not write a delta
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        tr.replaceDocument(docs[1], DocumentOperation::DocumentTerms);
+        tr.commit();
+    }
+
+    Transaction tr(db, Transaction::ReadOnly);
+    QCOMPARE(tr.postingDeltaCount(), 0u);
+}
+
+void WriteTransactionTest::testPrefixPostings()
+{
+    // Enough terms starting with "prog" for the prefix to be stored
+    const int count = PrefixDB::minTermCount() + 100;
+    QVector<Document> docs;
+    for (int i = 0; i < count; i++) {
+        const QString url(dir->path() + QStringLiteral("/file%1").arg(i));
+        touchFile(url);
+        const QByteArray term = "prog" + QByteArray::number(i);
+        docs.append(createDocument(url, 5, 1, {term}, {}, {}));
+    }
+
+    PostingList expected;
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        for (const Document& doc : qAsConst(docs)) {
+            tr.addDocument(doc);
+            expected.append(doc.id());
+        }
+        tr.commit();
+    }
+    std::sort(expected.begin(), expected.end());
+
+    {
+        Transaction tr(db, Transaction::ReadOnly);
+        DBState state = DBState::fromTransaction(&tr);
+        QCOMPARE(state.prefixDb.value("pro"), expected);
+        QCOMPARE(state.prefixDb.value("prog"), expected);
+        // "prog1" only expands to a few hundred terms
+        QVERIFY(!state.prefixDb.contains("prog1"));
+    }
+
+    // Take one document out by removing it, and one by replacing its term
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        tr.removeDocument(docs[0].id());
+
+        Document doc = createDocument(QFile::decodeName(docs[1].url()), 5, 1, {"other"}, {}, {});
+        tr.replaceDocument(doc, DocumentOperation::DocumentTerms);
+
+        Document doc2 = docs[2];
+        doc2.addTerm("progress");
+        tr.replaceDocument(doc2, DocumentOperation::DocumentTerms);
+        tr.commit();
+    }
+    expected.removeOne(docs[0].id());
+    expected.removeOne(docs[1].id());
+
+    {
+        Transaction tr(db, Transaction::ReadOnly);
+        // Only the changes to "pro" and "prog" were written
+        QCOMPARE(tr.postingDeltaCount(), 2u);
+
+        DBState state = DBState::fromTransaction(&tr);
+        QCOMPARE(state.prefixDb.value("pro"), expected);
+        QCOMPARE(state.prefixDb.value("prog"), expected);
+
+        QVector<quint64> results = tr.exec(EngineQuery("pro", EngineQuery::StartsWith));
+        QCOMPARE(results, expected);
+    }
+
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        QVERIFY(!tr.compactPostingDeltas(10));
+        tr.commit();
+    }
+
+    Transaction tr(db, Transaction::ReadOnly);
+    QCOMPARE(tr.postingDeltaCount(), 0u);
+    DBState state = DBState::fromTransaction(&tr);
+    QCOMPARE(state.prefixDb.value("pro"), expected);
+    QCOMPARE(state.prefixDb.value("prog"), expected);
+}
+
+void WriteTransactionTest::testPrefixBackfill()
+{
+    const int count = PrefixDB::minTermCount() + 100;
+    PostingList expected;
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        for (int i = 0; i < count; i++) {
+            const QString url(dir->path() + QStringLiteral("/file%1").arg(i));
+            touchFile(url);
+            const QByteArray term = "prog" + QByteArray::number(i);
+            const Document doc = createDocument(url, 5, 1, {term}, {}, {});
+            tr.addDocument(doc);
+            expected.append(doc.id());
+        }
+        tr.commit();
+    }
+    std::sort(expected.begin(), expected.end());
+
+    // Turn it into a database from before the PrefixDB existed
+    delete db;
+    {
+        MDB_env* env;
+        mdb_env_create(&env);
+        mdb_env_set_maxdbs(env, 17);
+        const QByteArray path = QFile::encodeName(dir->path() + QStringLiteral("/index"));
+        QCOMPARE(mdb_env_open(env, path.constData(), MDB_NOSUBDIR, 0664), 0);
+
+        MDB_txn* txn;
+        mdb_txn_begin(env, nullptr, 0, &txn);
+        for (const char* name : {"prefixdb", "prefixdeltadb"}) {
+            MDB_dbi dbi;
+            QCOMPARE(mdb_dbi_open(txn, name, 0, &dbi), 0);
+            QCOMPARE(mdb_drop(txn, dbi, 1), 0);
+        }
+        QCOMPARE(mdb_txn_commit(txn), 0);
+        mdb_env_close(env);
+    }
+
+    db = new Database(dir->path());
+    QVERIFY(db->open(Database::CreateDatabase));
+
+    // Not filled in when the database is opened, the terms are expanded instead
+    {
+        Transaction tr(db, Transaction::ReadOnly);
+        QVERIFY(DBState::fromTransaction(&tr).prefixDb.isEmpty());
+        QCOMPARE(tr.exec(EngineQuery("pro", EngineQuery::StartsWith)), expected);
+    }
+
+    int steps = 0;
+    bool moreRemaining = true;
+    while (moreRemaining) {
+        QVERIFY(++steps < 100);
+        Transaction tr(db, Transaction::ReadWrite);
+        moreRemaining = tr.buildPrefixes(1);
+        tr.commit();
+    }
+
+    {
+        Transaction tr(db, Transaction::ReadOnly);
+        DBState state = DBState::fromTransaction(&tr);
+        QCOMPARE(state.prefixDb.value("pro"), expected);
+        QCOMPARE(state.prefixDb.value("prog"), expected);
+        QVERIFY(!state.prefixDb.contains("prog1"));
+        QCOMPARE(tr.exec(EngineQuery("pro", EngineQuery::StartsWith)), expected);
+    }
+
+    // Only done once
+    Transaction tr(db, Transaction::ReadWrite);
+    QVERIFY(!tr.buildPrefixes(1));
+    tr.abort();
+}
+
+void WriteTransactionTest::testChangeLog()
+{
+    const QString filePath(dir->path() + "/file");
+    touchFile(filePath);
+    const QByteArray url = QFile::encodeName(filePath);
+    const quint64 id = filePathToId(url);
+
+    const quint64 createdTxnId = db->lastTxnId();
+    {
+        Document doc;
+        doc.setId(id);
+        doc.setUrl(url);
+        doc.addTerm("fire");
+        doc.addTerm("water");
+        doc.setMTime(1);
+
+        Transaction tr(db, Transaction::ReadWrite);
+        tr.addDocument(doc);
+        tr.commit();
+    }
+    const quint64 addedTxnId = db->lastTxnId();
+
+    {
+        Document doc;
+        doc.setId(id);
+        doc.setUrl(url);
+        doc.addTerm("earth");
+        doc.addTerm("fire");
+
+        Transaction tr(db, Transaction::ReadWrite);
+        tr.replaceDocument(doc, DocumentTerms);
+        tr.commit();
+    }
+
+    // Changes nothing, but is recorded as well
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        tr.compactPostingDeltas(10);
+        tr.commit();
+    }
+
+    Transaction tr(db, Transaction::ReadOnly);
+    QVector<QByteArray> terms;
+    bool documents = true;
+
+    QVERIFY(tr.changesSince(db->lastTxnId(), &terms, &documents));
+    QVERIFY(terms.isEmpty());
+    QVERIFY(!documents);
+
+    QVERIFY(tr.changesSince(addedTxnId, &terms, &documents));
+    QCOMPARE(terms, QVector<QByteArray>({"earth", "water"}));
+    QVERIFY(!documents);
+
+    QVERIFY(tr.changesSince(createdTxnId, &terms, &documents));
+    QCOMPARE(terms, QVector<QByteArray>({"earth", "fire", "water"}));
+    QVERIFY(documents);
+
+    // The transaction which created the database is not recorded
+    QVERIFY(!tr.changesSince(createdTxnId - 1, &terms, &documents));
+}
+
 QTEST_MAIN(WriteTransactionTest)
 
 #include "writetransactiontest.moc"
@@ -23,6 +23,8 @@
 #include <QObject>
 #include <QTest>
 
+#include <limits>
+
 using namespace Baloo;
 
 class PostingCodecTest : public QObject
@@ -40,6 +42,17 @@ private Q_SLOTS:
         QCOMPARE(vec2, vec);
     }
 
+    void testRange() {
+        PostingCodec codec;
+
+        const QByteArray arr = codec.encode({1, 2, 9, 12});
+        QCOMPARE(codec.decode(arr, 2, 9), QVector<quint64>({2, 9}));
+        QCOMPARE(codec.decode(arr, 3, 11), QVector<quint64>({9}));
+        QCOMPARE(codec.decode(arr, 0, std::numeric_limits<quint64>::max()), QVector<quint64>({1, 2, 9, 12}));
+        QVERIFY(codec.decode(arr, 13, 20).isEmpty());
+        QVERIFY(codec.decode(arr, 3, 8).isEmpty());
+    }
+
 };
 
 QTEST_MAIN(PostingCodecTest)
@@ -0,0 +1,131 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "andnotpostingiterator.h"
+#include "vectorpostingiterator.h"
+
+#include <QTest>
+
+using namespace Baloo;
+
+namespace {
+// Counts the steps taken one by one
+class CountingIterator : public VectorPostingIterator
+{
+public:
+    CountingIterator(const QVector<quint64>& values, int* nextCalls)
+        : VectorPostingIterator(values)
+        , m_nextCalls(nextCalls)
+    {
+    }
+
+    quint64 next() override {
+        (*m_nextCalls)++;
+        return VectorPostingIterator::next();
+    }
+
+private:
+    int* m_nextCalls;
+};
+}
+
+class AndNotPostingIteratorTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void test();
+    void testNullExclude();
+    void testExcludeAll();
+    void testExcludeSkipped();
+    void testSkipTo();
+};
+
+void AndNotPostingIteratorTest::test()
+{
+    QVector<quint64> l1 = {1, 3, 5, 7, 9, 11};
+    QVector<quint64> l2 = {2, 3, 7, 8, 11, 12};
+
+    AndNotPostingIterator it(new VectorPostingIterator(l1), new VectorPostingIterator(l2));
+    QCOMPARE(it.docId(), static_cast<quint64>(0));
+
+    QVector<quint64> result = {1, 5, 9};
+    for (quint64 val : result) {
+        QCOMPARE(it.next(), static_cast<quint64>(val));
+        QCOMPARE(it.docId(), static_cast<quint64>(val));
+    }
+    QCOMPARE(it.next(), static_cast<quint64>(0));
+    QCOMPARE(it.docId(), static_cast<quint64>(0));
+}
+
+void AndNotPostingIteratorTest::testNullExclude()
+{
+    QVector<quint64> l1 = {1, 3, 5};
+
+    AndNotPostingIterator it(new VectorPostingIterator(l1), nullptr);
+    QCOMPARE(it.next(), static_cast<quint64>(1));
+    QCOMPARE(it.next(), static_cast<quint64>(3));
+    QCOMPARE(it.next(), static_cast<quint64>(5));
+    QCOMPARE(it.next(), static_cast<quint64>(0));
+}
+
+void AndNotPostingIteratorTest::testExcludeAll()
+{
+    QVector<quint64> l1 = {1, 3, 5};
+    QVector<quint64> l2 = {1, 2, 3, 4, 5, 6};
+
+    AndNotPostingIterator it(new VectorPostingIterator(l1), new VectorPostingIterator(l2));
+    QCOMPARE(it.next(), static_cast<quint64>(0));
+    QCOMPARE(it.docId(), static_cast<quint64>(0));
+}
+
+void AndNotPostingIteratorTest::testExcludeSkipped()
+{
+    QVector<quint64> include = {500, 5000, 20000};
+    QVector<quint64> exclude;
+    for (quint64 i = 1; i <= 10000; i++) {
+        exclude << i;
+    }
+
+    int excludeNexts = 0;
+    AndNotPostingIterator it(new VectorPostingIterator(include), new CountingIterator(exclude, &excludeNexts));
+    QCOMPARE(it.next(), static_cast<quint64>(20000));
+    QCOMPARE(it.next(), static_cast<quint64>(0));
+
+    // The exclusion list is only skipped over
+    QVERIFY(excludeNexts <= 1);
+}
+
+void AndNotPostingIteratorTest::testSkipTo()
+{
+    QVector<quint64> l1 = {1, 3, 5, 7, 9, 11, 13};
+    QVector<quint64> l2 = {5, 9, 13};
+
+    AndNotPostingIterator it(new VectorPostingIterator(l1), new VectorPostingIterator(l2));
+    QCOMPARE(it.skipTo(4), static_cast<quint64>(7));
+    QCOMPARE(it.skipTo(7), static_cast<quint64>(7));
+    QCOMPARE(it.skipTo(8), static_cast<quint64>(11));
+    QCOMPARE(it.next(), static_cast<quint64>(0));
+    QCOMPARE(it.docId(), static_cast<quint64>(0));
+}
+
+QTEST_MAIN(AndNotPostingIteratorTest)
+
+#include "andnotpostingiteratortest.moc"
@@ -25,12 +25,36 @@
 
 using namespace Baloo;
 
+namespace {
+// Counts the steps taken one by one
+class CountingIterator : public VectorPostingIterator
+{
+public:
+    CountingIterator(const QVector<quint64>& values, int* nextCalls)
+        : VectorPostingIterator(values)
+        , m_nextCalls(nextCalls)
+    {
+    }
+
+    quint64 next() override {
+        (*m_nextCalls)++;
+        return VectorPostingIterator::next();
+    }
+
+private:
+    int* m_nextCalls;
+};
+}
+
 class AndPostingIteratorTest : public QObject
 {
     Q_OBJECT
 private Q_SLOTS:
     void test();
     void testNullIterators();
+    void testRarestDrives();
+    void testSkipTo();
+    void testCost();
 };
 
 void AndPostingIteratorTest::test()
@@ -72,6 +96,49 @@ void AndPostingIteratorTest::testNullIterators()
     QCOMPARE(it.docId(), static_cast<quint64>(0));
 }
 
+void AndPostingIteratorTest::testRarestDrives()
+{
+    QVector<quint64> common;
+    for (quint64 i = 1; i <= 10000; i++) {
+        common << i;
+    }
+    QVector<quint64> rare = {500, 5000, 20000};
+
+    int commonNexts = 0;
+    int rareNexts = 0;
+    AndPostingIterator it({new CountingIterator(common, &commonNexts), new CountingIterator(rare, &rareNexts)});
+
+    QCOMPARE(it.next(), static_cast<quint64>(500));
+    QCOMPARE(it.next(), static_cast<quint64>(5000));
+    QCOMPARE(it.next(), static_cast<quint64>(0));
+
+    // The common list is only skipped over
+    QVERIFY(commonNexts <= 1);
+    QCOMPARE(rareNexts, 3);
+}
+
+void AndPostingIteratorTest::testSkipTo()
+{
+    QVector<quint64> l1 = {1, 3, 5, 7, 9, 11, 13};
+    QVector<quint64> l2 = {3, 4, 5, 9, 11, 13};
+
+    AndPostingIterator it({new VectorPostingIterator(l1), new VectorPostingIterator(l2)});
+    QCOMPARE(it.skipTo(4), static_cast<quint64>(5));
+    QCOMPARE(it.skipTo(5), static_cast<quint64>(5));
+    QCOMPARE(it.skipTo(6), static_cast<quint64>(9));
+    QCOMPARE(it.next(), static_cast<quint64>(11));
+    QCOMPARE(it.skipTo(14), static_cast<quint64>(0));
+    QCOMPARE(it.docId(), static_cast<quint64>(0));
+}
+
+void AndPostingIteratorTest::testCost()
+{
+    QVector<quint64> l1 = {1, 3, 5, 7};
+    QVector<quint64> l2 = {3, 7};
+
+    AndPostingIterator it({new VectorPostingIterator(l1), new VectorPostingIterator(l2)});
+    QCOMPARE(it.cost(), static_cast<quint64>(2));
+}
 
 QTEST_MAIN(AndPostingIteratorTest)
 
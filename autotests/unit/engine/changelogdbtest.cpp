@@ -0,0 +1,66 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "changelogdb.h"
+#include "singledbtest.h"
+
+using namespace Baloo;
+
+class ChangeLogDBTest : public SingleDBTest
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testPutAndGet() {
+        ChangeLogDB db(ChangeLogDB::create(m_txn), m_txn);
+
+        ChangeLogDB::Changes changes;
+        changes.terms = {"fire", "fires", "water"};
+        changes.documents = true;
+        db.put(5, changes);
+        db.put(6, ChangeLogDB::Changes());
+
+        ChangeLogDB::Changes result;
+        QVERIFY(db.get(5, &result));
+        QCOMPARE(result, changes);
+        QVERIFY(db.get(6, &result));
+        QCOMPARE(result, ChangeLogDB::Changes());
+        QVERIFY(!db.get(7, &result));
+    }
+
+    void testPrune() {
+        ChangeLogDB db(ChangeLogDB::create(m_txn), m_txn);
+
+        ChangeLogDB::Changes changes;
+        changes.terms = {"fire"};
+        for (quint64 txnId = 1; txnId <= 5; txnId++) {
+            db.put(txnId, changes);
+        }
+
+        db.prune(4);
+        QCOMPARE(db.toTestMap().keys(), QList<quint64>({4, 5}));
+
+        db.prune(10);
+        QVERIFY(db.toTestMap().isEmpty());
+    }
+};
+
+QTEST_MAIN(ChangeLogDBTest)
+
+#include "changelogdbtest.moc"
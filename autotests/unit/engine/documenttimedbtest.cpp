@@ -19,8 +19,11 @@
  */
 
 #include "documenttimedb.h"
+#include "idutils.h"
 #include "singledbtest.h"
 
+#include <algorithm>
+
 using namespace Baloo;
 
 class DocumentTimeDBTest : public SingleDBTest
@@ -29,6 +32,7 @@ class DocumentTimeDBTest : public SingleDBTest
 private Q_SLOTS:
     void test();
     void testAllowZeroTime();
+    void testRangeStarts();
 };
 
 void DocumentTimeDBTest::test()
@@ -62,6 +66,46 @@ void DocumentTimeDBTest::testAllowZeroTime()
     QCOMPARE(db.get(1), DocumentTimeDB::TimeInfo());
 }
 
+void DocumentTimeDBTest::testRangeStarts()
+{
+    DocumentTimeDB db(DocumentTimeDB::create(m_txn), m_txn);
+    QVERIFY(db.rangeStarts(4).isEmpty());
+
+    const DocumentTimeDB::TimeInfo info(5, 6);
+    QVector<quint64> ids;
+    for (quint32 inode = 1; inode <= 100; inode++) {
+        for (quint32 devId : {3, 40}) {
+            ids << devIdAndInodeToId(devId, inode);
+        }
+    }
+    std::sort(ids.begin(), ids.end());
+    for (quint64 id : qAsConst(ids)) {
+        db.put(id, info);
+    }
+
+    QCOMPARE(db.rangeStarts(1), QVector<quint64>{ids.first()});
+
+    // The devices are mixed, so each range gets about as many documents
+    const QVector<quint64> starts = db.rangeStarts(4);
+    QCOMPARE(starts.size(), 4);
+    QCOMPARE(starts.first(), ids.first());
+    for (int i = 0; i < starts.size(); i++) {
+        const quint64 end = i + 1 < starts.size() ? starts[i + 1] : ids.last() + 1;
+        QVERIFY(starts[i] < end);
+        const int documents = std::count_if(ids.cbegin(), ids.cend(), [&](quint64 id) {
+            return id >= starts[i] && id < end;
+        });
+        QVERIFY2(documents >= 40 && documents <= 60, qPrintable(QString::number(documents)));
+    }
+
+    // A single document is not split
+    for (quint64 id : qAsConst(ids)) {
+        db.del(id);
+    }
+    db.put(devIdAndInodeToId(3, 7), info);
+    QCOMPARE(db.rangeStarts(4), QVector<quint64>{devIdAndInodeToId(3, 7)});
+}
+
 QTEST_MAIN(DocumentTimeDBTest)
 
 #include "documenttimedbtest.moc"
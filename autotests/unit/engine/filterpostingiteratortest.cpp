@@ -0,0 +1,85 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "filterpostingiterator.h"
+#include "vectorpostingiterator.h"
+
+#include <QTest>
+
+using namespace Baloo;
+
+class FilterPostingIteratorTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void test();
+    void testNothingAccepted();
+    void testSkipTo();
+};
+
+namespace {
+bool isOdd(quint64 id)
+{
+    return id % 2;
+}
+}
+
+void FilterPostingIteratorTest::test()
+{
+    QVector<quint64> l = {1, 2, 3, 4, 6, 7, 8, 9};
+
+    FilterPostingIterator it(new VectorPostingIterator(l), isOdd);
+    QCOMPARE(it.docId(), static_cast<quint64>(0));
+
+    QVector<quint64> result = {1, 3, 7, 9};
+    for (quint64 val : result) {
+        QCOMPARE(it.next(), static_cast<quint64>(val));
+        QCOMPARE(it.docId(), static_cast<quint64>(val));
+    }
+    QCOMPARE(it.next(), static_cast<quint64>(0));
+    QCOMPARE(it.docId(), static_cast<quint64>(0));
+}
+
+void FilterPostingIteratorTest::testNothingAccepted()
+{
+    QVector<quint64> l = {2, 4, 6};
+
+    FilterPostingIterator it(new VectorPostingIterator(l), isOdd);
+    QCOMPARE(it.next(), static_cast<quint64>(0));
+    QCOMPARE(it.docId(), static_cast<quint64>(0));
+}
+
+void FilterPostingIteratorTest::testSkipTo()
+{
+    QVector<quint64> l = {1, 2, 3, 4, 6, 7, 8, 9, 10};
+
+    FilterPostingIterator it(new VectorPostingIterator(l), isOdd);
+    QCOMPARE(it.skipTo(2), static_cast<quint64>(3));
+    QCOMPARE(it.skipTo(3), static_cast<quint64>(3));
+    QCOMPARE(it.skipTo(4), static_cast<quint64>(7));
+    QCOMPARE(it.next(), static_cast<quint64>(9));
+    QCOMPARE(it.skipTo(10), static_cast<quint64>(0));
+    QCOMPARE(it.docId(), static_cast<quint64>(0));
+}
+
+QTEST_MAIN(FilterPostingIteratorTest)
+
+#include "filterpostingiteratortest.moc"
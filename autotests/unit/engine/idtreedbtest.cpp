@@ -56,6 +56,27 @@ private Q_SLOTS:
             QCOMPARE(it->next(), static_cast<quint64>(val));
             QCOMPARE(it->docId(), static_cast<quint64>(val));
         }
+        delete it;
+    }
+
+    void testIterSkipTo() {
+        IdTreeDB db(IdTreeDB::create(m_txn), m_txn);
+
+        db.put(1, {5, 6, 7, 8});
+        db.put(6, {9, 11, 19});
+        db.put(8, {13, 15});
+        db.put(13, {18});
+
+        PostingIterator* it = db.iter(1);
+        QVERIFY(it);
+
+        QCOMPARE(it->skipTo(10), static_cast<quint64>(11));
+        QCOMPARE(it->skipTo(11), static_cast<quint64>(11));
+        QCOMPARE(it->next(), static_cast<quint64>(13));
+        QCOMPARE(it->skipTo(19), static_cast<quint64>(19));
+        QCOMPARE(it->skipTo(20), static_cast<quint64>(0));
+        QCOMPARE(it->docId(), static_cast<quint64>(0));
+        delete it;
     }
 };
 
@@ -0,0 +1,95 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "levenshteinautomaton.h"
+
+#include <QTest>
+
+using namespace Baloo;
+
+class LevenshteinAutomatonTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testMatches_data();
+    void testMatches();
+    void testDeadEnd();
+};
+
+void LevenshteinAutomatonTest::testMatches_data()
+{
+    QTest::addColumn<QByteArray>("word");
+    QTest::addColumn<int>("distance");
+    QTest::addColumn<QByteArray>("text");
+    QTest::addColumn<bool>("matches");
+
+    QTest::newRow("same") << QByteArray("hello") << 1 << QByteArray("hello") << true;
+    QTest::newRow("replaced") << QByteArray("hello") << 1 << QByteArray("hallo") << true;
+    QTest::newRow("inserted") << QByteArray("hello") << 1 << QByteArray("helllo") << true;
+    QTest::newRow("removed") << QByteArray("hello") << 1 << QByteArray("helo") << true;
+    QTest::newRow("two edits") << QByteArray("hello") << 1 << QByteArray("hlelo") << false;
+    QTest::newRow("two edits allowed") << QByteArray("hello") << 2 << QByteArray("hlelo") << true;
+    QTest::newRow("three edits") << QByteArray("hello") << 2 << QByteArray("yellow!") << false;
+    QTest::newRow("exact") << QByteArray("hello") << 0 << QByteArray("hallo") << false;
+    QTest::newRow("empty text") << QByteArray("ab") << 2 << QByteArray() << true;
+    QTest::newRow("umlaut") << QByteArray("f\xc3\xbc\x72") << 1 << QByteArray("fur") << true;
+    QTest::newRow("umlaut exact") << QByteArray("f\xc3\xbc\x72") << 0 << QByteArray("fur") << false;
+    QTest::newRow("umlaut same") << QByteArray("f\xc3\xbc\x72") << 0 << QByteArray("f\xc3\xbc\x72") << true;
+}
+
+void LevenshteinAutomatonTest::testMatches()
+{
+    QFETCH(QByteArray, word);
+    QFETCH(int, distance);
+    QFETCH(QByteArray, text);
+    QFETCH(bool, matches);
+
+    LevenshteinAutomaton automaton(word, distance);
+    QCOMPARE(automaton.matches(text), matches);
+}
+
+void LevenshteinAutomatonTest::testDeadEnd()
+{
+    LevenshteinAutomaton automaton("foo", 1);
+
+    int deadEnd = 0;
+    QVERIFY(automaton.matches("fox", &deadEnd));
+    QCOMPARE(deadEnd, -1);
+
+    // Could still become "fo" or "foo"
+    QVERIFY(!automaton.matches("f", &deadEnd));
+    QCOMPARE(deadEnd, -1);
+
+    // Nothing starting with "ba" is close to "foo"
+    QVERIFY(!automaton.matches("bar", &deadEnd));
+    QCOMPARE(deadEnd, 2);
+
+    QVERIFY(!automaton.matches("foobar", &deadEnd));
+    QCOMPARE(deadEnd, 5);
+
+    // Counted in bytes
+    QVERIFY(!automaton.matches("\xc3\xbc\xc3\xbc", &deadEnd));
+    QCOMPARE(deadEnd, 4);
+}
+
+QTEST_MAIN(LevenshteinAutomatonTest)
+
+#include "levenshteinautomatontest.moc"
@@ -161,6 +161,54 @@ private Q_SLOTS:
         }
     }
 
+    void testDocumentCount() {
+        MTimeDB db(MTimeDB::create(m_txn), m_txn);
+        QCOMPARE(db.documentCount(0, 100), static_cast<quint64>(0));
+
+        for (quint64 i = 1; i <= 100; i++) {
+            db.put(i, i);
+        }
+
+        QCOMPARE(db.documentCount(0, 1000), static_cast<quint64>(100));
+        QCOMPARE(db.documentCount(1, 50), static_cast<quint64>(50));
+        QCOMPARE(db.documentCount(101, 200), static_cast<quint64>(0));
+        QCOMPARE(db.documentCount(50, 49), static_cast<quint64>(0));
+        QCOMPARE(db.documentCount(20, 20), static_cast<quint64>(1));
+    }
+
+    void testNewest() {
+        MTimeDB db(MTimeDB::create(m_txn), m_txn);
+
+        db.put(5, 1);
+        db.put(9, 2);
+        db.put(6, 3);
+        db.put(6, 4);
+        db.put(0, 5);
+
+        auto ids = [](const QVector<MTimeDB::Entry>& entries) {
+            QVector<quint64> result;
+            for (const MTimeDB::Entry& entry : entries) {
+                result << entry.docId;
+            }
+            return result;
+        };
+
+        QVector<MTimeDB::Entry> entries = db.newest(2);
+        QCOMPARE(ids(entries), QVector<quint64>({2, 4}));
+        QCOMPARE(entries.last().mtime, static_cast<quint32>(6));
+
+        entries = db.newest(2, entries.last());
+        QCOMPARE(ids(entries), QVector<quint64>({3, 1}));
+
+        entries = db.newest(10, entries.last());
+        QCOMPARE(ids(entries), QVector<quint64>({5}));
+
+        entries = db.newest(10, entries.last());
+        QVERIFY(entries.isEmpty());
+
+        QCOMPARE(ids(db.newest(10)), QVector<quint64>({2, 4, 3, 1, 5}));
+    }
+
     void testBeginOfEpoch() {
         MTimeDB db(MTimeDB::create(m_txn), m_txn);
 
@@ -31,6 +31,10 @@ class OrPostingIteratorTest : public QObject
 private Q_SLOTS:
     void test();
     void testNullIterators();
+    void testSkipTo();
+    void testWideFanIn();
+    void testUnite();
+    void testSortUnique();
 };
 
 void OrPostingIteratorTest::test()
@@ -80,6 +84,82 @@ void OrPostingIteratorTest::testNullIterators()
 }
 
 
+void OrPostingIteratorTest::testSkipTo()
+{
+    QVector<quint64> l1 = {1, 3, 5, 7};
+    QVector<quint64> l2 = {3, 4, 5, 7, 9, 11};
+    QVector<quint64> l3 = {1, 3, 7};
+
+    OrPostingIterator it({new VectorPostingIterator(l1), new VectorPostingIterator(l2), new VectorPostingIterator(l3)});
+    QCOMPARE(it.skipTo(2), static_cast<quint64>(3));
+    QCOMPARE(it.skipTo(3), static_cast<quint64>(3));
+    QCOMPARE(it.next(), static_cast<quint64>(4));
+    QCOMPARE(it.skipTo(8), static_cast<quint64>(9));
+    QCOMPARE(it.next(), static_cast<quint64>(11));
+    QCOMPARE(it.skipTo(12), static_cast<quint64>(0));
+    QCOMPARE(it.docId(), static_cast<quint64>(0));
+}
+
+void OrPostingIteratorTest::testWideFanIn()
+{
+    // Every list holds the multiples of its step
+    QVector<PostingIterator*> vec;
+    QVector<bool> expected(1001, false);
+    quint64 total = 0;
+    for (quint64 step = 7; step <= 300; step++) {
+        QVector<quint64> list;
+        for (quint64 id = step; id <= 1000; id += step) {
+            list << id;
+            expected[id] = true;
+        }
+        total += list.size();
+        vec << new VectorPostingIterator(list);
+    }
+
+    OrPostingIterator it(vec);
+    QCOMPARE(it.cost(), total);
+
+    for (quint64 id = 1; id <= 1000; id++) {
+        if (expected[id]) {
+            QCOMPARE(it.next(), id);
+        }
+    }
+    QCOMPARE(it.next(), static_cast<quint64>(0));
+}
+
+void OrPostingIteratorTest::testUnite()
+{
+    QVector<quint64> l1 = {1, 3, 5, 7};
+    QVector<quint64> l2 = {3, 4, 5, 7, 9, 11};
+    QVector<quint64> l3 = {1, 3, 7};
+
+    QVector<PostingIterator*> vec = {new VectorPostingIterator(l1), nullptr,
+                                     new VectorPostingIterator(l2), new VectorPostingIterator(l3)};
+    PostingIterator* it = OrPostingIterator::unite(vec);
+    QVERIFY(it);
+
+    QVector<quint64> result = {1, 3, 4, 5, 7, 9, 11};
+    for (quint64 val : result) {
+        QCOMPARE(it->next(), static_cast<quint64>(val));
+    }
+    QCOMPARE(it->next(), static_cast<quint64>(0));
+    delete it;
+
+    QVERIFY(!OrPostingIterator::unite({}));
+}
+
+void OrPostingIteratorTest::testSortUnique()
+{
+    QVERIFY(OrPostingIterator::sortUnique({}).isEmpty());
+
+    // Dense, collected in a bitmap
+    QCOMPARE(OrPostingIterator::sortUnique({70, 3, 200, 3, 64, 65, 200}), QVector<quint64>({3, 64, 65, 70, 200}));
+
+    // Sparse, sorted
+    const quint64 far = static_cast<quint64>(1) << 40;
+    QCOMPARE(OrPostingIterator::sortUnique({far, 5, far, 1}), QVector<quint64>({1, 5, far}));
+}
+
 QTEST_MAIN(OrPostingIteratorTest)
 
 #include "orpostingiteratortest.moc"
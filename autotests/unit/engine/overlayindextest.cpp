@@ -0,0 +1,189 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "overlayindex.h"
+#include "document.h"
+#include "enginequery.h"
+#include "postingiterator.h"
+
+#include <QTest>
+#include <QTemporaryDir>
+
+using namespace Baloo;
+
+class OverlayIndexTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testPostingIterator();
+    void testFolderIter();
+    void testMTimeIter();
+    void testCompIterator();
+    void testReplace();
+    void testClear();
+
+private:
+    QVector<quint64> toList(PostingIterator* it);
+
+    QTemporaryDir* m_dir;
+    OverlayIndex* m_writer;
+    OverlayIndex* m_reader;
+};
+
+void OverlayIndexTest::init()
+{
+    m_dir = new QTemporaryDir();
+    m_writer = new OverlayIndex(m_dir->path());
+    m_reader = new OverlayIndex(m_dir->path());
+
+    Document doc1;
+    doc1.setId(1);
+    doc1.setUrl("/home/user/docs/a.txt");
+    doc1.setMTime(100);
+    doc1.addPositionTerm("hello", 1);
+    doc1.addPositionTerm("world", 2);
+    doc1.addTerm("X24-2019");
+    doc1.addFileNameTerm("Fa");
+
+    Document doc2;
+    doc2.setId(5);
+    doc2.setUrl("/home/user/music/b.ogg");
+    doc2.setMTime(200);
+    doc2.addTerm("help");
+    doc2.addTerm("X24-2015");
+    doc2.addXattrTerm("TAG-fun");
+
+    QVERIFY(m_writer->add(doc1));
+    QVERIFY(m_writer->add(doc2));
+
+    m_reader->load();
+}
+
+void OverlayIndexTest::cleanup()
+{
+    m_writer->clear();
+    delete m_reader;
+    delete m_writer;
+    delete m_dir;
+}
+
+QVector<quint64> OverlayIndexTest::toList(PostingIterator* it)
+{
+    QVector<quint64> ids;
+    if (!it) {
+        return ids;
+    }
+    while (it->next()) {
+        ids << it->docId();
+    }
+    delete it;
+    return ids;
+}
+
+void OverlayIndexTest::testPostingIterator()
+{
+    QVERIFY(!m_reader->isEmpty());
+
+    QCOMPARE(toList(m_reader->postingIterator(EngineQuery("hello"))), QVector<quint64>({1}));
+    QCOMPARE(toList(m_reader->postingIterator(EngineQuery("hel", EngineQuery::StartsWith))), QVector<quint64>({1, 5}));
+    QCOMPARE(toList(m_reader->postingIterator(EngineQuery("TAG-fun"))), QVector<quint64>({5}));
+    QCOMPARE(toList(m_reader->postingIterator(EngineQuery("Fa"))), QVector<quint64>({1}));
+    QVERIFY(!m_reader->postingIterator(EngineQuery("missing")));
+
+    QCOMPARE(toList(m_reader->postingIterator(EngineQuery("", "helo", 1))), QVector<quint64>({1, 5}));
+    QCOMPARE(toList(m_reader->postingIterator(EngineQuery("", "wrld", 1))), QVector<quint64>({1}));
+    QCOMPARE(toList(m_reader->postingIterator(EngineQuery("F", "b", 1))), QVector<quint64>({1}));
+    // "Fa" is a file name term, not a word of the text
+    QVERIFY(!m_reader->postingIterator(EngineQuery("", "a", 1)));
+    QVERIFY(!m_reader->postingIterator(EngineQuery("", "wrld", 0)));
+
+    EngineQuery both({EngineQuery("hello"), EngineQuery("help")}, EngineQuery::And);
+    QVERIFY(!m_reader->postingIterator(both));
+
+    EngineQuery either({EngineQuery("hello"), EngineQuery("help")}, EngineQuery::Or);
+    QCOMPARE(toList(m_reader->postingIterator(either)), QVector<quint64>({1, 5}));
+
+    EngineQuery phrase({EngineQuery("hello", 1), EngineQuery("world", 2)}, EngineQuery::Phrase);
+    QCOMPARE(toList(m_reader->postingIterator(phrase)), QVector<quint64>({1}));
+
+    QCOMPARE(m_reader->documentUrl(5), QByteArray("/home/user/music/b.ogg"));
+    QCOMPARE(m_reader->documentMTime(5), static_cast<quint32>(200));
+    QCOMPARE(m_reader->documentUrl(2), QByteArray());
+}
+
+void OverlayIndexTest::testFolderIter()
+{
+    QCOMPARE(toList(m_reader->folderIter("/home/user")), QVector<quint64>({1, 5}));
+    QCOMPARE(toList(m_reader->folderIter("/home/user/docs/")), QVector<quint64>({1}));
+    QVERIFY(!m_reader->folderIter("/home/user/doc"));
+}
+
+void OverlayIndexTest::testMTimeIter()
+{
+    QCOMPARE(toList(m_reader->mTimeIter(100, MTimeDB::Equal)), QVector<quint64>({1}));
+    QCOMPARE(toList(m_reader->mTimeIter(150, MTimeDB::GreaterEqual)), QVector<quint64>({5}));
+    QCOMPARE(toList(m_reader->mTimeIter(200, MTimeDB::LessEqual)), QVector<quint64>({1, 5}));
+    QCOMPARE(toList(m_reader->mTimeRangeIter(150, 250)), QVector<quint64>({5}));
+}
+
+void OverlayIndexTest::testCompIterator()
+{
+    QCOMPARE(toList(m_reader->postingCompIterator("X24-", 2016, PostingDB::GreaterEqual)), QVector<quint64>({1}));
+    QCOMPARE(toList(m_reader->postingCompIterator("X24-", 2016, PostingDB::LessEqual)), QVector<quint64>({5}));
+}
+
+void OverlayIndexTest::testReplace()
+{
+    Document doc;
+    doc.setId(1);
+    doc.setUrl("/home/user/docs/a.txt");
+    doc.setMTime(300);
+    doc.addTerm("goodbye");
+    QVERIFY(m_writer->add(doc));
+
+    m_reader->load();
+    QVERIFY(!m_reader->postingIterator(EngineQuery("hello")));
+    QCOMPARE(toList(m_reader->postingIterator(EngineQuery("goodbye"))), QVector<quint64>({1}));
+    QCOMPARE(m_reader->documentMTime(1), static_cast<quint32>(300));
+}
+
+void OverlayIndexTest::testClear()
+{
+    m_writer->clear();
+    QVERIFY(m_writer->isEmpty());
+
+    m_reader->load();
+    QVERIFY(m_reader->isEmpty());
+    QVERIFY(!m_reader->postingIterator(EngineQuery("hello")));
+
+    // Another database does not see the documents
+    QTemporaryDir otherDir;
+    OverlayIndex other(otherDir.path());
+    other.load();
+    QVERIFY(other.isEmpty());
+}
+
+QTEST_MAIN(OverlayIndexTest)
+
+#include "overlayindextest.moc"
@@ -0,0 +1,96 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "pendingtermoperations.h"
+
+#include <QTest>
+
+using namespace Baloo;
+
+class PendingTermOperationsTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testOperations();
+    void testClear();
+};
+
+void PendingTermOperationsTest::testOperations()
+{
+    PendingTermOperations ops;
+    QVERIFY(ops.isEmpty());
+
+    ops.add("fire", 1, {4, 5});
+    ops.add("abc", 1, {});
+    ops.remove("fire", 2);
+    ops.add("fire", 3, {7});
+    ops.replacePositions("fire", 4, {9});
+    QVERIFY(!ops.isEmpty());
+    QVERIFY(ops.memoryUsage() > 0);
+
+    const QVector<int> terms = ops.sortedTerms();
+    QCOMPARE(terms.size(), 2);
+    QCOMPARE(ops.term(terms[0]), QByteArray("abc"));
+    QCOMPARE(ops.term(terms[1]), QByteArray("fire"));
+
+    const QVector<PendingTermOperations::Operation> abc = ops.operations(terms[0]);
+    QCOMPARE(abc.size(), 1);
+    QCOMPARE(abc[0].type, PendingTermOperations::AddId);
+    QCOMPARE(abc[0].positionCount, 0);
+
+    const QVector<PendingTermOperations::Operation> fire = ops.operations(terms[1]);
+    QCOMPARE(fire.size(), 4);
+    QCOMPARE(fire[0].type, PendingTermOperations::AddId);
+    QCOMPARE(fire[0].docId, quint64(1));
+    QCOMPARE(fire[0].positionCount, 2);
+    QCOMPARE(fire[0].positions[0], 4u);
+    QCOMPARE(fire[0].positions[1], 5u);
+    QCOMPARE(fire[1].type, PendingTermOperations::RemoveId);
+    QCOMPARE(fire[1].docId, quint64(2));
+    QCOMPARE(fire[2].docId, quint64(3));
+    QCOMPARE(fire[2].positionCount, 1);
+    QCOMPARE(fire[2].positions[0], 7u);
+    QCOMPARE(fire[3].type, PendingTermOperations::ReplacePositions);
+    QCOMPARE(fire[3].docId, quint64(4));
+    QCOMPARE(fire[3].positionCount, 1);
+    QCOMPARE(fire[3].positions[0], 9u);
+}
+
+void PendingTermOperationsTest::testClear()
+{
+    PendingTermOperations ops;
+    ops.add("fire", 1, {4, 5});
+    ops.clear();
+
+    QVERIFY(ops.isEmpty());
+    QCOMPARE(ops.memoryUsage(), qint64(0));
+    QVERIFY(ops.sortedTerms().isEmpty());
+
+    ops.add("water", 2, {});
+    const QVector<int> terms = ops.sortedTerms();
+    QCOMPARE(terms.size(), 1);
+    QCOMPARE(ops.term(terms[0]), QByteArray("water"));
+    QCOMPARE(ops.operations(terms[0]).size(), 1);
+}
+
+QTEST_MAIN(PendingTermOperationsTest)
+
+#include "pendingtermoperationstest.moc"
@@ -32,6 +32,9 @@ class PhraseAndIteratorTest : public QObject
 private Q_SLOTS:
     void test();
     void testNullIterators();
+    void testLongPhrase();
+    void testSkipTo();
+    void testManyMismatches();
 };
 
 void PhraseAndIteratorTest::test()
@@ -109,6 +112,63 @@ void PhraseAndIteratorTest::testNullIterators()
     QCOMPARE(it.docId(), static_cast<quint64>(0));
 }
 
+void PhraseAndIteratorTest::testLongPhrase()
+{
+    // "a b c", where "b" is the rarest term within the documents
+    QVector<PositionInfo> a = {PositionInfo(1, {1, 4, 9, 12, 20}), PositionInfo(2, {3, 7}), PositionInfo(3, {1})};
+    QVector<PositionInfo> b = {PositionInfo(1, {13}), PositionInfo(2, {8}), PositionInfo(3, {2})};
+    QVector<PositionInfo> c = {PositionInfo(1, {2, 5, 10, 14, 21}), PositionInfo(2, {10}), PositionInfo(3, {3})};
+
+    PhraseAndIterator it({new VectorPositionInfoIterator(a), new VectorPositionInfoIterator(b),
+                          new VectorPositionInfoIterator(c)});
+    QCOMPARE(it.next(), static_cast<quint64>(1));
+    QCOMPARE(it.next(), static_cast<quint64>(3));
+    QCOMPARE(it.next(), static_cast<quint64>(0));
+
+    // The phrase cannot start before the first position
+    QVector<PositionInfo> d = {PositionInfo(1, {0})};
+    QVector<PositionInfo> e = {PositionInfo(1, {0, 1})};
+    PhraseAndIterator it2({new VectorPositionInfoIterator(e), new VectorPositionInfoIterator(d)});
+    QCOMPARE(it2.next(), static_cast<quint64>(0));
+}
+
+void PhraseAndIteratorTest::testSkipTo()
+{
+    QVector<PositionInfo> a;
+    QVector<PositionInfo> b;
+    for (quint64 id = 1; id <= 100; id++) {
+        a << PositionInfo(id, {1});
+        // Only the even documents have the phrase
+        b << PositionInfo(id, {id % 2 ? 3u : 2u});
+    }
+
+    PhraseAndIterator it({new VectorPositionInfoIterator(a), new VectorPositionInfoIterator(b)});
+    QCOMPARE(it.skipTo(11), static_cast<quint64>(12));
+    QCOMPARE(it.skipTo(12), static_cast<quint64>(12));
+    QCOMPARE(it.next(), static_cast<quint64>(14));
+    QCOMPARE(it.skipTo(99), static_cast<quint64>(100));
+    QCOMPARE(it.next(), static_cast<quint64>(0));
+}
+
+void PhraseAndIteratorTest::testManyMismatches()
+{
+    // A long run of documents with both terms, but never next to each
+    // other, must not exhaust the stack
+    const quint64 count = 200000;
+    QVector<PositionInfo> a;
+    QVector<PositionInfo> b;
+    a.reserve(count);
+    b.reserve(count);
+    for (quint64 id = 1; id <= count; id++) {
+        a << PositionInfo(id, {5});
+        b << PositionInfo(id, {id == count ? 6u : 9u});
+    }
+
+    PhraseAndIterator it({new VectorPositionInfoIterator(a), new VectorPositionInfoIterator(b)});
+    QCOMPARE(it.next(), count);
+    QCOMPARE(it.next(), static_cast<quint64>(0));
+}
+
 QTEST_MAIN(PhraseAndIteratorTest)
 
 #include "phraseanditeratortest.moc"
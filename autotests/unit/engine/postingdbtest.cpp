@@ -21,6 +21,8 @@
 #include "postingdb.h"
 #include "singledbtest.h"
 
+#include <algorithm>
+
 using namespace Baloo;
 
 class PostingDBTest : public SingleDBTest
@@ -55,6 +57,29 @@ private Q_SLOTS:
         }
     }
 
+    void testTermIterSkipTo() {
+        PostingDB db(PostingDB::create(m_txn), m_txn);
+
+        PostingList list;
+        for (quint64 id = 1; id <= 1000; id++) {
+            list << id * 3;
+        }
+        db.put("fir", list);
+
+        PostingIterator* it = db.iter("fir");
+        QVERIFY(it);
+
+        QCOMPARE(it->next(), static_cast<quint64>(3));
+        QCOMPARE(it->skipTo(3), static_cast<quint64>(3));
+        QCOMPARE(it->skipTo(4), static_cast<quint64>(6));
+        QCOMPARE(it->skipTo(2000), static_cast<quint64>(2001));
+        QCOMPARE(it->next(), static_cast<quint64>(2004));
+        QCOMPARE(it->skipTo(3000), static_cast<quint64>(3000));
+        QCOMPARE(it->skipTo(3001), static_cast<quint64>(0));
+        QCOMPARE(it->docId(), static_cast<quint64>(0));
+        delete it;
+    }
+
     void testPrefixIter() {
         PostingDB db(PostingDB::create(m_txn), m_txn);
 
@@ -73,6 +98,80 @@ private Q_SLOTS:
         }
     }
 
+    void testPrefixIterUnion() {
+        PostingDB db(PostingDB::create(m_txn), m_txn);
+
+        // Enough short lists to be united up front
+        QVector<quint64> result;
+        for (int i = 0; i < 100; i++) {
+            const quint64 id = 10 + i * 7;
+            db.put("fir" + QByteArray::number(i), {id, id + 1, 2000});
+            result << id << id + 1;
+        }
+        result << 2000;
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+
+        PostingIterator* it = db.prefixIter("fir");
+        QVERIFY(it);
+        QCOMPARE(it->cost(), static_cast<quint64>(result.size()));
+
+        for (quint64 val : qAsConst(result)) {
+            QCOMPARE(it->next(), val);
+        }
+        QCOMPARE(it->next(), static_cast<quint64>(0));
+        delete it;
+    }
+
+    void testIdRange() {
+        PostingDB db(PostingDB::create(m_txn), m_txn);
+
+        QVector<quint64> result;
+        for (int i = 0; i < 100; i++) {
+            const quint64 id = 10 + i * 7;
+            db.put("fir" + QByteArray::number(i), {id, id + 1, 2000});
+            if (id >= 100 && id <= 300) {
+                result << id;
+            }
+            if (id + 1 >= 100 && id + 1 <= 300) {
+                result << id + 1;
+            }
+        }
+        std::sort(result.begin(), result.end());
+
+        db.setIdRange(100, 300);
+        QCOMPARE(db.get("fir20"), PostingList({150, 151}));
+        QVERIFY(db.get("fir0").isEmpty());
+
+        PostingIterator* it = db.prefixIter("fir");
+        QVERIFY(it);
+        QCOMPARE(it->cost(), static_cast<quint64>(result.size()));
+        for (quint64 val : qAsConst(result)) {
+            QCOMPARE(it->next(), val);
+        }
+        QCOMPARE(it->next(), static_cast<quint64>(0));
+        delete it;
+
+        it = db.iter("fir0");
+        QVERIFY(it);
+        QCOMPARE(it->next(), static_cast<quint64>(0));
+        delete it;
+    }
+
+    void testDocumentCount() {
+        PostingDB db(PostingDB::create(m_txn), m_txn);
+
+        db.put("abc", {1, 4, 5, 9, 11});
+        db.put("fir", {1, 3, 5});
+        db.put("fire", {1, 8, 9});
+        db.put("fore", {2, 3, 5});
+
+        QCOMPARE(db.documentCount("abc"), static_cast<quint64>(5));
+        QCOMPARE(db.documentCount("fi"), static_cast<quint64>(0));
+        QCOMPARE(db.prefixDocumentCount("fi"), static_cast<quint64>(6));
+        QCOMPARE(db.prefixDocumentCount("g"), static_cast<quint64>(0));
+    }
+
     void testRegExpIter() {
         PostingDB db(PostingDB::create(m_txn), m_txn);
 
@@ -96,6 +195,109 @@ private Q_SLOTS:
         QVERIFY(it == nullptr);
     }
 
+    void testRegExpIterLiterals() {
+        PostingDB db(PostingDB::create(m_txn), m_txn);
+
+        db.put("Fbarn", {1, 4});
+        db.put("Ffoobar", {2, 3});
+        db.put("Ffoxbar", {5});
+        db.put("Fsnafoo", {6});
+        db.put("foobar", {7});
+
+        auto ids = [](PostingIterator* it) {
+            QVector<quint64> result;
+            if (it) {
+                while (it->next()) {
+                    result << it->docId();
+                }
+                delete it;
+            }
+            return result;
+        };
+
+        // Anchored, only the terms starting with "Ffoo" are read
+        QCOMPARE(ids(db.regexpIter(QRegularExpression(QStringLiteral("^foo.*r$")), QByteArray("F"))),
+                 (QVector<quint64>{2, 3}));
+        QCOMPARE(ids(db.regexpIter(QRegularExpression(QStringLiteral("fo+")), QByteArray("F"))),
+                 (QVector<quint64>{2, 3, 5, 6}));
+        QCOMPARE(ids(db.regexpIter(QRegularExpression(QStringLiteral("^fox?o")), QByteArray("F"))),
+                 (QVector<quint64>{2, 3}));
+
+        // The terms lacking "oob" are rejected before the expression runs
+        QCOMPARE(ids(db.regexpIter(QRegularExpression(QStringLiteral("oob")), QByteArray("F"))),
+                 (QVector<quint64>{2, 3}));
+
+        QCOMPARE(ids(db.regexpIter(QRegularExpression(QStringLiteral("ba.n?$")), QByteArray("F"))),
+                 (QVector<quint64>{1, 2, 3, 4, 5}));
+        QCOMPARE(ids(db.regexpIter(QRegularExpression(QStringLiteral("afo")), QByteArray("F"))),
+                 QVector<quint64>{6});
+        QCOMPARE(ids(db.regexpIter(QRegularExpression(QStringLiteral("o{2}")), QByteArray("F"))),
+                 (QVector<quint64>{2, 3, 6}));
+        QVERIFY(!db.regexpIter(QRegularExpression(QStringLiteral("xyz")), QByteArray("F")));
+    }
+
+    void testFuzzyIter() {
+        PostingDB db(PostingDB::create(m_txn), m_txn);
+
+        db.put("Fhallo", {1});
+        db.put("Fhello", {2, 3});
+        db.put("Fhelo", {4});
+        db.put("Fhlelo", {5});
+        db.put("Fyellow", {6});
+        db.put("hello", {7});
+
+        auto ids = [](PostingIterator* it) {
+            QVector<quint64> result;
+            if (it) {
+                while (it->next()) {
+                    result << it->docId();
+                }
+                delete it;
+            }
+            return result;
+        };
+
+        QCOMPARE(ids(db.fuzzyIter("F", "hello", 1)), (QVector<quint64>{1, 2, 3, 4}));
+        QCOMPARE(ids(db.fuzzyIter("F", "hello", 2)), (QVector<quint64>{1, 2, 3, 4, 5, 6}));
+        QCOMPARE(ids(db.fuzzyIter("F", "helol", 1)), (QVector<quint64>{4}));
+        QCOMPARE(ids(db.fuzzyIter("", "hello", 0)), QVector<quint64>{7});
+        QVERIFY(!db.fuzzyIter("F", "world", 2));
+
+        QCOMPARE(db.fuzzyDocumentCount("F", "hello", 1), static_cast<quint64>(4));
+    }
+
+    void testFuzzyIterContent() {
+        PostingDB db(PostingDB::create(m_txn), m_txn);
+
+        db.put("Ccat", {1});
+        db.put("Fcat", {2});
+        db.put("Mtext/plain", {3});
+        db.put("TAcat", {4});
+        db.put("Mtext", {5});
+        db.put("cat", {6});
+        db.put("cart", {7});
+        db.put("text", {8});
+        db.put("2cat", {9});
+
+        auto ids = [](PostingIterator* it) {
+            QVector<quint64> result;
+            if (it) {
+                while (it->next()) {
+                    result << it->docId();
+                }
+                delete it;
+            }
+            return result;
+        };
+
+        // Only the words of the text are matched, not the property terms
+        QCOMPARE(ids(db.fuzzyIter("", "cat", 1)), (QVector<quint64>{6, 7, 9}));
+        QCOMPARE(ids(db.fuzzyIter("", "text", 1)), QVector<quint64>{8});
+        QCOMPARE(db.fuzzyDocumentCount("", "cat", 1), static_cast<quint64>(3));
+
+        QCOMPARE(ids(db.fuzzyIter("F", "cat", 1)), QVector<quint64>{2});
+    }
+
     void testCompIter() {
         PostingDB db(PostingDB::create(m_txn), m_txn);
 
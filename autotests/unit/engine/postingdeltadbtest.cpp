@@ -0,0 +1,134 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "postingdeltadb.h"
+#include "singledbtest.h"
+
+using namespace Baloo;
+
+class PostingDeltaDBTest : public SingleDBTest
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testAppendAndGet() {
+        PostingDeltaDB db(PostingDeltaDB::create(m_txn), m_txn);
+
+        db.append("fire", {{1, 5}, {}});
+        db.append("fire", {{7}, {1}});
+        db.append("fir", {{2}, {}});
+        db.append("fires", {{3}, {}});
+
+        QCOMPARE(db.count("fire"), 2);
+        QCOMPARE(db.count("fir"), 1);
+        QCOMPARE(db.count("water"), 0);
+        QCOMPARE(db.size(), 4u);
+
+        QVector<PostingDeltaDB::Delta> deltas = db.get("fire");
+        QCOMPARE(deltas.size(), 2);
+        QCOMPARE(deltas[0].added, PostingList({1, 5}));
+        QVERIFY(deltas[0].removed.isEmpty());
+        QCOMPARE(deltas[1].added, PostingList({7}));
+        QCOMPARE(deltas[1].removed, PostingList({1}));
+
+        QCOMPARE(db.fetchTerms(10), QVector<QByteArray>({"fir", "fire", "fires"}));
+        QCOMPARE(db.fetchTerms(2), QVector<QByteArray>({"fir", "fire"}));
+    }
+
+    void testDel() {
+        PostingDeltaDB db(PostingDeltaDB::create(m_txn), m_txn);
+
+        db.append("fire", {{1}, {}});
+        db.append("fire", {{2}, {}});
+        db.append("fires", {{3}, {}});
+
+        db.del("fire");
+        QCOMPARE(db.count("fire"), 0);
+        QCOMPARE(db.count("fires"), 1);
+
+        // The sequence starts over
+        db.append("fire", {{4}, {}});
+        QCOMPARE(db.get("fire").size(), 1);
+        QCOMPARE(db.get("fire").first().added, PostingList({4}));
+    }
+
+    void testApply() {
+        PostingList list = {1, 3, 5, 7};
+        PostingDeltaDB::apply(list, {{2, 5, 9}, {3, 7, 8}});
+        QCOMPARE(list, PostingList({1, 2, 5, 9}));
+
+        PostingDeltaDB::apply(list, {{}, {1, 2, 5, 9}});
+        QVERIFY(list.isEmpty());
+    }
+
+    void testSlice() {
+        const PostingDeltaDB::Delta delta = {{2, 5, 9}, {3, 7, 8}};
+        QCOMPARE(PostingDeltaDB::slice(delta, 3, 8), PostingDeltaDB::Delta({{5}, {3, 7, 8}}));
+        QCOMPARE(PostingDeltaDB::slice(delta, 10, 20), PostingDeltaDB::Delta());
+
+        const PostingDeltaDB::Delta positions = {{2, 5}, {3}, {{2, {1}}, {3, {}}, {5, {4, 6}}}};
+        QCOMPARE(PostingDeltaDB::slice(positions, 3, 8), PostingDeltaDB::Delta({{5}, {3}, {{3, {}}, {5, {4, 6}}}}));
+    }
+
+    void testPositions() {
+        PostingDeltaDB db(PostingDeltaDB::create(m_txn), m_txn);
+
+        const PostingDeltaDB::Delta delta = {{5}, {3}, {{1, {2, 4}}, {3, {}}, {5, {7}}}};
+        db.append("fire", delta);
+        QCOMPARE(db.get("fire"), QVector<PostingDeltaDB::Delta>({delta}));
+
+        // Positions are compared as well
+        PostingDeltaDB::Delta other = delta;
+        other.positions[0].positions = {2, 5};
+        QVERIFY(!(other == delta));
+    }
+
+    void testDecodeWithoutPositions() {
+        // The records written before deltas carried positions
+        const quint32 addedCount = 1;
+        const quint64 ids[] = {5, 3, 7};
+        QByteArray arr(reinterpret_cast<const char*>(&addedCount), sizeof(quint32));
+        arr.append(reinterpret_cast<const char*>(ids), sizeof(ids));
+
+        const PostingDeltaDB::Delta delta = {{5}, {3, 7}, {}};
+        QCOMPARE(PostingDeltaDB::decode(arr), delta);
+        QCOMPARE(PostingDeltaDB::encode(delta), arr);
+    }
+
+    void testApplyPositions() {
+        QVector<PositionInfo> list = {{1, {1}}, {3, {2}}, {5, {3}}};
+        PostingDeltaDB::applyPositions(list, {{2}, {3}, {{2, {4}}, {3, {}}, {5, {5, 6}}}});
+
+        const QVector<PositionInfo> expected = {{1, {1}}, {2, {4}}, {5, {5, 6}}};
+        QCOMPARE(list.size(), expected.size());
+        for (int i = 0; i < expected.size(); ++i) {
+            QCOMPARE(list[i].docId, expected[i].docId);
+            QCOMPARE(list[i].positions, expected[i].positions);
+        }
+
+        // Removals without positions leave the list alone
+        PostingDeltaDB::applyPositions(list, {{}, {1}, {}});
+        QCOMPARE(list.size(), expected.size());
+    }
+};
+
+QTEST_MAIN(PostingDeltaDBTest)
+
+#include "postingdeltadbtest.moc"
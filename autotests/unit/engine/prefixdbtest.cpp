@@ -0,0 +1,77 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "prefixdb.h"
+#include "singledbtest.h"
+
+#include <memory>
+
+using namespace Baloo;
+
+class PrefixDBTest : public SingleDBTest
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testPutAndGet() {
+        PrefixDB db(PrefixDB::create(m_txn), m_txn);
+
+        db.put("pro", {1, 5, 9});
+        QVERIFY(db.contains("pro"));
+        QVERIFY(!db.contains("prog"));
+        QCOMPARE(db.get("pro"), PostingList({1, 5, 9}));
+        QVERIFY(db.get("prog").isEmpty());
+
+        std::unique_ptr<PostingIterator> it(db.iter("pro"));
+        QVERIFY(it);
+        QCOMPARE(it->next(), static_cast<quint64>(1));
+        QCOMPARE(it->next(), static_cast<quint64>(5));
+        QCOMPARE(it->next(), static_cast<quint64>(9));
+        QCOMPARE(it->next(), static_cast<quint64>(0));
+        QVERIFY(!db.iter("prog"));
+
+        db.del("pro");
+        QVERIFY(!db.contains("pro"));
+    }
+
+    void testPrefixesOf() {
+        QCOMPARE(PrefixDB::prefixesOf("pr"), QVector<QByteArray>());
+        QCOMPARE(PrefixDB::prefixesOf("pro"), QVector<QByteArray>({"pro"}));
+        QCOMPARE(PrefixDB::prefixesOf("program"), QVector<QByteArray>({"pro", "prog", "progr"}));
+
+        // Multi-byte characters are not split
+        const QByteArray term = QStringLiteral("grüße").toUtf8();
+        QCOMPARE(PrefixDB::prefixesOf(term), QVector<QByteArray>({QStringLiteral("grü").toUtf8(),
+                                                                  QStringLiteral("grüß").toUtf8(),
+                                                                  term}));
+    }
+
+    void testIsIndexable() {
+        QVERIFY(!PrefixDB::isIndexable("pr"));
+        QVERIFY(PrefixDB::isIndexable("pro"));
+        QVERIFY(PrefixDB::isIndexable("progr"));
+        QVERIFY(!PrefixDB::isIndexable("progra"));
+        QVERIFY(PrefixDB::isIndexable(QStringLiteral("grüße").toUtf8()));
+    }
+};
+
+QTEST_MAIN(PrefixDBTest)
+
+#include "prefixdbtest.moc"
@@ -41,6 +41,7 @@ private Q_SLOTS:
     void testUnderscoreSplitting();
     void testAutoExpand();
     void testUnicodeLowering();
+    void testFuzzy();
 };
 
 void QueryParserTest::testSinglePrefixWord()
@@ -245,6 +246,43 @@ void QueryParserTest::testUnicodeLowering()
     QCOMPARE(query, expected);
 }
 
+void QueryParserTest::testFuzzy()
+{
+    QueryParser parser;
+
+    EngineQuery query = parser.parseQuery("Helo~", "F");
+    QCOMPARE(query, EngineQuery("F", "helo", 1, 1));
+
+    query = parser.parseQuery("helo~2 wrld~ the");
+    {
+        QVector<EngineQuery> queries;
+        queries << EngineQuery("", "helo", 2, 1);
+        queries << EngineQuery("", "wrld", 1, 2);
+        queries << EngineQuery("the", EngineQuery::StartsWith, 3);
+
+        EngineQuery q(queries, EngineQuery::And);
+        QCOMPARE(query, q);
+    }
+
+    // A single character is not made fuzzy
+    query = parser.parseQuery("a~");
+    QCOMPARE(query, EngineQuery("a", 1));
+
+    query = parser.parseQuery("ab~2");
+    QCOMPARE(query, EngineQuery("", "ab", 1, 1));
+
+    // Not followed by a space, it still joins words
+    query = parser.parseQuery("foo~bar");
+    {
+        QVector<EngineQuery> queries;
+        queries << EngineQuery("foo", 1);
+        queries << EngineQuery("bar", 2);
+
+        EngineQuery q(queries, EngineQuery::Phrase);
+        QCOMPARE(query, q);
+    }
+}
+
 QTEST_MAIN(QueryParserTest)
 
 #include "queryparsertest.moc"
@@ -0,0 +1,82 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "rangepostingiterator.h"
+#include "vectorpostingiterator.h"
+
+#include <QTest>
+
+using namespace Baloo;
+
+class RangePostingIteratorTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void test();
+    void testEmptyRange();
+    void testSkipTo();
+};
+
+void RangePostingIteratorTest::test()
+{
+    QVector<quint64> l = {1, 3, 5, 7, 9, 11};
+
+    RangePostingIterator it(new VectorPostingIterator(l), 4, 9);
+    QCOMPARE(it.docId(), static_cast<quint64>(0));
+
+    QVector<quint64> result = {5, 7, 9};
+    for (quint64 val : result) {
+        QCOMPARE(it.next(), static_cast<quint64>(val));
+        QCOMPARE(it.docId(), static_cast<quint64>(val));
+    }
+    QCOMPARE(it.next(), static_cast<quint64>(0));
+    QCOMPARE(it.docId(), static_cast<quint64>(0));
+    QCOMPARE(it.next(), static_cast<quint64>(0));
+}
+
+void RangePostingIteratorTest::testEmptyRange()
+{
+    QVector<quint64> l = {1, 3, 9};
+
+    RangePostingIterator it(new VectorPostingIterator(l), 4, 8);
+    QCOMPARE(it.next(), static_cast<quint64>(0));
+    QCOMPARE(it.docId(), static_cast<quint64>(0));
+
+    RangePostingIterator after(new VectorPostingIterator(l), 10, 20);
+    QCOMPARE(after.next(), static_cast<quint64>(0));
+}
+
+void RangePostingIteratorTest::testSkipTo()
+{
+    QVector<quint64> l = {1, 3, 5, 7, 9, 11};
+
+    RangePostingIterator it(new VectorPostingIterator(l), 2, 9);
+    QCOMPARE(it.skipTo(1), static_cast<quint64>(3));
+    QCOMPARE(it.skipTo(3), static_cast<quint64>(3));
+    QCOMPARE(it.skipTo(6), static_cast<quint64>(7));
+    QCOMPARE(it.next(), static_cast<quint64>(9));
+    QCOMPARE(it.skipTo(10), static_cast<quint64>(0));
+    QCOMPARE(it.docId(), static_cast<quint64>(0));
+}
+
+QTEST_MAIN(RangePostingIteratorTest)
+
+#include "rangepostingiteratortest.moc"
@@ -0,0 +1,97 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "regexpliterals.h"
+
+#include <QTest>
+
+using namespace Baloo;
+
+class RegExpLiteralsTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void test_data();
+    void test();
+    void testMayMatch();
+};
+
+void RegExpLiteralsTest::test_data()
+{
+    QTest::addColumn<QString>("pattern");
+    QTest::addColumn<QByteArray>("prefix");
+    QTest::addColumn<QVector<QByteArray>>("required");
+
+    QTest::newRow("literal") << QStringLiteral("foo") << QByteArray() << QVector<QByteArray>{"foo"};
+    QTest::newRow("anchored") << QStringLiteral("^foo.*bar$") << QByteArray("foo") << QVector<QByteArray>{"foo", "bar"};
+    QTest::newRow("\\A") << QStringLiteral("\\Afoo") << QByteArray("foo") << QVector<QByteArray>{"foo"};
+    QTest::newRow("optional") << QStringLiteral("^abc?d") << QByteArray("ab") << QVector<QByteArray>{"ab", "d"};
+    QTest::newRow("star") << QStringLiteral("ab*c") << QByteArray() << QVector<QByteArray>{"a", "c"};
+    QTest::newRow("plus") << QStringLiteral("^ab+c") << QByteArray("ab") << QVector<QByteArray>{"ab", "c"};
+    QTest::newRow("count") << QStringLiteral("ab{2,3}c") << QByteArray() << QVector<QByteArray>{"ab", "c"};
+    QTest::newRow("zero count") << QStringLiteral("ab{0,3}c") << QByteArray() << QVector<QByteArray>{"a", "c"};
+    QTest::newRow("escaped") << QStringLiteral("a\\.b\\d") << QByteArray() << QVector<QByteArray>{"a.b"};
+    QTest::newRow("class") << QStringLiteral("ab[]c]d") << QByteArray() << QVector<QByteArray>{"ab", "d"};
+    QTest::newRow("group") << QStringLiteral("^x(a[)]b)?yz") << QByteArray("x") << QVector<QByteArray>{"x", "yz"};
+    QTest::newRow("unicode") << QStringLiteral("grüße") << QByteArray() << QVector<QByteArray>{QStringLiteral("grüße").toUtf8()};
+    QTest::newRow("alternative") << QStringLiteral("foo|bar") << QByteArray() << QVector<QByteArray>();
+    QTest::newRow("lookahead") << QStringLiteral("foo(?!bar)") << QByteArray() << QVector<QByteArray>();
+    QTest::newRow("inline option") << QStringLiteral("(?i)foo") << QByteArray() << QVector<QByteArray>();
+    QTest::newRow("hex escape") << QStringLiteral("ab\\x41cd") << QByteArray() << QVector<QByteArray>();
+    QTest::newRow("hex escape braces") << QStringLiteral("ab\\x{41}cd") << QByteArray() << QVector<QByteArray>();
+    QTest::newRow("control escape") << QStringLiteral("ab\\cAcd") << QByteArray() << QVector<QByteArray>();
+    QTest::newRow("octal escape") << QStringLiteral("ab\\012cd") << QByteArray() << QVector<QByteArray>();
+    QTest::newRow("nul escape") << QStringLiteral("ab\\0cd") << QByteArray() << QVector<QByteArray>();
+    QTest::newRow("octal braces") << QStringLiteral("ab\\o{101}cd") << QByteArray() << QVector<QByteArray>();
+    QTest::newRow("back reference") << QStringLiteral("(a)b\\1cd") << QByteArray() << QVector<QByteArray>();
+    QTest::newRow("named character") << QStringLiteral("ab\\N{U+41}cd") << QByteArray() << QVector<QByteArray>();
+    QTest::newRow("property") << QStringLiteral("ab\\pLcd") << QByteArray() << QVector<QByteArray>();
+    QTest::newRow("negated property") << QStringLiteral("ab\\P{Lu}cd") << QByteArray() << QVector<QByteArray>();
+    QTest::newRow("quoted") << QStringLiteral("ab\\Qc.d\\E") << QByteArray() << QVector<QByteArray>();
+    QTest::newRow("dangling quantifier") << QStringLiteral("*foo") << QByteArray() << QVector<QByteArray>();
+}
+
+void RegExpLiteralsTest::test()
+{
+    QFETCH(QString, pattern);
+    QFETCH(QByteArray, prefix);
+    QFETCH(QVector<QByteArray>, required);
+
+    const RegExpLiterals literals{QRegularExpression(pattern)};
+    QCOMPARE(literals.prefix(), prefix);
+    QCOMPARE(literals.required(), required);
+}
+
+void RegExpLiteralsTest::testMayMatch()
+{
+    const RegExpLiterals literals{QRegularExpression(QStringLiteral("foo.*bar"))};
+    QVERIFY(literals.mayMatch("xfooybarz"));
+    QVERIFY(!literals.mayMatch("xfooy"));
+
+    // Case insensitive matching is not looked into
+    const RegExpLiterals insensitive{QRegularExpression(QStringLiteral("foo"), QRegularExpression::CaseInsensitiveOption)};
+    QVERIFY(insensitive.required().isEmpty());
+    QVERIFY(insensitive.mayMatch("FOO"));
+}
+
+QTEST_MAIN(RegExpLiteralsTest)
+
+#include "regexpliteralstest.moc"
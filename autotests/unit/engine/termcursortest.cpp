@@ -0,0 +1,76 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "termcursor.h"
+#include "postingdb.h"
+#include "singledbtest.h"
+
+using namespace Baloo;
+
+class TermCursorTest : public SingleDBTest
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testSeek() {
+        MDB_dbi dbi = PostingDB::create(m_txn);
+        PostingDB db(dbi, m_txn);
+        db.put("abc", {1, 2});
+        db.put("fire", {3});
+
+        TermCursor cursor(dbi, m_txn);
+        QCOMPARE(cursor.seek("abc").size(), 2 * static_cast<int>(sizeof(quint64)));
+        QVERIFY(cursor.seek("abd").isEmpty());
+        QCOMPARE(cursor.seek("fire").size(), static_cast<int>(sizeof(quint64)));
+    }
+
+    void testPutAndDel() {
+        MDB_dbi dbi = PostingDB::create(m_txn);
+        PostingDB db(dbi, m_txn);
+        db.put("abc", {1, 2});
+        db.put("fire", {3});
+        db.put("water", {4});
+
+        const PostingList same = {5, 6};
+        const PostingList bigger = {7, 8, 9};
+        const PostingList added = {10};
+
+        {
+            TermCursor cursor(dbi, m_txn);
+            cursor.seek("abc");
+            cursor.put(QByteArray(reinterpret_cast<const char*>(same.constData()), 2 * sizeof(quint64)));
+            cursor.seek("fire");
+            cursor.put(QByteArray(reinterpret_cast<const char*>(bigger.constData()), 3 * sizeof(quint64)));
+            cursor.seek("ice");
+            cursor.put(QByteArray(reinterpret_cast<const char*>(added.constData()), sizeof(quint64)));
+            cursor.seek("water");
+            cursor.del();
+            cursor.seek("zebra");
+            cursor.del();
+        }
+
+        QMap<QByteArray, PostingList> map = {{"abc", same}, {"fire", bigger}, {"ice", added}};
+        QCOMPARE(db.toTestMap(), map);
+    }
+};
+
+QTEST_MAIN(TermCursorTest)
+
+#include "termcursortest.moc"
@@ -43,6 +43,7 @@ private Q_SLOTS:
     }
 
     void testTimeInfo();
+    void testCommitStats();
 private:
     QTemporaryDir* dir;
     Database* db;
@@ -87,6 +88,37 @@ void TransactionTest::testTimeInfo()
     QCOMPARE(tr2.documentTimeInfo(id), timeInfo);
 }
 
+void TransactionTest::testCommitStats()
+{
+    Transaction tr(db, Transaction::ReadWrite);
+
+    const QByteArray url(dir->path().toUtf8() + "/file");
+    quint64 id = touchFile(url);
+
+    Document doc;
+    doc.setId(id);
+    doc.setUrl(url);
+    doc.addTerm("a");
+    doc.addPositionTerm("power", 1);
+    doc.addFileNameTerm("link");
+    doc.setMTime(1);
+    doc.setCTime(2);
+
+    tr.addDocument(doc);
+    tr.commit();
+
+    const CommitStats stats = tr.commitStats();
+    QCOMPARE(stats.value(CommitStats::Terms), static_cast<qint64>(3));
+    QCOMPARE(stats.value(CommitStats::PostingBytesRead), static_cast<qint64>(0));
+    QVERIFY(stats.value(CommitStats::PostingBytesWritten) > 0);
+    QVERIFY(stats.value(CommitStats::PositionBytesWritten) > 0);
+
+    const CommitStats copy = CommitStats::fromByteArray(stats.toByteArray());
+    for (int m = 0; m < CommitStats::MetricCount; m++) {
+        const auto metric = static_cast<CommitStats::Metric>(m);
+        QCOMPARE(copy.value(metric), stats.value(metric));
+    }
+}
 
 QTEST_MAIN(TransactionTest)
 
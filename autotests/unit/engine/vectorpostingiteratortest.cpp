@@ -0,0 +1,153 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "vectorpostingiterator.h"
+#include "vectorpositioninfoiterator.h"
+#include "gallopsearch.h"
+
+#include <QTest>
+
+using namespace Baloo;
+
+namespace {
+// Only moves with next(), so skipTo is the one of PostingIterator
+class StepPostingIterator : public PostingIterator
+{
+public:
+    explicit StepPostingIterator(const QVector<quint64>& values)
+        : m_it(values)
+    {
+    }
+
+    quint64 next() override {
+        return m_it.next();
+    }
+    quint64 docId() const override {
+        return m_it.docId();
+    }
+
+private:
+    VectorPostingIterator m_it;
+};
+}
+
+class VectorPostingIteratorTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testGallopSearch_data();
+    void testGallopSearch();
+    void testSkipTo();
+    void testSkipToBeforeNext();
+    void testDefaultSkipTo();
+    void testPositionInfoSkipTo();
+};
+
+void VectorPostingIteratorTest::testGallopSearch_data()
+{
+    QTest::addColumn<int>("pos");
+    QTest::addColumn<quint64>("id");
+    QTest::addColumn<int>("expected");
+
+    // The values are 2, 4, .., 200
+    QTest::newRow("current") << 0 << quint64(2) << 0;
+    QTest::newRow("before current") << 10 << quint64(1) << 10;
+    QTest::newRow("next") << 0 << quint64(4) << 1;
+    QTest::newRow("between") << 0 << quint64(51) << 25;
+    QTest::newRow("far") << 3 << quint64(199) << 99;
+    QTest::newRow("last") << 0 << quint64(200) << 99;
+    QTest::newRow("past the end") << 0 << quint64(201) << 100;
+    QTest::newRow("at the end") << 100 << quint64(5) << 100;
+}
+
+void VectorPostingIteratorTest::testGallopSearch()
+{
+    QFETCH(int, pos);
+    QFETCH(quint64, id);
+    QFETCH(int, expected);
+
+    QVector<quint64> values;
+    for (quint64 i = 1; i <= 100; i++) {
+        values << i * 2;
+    }
+
+    QCOMPARE(gallopSearch(values, pos, id), expected);
+
+    // Must match a plain linear search
+    int linear = pos;
+    while (linear < values.size() && values[linear] < id) {
+        linear++;
+    }
+    QCOMPARE(expected, linear);
+}
+
+void VectorPostingIteratorTest::testSkipTo()
+{
+    VectorPostingIterator it({1, 3, 5, 7, 9, 11, 13, 15});
+
+    QCOMPARE(it.next(), static_cast<quint64>(1));
+    QCOMPARE(it.skipTo(1), static_cast<quint64>(1));
+    QCOMPARE(it.skipTo(6), static_cast<quint64>(7));
+    QCOMPARE(it.docId(), static_cast<quint64>(7));
+    QCOMPARE(it.next(), static_cast<quint64>(9));
+    QCOMPARE(it.skipTo(15), static_cast<quint64>(15));
+    QCOMPARE(it.skipTo(16), static_cast<quint64>(0));
+    QCOMPARE(it.docId(), static_cast<quint64>(0));
+    QCOMPARE(it.next(), static_cast<quint64>(0));
+}
+
+void VectorPostingIteratorTest::testSkipToBeforeNext()
+{
+    VectorPostingIterator it({4, 8});
+    QCOMPARE(it.skipTo(2), static_cast<quint64>(4));
+    QCOMPARE(it.next(), static_cast<quint64>(8));
+}
+
+void VectorPostingIteratorTest::testDefaultSkipTo()
+{
+    StepPostingIterator it({4, 8, 12});
+    QCOMPARE(it.skipTo(2), static_cast<quint64>(4));
+    QCOMPARE(it.skipTo(5), static_cast<quint64>(8));
+    QCOMPARE(it.next(), static_cast<quint64>(12));
+    QCOMPARE(it.skipTo(13), static_cast<quint64>(0));
+    QCOMPARE(it.skipTo(1), static_cast<quint64>(0));
+}
+
+void VectorPostingIteratorTest::testPositionInfoSkipTo()
+{
+    QVector<PositionInfo> vec;
+    for (quint64 id = 10; id <= 100; id += 10) {
+        PositionInfo info(id, {static_cast<uint>(id)});
+        vec << info;
+    }
+
+    VectorPositionInfoIterator it(vec);
+    QCOMPARE(it.next(), static_cast<quint64>(10));
+    QCOMPARE(it.skipTo(55), static_cast<quint64>(60));
+    QCOMPARE(it.positions(), QVector<uint>({60}));
+    QCOMPARE(it.skipTo(100), static_cast<quint64>(100));
+    QCOMPARE(it.skipTo(101), static_cast<quint64>(0));
+    QCOMPARE(it.positions(), QVector<uint>());
+}
+
+QTEST_MAIN(VectorPostingIteratorTest)
+
+#include "vectorpostingiteratortest.moc"
@@ -0,0 +1,91 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "commitstatistics.h"
+
+#include <QTest>
+
+using namespace Baloo;
+
+class CommitStatisticsTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testBucket();
+    void testHistograms();
+    void testWindow();
+};
+
+void CommitStatisticsTest::testBucket()
+{
+    QCOMPARE(CommitStatistics::bucket(0), 0);
+    QCOMPARE(CommitStatistics::bucket(1), 1);
+    QCOMPARE(CommitStatistics::bucket(2), 2);
+    QCOMPARE(CommitStatistics::bucket(3), 2);
+    QCOMPARE(CommitStatistics::bucket(4), 3);
+    QCOMPARE(CommitStatistics::bucket(1023), 10);
+    QCOMPARE(CommitStatistics::bucket(1024), 11);
+}
+
+void CommitStatisticsTest::testHistograms()
+{
+    CommitStatistics statistics;
+    QVERIFY(statistics.histograms().isEmpty());
+
+    CommitStats fast;
+    fast.add(CommitStats::CommitTime, 3);
+    CommitStats slow;
+    slow.add(CommitStats::CommitTime, 30 * 1000 * 1000);
+
+    statistics.record(QStringLiteral("indexer"), fast);
+    statistics.record(QStringLiteral("indexer"), fast);
+    statistics.record(QStringLiteral("indexer"), slow);
+    statistics.record(QStringLiteral("extractor"), slow);
+
+    const QVariantMap histograms = statistics.histograms();
+    QCOMPARE(histograms.size(), 2 * CommitStats::MetricCount);
+
+    const QList<uint> commitTime = histograms.value(QStringLiteral("indexer/commitTime")).value<QList<uint>>();
+    QCOMPARE(commitTime.size(), CommitStatistics::bucket(30 * 1000 * 1000) + 1);
+    QCOMPARE(commitTime[2], 2u);
+    QCOMPARE(commitTime.last(), 1u);
+
+    const QList<uint> terms = histograms.value(QStringLiteral("extractor/terms")).value<QList<uint>>();
+    QCOMPARE(terms, QList<uint>({1}));
+}
+
+void CommitStatisticsTest::testWindow()
+{
+    CommitStatistics statistics;
+    statistics.setWindowSize(2);
+
+    CommitStats stats;
+    for (int i = 0; i < 5; i++) {
+        statistics.record(QStringLiteral("indexer"), stats);
+    }
+
+    const QList<uint> terms = statistics.histograms().value(QStringLiteral("indexer/terms")).value<QList<uint>>();
+    QCOMPARE(terms, QList<uint>({2}));
+}
+
+QTEST_MAIN(CommitStatisticsTest)
+
+#include "commitstatisticstest.moc"
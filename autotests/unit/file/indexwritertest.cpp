@@ -0,0 +1,205 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "indexwriter.h"
+
+#include "database.h"
+#include "transaction.h"
+#include "document.h"
+#include "idutils.h"
+
+#include <QAtomicInt>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QThread>
+
+using namespace Baloo;
+
+namespace {
+
+class Producer : public QThread
+{
+public:
+    Producer(IndexWriter* writer, const QVector<Document>& docs)
+        : m_writer(writer)
+        , m_docs(docs)
+    {}
+
+    void run() override {
+        for (const Document& doc : qAsConst(m_docs)) {
+            m_writer->submit([doc](Transaction& tr) {
+                tr.addDocument(doc);
+            });
+        }
+    }
+
+private:
+    IndexWriter* m_writer;
+    QVector<Document> m_docs;
+};
+
+}
+
+class IndexWriterTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init() {
+        m_dir = new QTemporaryDir();
+        m_db = new Database(m_dir->path());
+        m_db->open(Database::CreateDatabase);
+    }
+
+    void cleanup() {
+        delete m_db;
+        delete m_dir;
+    }
+
+    void testParallelProducers();
+    void testBatchSize();
+    void testFinish();
+
+private:
+    Document createDocument(const QString& fileName);
+
+    QTemporaryDir* m_dir;
+    Database* m_db;
+};
+
+Document IndexWriterTest::createDocument(const QString& fileName)
+{
+    const QString path = m_dir->path() + QLatin1Char('/') + fileName;
+    QFile file(path);
+    file.open(QIODevice::WriteOnly);
+    file.write("data");
+    file.close();
+
+    const QByteArray url = QFile::encodeName(path);
+
+    Document doc;
+    doc.setId(filePathToId(url));
+    doc.setUrl(url);
+    doc.addTerm("data");
+    doc.addFileNameTerm(fileName.toUtf8());
+    doc.setMTime(1);
+    doc.setCTime(2);
+    return doc;
+}
+
+void IndexWriterTest::testParallelProducers()
+{
+    IndexWriter writer(m_db);
+    // Only waitForCommitted ends the group
+    writer.setMaxLatency(60 * 1000);
+
+    QAtomicInt committed;
+    connect(&writer, &IndexWriter::committed, this, [&committed](int mutations) {
+        committed.fetchAndAddOrdered(mutations);
+    }, Qt::DirectConnection);
+
+    QVector<Document> allDocs;
+    QVector<Producer*> producers;
+    for (int i = 0; i < 4; i++) {
+        QVector<Document> docs;
+        for (int j = 0; j < 10; j++) {
+            docs << createDocument(QStringLiteral("file%1_%2").arg(i).arg(j));
+        }
+        allDocs << docs;
+        producers << new Producer(&writer, docs);
+    }
+
+    for (Producer* producer : qAsConst(producers)) {
+        producer->start();
+    }
+    for (Producer* producer : qAsConst(producers)) {
+        producer->wait();
+        delete producer;
+    }
+
+    writer.waitForCommitted();
+    QCOMPARE(committed.load(), allDocs.size());
+
+    Transaction tr(m_db, Transaction::ReadOnly);
+    for (const Document& doc : qAsConst(allDocs)) {
+        QVERIFY(tr.hasDocument(doc.id()));
+    }
+}
+
+void IndexWriterTest::testBatchSize()
+{
+    IndexWriter writer(m_db);
+    writer.setMaxBatchSize(5);
+    writer.setMaxLatency(60 * 1000);
+
+    QAtomicInt groups;
+    QAtomicInt largestGroup;
+    connect(&writer, &IndexWriter::committed, this, [&groups, &largestGroup](int mutations) {
+        groups.fetchAndAddOrdered(1);
+        if (mutations > largestGroup.load()) {
+            largestGroup.store(mutations);
+        }
+    }, Qt::DirectConnection);
+
+    QAtomicInt applied;
+    for (int i = 0; i < 10; i++) {
+        writer.submit([&applied](Transaction&) {
+            applied.fetchAndAddOrdered(1);
+        });
+    }
+
+    writer.waitForCommitted();
+    QCOMPARE(applied.load(), 10);
+    QVERIFY(groups.load() >= 2);
+    QVERIFY(largestGroup.load() <= 5);
+}
+
+void IndexWriterTest::testFinish()
+{
+    const Document doc = createDocument(QStringLiteral("file"));
+
+    IndexWriter writer(m_db);
+    writer.setMaxLatency(60 * 1000);
+    writer.submit([doc](Transaction& tr) {
+        tr.addDocument(doc);
+    });
+
+    // Whatever is queued is committed before the thread stops
+    writer.finish();
+    QVERIFY(writer.isFinished());
+    {
+        Transaction tr(m_db, Transaction::ReadOnly);
+        QVERIFY(tr.hasDocument(doc.id()));
+    }
+
+    bool applied = false;
+    QTest::ignoreMessage(QtWarningMsg, "IndexWriter: dropping a mutation submitted after finish");
+    writer.submit([&applied](Transaction&) {
+        applied = true;
+    });
+    writer.waitForCommitted();
+    QVERIFY(!applied);
+    QVERIFY(writer.isFinished());
+}
+
+QTEST_MAIN(IndexWriterTest)
+
+#include "indexwritertest.moc"
@@ -33,6 +33,7 @@ private Q_SLOTS:
     void testSimpleProperty();
     void testSimpleString();
     void testStringAndProperty();
+    void testFuzzyWords();
     void testLogicalOps();
     void testNesting();
     void testDateTime();
@@ -42,6 +43,9 @@ private Q_SLOTS:
     void testNestedParentheses_data();
     void testOptimizedLogic();
     void testOptimizedLogic_data();
+    void testNegation();
+    void testNegation_data();
+    void testNegationVariantMap();
 };
 
 void AdvancedQueryParserTest::testSimpleProperty()
@@ -75,6 +79,19 @@ void AdvancedQueryParserTest::testStringAndProperty()
     QCOMPARE(term, expectedTerm);
 }
 
+void AdvancedQueryParserTest::testFuzzyWords()
+{
+    // The markers are left for the engine to parse
+    AdvancedQueryParser parser;
+    Term term = parser.parse(QStringLiteral("colour~ filename:recipe~2"));
+    Term expectedTerm(Term::And);
+
+    expectedTerm.addSubTerm(Term(QLatin1String(""), QStringLiteral("colour~")));
+    expectedTerm.addSubTerm(Term(QStringLiteral("filename"), QStringLiteral("recipe~2")));
+
+    QCOMPARE(term, expectedTerm);
+}
+
 void AdvancedQueryParserTest::testLogicalOps()
 {
     // AND
@@ -335,6 +352,57 @@ void AdvancedQueryParserTest::testOptimizedLogic_data()
 
 }
 
+void AdvancedQueryParserTest::testNegation()
+{
+    QFETCH(QString, searchInput);
+    QFETCH(Term, expectedTerm);
+
+    AdvancedQueryParser parser;
+    QCOMPARE(parser.parse(searchInput), expectedTerm);
+}
+
+void AdvancedQueryParserTest::testNegation_data()
+{
+    QTest::addColumn<QString>("searchInput");
+    QTest::addColumn<Term>("expectedTerm");
+
+    const Term a{QString(), QStringLiteral("a"), Term::Contains};
+    const Term b{QString(), QStringLiteral("b"), Term::Contains};
+    const Term c{QString(), QStringLiteral("c"), Term::Contains};
+
+    QTest::newRow("a NOT b")
+        << QStringLiteral("a NOT b")
+        << Term{Term::And, QList<Term>{a, !b}};
+    QTest::newRow("a -b")
+        << QStringLiteral("a -b")
+        << Term{Term::And, QList<Term>{a, !b}};
+    QTest::newRow("-title:foo")
+        << QStringLiteral("-title:foo")
+        << !Term{QStringLiteral("title"), QStringLiteral("foo"), Term::Contains};
+    QTest::newRow("a NOT (b OR c)")
+        << QStringLiteral("a NOT (b OR c)")
+        << Term{Term::And, QList<Term>{a, !Term{Term::Or, QList<Term>{b, c}}}};
+    QTest::newRow("-(a b) c")
+        << QStringLiteral("-(a b) c")
+        << Term{Term::And, QList<Term>{!Term{Term::And, QList<Term>{a, b}}, c}};
+    QTest::newRow("a \"-b\"")
+        << QStringLiteral("a \"-b\"")
+        << Term{Term::And, QList<Term>{a, Term{QString(), QStringLiteral("-b"), Term::Contains}}};
+    QTest::newRow("a \"NOT\" b")
+        << QStringLiteral("a \"NOT\" b")
+        << Term{Term::And, QList<Term>{a, Term{QString(), QStringLiteral("NOT"), Term::Contains}, b}};
+    QTest::newRow("-\"a b\"")
+        << QStringLiteral("-\"a b\"")
+        << !Term{QString(), QStringLiteral("a b"), Term::Contains};
+}
+
+void AdvancedQueryParserTest::testNegationVariantMap()
+{
+    AdvancedQueryParser parser;
+    const Term term = parser.parse(QStringLiteral("a -title:foo NOT (b OR c)"));
+    QCOMPARE(Term::fromVariantMap(term.toVariantMap()), term);
+}
+
 QTEST_MAIN(AdvancedQueryParserTest)
 
 #include "advancedqueryparsertest.moc"
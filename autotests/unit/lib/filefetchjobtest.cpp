@@ -19,6 +19,8 @@
  */
 
 #include "file.h"
+#include "query.h"
+#include "resultiterator.h"
 #include "document.h"
 #include "database.h"
 #include "transaction.h"
@@ -40,17 +42,48 @@ class FileFetchJobTest : public QObject
     Q_OBJECT
 
     QTemporaryDir dir;
+    QTemporaryFile resultFile1;
+    QTemporaryFile resultFile2;
 
 private Q_SLOTS:
+    void initTestCase();
     void test();
+    void testLoadWhileIterating();
 };
 
+void FileFetchJobTest::initTestCase()
+{
+    setenv("BALOO_DB_PATH", dir.path().toStdString().c_str(), 1);
+
+    resultFile1.open();
+    resultFile2.open();
+
+    KFileMetaData::PropertyMap map;
+    map.insert(KFileMetaData::Property::Title, QStringLiteral("iterated"));
+    const QByteArray json = QJsonDocument(QJsonObject::fromVariantMap(KFileMetaData::toVariantMap(map))).toJson();
+
+    // Written before the global database is opened by any test
+    Database db(fileIndexDbPath());
+    db.open(Database::CreateDatabase);
+
+    Transaction tr(db, Transaction::ReadWrite);
+    for (QTemporaryFile* file : {&resultFile1, &resultFile2}) {
+        Document doc;
+        doc.setUrl(file->fileName().toUtf8());
+        doc.setId(filePathToId(doc.url()));
+        doc.setData(json);
+        doc.addTerm("iterated");
+        doc.setMTime(1);
+        doc.setCTime(1);
+        tr.addDocument(doc);
+    }
+    tr.commit();
+}
+
 void FileFetchJobTest::test()
 {
     using namespace KFileMetaData;
 
-    setenv("BALOO_DB_PATH", dir.path().toStdString().c_str(), 1);
-
     PropertyMap map;
     map.insert(Property::Album, QLatin1String("value1"));
     map.insert(Property::Artist, QLatin1String("value2"));
@@ -88,6 +121,23 @@ void FileFetchJobTest::test()
     QCOMPARE(file.properties(), map);
 }
 
+void FileFetchJobTest::testLoadWhileIterating()
+{
+    Query query;
+    query.setSearchString(QStringLiteral("iterated"));
+
+    ResultIterator it = query.exec();
+    int count = 0;
+    while (it.next()) {
+        // Begins a read transaction while the query still has one open
+        File file(it.filePath());
+        QVERIFY(file.load());
+        QCOMPARE(file.property(KFileMetaData::Property::Title).toString(), QStringLiteral("iterated"));
+        count++;
+    }
+    QCOMPARE(count, 2);
+}
+
 QTEST_MAIN(FileFetchJobTest)
 
 #include "filefetchjobtest.moc"
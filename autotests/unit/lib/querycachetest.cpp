@@ -0,0 +1,168 @@
+/*
+ * This file is part of the KDE Baloo Project
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "querycache.h"
+#include "term.h"
+
+#include <QTest>
+
+using namespace Baloo;
+
+class QueryCacheTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testKey();
+    void testLookup();
+    void testRevalidate();
+    void testChangedBy();
+    void testMaxIds();
+};
+
+void QueryCacheTest::testKey()
+{
+    const Term a{QString(), QStringLiteral("a"), Term::Contains};
+    const Term b{QString(), QStringLiteral("b"), Term::Contains};
+    const Term c{QStringLiteral("Title"), QStringLiteral("c"), Term::Contains};
+
+    QCOMPARE(QueryCache::key(a && b), QueryCache::key(b && a));
+    QCOMPARE(QueryCache::key(a && (b && c)), QueryCache::key(Term{Term::And, QList<Term>{c, b, a}}));
+    QCOMPARE(QueryCache::key(a || a), QueryCache::key(a));
+    QCOMPARE(QueryCache::key(c), QueryCache::key(Term{QStringLiteral("title"), QStringLiteral("c"), Term::Contains}));
+
+    QVERIFY(QueryCache::key(a && b) != QueryCache::key(a || b));
+    QVERIFY(QueryCache::key(a && !b) != QueryCache::key(a && b));
+    QVERIFY(QueryCache::key(a && !(b && c)) != QueryCache::key(a && !b && c));
+    QVERIFY(QueryCache::key(Term{QString(), QStringLiteral("a"), Term::Equal}) != QueryCache::key(a));
+    QVERIFY(QueryCache::key(Term{QStringLiteral("rating"), 5, Term::Equal})
+            != QueryCache::key(Term{QStringLiteral("rating"), QStringLiteral("5"), Term::Equal}));
+}
+
+namespace {
+// Nothing is known about what has been committed
+bool unknownChanges(quint64, QVector<QByteArray>*, bool*)
+{
+    return false;
+}
+}
+
+void QueryCacheTest::testLookup()
+{
+    QueryCache cache;
+    const QVector<quint64> ids = {1, 5, 9};
+
+    QVector<quint64> result;
+    QVERIFY(!cache.lookup(QStringLiteral("q"), 3, unknownChanges, &result));
+
+    cache.insert(QStringLiteral("q"), 3, {}, ids);
+    QVERIFY(cache.lookup(QStringLiteral("q"), 3, unknownChanges, &result));
+    QCOMPARE(result, ids);
+
+    // Stored for a newer snapshot than the one looked up with
+    QVERIFY(!cache.lookup(QStringLiteral("q"), 2, unknownChanges, &result));
+    QVERIFY(cache.lookup(QStringLiteral("q"), 3, unknownChanges, &result));
+
+    // Something has been committed, and what is not known
+    QVERIFY(!cache.lookup(QStringLiteral("q"), 4, unknownChanges, &result));
+    QVERIFY(!cache.lookup(QStringLiteral("q"), 3, unknownChanges, &result));
+
+    cache.insert(QStringLiteral("empty"), 4, {}, QVector<quint64>());
+    QVERIFY(cache.lookup(QStringLiteral("empty"), 4, unknownChanges, &result));
+    QVERIFY(result.isEmpty());
+}
+
+void QueryCacheTest::testRevalidate()
+{
+    QueryCache cache;
+    QueryCache::Dependencies deps;
+    deps.terms = {"fire", "water"};
+    deps.prefixes = {"Fsum"};
+    cache.insert(QStringLiteral("q"), 3, deps, {1, 5, 9});
+
+    QVector<QByteArray> changedTerms;
+    bool documentsChanged = false;
+    QVector<quint64> sinceIds;
+    auto changesSince = [&](quint64 txnId, QVector<QByteArray>* terms, bool* documents) {
+        sinceIds << txnId;
+        *terms = changedTerms;
+        *documents = documentsChanged;
+        return true;
+    };
+
+    // Neither the terms nor the documents the query reads
+    changedTerms = {"Fsu", "earth", "wind"};
+    documentsChanged = true;
+    QVector<quint64> result;
+    QVERIFY(cache.lookup(QStringLiteral("q"), 5, changesSince, &result));
+    QCOMPARE(result, QVector<quint64>({1, 5, 9}));
+
+    // Only what is committed after the last check is looked at again
+    QVERIFY(cache.lookup(QStringLiteral("q"), 6, changesSince, &result));
+    QCOMPARE(sinceIds, QVector<quint64>({3, 5}));
+
+    changedTerms = {"Fsummer"};
+    QVERIFY(!cache.lookup(QStringLiteral("q"), 7, changesSince, &result));
+    QVERIFY(!cache.lookup(QStringLiteral("q"), 6, changesSince, &result));
+}
+
+void QueryCacheTest::testChangedBy()
+{
+    QueryCache::Dependencies deps;
+    deps.terms = {"fire", "water"};
+    deps.prefixes = {"Fsum", "X5-"};
+
+    QVERIFY(!deps.changedBy({}, true));
+    QVERIFY(!deps.changedBy({"Fsu", "X5", "earth", "fir", "fires"}, true));
+    QVERIFY(deps.changedBy({"earth", "water"}, false));
+    QVERIFY(deps.changedBy({"Fsum"}, false));
+    QVERIFY(deps.changedBy({"Fsummer", "fire"}, false));
+    QVERIFY(deps.changedBy({"X5-2", "Z"}, false));
+
+    deps.documents = true;
+    QVERIFY(deps.changedBy({}, true));
+    QVERIFY(!deps.changedBy({}, false));
+
+    // An empty prefix is a start of every term
+    QueryCache::Dependencies all;
+    all.prefixes = {QByteArray()};
+    QVERIFY(all.changedBy({"a"}, false));
+    QVERIFY(!all.changedBy({}, false));
+}
+
+void QueryCacheTest::testMaxIds()
+{
+    QueryCache cache;
+    cache.setMaxIds(5);
+    QCOMPARE(cache.maxIds(), 5);
+
+    QVector<quint64> result;
+    cache.insert(QStringLiteral("q1"), 1, {}, {1, 2, 3});
+    cache.insert(QStringLiteral("q2"), 1, {}, {4, 5, 6});
+    QVERIFY(!cache.lookup(QStringLiteral("q1"), 1, unknownChanges, &result));
+    QVERIFY(cache.lookup(QStringLiteral("q2"), 1, unknownChanges, &result));
+
+    // Too large to be kept at all
+    cache.insert(QStringLiteral("q3"), 1, {}, {1, 2, 3, 4, 5, 6});
+    QVERIFY(!cache.lookup(QStringLiteral("q3"), 1, unknownChanges, &result));
+}
+
+QTEST_MAIN(QueryCacheTest)
+
+#include "querycachetest.moc"
@@ -0,0 +1,73 @@
+/*
+ * This file is part of the KDE Baloo Project
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "queryplan.h"
+#include "vectorpostingiterator.h"
+
+#include <QTest>
+
+using namespace Baloo;
+
+class QueryPlanTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testCount();
+    void testToString();
+};
+
+void QueryPlanTest::testCount()
+{
+    QueryPlan plan(QStringLiteral("results"), 5);
+    QueryPlan* step = plan.addChild(QStringLiteral("index"), 3);
+    QCOMPARE(plan.children().size(), 1);
+    QCOMPARE(step->estimate(), static_cast<quint64>(3));
+    QCOMPARE(step->actual(), static_cast<qint64>(-1));
+
+    QScopedPointer<PostingIterator> it(step->count(new VectorPostingIterator({2, 4, 8, 9})));
+    QCOMPARE(step->actual(), static_cast<qint64>(0));
+    QCOMPARE(it->next(), static_cast<quint64>(2));
+    QCOMPARE(it->skipTo(8), static_cast<quint64>(8));
+    QCOMPARE(it->next(), static_cast<quint64>(9));
+    QCOMPARE(it->next(), static_cast<quint64>(0));
+    QCOMPARE(step->actual(), static_cast<qint64>(3));
+
+    // An empty step has been run, and produced nothing
+    QVERIFY(!plan.count(nullptr));
+    QCOMPARE(plan.actual(), static_cast<qint64>(0));
+}
+
+void QueryPlanTest::testToString()
+{
+    QueryPlan plan(QStringLiteral("results"), 2);
+    plan.addChild(QStringLiteral("AND"), 2)->addChild(QStringLiteral("folder /home"), 10);
+    QScopedPointer<PostingIterator> it(plan.count(new VectorPostingIterator({1})));
+    while (it->next()) {
+    }
+
+    const QString expected = QStringLiteral("results (estimated: 2, actual: 1)\n"
+                                            "  AND (estimated: 2, actual: not run)\n"
+                                            "    folder /home (estimated: 10, actual: not run)\n");
+    QCOMPARE(plan.toString(), expected);
+}
+
+QTEST_GUILESS_MAIN(QueryPlanTest)
+
+#include "queryplantest.moc"
@@ -20,6 +20,8 @@
 
 #include "postingcodec.h"
 
+#include <limits>
+
 using namespace Baloo;
 
 PostingCodec::PostingCodec()
@@ -42,3 +44,34 @@ QVector<quint64> PostingCodec::decode(const QByteArray& arr)
     memcpy(vec.data(), arr.constData(), arr.size());
     return vec;
 }
+
+QVector<quint64> PostingCodec::decode(const QByteArray& arr, quint64 first, quint64 last)
+{
+    const int count = arr.size() / sizeof(quint64);
+    auto idAt = [&arr](int pos) {
+        quint64 id;
+        memcpy(&id, arr.constData() + pos * sizeof(quint64), sizeof(quint64));
+        return id;
+    };
+    auto lowerBound = [&](int begin, quint64 id) {
+        int end = count;
+        while (begin < end) {
+            const int mid = begin + (end - begin) / 2;
+            if (idAt(mid) < id) {
+                begin = mid + 1;
+            } else {
+                end = mid;
+            }
+        }
+        return begin;
+    };
+
+    const int begin = lowerBound(0, first);
+    const int end = last == std::numeric_limits<quint64>::max() ? count : lowerBound(begin, last + 1);
+
+    QVector<quint64> vec;
+    vec.resize(end - begin);
+
+    memcpy(vec.data(), arr.constData() + begin * sizeof(quint64), vec.size() * sizeof(quint64));
+    return vec;
+}
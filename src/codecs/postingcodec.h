@@ -33,6 +33,12 @@ public:
 
     QByteArray encode(const QVector<quint64>& list);
     QVector<quint64> decode(const QByteArray& arr);
+
+    /**
+     * Only decodes the ids from \p first to \p last. The list is sorted,
+     * so the ids outside of the range are skipped without being copied.
+     */
+    QVector<quint64> decode(const QByteArray& arr, quint64 first, quint64 last);
 };
 
 }
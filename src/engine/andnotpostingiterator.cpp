@@ -0,0 +1,86 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "andnotpostingiterator.h"
+
+using namespace Baloo;
+
+AndNotPostingIterator::AndNotPostingIterator(PostingIterator* include, PostingIterator* exclude)
+    : m_include(include)
+    , m_exclude(exclude)
+    , m_docId(0)
+{
+    Q_ASSERT(include);
+}
+
+AndNotPostingIterator::~AndNotPostingIterator()
+{
+    delete m_include;
+    delete m_exclude;
+}
+
+quint64 AndNotPostingIterator::docId() const
+{
+    return m_docId;
+}
+
+quint64 AndNotPostingIterator::next()
+{
+    m_docId = filter(m_include->next());
+    return m_docId;
+}
+
+quint64 AndNotPostingIterator::skipTo(quint64 docId)
+{
+    if (m_docId && m_docId >= docId) {
+        return m_docId;
+    }
+
+    m_docId = filter(m_include->skipTo(docId));
+    return m_docId;
+}
+
+quint64 AndNotPostingIterator::cost() const
+{
+    return m_include->cost();
+}
+
+quint64 AndNotPostingIterator::filter(quint64 candidate)
+{
+    while (candidate && m_exclude) {
+        quint64 excluded = m_exclude->docId();
+        if (excluded < candidate) {
+            excluded = m_exclude->skipTo(candidate);
+        }
+
+        if (excluded == 0) {
+            // Nothing left to exclude
+            delete m_exclude;
+            m_exclude = nullptr;
+        } else if (excluded == candidate) {
+            candidate = m_include->next();
+        } else {
+            break;
+        }
+    }
+
+    return candidate;
+}
@@ -0,0 +1,59 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef BALOO_ANDNOTPOSTINGITERATOR_H
+#define BALOO_ANDNOTPOSTINGITERATOR_H
+
+#include "postingiterator.h"
+
+namespace Baloo {
+
+/**
+ * Iterates over the ids of one iterator which are not in another one.
+ * The excluded iterator is only ever skipped to the next candidate, so
+ * a long exclusion list is not walked id by id.
+ */
+class BALOO_ENGINE_EXPORT AndNotPostingIterator : public PostingIterator
+{
+public:
+    /**
+     * Takes ownership of both iterators. \p exclude may be a nullptr,
+     * in which case nothing is excluded.
+     */
+    AndNotPostingIterator(PostingIterator* include, PostingIterator* exclude);
+    ~AndNotPostingIterator() override;
+
+    quint64 next() override;
+    quint64 docId() const override;
+    quint64 skipTo(quint64 docId) override;
+    quint64 cost() const override;
+
+private:
+    quint64 filter(quint64 candidate);
+
+    PostingIterator* m_include;
+    PostingIterator* m_exclude;
+    quint64 m_docId;
+};
+
+}
+
+#endif // BALOO_ANDNOTPOSTINGITERATOR_H
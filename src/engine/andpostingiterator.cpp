@@ -20,6 +20,8 @@
 
 #include "andpostingiterator.h"
 
+#include <algorithm>
+
 using namespace Baloo;
 
 AndPostingIterator::AndPostingIterator(const QVector<PostingIterator*>& iterators)
@@ -30,6 +32,10 @@ AndPostingIterator::AndPostingIterator(const QVector<PostingIterator*>& iterator
         qDeleteAll(m_iterators);
         m_iterators.clear();
     }
+
+    std::stable_sort(m_iterators.begin(), m_iterators.end(), [](PostingIterator* lhs, PostingIterator* rhs) {
+        return lhs->cost() < rhs->cost();
+    });
 }
 
 AndPostingIterator::~AndPostingIterator()
@@ -42,6 +48,12 @@ quint64 AndPostingIterator::docId() const
     return m_docId;
 }
 
+quint64 AndPostingIterator::cost() const
+{
+    // The iterators are sorted
+    return m_iterators.isEmpty() ? 0 : m_iterators[0]->cost();
+}
+
 quint64 AndPostingIterator::next()
 {
     if (m_iterators.isEmpty()) {
@@ -49,26 +61,42 @@ quint64 AndPostingIterator::next()
         return 0;
     }
 
-    if (m_iterators[0]->next() == 0) {
+    m_docId = leapfrog(m_iterators[0]->next());
+    return m_docId;
+}
+
+quint64 AndPostingIterator::skipTo(quint64 docId)
+{
+    if (m_iterators.isEmpty()) {
         m_docId = 0;
         return 0;
     }
+    if (m_docId && m_docId >= docId) {
+        return m_docId;
+    }
 
-    m_docId = m_iterators[0]->docId();
-
-    for (int i = 1; i < m_iterators.size(); i++) {
-        PostingIterator* iter = m_iterators[i];
-        if (iter->docId() == 0 && iter->next() == 0) {
-            m_docId = 0;
-            return 0;
-        }
-
-        iter->skipTo(m_docId);
+    m_docId = leapfrog(m_iterators[0]->skipTo(docId));
+    return m_docId;
+}
 
-        if (m_docId != iter->docId()) {
-            return next();
+quint64 AndPostingIterator::leapfrog(quint64 candidate)
+{
+    // The first iterator is at the candidate. Go around the others, each
+    // skipping to the candidate, until all of them agree on it. Whenever
+    // one overshoots, its id becomes the new candidate.
+    const int size = m_iterators.size();
+    int agreeing = 1;
+    int i = 1 % size;
+    while (candidate && agreeing < size) {
+        const quint64 docId = m_iterators[i]->skipTo(candidate);
+        if (docId == candidate) {
+            agreeing++;
+        } else {
+            candidate = docId;
+            agreeing = 1;
         }
+        i = (i + 1) % size;
     }
 
-    return m_docId;
+    return candidate;
 }
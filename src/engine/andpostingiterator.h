@@ -26,6 +26,11 @@
 
 namespace Baloo {
 
+/**
+ * Intersects the iterators with a leapfrog join. The iterators are
+ * ordered by their cost, so the rarest one proposes the candidates and
+ * the others only skip to them.
+ */
 class BALOO_ENGINE_EXPORT AndPostingIterator : public PostingIterator
 {
 public:
@@ -34,8 +39,12 @@ public:
 
     quint64 next() override;
     quint64 docId() const override;
+    quint64 skipTo(quint64 docId) override;
+    quint64 cost() const override;
 
 private:
+    quint64 leapfrog(quint64 candidate);
+
     QVector<PostingIterator*> m_iterators;
     quint64 m_docId;
 };
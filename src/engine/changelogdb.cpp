@@ -0,0 +1,170 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "changelogdb.h"
+#include "doctermscodec.h"
+#include "enginedebug.h"
+
+using namespace Baloo;
+
+ChangeLogDB::ChangeLogDB(MDB_dbi dbi, MDB_txn* txn)
+    : m_txn(txn)
+    , m_dbi(dbi)
+{
+    Q_ASSERT(txn != nullptr);
+    Q_ASSERT(dbi != 0);
+}
+
+ChangeLogDB::~ChangeLogDB()
+{
+}
+
+MDB_dbi ChangeLogDB::create(MDB_txn* txn)
+{
+    MDB_dbi dbi = 0;
+    int rc = mdb_dbi_open(txn, "changelogdb", MDB_CREATE | MDB_INTEGERKEY, &dbi);
+    if (rc) {
+        qCWarning(ENGINE) << "ChangeLogDB::create" << mdb_strerror(rc);
+        return 0;
+    }
+
+    return dbi;
+}
+
+MDB_dbi ChangeLogDB::open(MDB_txn* txn)
+{
+    MDB_dbi dbi = 0;
+    int rc = mdb_dbi_open(txn, "changelogdb", MDB_INTEGERKEY, &dbi);
+    if (rc) {
+        // Databases created by older versions do not have it
+        qCDebug(ENGINE) << "ChangeLogDB::open" << mdb_strerror(rc);
+        return 0;
+    }
+
+    return dbi;
+}
+
+void ChangeLogDB::put(quint64 txnId, const Changes& changes)
+{
+    MDB_val key;
+    key.mv_size = sizeof(quint64);
+    key.mv_data = static_cast<void*>(&txnId);
+
+    const QByteArray arr = encode(changes);
+
+    MDB_val val;
+    val.mv_size = arr.size();
+    val.mv_data = static_cast<void*>(const_cast<char*>(arr.constData()));
+
+    int rc = mdb_put(m_txn, m_dbi, &key, &val, 0);
+    if (rc) {
+        qCWarning(ENGINE) << "ChangeLogDB::put" << txnId << mdb_strerror(rc);
+    }
+}
+
+bool ChangeLogDB::get(quint64 txnId, Changes* changes)
+{
+    MDB_val key;
+    key.mv_size = sizeof(quint64);
+    key.mv_data = static_cast<void*>(&txnId);
+
+    MDB_val val{0, nullptr};
+    int rc = mdb_get(m_txn, m_dbi, &key, &val);
+    if (rc) {
+        if (rc != MDB_NOTFOUND) {
+            qCDebug(ENGINE) << "ChangeLogDB::get" << txnId << mdb_strerror(rc);
+        }
+        return false;
+    }
+
+    *changes = decode(QByteArray::fromRawData(static_cast<char*>(val.mv_data), val.mv_size));
+    return true;
+}
+
+void ChangeLogDB::prune(quint64 txnId)
+{
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_dbi, &cursor);
+
+    MDB_val key = {0, nullptr};
+    int rc = mdb_cursor_get(cursor, &key, nullptr, MDB_FIRST);
+    while (rc == 0 && *static_cast<quint64*>(key.mv_data) < txnId) {
+        rc = mdb_cursor_del(cursor, 0);
+        if (rc) {
+            break;
+        }
+        rc = mdb_cursor_get(cursor, &key, nullptr, MDB_FIRST);
+    }
+    if (rc != 0 && rc != MDB_NOTFOUND) {
+        qCDebug(ENGINE) << "ChangeLogDB::prune" << txnId << mdb_strerror(rc);
+    }
+
+    mdb_cursor_close(cursor);
+}
+
+QByteArray ChangeLogDB::encode(const Changes& changes)
+{
+    QByteArray arr;
+    arr.append(changes.documents ? '\1' : '\0');
+    if (!changes.terms.isEmpty()) {
+        arr.append(DocTermsCodec().encode(changes.terms));
+    }
+    return arr;
+}
+
+ChangeLogDB::Changes ChangeLogDB::decode(const QByteArray& arr)
+{
+    Changes changes;
+    if (arr.isEmpty()) {
+        return changes;
+    }
+
+    changes.documents = arr[0] != '\0';
+    if (arr.size() > 1) {
+        changes.terms = DocTermsCodec().decode(arr.mid(1));
+    }
+    return changes;
+}
+
+QMap<quint64, ChangeLogDB::Changes> ChangeLogDB::toTestMap() const
+{
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_dbi, &cursor);
+
+    MDB_val key = {0, nullptr};
+    MDB_val val;
+
+    QMap<quint64, Changes> map;
+    while (1) {
+        int rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
+        if (rc) {
+            if (rc != MDB_NOTFOUND) {
+                qCDebug(ENGINE) << "ChangeLogDB::toTestMap" << mdb_strerror(rc);
+            }
+            break;
+        }
+
+        const quint64 txnId = *(static_cast<quint64*>(key.mv_data));
+        map.insert(txnId, decode(QByteArray(static_cast<char*>(val.mv_data), val.mv_size)));
+    }
+
+    mdb_cursor_close(cursor);
+    return map;
+}
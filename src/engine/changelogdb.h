@@ -0,0 +1,85 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef BALOO_CHANGELOGDB_H
+#define BALOO_CHANGELOGDB_H
+
+#include "engine_export.h"
+#include <lmdb.h>
+#include <QMap>
+#include <QVector>
+
+namespace Baloo {
+
+/**
+ * The ChangeLogDB records what each of the last few write transactions
+ * changed which queries read: the terms whose posting or position lists
+ * changed, and whether documents were added, removed, moved or had their
+ * mtime changed.
+ *
+ * It is keyed by the id of the transaction, so that the results of a query
+ * run at an older transaction can be checked against the changes since.
+ * A transaction without a record changed something unknown.
+ */
+class BALOO_ENGINE_EXPORT ChangeLogDB
+{
+public:
+    struct Changes {
+        // Sorted
+        QVector<QByteArray> terms;
+        bool documents = false;
+
+        bool operator==(const Changes& rhs) const {
+            return terms == rhs.terms && documents == rhs.documents;
+        }
+    };
+
+    ChangeLogDB(MDB_dbi dbi, MDB_txn* txn);
+    ~ChangeLogDB();
+
+    static MDB_dbi create(MDB_txn* txn);
+    static MDB_dbi open(MDB_txn* txn);
+
+    void put(quint64 txnId, const Changes& changes);
+
+    /**
+     * Fills \p changes with the record of \p txnId, returns false if
+     * there is none
+     */
+    bool get(quint64 txnId, Changes* changes);
+
+    /**
+     * Removes the records of the transactions before \p txnId
+     */
+    void prune(quint64 txnId);
+
+    static QByteArray encode(const Changes& changes);
+    static Changes decode(const QByteArray& arr);
+
+    QMap<quint64, Changes> toTestMap() const;
+
+private:
+    MDB_txn* m_txn;
+    MDB_dbi m_dbi;
+};
+
+}
+
+#endif // BALOO_CHANGELOGDB_H
@@ -0,0 +1,110 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "commitstats.h"
+
+#include <QByteArrayList>
+
+#include <algorithm>
+
+using namespace Baloo;
+
+CommitStats::CommitStats()
+{
+    std::fill(m_values, m_values + MetricCount, 0);
+}
+
+CommitStats& CommitStats::operator+=(const CommitStats& other)
+{
+    for (int i = 0; i < MetricCount; i++) {
+        m_values[i] += other.m_values[i];
+    }
+    return *this;
+}
+
+QString CommitStats::metricName(Metric metric)
+{
+    switch (metric) {
+    case Terms:
+        return QStringLiteral("terms");
+    case PostingBytesRead:
+        return QStringLiteral("postingBytesRead");
+    case PostingBytesWritten:
+        return QStringLiteral("postingBytesWritten");
+    case PositionBytesRead:
+        return QStringLiteral("positionBytesRead");
+    case PositionBytesWritten:
+        return QStringLiteral("positionBytesWritten");
+    case PostingTime:
+        return QStringLiteral("postingTime");
+    case PositionTime:
+        return QStringLiteral("positionTime");
+    case DocumentTime:
+        return QStringLiteral("documentTime");
+    case CommitTime:
+        return QStringLiteral("commitTime");
+    case NewPages:
+        return QStringLiteral("newPages");
+    case MetricCount:
+        break;
+    }
+
+    Q_ASSERT(0);
+    return QString();
+}
+
+CommitStats::Unit CommitStats::metricUnit(Metric metric)
+{
+    switch (metric) {
+    case PostingBytesRead:
+    case PostingBytesWritten:
+    case PositionBytesRead:
+    case PositionBytesWritten:
+        return Bytes;
+    case PostingTime:
+    case PositionTime:
+    case DocumentTime:
+    case CommitTime:
+        return Microseconds;
+    default:
+        return Count;
+    }
+}
+
+QByteArray CommitStats::toByteArray() const
+{
+    QByteArrayList values;
+    values.reserve(MetricCount);
+    for (int i = 0; i < MetricCount; i++) {
+        values << QByteArray::number(m_values[i]);
+    }
+    return values.join(' ');
+}
+
+CommitStats CommitStats::fromByteArray(const QByteArray& data)
+{
+    CommitStats stats;
+    const QByteArrayList values = data.split(' ');
+    for (int i = 0; i < MetricCount && i < values.size(); i++) {
+        stats.m_values[i] = values[i].toLongLong();
+    }
+    return stats;
+}
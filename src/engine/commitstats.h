@@ -0,0 +1,85 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef BALOO_COMMITSTATS_H
+#define BALOO_COMMITSTATS_H
+
+#include "engine_export.h"
+
+#include <QByteArray>
+#include <QString>
+
+namespace Baloo {
+
+/**
+ * What a write transaction did, and where it spent its time. The
+ * times are in microseconds.
+ */
+class BALOO_ENGINE_EXPORT CommitStats
+{
+public:
+    enum Metric {
+        Terms,
+        PostingBytesRead,
+        PostingBytesWritten,
+        PositionBytesRead,
+        PositionBytesWritten,
+        PostingTime,
+        PositionTime,
+        DocumentTime,
+        CommitTime,
+        NewPages,
+        MetricCount
+    };
+
+    enum Unit {
+        Count,
+        Bytes,
+        Microseconds
+    };
+
+    CommitStats();
+
+    qint64 value(Metric metric) const {
+        return m_values[metric];
+    }
+    void add(Metric metric, qint64 value) {
+        m_values[metric] += value;
+    }
+
+    CommitStats& operator+=(const CommitStats& other);
+
+    static QString metricName(Metric metric);
+    static Unit metricUnit(Metric metric);
+
+    /**
+     * A single line of text, used to hand the statistics over
+     * between processes
+     */
+    QByteArray toByteArray() const;
+    static CommitStats fromByteArray(const QByteArray& data);
+
+private:
+    qint64 m_values[MetricCount];
+};
+}
+
+#endif // BALOO_COMMITSTATS_H
@@ -22,6 +22,9 @@
 #include "database.h"
 #include "transaction.h"
 #include "postingdb.h"
+#include "postingdeltadb.h"
+#include "prefixdb.h"
+#include "changelogdb.h"
 #include "documentdb.h"
 #include "documenturldb.h"
 #include "documentiddb.h"
@@ -114,7 +117,7 @@ bool Database::open(OpenMode mode)
      * maximal number of allowed named databases, must match number of databases we create below
      * each additional one leads to overhead
      */
-    mdb_env_set_maxdbs(m_env, 12);
+    mdb_env_set_maxdbs(m_env, 17);
 
     /**
      * size limit for database == size limit of mmap
@@ -134,9 +137,12 @@ bool Database::open(OpenMode mode)
     const size_t maximalSizeInBytes = sizeInGByte * size_t(1024) * size_t(1024) * size_t(1024);
     mdb_env_set_mapsize(m_env, maximalSizeInBytes);
 
-    // The directory needs to be created before opening the environment
+    // The directory needs to be created before opening the environment.
+    // Read transactions are not tied to their thread, as a query keeps one
+    // open while its results are read, and File or the tag jobs may begin
+    // another one on the same thread in the meantime.
     QByteArray arr = QFile::encodeName(indexInfo.absoluteFilePath());
-    rc = mdb_env_open(m_env, arr.constData(), MDB_NOSUBDIR | MDB_NOMEMINIT | ((mode == ReadOnlyDatabase) ? MDB_RDONLY : 0), 0664);
+    rc = mdb_env_open(m_env, arr.constData(), MDB_NOSUBDIR | MDB_NOMEMINIT | MDB_NOTLS | ((mode == ReadOnlyDatabase) ? MDB_RDONLY : 0), 0664);
     if (rc) {
         mdb_env_close(m_env);
         m_env = nullptr;
@@ -167,6 +173,10 @@ bool Database::open(OpenMode mode)
 
         m_dbis.postingDbi = PostingDB::open(txn);
         m_dbis.positionDBi = PositionDB::open(txn);
+        m_dbis.postingDeltaDbi = PostingDeltaDB::open(txn);
+        m_dbis.prefixDbi = PrefixDB::open(txn);
+        m_dbis.prefixDeltaDbi = PrefixDB::openDeltas(txn);
+        m_dbis.changeLogDbi = ChangeLogDB::open(txn);
 
         m_dbis.docTermsDbi = DocumentDB::open("docterms", txn);
         m_dbis.docFilenameTermsDbi = DocumentDB::open("docfilenameterms", txn);
@@ -209,6 +219,21 @@ bool Database::open(OpenMode mode)
 
         m_dbis.postingDbi = PostingDB::create(txn);
         m_dbis.positionDBi = PositionDB::create(txn);
+        m_dbis.postingDeltaDbi = PostingDeltaDB::create(txn);
+        m_dbis.prefixDbi = PrefixDB::open(txn);
+        m_dbis.prefixBuildDbi = PrefixDB::openBuildState(txn);
+        if (!m_dbis.prefixDbi) {
+            // Databases created before the PrefixDB existed have it filled
+            // in by the scheduler, see Transaction::buildPrefixes
+            MDB_stat stat;
+            mdb_stat(txn, m_dbis.postingDbi, &stat);
+            if (stat.ms_entries) {
+                m_dbis.prefixBuildDbi = PrefixDB::createBuildState(txn);
+            }
+            m_dbis.prefixDbi = PrefixDB::create(txn);
+        }
+        m_dbis.prefixDeltaDbi = PrefixDB::createDeltas(txn);
+        m_dbis.changeLogDbi = ChangeLogDB::create(txn);
 
         m_dbis.docTermsDbi = DocumentDB::create("docterms", txn);
         m_dbis.docFilenameTermsDbi = DocumentDB::create("docfilenameterms", txn);
@@ -252,6 +277,65 @@ bool Database::isOpen() const
     return m_env != nullptr;
 }
 
+quint64 Database::lastTxnId() const
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_env) {
+        return 0;
+    }
+
+    MDB_envinfo info;
+    mdb_env_info(m_env, &info);
+    return info.me_last_txnid;
+}
+
+DatabaseDbis Database::currentDbis() const
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_env || (m_dbis.postingDeltaDbi && m_dbis.prefixDbi && m_dbis.prefixDeltaDbi && m_dbis.changeLogDbi)) {
+        return m_dbis;
+    }
+
+    MDB_envinfo info;
+    mdb_env_info(m_env, &info);
+    if (info.me_last_txnid == m_dbisTxnId) {
+        return m_dbis;
+    }
+    m_dbisTxnId = info.me_last_txnid;
+
+    // The handles only become visible to other transactions once the
+    // transaction which opened them has been committed
+    MDB_txn* txn;
+    int rc = mdb_txn_begin(m_env, nullptr, MDB_RDONLY, &txn);
+    if (rc) {
+        qCWarning(ENGINE) << "Database::currentDbis begin" << mdb_strerror(rc);
+        return m_dbis;
+    }
+
+    DatabaseDbis dbis = m_dbis;
+    if (!dbis.postingDeltaDbi) {
+        dbis.postingDeltaDbi = PostingDeltaDB::open(txn);
+    }
+    if (!dbis.prefixDbi) {
+        dbis.prefixDbi = PrefixDB::open(txn);
+    }
+    if (!dbis.prefixDeltaDbi) {
+        dbis.prefixDeltaDbi = PrefixDB::openDeltas(txn);
+    }
+    if (!dbis.changeLogDbi) {
+        dbis.changeLogDbi = ChangeLogDB::open(txn);
+    }
+
+    rc = mdb_txn_commit(txn);
+    if (rc) {
+        qCWarning(ENGINE) << "Database::currentDbis commit" << mdb_strerror(rc);
+        return m_dbis;
+    }
+
+    m_dbis = dbis;
+    return m_dbis;
+}
+
 QString Database::path() const
 {
     QMutexLocker locker(&m_mutex);
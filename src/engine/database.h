@@ -86,6 +86,13 @@ public:
      */
     QString path() const;
 
+    /**
+     * The id of the last committed transaction. It changes with every
+     * commit, which makes it a cheap way to tell whether the index has
+     * changed. Returns 0 if the database is not open.
+     */
+    quint64 lastTxnId() const;
+
 private:
     /**
      * serialize access, as open might be called from multiple threads
@@ -97,10 +104,19 @@ private:
      */
     const QString m_path;
 
+    /**
+     * The dbis a new transaction uses. The optional databases which did
+     * not exist yet when the index was opened are looked for again after
+     * every commit, as another process may have created them since.
+     */
+    DatabaseDbis currentDbis() const;
+
     MDB_env* m_env;
-    DatabaseDbis m_dbis;
+    mutable DatabaseDbis m_dbis;
+    mutable quint64 m_dbisTxnId = 0;
 
     friend class Transaction;
+    friend class DatabaseArchive;
     friend class DatabaseTest;
 
 };
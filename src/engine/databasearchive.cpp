@@ -0,0 +1,513 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "databasearchive.h"
+#include "database.h"
+#include "documenturldb.h"
+#include "postingdeltadb.h"
+#include "prefixdb.h"
+#include "positioninfo.h"
+#include "postingcodec.h"
+#include "positioncodec.h"
+#include "idutils.h"
+
+#include "enginedebug.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QIODevice>
+#include <QVector>
+
+#include <algorithm>
+
+using namespace Baloo;
+
+namespace {
+
+const char archiveMagic[8] = {'B', 'A', 'L', 'O', 'O', 'A', 'R', 'C'};
+
+// Records are collected into blocks of roughly this size before being compressed
+const int archiveBlockSize = 1024 * 1024;
+
+enum KeyType {
+    TermKey,
+    IdKey,
+    TimeKey
+};
+
+enum ValueType {
+    OpaqueValue,
+    PostingValue,
+    PostingDeltaValue,
+    PositionValue,
+    IdListValue,
+    FilePathValue,
+    IdValue
+};
+
+struct ArchiveDbi {
+    const char* name;
+    MDB_dbi dbi;
+    KeyType keyType;
+    ValueType valueType;
+    bool dupSort;
+};
+
+QVector<ArchiveDbi> archiveDbis(const DatabaseDbis& dbis)
+{
+    QVector<ArchiveDbi> list = {
+        {"postingdb", dbis.postingDbi, TermKey, PostingValue, false},
+        {"positiondb", dbis.positionDBi, TermKey, PositionValue, false},
+        {"docterms", dbis.docTermsDbi, IdKey, OpaqueValue, false},
+        {"docfilenameterms", dbis.docFilenameTermsDbi, IdKey, OpaqueValue, false},
+        {"docxatrrterms", dbis.docXattrTermsDbi, IdKey, OpaqueValue, false},
+        {"idtree", dbis.idTreeDbi, IdKey, IdListValue, false},
+        {"idfilename", dbis.idFilenameDbi, IdKey, FilePathValue, false},
+        {"documenttimedb", dbis.docTimeDbi, IdKey, OpaqueValue, false},
+        {"documentdatadb", dbis.docDataDbi, IdKey, OpaqueValue, false},
+        {"indexingleveldb", dbis.contentIndexingDbi, IdKey, OpaqueValue, false},
+        {"failediddb", dbis.failedIdDbi, IdKey, OpaqueValue, false},
+        {"mtimedb", dbis.mtimeDbi, TimeKey, IdValue, true},
+    };
+
+    if (dbis.postingDeltaDbi) {
+        list.append({"postingdeltadb", dbis.postingDeltaDbi, TermKey, PostingDeltaValue, false});
+    }
+    if (dbis.prefixDbi) {
+        list.append({"prefixdb", dbis.prefixDbi, TermKey, PostingValue, false});
+    }
+    if (dbis.prefixDeltaDbi) {
+        list.append({"prefixdeltadb", dbis.prefixDeltaDbi, TermKey, PostingDeltaValue, false});
+    }
+    return list;
+}
+
+/*
+ * Returns a path for every device found in the database. The path is the
+ * topmost indexed folder which still lives on that device, i.e. usually
+ * its mount point.
+ */
+QHash<quint32, QByteArray> deviceRoots(MDB_txn* txn, const DatabaseDbis& dbis)
+{
+    DocumentUrlDB docUrlDb(dbis.idTreeDbi, dbis.idFilenameDbi, txn);
+    QHash<quint32, QByteArray> roots;
+
+    MDB_cursor* cursor;
+    mdb_cursor_open(txn, dbis.idFilenameDbi, &cursor);
+
+    MDB_val key{0, nullptr};
+    MDB_val val{0, nullptr};
+    while (mdb_cursor_get(cursor, &key, &val, MDB_NEXT) == 0) {
+        const quint64 id = *static_cast<quint64*>(key.mv_data);
+        const quint64 parentId = *static_cast<quint64*>(val.mv_data);
+        const quint32 devId = idToDeviceId(id);
+
+        if (roots.contains(devId)) {
+            continue;
+        }
+        if (parentId && idToDeviceId(parentId) == devId) {
+            continue;
+        }
+
+        const QByteArray url = docUrlDb.get(id);
+        if (!url.isEmpty()) {
+            roots.insert(devId, url);
+        }
+    }
+
+    mdb_cursor_close(cursor);
+    return roots;
+}
+
+void appendRecord(QByteArray& block, const MDB_val& key, const MDB_val& val)
+{
+    const quint32 keySize = key.mv_size;
+    const quint32 valSize = val.mv_size;
+
+    block.append(reinterpret_cast<const char*>(&keySize), sizeof(quint32));
+    block.append(static_cast<const char*>(key.mv_data), keySize);
+    block.append(reinterpret_cast<const char*>(&valSize), sizeof(quint32));
+    block.append(static_cast<const char*>(val.mv_data), valSize);
+}
+
+quint64 remapId(const QHash<quint32, quint32>& deviceIdMap, quint64 id)
+{
+    if (!id) {
+        return id;
+    }
+
+    auto it = deviceIdMap.constFind(idToDeviceId(id));
+    if (it == deviceIdMap.constEnd()) {
+        return id;
+    }
+    return devIdAndInodeToId(it.value(), idToInode(id));
+}
+
+QByteArray remapValue(const QHash<quint32, quint32>& deviceIdMap, ValueType type, const QByteArray& value)
+{
+    switch (type) {
+    case OpaqueValue:
+        return value;
+
+    case PostingValue:
+    case IdListValue: {
+        // The IdTree stores a plain array of ids, just like the PostingCodec
+        PostingCodec codec;
+        QVector<quint64> list = codec.decode(value);
+        for (quint64& id : list) {
+            id = remapId(deviceIdMap, id);
+        }
+        std::sort(list.begin(), list.end());
+        return codec.encode(list);
+    }
+
+    case PostingDeltaValue: {
+        PostingDeltaDB::Delta delta = PostingDeltaDB::decode(value);
+        for (PostingList* list : {&delta.added, &delta.removed}) {
+            for (quint64& id : *list) {
+                id = remapId(deviceIdMap, id);
+            }
+            std::sort(list->begin(), list->end());
+        }
+        for (PositionInfo& info : delta.positions) {
+            info.docId = remapId(deviceIdMap, info.docId);
+        }
+        std::sort(delta.positions.begin(), delta.positions.end());
+        return PostingDeltaDB::encode(delta);
+    }
+
+    case PositionValue: {
+        PositionCodec codec;
+        QVector<PositionInfo> list = codec.decode(value);
+        for (PositionInfo& info : list) {
+            info.docId = remapId(deviceIdMap, info.docId);
+        }
+        std::sort(list.begin(), list.end());
+        return codec.encode(list);
+    }
+
+    case FilePathValue:
+    case IdValue: {
+        QByteArray result = value;
+        quint64 id;
+        memcpy(&id, result.constData(), sizeof(quint64));
+        id = remapId(deviceIdMap, id);
+        memcpy(result.data(), &id, sizeof(quint64));
+        return result;
+    }
+    }
+
+    return value;
+}
+
+int appendPut(MDB_cursor* cursor, MDB_val* key, MDB_val* val, bool dupSort)
+{
+    int rc = mdb_cursor_put(cursor, key, val, dupSort ? MDB_APPENDDUP : MDB_APPEND);
+    if (rc == MDB_KEYEXIST) {
+        // Rewriting the device ids can change the order of the keys.
+        // Those few records are inserted the slow way.
+        rc = mdb_cursor_put(cursor, key, val, 0);
+    }
+    return rc;
+}
+
+}
+
+DatabaseArchive::DatabaseArchive(Database* db)
+    : m_db(db)
+{
+    Q_ASSERT(db);
+}
+
+bool DatabaseArchive::exportTo(QIODevice* device)
+{
+    Q_ASSERT(device && device->isWritable());
+    m_errorString.clear();
+
+    if (!m_db->isOpen()) {
+        m_errorString = QStringLiteral("The database is not open");
+        return false;
+    }
+
+    MDB_txn* txn = nullptr;
+    int rc = mdb_txn_begin(m_db->m_env, nullptr, MDB_RDONLY, &txn);
+    if (rc) {
+        m_errorString = QString::fromUtf8(mdb_strerror(rc));
+        return false;
+    }
+
+    QDataStream stream(device);
+    stream.setVersion(QDataStream::Qt_5_11);
+    stream.writeRawData(archiveMagic, sizeof(archiveMagic));
+    stream << formatVersion;
+
+    const QHash<quint32, QByteArray> devices = deviceRoots(txn, m_db->m_dbis);
+    stream << static_cast<quint32>(devices.size());
+    for (auto it = devices.cbegin(); it != devices.cend(); ++it) {
+        stream << it.key() << it.value();
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    const QVector<ArchiveDbi> dbis = archiveDbis(m_db->m_dbis);
+
+    QByteArray block;
+    block.reserve(archiveBlockSize + 4096);
+
+    auto writeBlock = [&]() {
+        hash.addData(block);
+        stream << qCompress(block);
+        block.resize(0);
+    };
+
+    stream << static_cast<quint32>(dbis.size());
+    for (const ArchiveDbi& info : dbis) {
+        MDB_stat stat;
+        mdb_stat(txn, info.dbi, &stat);
+        stream << QByteArray(info.name) << static_cast<quint64>(stat.ms_entries);
+
+        MDB_cursor* cursor;
+        mdb_cursor_open(txn, info.dbi, &cursor);
+
+        MDB_val key{0, nullptr};
+        MDB_val val{0, nullptr};
+        while ((rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT)) == 0) {
+            appendRecord(block, key, val);
+            if (block.size() >= archiveBlockSize) {
+                writeBlock();
+            }
+        }
+        mdb_cursor_close(cursor);
+
+        if (rc != MDB_NOTFOUND) {
+            qCWarning(ENGINE) << "DatabaseArchive::exportTo" << info.name << mdb_strerror(rc);
+            m_errorString = QString::fromUtf8(mdb_strerror(rc));
+            mdb_txn_abort(txn);
+            return false;
+        }
+
+        if (!block.isEmpty()) {
+            writeBlock();
+        }
+        // An empty block marks the end of the database
+        stream << QByteArray();
+    }
+
+    stream << hash.result();
+    mdb_txn_abort(txn);
+
+    if (stream.status() != QDataStream::Ok) {
+        m_errorString = device->errorString();
+        return false;
+    }
+    return true;
+}
+
+bool DatabaseArchive::importFrom(QIODevice* device)
+{
+    Q_ASSERT(device && device->isReadable());
+    m_errorString.clear();
+    m_deviceIdMap.clear();
+
+    if (!m_db->isOpen()) {
+        m_errorString = QStringLiteral("The database is not open");
+        return false;
+    }
+
+    QDataStream stream(device);
+    stream.setVersion(QDataStream::Qt_5_11);
+
+    char magic[sizeof(archiveMagic)];
+    if (stream.readRawData(magic, sizeof(magic)) != sizeof(magic) || memcmp(magic, archiveMagic, sizeof(magic)) != 0) {
+        m_errorString = QStringLiteral("Not a Baloo index archive");
+        return false;
+    }
+
+    quint32 version = 0;
+    stream >> version;
+    if (version != formatVersion) {
+        m_errorString = QStringLiteral("Unsupported archive version %1").arg(version);
+        return false;
+    }
+
+    quint32 deviceCount = 0;
+    stream >> deviceCount;
+    for (quint32 i = 0; i < deviceCount && stream.status() == QDataStream::Ok; i++) {
+        quint32 devId;
+        QByteArray path;
+        stream >> devId >> path;
+
+        const quint64 id = filePathToId(path);
+        if (!id) {
+            qCDebug(ENGINE) << "DatabaseArchive::importFrom" << path << "does not exist, keeping device id" << devId;
+            continue;
+        }
+        if (idToDeviceId(id) != devId) {
+            m_deviceIdMap.insert(devId, idToDeviceId(id));
+        }
+    }
+
+    MDB_txn* txn = nullptr;
+    int rc = mdb_txn_begin(m_db->m_env, nullptr, 0, &txn);
+    if (rc) {
+        m_errorString = QString::fromUtf8(mdb_strerror(rc));
+        return false;
+    }
+
+    auto fail = [&](const QString& error) {
+        qCWarning(ENGINE) << "DatabaseArchive::importFrom" << error;
+        m_errorString = error;
+        mdb_txn_abort(txn);
+        return false;
+    };
+
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    const QVector<ArchiveDbi> dbis = archiveDbis(m_db->m_dbis);
+    const bool remap = !m_deviceIdMap.isEmpty();
+
+    quint32 dbiCount = 0;
+    stream >> dbiCount;
+    for (quint32 i = 0; i < dbiCount; i++) {
+        QByteArray name;
+        quint64 entries = 0;
+        stream >> name >> entries;
+        if (stream.status() != QDataStream::Ok) {
+            return fail(QStringLiteral("The archive is truncated"));
+        }
+
+        auto info = std::find_if(dbis.cbegin(), dbis.cend(), [&name](const ArchiveDbi& dbi) {
+            return name == dbi.name;
+        });
+        if (info == dbis.cend()) {
+            return fail(QStringLiteral("Unknown database %1 in archive").arg(QString::fromUtf8(name)));
+        }
+
+        MDB_stat stat;
+        mdb_stat(txn, info->dbi, &stat);
+        if (stat.ms_entries) {
+            return fail(QStringLiteral("The index is not empty"));
+        }
+
+        MDB_cursor* cursor;
+        mdb_cursor_open(txn, info->dbi, &cursor);
+
+        quint64 count = 0;
+        while (true) {
+            QByteArray compressed;
+            stream >> compressed;
+            if (stream.status() != QDataStream::Ok) {
+                mdb_cursor_close(cursor);
+                return fail(QStringLiteral("The archive is truncated"));
+            }
+            if (compressed.isEmpty()) {
+                break;
+            }
+
+            const QByteArray block = qUncompress(compressed);
+            if (block.isEmpty()) {
+                mdb_cursor_close(cursor);
+                return fail(QStringLiteral("The archive is corrupt"));
+            }
+            hash.addData(block);
+
+            const char* data = block.constData();
+            const char* end = data + block.size();
+            while (data < end) {
+                quint32 keySize;
+                quint32 valSize;
+                if (end - data < static_cast<qptrdiff>(sizeof(quint32))) {
+                    break;
+                }
+                memcpy(&keySize, data, sizeof(quint32));
+                data += sizeof(quint32);
+                if (end - data < static_cast<qptrdiff>(keySize + sizeof(quint32))) {
+                    break;
+                }
+                const char* keyData = data;
+                data += keySize;
+
+                memcpy(&valSize, data, sizeof(quint32));
+                data += sizeof(quint32);
+                if (end - data < static_cast<qptrdiff>(valSize)) {
+                    break;
+                }
+                const char* valData = data;
+                data += valSize;
+
+                MDB_val key{keySize, const_cast<char*>(keyData)};
+                MDB_val val{valSize, const_cast<char*>(valData)};
+
+                quint64 id;
+                QByteArray value;
+                if (remap) {
+                    if (info->keyType == IdKey) {
+                        memcpy(&id, keyData, sizeof(quint64));
+                        id = remapId(m_deviceIdMap, id);
+                        key.mv_data = &id;
+                    }
+                    if (info->valueType != OpaqueValue) {
+                        value = remapValue(m_deviceIdMap, info->valueType, QByteArray::fromRawData(valData, valSize));
+                        val.mv_size = value.size();
+                        val.mv_data = value.data();
+                    }
+                }
+
+                rc = appendPut(cursor, &key, &val, info->dupSort);
+                if (rc) {
+                    mdb_cursor_close(cursor);
+                    return fail(QString::fromUtf8(mdb_strerror(rc)));
+                }
+                count++;
+            }
+
+            if (data != end) {
+                mdb_cursor_close(cursor);
+                return fail(QStringLiteral("The archive is corrupt"));
+            }
+        }
+        mdb_cursor_close(cursor);
+
+        if (count != entries) {
+            return fail(QStringLiteral("Expected %1 entries for %2, found %3")
+                        .arg(entries).arg(QString::fromUtf8(name)).arg(count));
+        }
+    }
+
+    QByteArray checksum;
+    stream >> checksum;
+    if (stream.status() != QDataStream::Ok || checksum != hash.result()) {
+        return fail(QStringLiteral("Checksum mismatch"));
+    }
+
+    // The archive may have been taken while the prefixes were being filled
+    // in, so the scheduler goes through the terms again
+    MDB_stat stat;
+    mdb_stat(txn, m_db->m_dbis.postingDbi, &stat);
+    const MDB_dbi prefixBuildDbi = stat.ms_entries ? PrefixDB::createBuildState(txn) : 0;
+
+    rc = mdb_txn_commit(txn);
+    if (rc) {
+        m_errorString = QString::fromUtf8(mdb_strerror(rc));
+        return false;
+    }
+    if (prefixBuildDbi) {
+        m_db->m_dbis.prefixBuildDbi = prefixBuildDbi;
+    }
+    return true;
+}
@@ -0,0 +1,90 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef BALOO_DATABASEARCHIVE_H
+#define BALOO_DATABASEARCHIVE_H
+
+#include "engine_export.h"
+
+#include <QHash>
+
+class QIODevice;
+
+namespace Baloo {
+
+class Database;
+
+/**
+ * The DatabaseArchive streams the complete contents of a Database into a
+ * versioned, checksummed and compressed archive, and loads such an archive
+ * back into an empty Database.
+ *
+ * All the databases are read with sequential cursors in a single read
+ * transaction, so an export is a consistent snapshot and can be taken while
+ * the indexer is running. An import uses MDB_APPEND, which lets LMDB fill
+ * pages sequentially instead of descending the tree for every key.
+ *
+ * Document ids are built from the device id and the inode of a file. Device
+ * ids are usually not stable across machines, so the archive records a path
+ * for every device it contains. When importing, each of those paths is
+ * looked up again and the ids are rewritten for the device it now lives on.
+ * Inodes are kept as they are, so a prebuilt index is only useful for a tree
+ * which is an identical copy, e.g. a shared network mount or a disk image.
+ */
+class BALOO_ENGINE_EXPORT DatabaseArchive
+{
+public:
+    explicit DatabaseArchive(Database* db);
+
+    /**
+     * Writes the archive to \p device, which must be open for writing.
+     */
+    bool exportTo(QIODevice* device);
+
+    /**
+     * Reads an archive from \p device, which must be open for reading.
+     * The Database must have been freshly created. Nothing is committed
+     * unless the whole archive has been read and its checksum matches.
+     */
+    bool importFrom(QIODevice* device);
+
+    /**
+     * The device ids which were rewritten by the last importFrom
+     */
+    QHash<quint32, quint32> deviceIdMap() const {
+        return m_deviceIdMap;
+    }
+
+    QString errorString() const {
+        return m_errorString;
+    }
+
+    // 2 added the posting deltas and the stored prefix unions with their deltas
+    static const quint32 formatVersion = 2;
+
+private:
+    Database* m_db;
+    QHash<quint32, quint32> m_deviceIdMap;
+    QString m_errorString;
+};
+
+}
+
+#endif // BALOO_DATABASEARCHIVE_H
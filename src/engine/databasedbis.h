@@ -29,6 +29,15 @@ class DatabaseDbis {
 public:
     MDB_dbi postingDbi;
     MDB_dbi positionDBi;
+    // Optional, databases created by older versions do not have it
+    MDB_dbi postingDeltaDbi;
+    // Optional as well
+    MDB_dbi prefixDbi;
+    MDB_dbi prefixDeltaDbi;
+    // Only opened by the writer, see PrefixDB::createBuildState
+    MDB_dbi prefixBuildDbi;
+    // Optional, see ChangeLogDB
+    MDB_dbi changeLogDbi;
 
     MDB_dbi docTermsDbi;
     MDB_dbi docFilenameTermsDbi;
@@ -47,6 +56,11 @@ public:
     DatabaseDbis()
         : postingDbi(0)
         , positionDBi(0)
+        , postingDeltaDbi(0)
+        , prefixDbi(0)
+        , prefixDeltaDbi(0)
+        , prefixBuildDbi(0)
+        , changeLogDbi(0)
         , docTermsDbi(0)
         , docFilenameTermsDbi(0)
         , docXattrTermsDbi(0)
@@ -40,6 +40,9 @@ public:
 
     size_t postingDb;
     size_t positionDb;
+    size_t postingDeltaDb;
+    size_t prefixDb;
+    size_t changeLog;
 
     size_t docTerms;
     size_t docFilenameTerms;
@@ -29,6 +29,7 @@
 namespace Baloo {
 
 class WriteTransaction;
+class OverlayIndex;
 class TermGeneratorTest;
 
 /**
@@ -90,6 +91,7 @@ private:
     QByteArray m_data;
 
     friend class WriteTransaction;
+    friend class OverlayIndex;
     friend class TermGeneratorTest;
 };
 
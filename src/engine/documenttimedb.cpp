@@ -131,6 +131,50 @@ bool DocumentTimeDB::contains(quint64 docId)
     return true;
 }
 
+QVector<quint64> DocumentTimeDB::rangeStarts(int count) const
+{
+    Q_ASSERT(count > 0);
+
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_dbi, &cursor);
+
+    // The inode number sits above the device id (see devIdAndInodeToId),
+    // so the ids of all the devices are mixed and spread fairly evenly
+    // between the first and the last one. Splitting that span does not
+    // need to walk the documents.
+    MDB_val key = {0, nullptr};
+    MDB_val val;
+    int rc = mdb_cursor_get(cursor, &key, &val, MDB_FIRST);
+    if (rc) {
+        if (rc != MDB_NOTFOUND) {
+            qCWarning(ENGINE) << "DocumentTimeDB::rangeStarts" << mdb_strerror(rc);
+        }
+        mdb_cursor_close(cursor);
+        return {};
+    }
+    const quint64 first = *(static_cast<quint64*>(key.mv_data));
+
+    rc = mdb_cursor_get(cursor, &key, &val, MDB_LAST);
+    mdb_cursor_close(cursor);
+    if (rc) {
+        qCWarning(ENGINE) << "DocumentTimeDB::rangeStarts" << mdb_strerror(rc);
+        return {first};
+    }
+    const quint64 last = *(static_cast<quint64*>(key.mv_data));
+
+    const quint64 step = (last - first) / count + 1;
+
+    QVector<quint64> starts;
+    for (int i = 0; i < count; i++) {
+        const quint64 offset = step * i;
+        if (offset > last - first) {
+            break;
+        }
+        starts << first + offset;
+    }
+    return starts;
+}
+
 QMap<quint64, DocumentTimeDB::TimeInfo> DocumentTimeDB::toTestMap() const
 {
     MDB_cursor* cursor;
@@ -24,6 +24,7 @@
 #include "engine_export.h"
 
 #include <QMap>
+#include <QVector>
 #include <QDebug>
 #include <lmdb.h>
 
@@ -62,6 +63,13 @@ public:
     void del(quint64 docId);
     bool contains(quint64 docId);
 
+    /**
+     * Splits the ids of the documents into up to \p count ranges of about
+     * the same width, and returns the first id of each one, ascending.
+     * A range ends right before the next one starts.
+     */
+    QVector<quint64> rangeStarts(int count) const;
+
     QMap<quint64, TimeInfo> toTestMap() const;
 private:
     MDB_txn* m_txn;
@@ -72,9 +72,10 @@ public:
 
     quint64 getId(quint64 docId, const QByteArray& fileName) const;
 
-    PostingIterator* iter(quint64 docId) {
+    PostingIterator* iter(quint64 docId, quint64 firstId = 0,
+                          quint64 lastId = std::numeric_limits<quint64>::max()) {
         IdTreeDB db(m_idTreeDbi, m_txn);
-        return db.iter(docId);
+        return db.iter(docId, firstId, lastId);
     }
 
     QMap<quint64, QByteArray> toTestMap() const;
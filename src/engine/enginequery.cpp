@@ -48,3 +48,12 @@ EngineQuery::EngineQuery(const QVector<EngineQuery> subQueries, Operation op)
     , m_subQueries(subQueries)
 {
 }
+
+EngineQuery::EngineQuery(const QByteArray& prefix, const QByteArray& word, int distance, int pos)
+    : m_term(prefix + word)
+    , m_pos(pos)
+    , m_op(Fuzzy)
+    , m_distance(distance)
+    , m_prefixSize(prefix.size())
+{
+}
@@ -37,7 +37,8 @@ public:
         StartsWith,
         And,
         Or,
-        Phrase
+        Phrase,
+        Fuzzy
     };
 
     EngineQuery();
@@ -45,6 +46,12 @@ public:
     EngineQuery(const QByteArray& term, Operation op, int pos = 0);
     EngineQuery(const QVector<EngineQuery> subQueries, Operation op);
 
+    /**
+     * Matches the terms starting with \p prefix which are at most
+     * \p distance edits away from \p word after it
+     */
+    EngineQuery(const QByteArray& prefix, const QByteArray& word, int distance, int pos = 0);
+
     QByteArray term() const {
         return m_term;
     }
@@ -61,6 +68,20 @@ public:
         m_op = op;
     }
 
+    /**
+     * The number of edits a Fuzzy query allows
+     */
+    int distance() const {
+        return m_distance;
+    }
+
+    /**
+     * The size of the start of the term a Fuzzy query matches exactly
+     */
+    int prefixSize() const {
+        return m_prefixSize;
+    }
+
     bool leaf() const {
         return !m_term.isEmpty();
     }
@@ -74,12 +95,15 @@ public:
     }
 
     bool operator ==(const EngineQuery& q) const {
-        return m_term == q.m_term && m_pos == q.m_pos && m_op == q.m_op && m_subQueries == q.m_subQueries;
+        return m_term == q.m_term && m_pos == q.m_pos && m_op == q.m_op
+            && m_distance == q.m_distance && m_prefixSize == q.m_prefixSize && m_subQueries == q.m_subQueries;
     }
 private:
     QByteArray m_term;
     int m_pos;
     Operation m_op;
+    int m_distance = 0;
+    int m_prefixSize = 0;
 
     QVector<EngineQuery> m_subQueries;
 };
@@ -95,6 +119,8 @@ inline QDebug operator << (QDebug d, const Baloo::EngineQuery& q) {
         d << "[OR " << q.subQueries() << "]";
     } else if (q.op() == Baloo::EngineQuery::Phrase) {
         d << "[PHRASE " << q.subQueries() << "]";
+    } else if (q.op() == Baloo::EngineQuery::Fuzzy) {
+        d << "(" << q.term() << "," << q.pos() << "," << q.op() << ",~" << q.distance() << ")";
     } else {
         Q_ASSERT(q.subQueries().isEmpty());
         d << "(" << q.term() << "," << q.pos() << "," << q.op() << ")";
@@ -0,0 +1,71 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "filterpostingiterator.h"
+
+using namespace Baloo;
+
+FilterPostingIterator::FilterPostingIterator(PostingIterator* it, std::function<bool(quint64)> accept)
+    : m_it(it)
+    , m_accept(accept)
+    , m_docId(0)
+{
+    Q_ASSERT(it);
+}
+
+FilterPostingIterator::~FilterPostingIterator()
+{
+    delete m_it;
+}
+
+quint64 FilterPostingIterator::docId() const
+{
+    return m_docId;
+}
+
+quint64 FilterPostingIterator::next()
+{
+    m_docId = filter(m_it->next());
+    return m_docId;
+}
+
+quint64 FilterPostingIterator::skipTo(quint64 docId)
+{
+    if (m_docId && m_docId >= docId) {
+        return m_docId;
+    }
+
+    m_docId = filter(m_it->skipTo(docId));
+    return m_docId;
+}
+
+quint64 FilterPostingIterator::cost() const
+{
+    return m_it->cost();
+}
+
+quint64 FilterPostingIterator::filter(quint64 candidate)
+{
+    while (candidate && !m_accept(candidate)) {
+        candidate = m_it->next();
+    }
+    return candidate;
+}
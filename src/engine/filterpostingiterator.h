@@ -0,0 +1,60 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef BALOO_FILTERPOSTINGITERATOR_H
+#define BALOO_FILTERPOSTINGITERATOR_H
+
+#include "postingiterator.h"
+
+#include <functional>
+
+namespace Baloo {
+
+/**
+ * Iterates over the ids of another iterator which pass a check. This is
+ * cheaper than intersecting with a second list when that list is a lot
+ * longer than the first one, and the check only needs a lookup.
+ */
+class BALOO_ENGINE_EXPORT FilterPostingIterator : public PostingIterator
+{
+public:
+    /**
+     * Takes ownership of \p it
+     */
+    FilterPostingIterator(PostingIterator* it, std::function<bool(quint64)> accept);
+    ~FilterPostingIterator() override;
+
+    quint64 next() override;
+    quint64 docId() const override;
+    quint64 skipTo(quint64 docId) override;
+    quint64 cost() const override;
+
+private:
+    quint64 filter(quint64 candidate);
+
+    PostingIterator* m_it;
+    std::function<bool(quint64)> m_accept;
+    quint64 m_docId;
+};
+
+}
+
+#endif // BALOO_FILTERPOSTINGITERATOR_H
@@ -0,0 +1,71 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef BALOO_GALLOPSEARCH_H
+#define BALOO_GALLOPSEARCH_H
+
+#include <QVector>
+
+#include <algorithm>
+
+namespace Baloo {
+
+/**
+ * Returns the index of the first element at or after \p pos whose id,
+ * as returned by \p idOf, is not smaller than \p id, or the size of
+ * \p vec if there is none. The elements must be sorted by id.
+ *
+ * The step is doubled until it overshoots, and only the last step is
+ * searched in binary, so the cost grows with the logarithm of the
+ * distance skipped instead of the length of the list.
+ */
+template <typename T, typename IdOf>
+int gallopSearch(const QVector<T>& vec, int pos, quint64 id, IdOf idOf)
+{
+    const int size = vec.size();
+    if (pos >= size || idOf(vec[pos]) >= id) {
+        return pos;
+    }
+
+    // vec[lo] is always smaller than id
+    int lo = pos;
+    int step = 1;
+    int hi = lo + 1;
+    while (hi < size && idOf(vec[hi]) < id) {
+        lo = hi;
+        step *= 2;
+        hi = size - lo > step ? lo + step : size;
+    }
+
+    auto it = std::lower_bound(vec.cbegin() + lo + 1, vec.cbegin() + hi, id, [&idOf](const T& value, quint64 id) {
+        return idOf(value) < id;
+    });
+    return it - vec.cbegin();
+}
+
+inline int gallopSearch(const QVector<quint64>& vec, int pos, quint64 id)
+{
+    return gallopSearch(vec, pos, id, [](quint64 value) { return value; });
+}
+
+}
+
+#endif // BALOO_GALLOPSEARCH_H
@@ -21,6 +21,7 @@
 #include "idtreedb.h"
 #include "enginedebug.h"
 #include "postingiterator.h"
+#include "gallopsearch.h"
 
 #include <algorithm>
 
@@ -116,8 +117,8 @@ void IdTreeDB::del(quint64 docId)
 //
 class IdTreePostingIterator : public PostingIterator {
 public:
-    IdTreePostingIterator(const IdTreeDB& db, const QVector<quint64> list)
-        : m_db(db), m_pos(-1), m_idList(list) {}
+    IdTreePostingIterator(const IdTreeDB& db, const QVector<quint64> list, quint64 firstId, quint64 lastId)
+        : m_db(db), m_pos(-1), m_idList(list), m_firstId(firstId), m_lastId(lastId) {}
 
     quint64 docId() const override {
         if (m_pos >= 0 && m_pos < m_resultList.size())
@@ -134,7 +135,9 @@ public:
             while (!m_idList.isEmpty()) {
                 quint64 id = m_idList.takeLast();
                 m_idList << m_db.get(id);
-                m_resultList << id;
+                // The whole subtree is walked, but only the range is sorted
+                if (id >= m_firstId && id <= m_lastId)
+                    m_resultList << id;
             }
             std::sort(m_resultList.begin(), m_resultList.end());
             m_pos = 0;
@@ -152,19 +155,41 @@ public:
             return 0;
     }
 
+    quint64 cost() const override {
+        // Unknown until the tree has been collected
+        if (m_pos < 0)
+            return PostingIterator::cost();
+        return m_resultList.size() - qMin(m_pos, m_resultList.size());
+    }
+
+    quint64 skipTo(quint64 docId) override {
+        // The first call to next() collects the whole tree
+        if (m_pos < 0 && !next()) {
+            return 0;
+        }
+
+        m_pos = gallopSearch(m_resultList, m_pos, docId);
+        if (m_pos < m_resultList.size())
+            return m_resultList[m_pos];
+        else
+            return 0;
+    }
+
 private:
     IdTreeDB m_db;
     int m_pos;
     QVector<quint64> m_idList;
     QVector<quint64> m_resultList;
+    quint64 m_firstId;
+    quint64 m_lastId;
 };
 
-PostingIterator* IdTreeDB::iter(quint64 docId)
+PostingIterator* IdTreeDB::iter(quint64 docId, quint64 firstId, quint64 lastId)
 {
     Q_ASSERT(docId > 0);
 
     QVector<quint64> list = {docId};
-    return new IdTreePostingIterator(*this, list);
+    return new IdTreePostingIterator(*this, list, firstId, lastId);
 }
 
 QMap<quint64, QVector<quint64>> IdTreeDB::toTestMap() const
@@ -26,6 +26,8 @@
 #include <QVector>
 #include <QMap>
 
+#include <limits>
+
 namespace Baloo {
 
 class PostingIterator;
@@ -44,9 +46,11 @@ public:
 
     /**
      * Returns an iterator which will return all the docIds which use \p docId
-     * are the parent docID.
+     * are the parent docID. Only the ids from \p firstId to \p lastId are
+     * returned.
      */
-    PostingIterator* iter(quint64 docId);
+    PostingIterator* iter(quint64 docId, quint64 firstId = 0,
+                          quint64 lastId = std::numeric_limits<quint64>::max());
 
     QMap<quint64, QVector<quint64>> toTestMap() const;
 private:
@@ -0,0 +1,106 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "levenshteinautomaton.h"
+
+using namespace Baloo;
+
+namespace {
+// Decodes the code point at the start of \p data and sets \p length to the
+// number of bytes it takes. Broken sequences are taken a byte at a time.
+uint decode(const char* data, int size, int* length)
+{
+    const uchar lead = data[0];
+    int count = lead < 0xC0 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+    if (count > size) {
+        count = 1;
+    }
+
+    uint ch = count == 1 ? lead : lead & (0x7F >> count);
+    for (int i = 1; i < count; i++) {
+        const uchar byte = data[i];
+        if ((byte & 0xC0) != 0x80) {
+            *length = 1;
+            return lead;
+        }
+        ch = (ch << 6) | (byte & 0x3F);
+    }
+
+    *length = count;
+    return ch;
+}
+}
+
+LevenshteinAutomaton::LevenshteinAutomaton(const QByteArray& word, int maxDistance)
+    : m_maxDistance(qMax(maxDistance, 0))
+{
+    int pos = 0;
+    while (pos < word.size()) {
+        int length = 0;
+        m_word << decode(word.constData() + pos, word.size() - pos, &length);
+        pos += length;
+    }
+}
+
+bool LevenshteinAutomaton::matches(const QByteArray& text, int* deadEnd) const
+{
+    if (deadEnd) {
+        *deadEnd = -1;
+    }
+
+    // The state is the last row of the edit distance table between the
+    // text read so far and every start of the word. Distances above the
+    // maximum are all the same to the automaton.
+    const int size = m_word.size();
+    const int limit = m_maxDistance + 1;
+
+    QVector<int> row(size + 1);
+    QVector<int> nextRow(size + 1);
+    for (int i = 0; i <= size; i++) {
+        row[i] = qMin(i, limit);
+    }
+
+    int pos = 0;
+    while (pos < text.size()) {
+        int length = 0;
+        const uint ch = decode(text.constData() + pos, text.size() - pos, &length);
+        pos += length;
+
+        nextRow[0] = qMin(row[0] + 1, limit);
+        int best = nextRow[0];
+        for (int i = 1; i <= size; i++) {
+            const int replaced = row[i - 1] + (m_word[i - 1] == ch ? 0 : 1);
+            const int distance = qMin(qMin(nextRow[i - 1], row[i]) + 1, replaced);
+            nextRow[i] = qMin(distance, limit);
+            best = qMin(best, nextRow[i]);
+        }
+        row.swap(nextRow);
+
+        if (best == limit) {
+            if (deadEnd) {
+                *deadEnd = pos;
+            }
+            return false;
+        }
+    }
+
+    return row[size] <= m_maxDistance;
+}
@@ -0,0 +1,65 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef BALOO_LEVENSHTEINAUTOMATON_H
+#define BALOO_LEVENSHTEINAUTOMATON_H
+
+#include "engine_export.h"
+
+#include <QByteArray>
+#include <QVector>
+
+namespace Baloo {
+
+/**
+ * Accepts the texts which are at most a given number of edits away from
+ * a word, counting inserted, removed and replaced characters. It is run
+ * over the text one character at a time, so it also tells after which
+ * start of the text no continuation can be accepted any more, which lets
+ * a sorted list of terms be walked without looking at every term.
+ *
+ * The word and the texts are in UTF-8 and compared per code point.
+ */
+class BALOO_ENGINE_EXPORT LevenshteinAutomaton
+{
+public:
+    LevenshteinAutomaton(const QByteArray& word, int maxDistance);
+
+    int maxDistance() const {
+        return m_maxDistance;
+    }
+
+    /**
+     * Returns true if \p text is at most maxDistance() edits away from
+     * the word. Otherwise \p deadEnd, when given, is set to the size in
+     * bytes of the shortest start of \p text which is already too far
+     * away whatever follows it, or to -1 if there is none.
+     */
+    bool matches(const QByteArray& text, int* deadEnd = nullptr) const;
+
+private:
+    QVector<uint> m_word;
+    int m_maxDistance;
+};
+
+}
+
+#endif // BALOO_LEVENSHTEINAUTOMATON_H
@@ -272,6 +272,104 @@ PostingIterator* MTimeDB::iterRange(quint32 beginTime, quint32 endTime)
     return new VectorPostingIterator(results);
 }
 
+quint64 MTimeDB::documentCount(quint32 beginTime, quint32 endTime)
+{
+    if (endTime < beginTime) {
+        return 0;
+    }
+
+    MDB_stat stat;
+    int rc = mdb_stat(m_txn, m_dbi, &stat);
+    if (rc) {
+        qCWarning(ENGINE) << "MTimeDB::documentCount" << mdb_strerror(rc);
+        return 0;
+    }
+    if (!stat.ms_entries) {
+        return 0;
+    }
+
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_dbi, &cursor);
+
+    MDB_val key{0, nullptr};
+    MDB_val val{0, nullptr};
+    rc = mdb_cursor_get(cursor, &key, &val, MDB_FIRST);
+    const quint32 first = rc ? 0 : *static_cast<quint32*>(key.mv_data);
+    if (!rc) {
+        rc = mdb_cursor_get(cursor, &key, &val, MDB_LAST);
+    }
+    const quint32 last = rc ? 0 : *static_cast<quint32*>(key.mv_data);
+    mdb_cursor_close(cursor);
+
+    if (rc) {
+        qCWarning(ENGINE) << "MTimeDB::documentCount" << mdb_strerror(rc);
+        return stat.ms_entries;
+    }
+
+    beginTime = qMax(beginTime, first);
+    endTime = qMin(endTime, last);
+    if (endTime < beginTime) {
+        return 0;
+    }
+
+    // All the documents have the same mtime
+    if (first == last) {
+        return stat.ms_entries;
+    }
+    const double fraction = (double(endTime) - beginTime + 1) / (double(last) - first + 1);
+    return qMax<quint64>(1, static_cast<quint64>(fraction * stat.ms_entries));
+}
+
+QVector<MTimeDB::Entry> MTimeDB::newest(int count, const Entry& after)
+{
+    QVector<Entry> entries;
+    if (count <= 0) {
+        return entries;
+    }
+
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_dbi, &cursor);
+
+    quint32 mtime = after.mtime;
+    quint64 docId = after.docId;
+
+    MDB_val key{0, nullptr};
+    MDB_val val{0, nullptr};
+    int rc = 0;
+    if (docId) {
+        key.mv_size = sizeof(quint32);
+        key.mv_data = &mtime;
+        val.mv_size = sizeof(quint64);
+        val.mv_data = &docId;
+
+        rc = mdb_cursor_get(cursor, &key, &val, MDB_GET_BOTH);
+        if (!rc) {
+            rc = mdb_cursor_get(cursor, &key, &val, MDB_PREV);
+        }
+    } else {
+        rc = mdb_cursor_get(cursor, &key, &val, MDB_LAST);
+    }
+
+    while (!rc) {
+        Entry entry;
+        entry.mtime = *static_cast<quint32*>(key.mv_data);
+        entry.docId = *static_cast<quint64*>(val.mv_data);
+        entries << entry;
+        if (entries.size() == count) {
+            break;
+        }
+
+        rc = mdb_cursor_get(cursor, &key, &val, MDB_PREV);
+    }
+
+    if (rc && rc != MDB_NOTFOUND) {
+        qCWarning(ENGINE) << "MTimeDB::newest" << after.mtime << after.docId << mdb_strerror(rc);
+    }
+
+    mdb_cursor_close(cursor);
+    return entries;
+}
+
 QMap<quint32, quint64> MTimeDB::toTestMap() const
 {
     MDB_cursor* cursor;
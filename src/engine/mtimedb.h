@@ -60,6 +60,25 @@ public:
       */
     PostingIterator* iterRange(quint32 beginTime, quint32 endTime);
 
+    /**
+      * Estimates the number of documents with an mtime between \p beginTime
+      * and \p endTime (inclusive), assuming the mtimes are spread evenly
+      * between the oldest and the newest one. Only returns 0 when there is
+      * no such document.
+      */
+    quint64 documentCount(quint32 beginTime, quint32 endTime);
+
+    struct Entry {
+        quint32 mtime = 0;
+        quint64 docId = 0;
+    };
+    /**
+      * Lists up to \p count documents, the most recently modified first.
+      * The listing continues after \p after, the last entry returned by
+      * the previous call. The default Entry starts with the newest document.
+      */
+    QVector<Entry> newest(int count, const Entry& after = Entry());
+
     QMap<quint32, quint64> toTestMap() const;
 private:
     MDB_txn* m_txn;
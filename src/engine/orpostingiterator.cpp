@@ -19,37 +19,47 @@
  */
 
 #include "orpostingiterator.h"
+#include "vectorpostingiterator.h"
+
+#include <QtAlgorithms>
+
+#include <algorithm>
+#include <limits>
 
 using namespace Baloo;
 
 OrPostingIterator::OrPostingIterator(const QVector<PostingIterator*>& iterators)
-    : m_iterators(iterators)
-    , m_docId(0)
-    , m_nextId(0)
+    : m_docId(0)
 {
-    for (auto it = m_iterators.begin(), end = m_iterators.end(); it != end;) {
+    m_heap.reserve(iterators.size());
+    for (PostingIterator* iter : iterators) {
         /*
          * Check for null iterators
          * Preferably, these are not pushed to the list at all, but better be safe
          */
-        if (!(*it)) {
-            it = m_iterators.erase(it);
+        if (!iter) {
             continue;
         }
 
-        auto docId = (*it)->next();
-        // find smallest docId
-        if (docId && (docId < m_nextId || m_nextId == 0)) {
-            m_nextId = docId;
+        const quint64 docId = iter->next();
+        if (!docId) {
+            delete iter;
+            continue;
         }
-
-        it++;
+        m_heap.append({docId, iter});
     }
+
+    auto greater = [](const Entry& lhs, const Entry& rhs) {
+        return lhs.docId > rhs.docId;
+    };
+    std::make_heap(m_heap.begin(), m_heap.end(), greater);
 }
 
 OrPostingIterator::~OrPostingIterator()
 {
-    qDeleteAll(m_iterators);
+    for (const Entry& entry : qAsConst(m_heap)) {
+        delete entry.iter;
+    }
 }
 
 quint64 OrPostingIterator::docId() const
@@ -57,38 +67,128 @@ quint64 OrPostingIterator::docId() const
     return m_docId;
 }
 
+void OrPostingIterator::updateTop(quint64 docId)
+{
+    if (docId) {
+        m_heap[0].docId = docId;
+    } else {
+        delete m_heap[0].iter;
+        m_heap[0] = m_heap.last();
+        m_heap.removeLast();
+    }
+
+    const int size = m_heap.size();
+    int pos = 0;
+    while (true) {
+        int smallest = pos;
+        const int left = 2 * pos + 1;
+        const int right = left + 1;
+        if (left < size && m_heap[left].docId < m_heap[smallest].docId) {
+            smallest = left;
+        }
+        if (right < size && m_heap[right].docId < m_heap[smallest].docId) {
+            smallest = right;
+        }
+        if (smallest == pos) {
+            break;
+        }
+        std::swap(m_heap[pos], m_heap[smallest]);
+        pos = smallest;
+    }
+}
+
 quint64 OrPostingIterator::next()
 {
-    m_docId = m_nextId;
-    m_nextId = 0;
+    // advance all iterators which point to the current docId
+    if (m_docId) {
+        while (!m_heap.isEmpty() && m_heap[0].docId == m_docId) {
+            updateTop(m_heap[0].iter->next());
+        }
+    }
+
+    m_docId = m_heap.isEmpty() ? 0 : m_heap[0].docId;
+    return m_docId;
+}
+
+quint64 OrPostingIterator::skipTo(quint64 docId)
+{
+    if (m_docId && m_docId >= docId) {
+        return m_docId;
+    }
 
-    if (!m_docId) {
-        return 0;
+    while (!m_heap.isEmpty() && m_heap[0].docId < docId) {
+        updateTop(m_heap[0].iter->skipTo(docId));
     }
 
-    // advance all iterators which point to the lowest docId
-    for (auto it = m_iterators.begin(); it != m_iterators.end(); ) {
-        PostingIterator* iter = *it;
-
-        auto docId = iter->docId();
-        if (docId <= m_docId) {
-            docId = iter->next();
-            // remove element if iterator has reached the end
-            if (docId == 0) {
-                delete iter;
-                *it = nullptr;
-                it = m_iterators.erase(it);
-                continue;
-            }
+    m_docId = m_heap.isEmpty() ? 0 : m_heap[0].docId;
+    return m_docId;
+}
+
+quint64 OrPostingIterator::cost() const
+{
+    quint64 cost = 0;
+    for (const Entry& entry : m_heap) {
+        const quint64 iterCost = entry.iter->cost();
+        if (iterCost > std::numeric_limits<quint64>::max() - cost) {
+            return std::numeric_limits<quint64>::max();
         }
+        cost += iterCost;
+    }
+    return cost;
+}
 
-        // check if the docId is the new lowest docId
-        if ((docId < m_nextId) || (m_nextId == 0)) {
-            m_nextId = docId;
+PostingIterator* OrPostingIterator::unite(const QVector<PostingIterator*>& iterators)
+{
+    QVector<quint64> ids;
+    for (PostingIterator* iter : iterators) {
+        if (!iter) {
+            continue;
+        }
+        while (quint64 docId = iter->next()) {
+            ids.append(docId);
         }
+        delete iter;
+    }
 
-        it++;
+    if (ids.isEmpty()) {
+        return nullptr;
     }
 
-    return m_docId;
+    return new VectorPostingIterator(sortUnique(ids));
+}
+
+QVector<quint64> OrPostingIterator::sortUnique(QVector<quint64> ids)
+{
+    if (ids.isEmpty()) {
+        return ids;
+    }
+
+    const auto bounds = std::minmax_element(ids.cbegin(), ids.cend());
+    const quint64 first = *bounds.first;
+    const quint64 range = *bounds.second - first;
+
+    // The ids of different devices are far apart, then sorting is cheaper
+    // than a bitmap larger than the ids themselves
+    if (range / 64 >= static_cast<quint64>(ids.size())) {
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+        return ids;
+    }
+
+    QVector<quint64> bitmap(range / 64 + 1, 0);
+    for (quint64 id : qAsConst(ids)) {
+        const quint64 bit = id - first;
+        bitmap[bit / 64] |= static_cast<quint64>(1) << (bit % 64);
+    }
+
+    QVector<quint64> result;
+    result.reserve(ids.size());
+    for (int word = 0; word < bitmap.size(); word++) {
+        quint64 bits = bitmap[word];
+        while (bits) {
+            result.append(first + static_cast<quint64>(word) * 64 + qCountTrailingZeroBits(bits));
+            bits &= bits - 1;
+        }
+    }
+    return result;
 }
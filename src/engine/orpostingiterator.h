@@ -26,6 +26,10 @@
 
 namespace Baloo {
 
+/**
+ * Merges the iterators with a min-heap keyed on their current id, so
+ * every step costs O(log k) in the number of iterators instead of O(k).
+ */
 class BALOO_ENGINE_EXPORT OrPostingIterator : public PostingIterator
 {
 public:
@@ -34,11 +38,35 @@ public:
 
     quint64 next() override;
     quint64 docId() const override;
+    quint64 skipTo(quint64 docId) override;
+    quint64 cost() const override;
+
+    /**
+     * Reads all of \p iterators into a single sorted list up front, and
+     * deletes them. For a very large number of iterators this is cheaper
+     * than merging them one id at a time, but nothing is gained from
+     * stopping early.
+     */
+    static PostingIterator* unite(const QVector<PostingIterator*>& iterators);
+
+    /**
+     * Sorts \p ids and removes the duplicates. When the ids are dense,
+     * they are collected in a bitmap, which takes linear time.
+     */
+    static QVector<quint64> sortUnique(QVector<quint64> ids);
 
 private:
-    QVector<PostingIterator*> m_iterators;
+    struct Entry {
+        quint64 docId;
+        PostingIterator* iter;
+    };
+
+    // Moves the top entry down after its id has grown, removing it
+    // if its iterator is done
+    void updateTop(quint64 docId);
+
+    QVector<Entry> m_heap;
     quint64 m_docId;
-    quint64 m_nextId;
 };
 }
 
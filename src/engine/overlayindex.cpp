@@ -0,0 +1,287 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "overlayindex.h"
+#include "document.h"
+#include "enginequery.h"
+#include "levenshteinautomaton.h"
+#include "vectorpostingiterator.h"
+#include "enginedebug.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+
+using namespace Baloo;
+
+namespace {
+const quint32 overlayVersion = 1;
+
+// Documents published longer ago than this belong to a writer which
+// did not get to clean up after itself
+const int maxAgeSecs = 10 * 60;
+
+bool matches(const QVector<QByteArray>& terms, const EngineQuery& query)
+{
+    if (query.leaf()) {
+        const QByteArray& term = query.term();
+        if (query.op() == EngineQuery::Fuzzy) {
+            const QByteArray prefix = term.left(query.prefixSize());
+            const LevenshteinAutomaton automaton(term.mid(query.prefixSize()), query.distance());
+            auto it = std::lower_bound(terms.begin(), terms.end(), prefix);
+            for (; it != terms.end() && it->startsWith(prefix); ++it) {
+                // Words in the text are lower case, unlike the property terms
+                if (prefix.isEmpty() && it->at(0) >= 'A' && it->at(0) <= 'Z') {
+                    continue;
+                }
+                if (automaton.matches(it->mid(prefix.size()))) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        auto it = std::lower_bound(terms.begin(), terms.end(), term);
+        if (it == terms.end()) {
+            return false;
+        }
+        if (query.op() == EngineQuery::StartsWith) {
+            return it->startsWith(term);
+        }
+        return *it == term;
+    }
+
+    const auto subQueries = query.subQueries();
+    if (subQueries.isEmpty()) {
+        return false;
+    }
+
+    if (query.op() == EngineQuery::Or) {
+        return std::any_of(subQueries.begin(), subQueries.end(), [&terms](const EngineQuery& q) {
+            return matches(terms, q);
+        });
+    }
+    // And and Phrase, the positions are not known
+    return std::all_of(subQueries.begin(), subQueries.end(), [&terms](const EngineQuery& q) {
+        return matches(terms, q);
+    });
+}
+}
+
+OverlayIndex::OverlayIndex(const QString& dbPath)
+{
+    const QByteArray hash = QCryptographicHash::hash(QFile::encodeName(dbPath), QCryptographicHash::Sha1).toHex().left(16);
+    const QString runtimeDir = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    m_path = runtimeDir + QLatin1String("/baloo-overlay-") + QString::fromLatin1(hash);
+}
+
+bool OverlayIndex::add(const Document& doc)
+{
+    if (!doc.m_id) {
+        return false;
+    }
+
+    Entry entry;
+    entry.url = doc.m_url;
+    entry.mTime = doc.m_mTime;
+    entry.terms.reserve(doc.m_terms.size() + doc.m_xattrTerms.size() + doc.m_fileNameTerms.size());
+    for (auto it = doc.m_terms.cbegin(); it != doc.m_terms.cend(); ++it) {
+        entry.terms << it.key();
+    }
+    for (auto it = doc.m_xattrTerms.cbegin(); it != doc.m_xattrTerms.cend(); ++it) {
+        entry.terms << it.key();
+    }
+    for (auto it = doc.m_fileNameTerms.cbegin(); it != doc.m_fileNameTerms.cend(); ++it) {
+        entry.terms << it.key();
+    }
+    std::sort(entry.terms.begin(), entry.terms.end());
+    entry.terms.erase(std::unique(entry.terms.begin(), entry.terms.end()), entry.terms.end());
+
+    m_documents.insert(doc.m_id, entry);
+
+    if (!QDir().mkpath(m_path)) {
+        qCWarning(ENGINE) << "Could not create the overlay directory" << m_path;
+        return false;
+    }
+
+    QSaveFile file(m_path + QLatin1Char('/') + QString::number(doc.m_id));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(ENGINE) << "Could not publish" << doc.m_url << file.errorString();
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream << overlayVersion << entry.url << entry.mTime << entry.terms;
+    if (!file.commit()) {
+        qCWarning(ENGINE) << "Could not publish" << doc.m_url << file.errorString();
+        return false;
+    }
+
+    if (!m_published.contains(doc.m_id)) {
+        m_published << doc.m_id;
+    }
+    return true;
+}
+
+void OverlayIndex::clear()
+{
+    for (quint64 id : qAsConst(m_published)) {
+        QFile::remove(m_path + QLatin1Char('/') + QString::number(id));
+    }
+    m_published.clear();
+    m_documents.clear();
+}
+
+void OverlayIndex::load()
+{
+    m_documents.clear();
+
+    QDir dir(m_path);
+    if (!dir.exists()) {
+        return;
+    }
+
+    const QDateTime oldest = QDateTime::currentDateTime().addSecs(-maxAgeSecs);
+    const QFileInfoList files = dir.entryInfoList(QDir::Files);
+    for (const QFileInfo& fileInfo : files) {
+        if (fileInfo.lastModified() < oldest) {
+            continue;
+        }
+
+        bool ok = false;
+        const quint64 id = fileInfo.fileName().toULongLong(&ok);
+        if (!ok || !id) {
+            continue;
+        }
+
+        QFile file(fileInfo.absoluteFilePath());
+        // The writer might have committed the document in the meantime
+        if (!file.open(QIODevice::ReadOnly)) {
+            continue;
+        }
+
+        QDataStream stream(&file);
+        quint32 version = 0;
+        stream >> version;
+        if (version != overlayVersion) {
+            continue;
+        }
+
+        Entry entry;
+        stream >> entry.url >> entry.mTime >> entry.terms;
+        if (stream.status() != QDataStream::Ok) {
+            qCDebug(ENGINE) << "Skipping corrupt overlay entry" << fileInfo.fileName();
+            continue;
+        }
+        m_documents.insert(id, entry);
+    }
+}
+
+QByteArray OverlayIndex::documentUrl(quint64 id) const
+{
+    return m_documents.value(id).url;
+}
+
+quint32 OverlayIndex::documentMTime(quint64 id) const
+{
+    return m_documents.value(id).mTime;
+}
+
+template <typename Filter>
+PostingIterator* OverlayIndex::iter(Filter filter) const
+{
+    QVector<quint64> ids;
+    for (auto it = m_documents.cbegin(); it != m_documents.cend(); ++it) {
+        if (filter(it.value())) {
+            ids << it.key();
+        }
+    }
+
+    if (ids.isEmpty()) {
+        return nullptr;
+    }
+    return new VectorPostingIterator(ids);
+}
+
+PostingIterator* OverlayIndex::postingIterator(const EngineQuery& query) const
+{
+    if (m_documents.isEmpty()) {
+        return nullptr;
+    }
+    return iter([&query](const Entry& entry) {
+        return matches(entry.terms, query);
+    });
+}
+
+PostingIterator* OverlayIndex::postingCompIterator(const QByteArray& prefix, qlonglong value, PostingDB::Comparator com) const
+{
+    const int prefixLen = prefix.length();
+    return iter([&prefix, prefixLen, value, com](const Entry& entry) {
+        auto it = std::lower_bound(entry.terms.begin(), entry.terms.end(), prefix);
+        for (; it != entry.terms.end() && it->startsWith(prefix); ++it) {
+            bool ok = false;
+            auto val = QByteArray::fromRawData(it->constData() + prefixLen, it->length() - prefixLen).toLongLong(&ok);
+            if (ok && ((com == PostingDB::LessEqual && val <= value) || (com == PostingDB::GreaterEqual && val >= value))) {
+                return true;
+            }
+        }
+        return false;
+    });
+}
+
+PostingIterator* OverlayIndex::mTimeIter(quint32 mtime, MTimeDB::Comparator com) const
+{
+    return iter([mtime, com](const Entry& entry) {
+        switch (com) {
+        case MTimeDB::Equal:
+            return entry.mTime == mtime;
+        case MTimeDB::LessEqual:
+            return entry.mTime <= mtime;
+        case MTimeDB::GreaterEqual:
+            return entry.mTime >= mtime;
+        }
+        return false;
+    });
+}
+
+PostingIterator* OverlayIndex::mTimeRangeIter(quint32 beginTime, quint32 endTime) const
+{
+    return iter([beginTime, endTime](const Entry& entry) {
+        return entry.mTime >= beginTime && entry.mTime <= endTime;
+    });
+}
+
+PostingIterator* OverlayIndex::folderIter(const QByteArray& folder) const
+{
+    QByteArray prefix = folder;
+    if (!prefix.endsWith('/')) {
+        prefix.append('/');
+    }
+    return iter([&prefix](const Entry& entry) {
+        return entry.url.startsWith(prefix);
+    });
+}
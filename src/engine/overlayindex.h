@@ -0,0 +1,117 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef BALOO_OVERLAYINDEX_H
+#define BALOO_OVERLAYINDEX_H
+
+#include "engine_export.h"
+#include "postingdb.h"
+#include "mtimedb.h"
+
+#include <QByteArray>
+#include <QMap>
+#include <QString>
+#include <QVector>
+
+namespace Baloo {
+
+class Document;
+class EngineQuery;
+class PostingIterator;
+
+/**
+ * A small index of documents which have been extracted, but whose
+ * transaction has not been committed yet.
+ *
+ * The writer publishes every document as soon as it has been indexed,
+ * one file per document in the runtime directory, and clears them once
+ * the LMDB transaction containing them has been committed. Readers load
+ * the published documents and merge them with the results from the
+ * database, so that freshly indexed files can be found right away.
+ *
+ * Only the terms are kept, not their positions, so phrase queries
+ * match any document containing all of the words.
+ */
+class BALOO_ENGINE_EXPORT OverlayIndex
+{
+public:
+    explicit OverlayIndex(const QString& dbPath);
+
+    /**
+     * Publishes the document \p doc, replacing an earlier version
+     */
+    bool add(const Document& doc);
+
+    /**
+     * Withdraws all the documents published by this instance
+     */
+    void clear();
+
+    /**
+     * Loads the documents published by all the writers. Documents which
+     * have been published too long ago are ignored, as their writer is
+     * most likely gone.
+     */
+    void load();
+
+    bool isEmpty() const {
+        return m_documents.isEmpty();
+    }
+
+    bool contains(quint64 id) const {
+        return m_documents.contains(id);
+    }
+
+    QByteArray documentUrl(quint64 id) const;
+    quint32 documentMTime(quint64 id) const;
+
+    //
+    // Query methods, matching the ones of the Transaction
+    //
+    PostingIterator* postingIterator(const EngineQuery& query) const;
+    PostingIterator* postingCompIterator(const QByteArray& prefix, qlonglong value, PostingDB::Comparator com) const;
+    PostingIterator* mTimeIter(quint32 mtime, MTimeDB::Comparator com) const;
+    PostingIterator* mTimeRangeIter(quint32 beginTime, quint32 endTime) const;
+
+    /**
+     * Iterates over the documents below the folder \p folder
+     */
+    PostingIterator* folderIter(const QByteArray& folder) const;
+
+private:
+    struct Entry {
+        QByteArray url;
+        quint32 mTime = 0;
+        // sorted
+        QVector<QByteArray> terms;
+    };
+
+    template <typename Filter>
+    PostingIterator* iter(Filter filter) const;
+    PostingIterator* termIter(const QByteArray& term, bool prefix) const;
+
+    QString m_path;
+    QMap<quint64, Entry> m_documents;
+    QVector<quint64> m_published;
+};
+}
+
+#endif // BALOO_OVERLAYINDEX_H
@@ -0,0 +1,114 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "pendingtermoperations.h"
+
+#include <algorithm>
+#include <numeric>
+
+using namespace Baloo;
+
+void PendingTermOperations::add(const QByteArray& term, quint64 id, const QVector<uint>& positions)
+{
+    append(term, AddId, id, positions);
+}
+
+void PendingTermOperations::remove(const QByteArray& term, quint64 id)
+{
+    append(term, RemoveId, id, QVector<uint>());
+}
+
+void PendingTermOperations::replacePositions(const QByteArray& term, quint64 id, const QVector<uint>& positions)
+{
+    append(term, ReplacePositions, id, positions);
+}
+
+void PendingTermOperations::append(const QByteArray& term, OperationType type, quint64 id, const QVector<uint>& positions)
+{
+    Entry entry;
+    entry.docId = id;
+    entry.next = -1;
+    entry.positionOffset = m_positions.size();
+    entry.positionCount = positions.size();
+    entry.type = type;
+    m_positions.append(positions);
+
+    const int index = m_entries.size();
+    m_entries.append(entry);
+
+    auto it = m_termIndex.find(term);
+    if (it == m_termIndex.end()) {
+        // The hash and the slot share the data of the term
+        it = m_termIndex.insert(term, m_terms.size());
+        m_terms.append({it.key(), index, index, 1});
+        m_termBytes += term.size();
+        return;
+    }
+
+    TermSlot& slot = m_terms[it.value()];
+    m_entries[slot.last].next = index;
+    slot.last = index;
+    slot.count++;
+}
+
+void PendingTermOperations::clear()
+{
+    m_termIndex.clear();
+    // resize keeps the capacity, unlike QVector::clear in older Qt versions
+    m_terms.resize(0);
+    m_entries.resize(0);
+    m_positions.resize(0);
+    m_termBytes = 0;
+}
+
+qint64 PendingTermOperations::memoryUsage() const
+{
+    // A hash node holds the key, the value and two pointers
+    const qint64 hashNodeSize = sizeof(QByteArray) + sizeof(int) + 2 * sizeof(void*);
+
+    return m_termBytes
+        + m_terms.size() * (sizeof(TermSlot) + hashNodeSize)
+        + m_entries.size() * sizeof(Entry)
+        + m_positions.size() * sizeof(uint);
+}
+
+QVector<int> PendingTermOperations::sortedTerms() const
+{
+    QVector<int> order(m_terms.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [this](int a, int b) {
+        return m_terms[a].term < m_terms[b].term;
+    });
+    return order;
+}
+
+QVector<PendingTermOperations::Operation> PendingTermOperations::operations(int slot) const
+{
+    const TermSlot& termSlot = m_terms[slot];
+
+    QVector<Operation> result;
+    result.reserve(termSlot.count);
+    for (int i = termSlot.first; i != -1; i = m_entries[i].next) {
+        const Entry& entry = m_entries[i];
+        result.append({entry.type, entry.docId, m_positions.constData() + entry.positionOffset, entry.positionCount});
+    }
+    return result;
+}
@@ -0,0 +1,130 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef BALOO_PENDINGTERMOPERATIONS_H
+#define BALOO_PENDINGTERMOPERATIONS_H
+
+#include "engine_export.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QVector>
+
+namespace Baloo {
+
+/**
+ * The term operations a WriteTransaction has queued, but not yet written
+ * into the PostingDB and PositionDB.
+ *
+ * A batch easily contains millions of operations, so they are not stored
+ * as individual objects. Every distinct term is interned once, the
+ * operations are records in a single array chained per term, and all the
+ * positions are packed into one run. clear() keeps the allocated capacity,
+ * so after the first flush a transaction mostly stops allocating.
+ */
+class BALOO_ENGINE_EXPORT PendingTermOperations
+{
+public:
+    enum OperationType {
+        AddId,
+        RemoveId,
+        // Only the positions of the id change, not the posting list
+        ReplacePositions
+    };
+
+    /**
+     * A queued operation. The positions point into the packed run, and
+     * are only valid until the next operation is added.
+     */
+    struct Operation {
+        OperationType type;
+        quint64 docId;
+        const uint* positions;
+        int positionCount;
+    };
+
+    void add(const QByteArray& term, quint64 id, const QVector<uint>& positions);
+    void remove(const QByteArray& term, quint64 id);
+
+    /**
+     * Replaces the positions of \p id for \p term, without changing
+     * whether the id is in the posting list of the term
+     */
+    void replacePositions(const QByteArray& term, quint64 id, const QVector<uint>& positions);
+
+    bool isEmpty() const {
+        return m_entries.isEmpty();
+    }
+
+    /**
+     * Removes all the operations, without releasing the memory
+     */
+    void clear();
+
+    /**
+     * The approximate memory used by the queued operations
+     */
+    qint64 memoryUsage() const;
+
+    /**
+     * The term slots, in the key order of the databases
+     */
+    QVector<int> sortedTerms() const;
+
+    QByteArray term(int slot) const {
+        return m_terms[slot].term;
+    }
+
+    /**
+     * The operations for the term in \p slot, in the order they were queued
+     */
+    QVector<Operation> operations(int slot) const;
+
+private:
+    struct Entry {
+        quint64 docId;
+        int next;
+        int positionOffset;
+        int positionCount;
+        OperationType type;
+    };
+
+    struct TermSlot {
+        QByteArray term;
+        int first;
+        int last;
+        int count;
+    };
+
+    void append(const QByteArray& term, OperationType type, quint64 id, const QVector<uint>& positions);
+
+    QHash<QByteArray, int> m_termIndex;
+    QVector<TermSlot> m_terms;
+    QVector<Entry> m_entries;
+    QVector<uint> m_positions;
+    qint64 m_termBytes = 0;
+};
+
+}
+
+Q_DECLARE_TYPEINFO(Baloo::PendingTermOperations::Operation, Q_PRIMITIVE_TYPE);
+
+#endif // BALOO_PENDINGTERMOPERATIONS_H
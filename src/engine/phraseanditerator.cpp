@@ -20,6 +20,9 @@
 
 #include "phraseanditerator.h"
 #include "positioninfo.h"
+#include "gallopsearch.h"
+
+#include <algorithm>
 
 using namespace Baloo;
 
@@ -31,6 +34,15 @@ PhraseAndIterator::PhraseAndIterator(const QVector<VectorPositionInfoIterator*>&
         qDeleteAll(m_iterators);
         m_iterators.clear();
     }
+
+    m_order.reserve(m_iterators.size());
+    for (int i = 0; i < m_iterators.size(); i++) {
+        m_order << i;
+    }
+    std::stable_sort(m_order.begin(), m_order.end(), [this](int a, int b) {
+        return m_iterators[a]->cost() < m_iterators[b]->cost();
+    });
+    m_cursors.resize(m_iterators.size());
 }
 
 PhraseAndIterator::~PhraseAndIterator()
@@ -43,47 +55,95 @@ quint64 PhraseAndIterator::docId() const
     return m_docId;
 }
 
+quint64 PhraseAndIterator::cost() const
+{
+    if (m_iterators.isEmpty()) {
+        return 0;
+    }
+
+    quint64 cost = m_iterators[0]->cost();
+    for (auto* iter : m_iterators) {
+        cost = qMin(cost, iter->cost());
+    }
+    return cost;
+}
+
 bool PhraseAndIterator::checkIfPositionsMatch()
 {
-    QVector< QVector<uint> > positionList;
-    positionList.reserve(m_iterators.size());
-    // All the iterators should have the same value
-    for (int i = 0; i < m_iterators.size(); i++) {
-        auto* iter = m_iterators[i];
-        Q_ASSERT(iter->docId() == m_docId);
+    // The positions of every term are sorted, so each one is only
+    // searched forward from where the previous start left off
+    int rarest = 0;
+    for (int i = 1; i < m_iterators.size(); i++) {
+        if (m_iterators[i]->positions().size() < m_iterators[rarest]->positions().size()) {
+            rarest = i;
+        }
+    }
+    std::fill(m_cursors.begin(), m_cursors.end(), 0);
 
-        QVector<uint> pi = iter->positions();
-        for (int j = 0; j < pi.size(); j++) {
-            pi[j] -= i;
+    const QVector<uint>& anchors = m_iterators[rarest]->positions();
+    for (uint anchor : anchors) {
+        if (anchor < static_cast<uint>(rarest)) {
+            continue;
+        }
+        const uint start = anchor - rarest;
+
+        bool match = true;
+        for (int i = 0; i < m_iterators.size() && match; i++) {
+            if (i == rarest) {
+                continue;
+            }
+
+            const QVector<uint>& positions = m_iterators[i]->positions();
+            const uint wanted = start + i;
+            int& cursor = m_cursors[i];
+            cursor = gallopSearch(positions, cursor, wanted, [](uint position) {
+                return position;
+            });
+            if (cursor >= positions.size()) {
+                // The later starts are larger still
+                return false;
+            }
+            match = positions[cursor] == wanted;
         }
 
-        positionList << pi;
+        if (match) {
+            return true;
+        }
     }
 
-    // Intersect all these positions
-    QVector<uint> vec = positionList[0];
-    for (int l = 1; l < positionList.size(); l++) {
-        QVector<uint> newVec = positionList[l];
-
-        int i = 0;
-        int j = 0;
-        QVector<uint> finalVec;
-        while (i < vec.size() && j < newVec.size()) {
-            if (vec[i] == newVec[j]) {
-                finalVec << vec[i];
-                i++;
-                j++;
-            } else if (vec[i] < newVec[j]) {
-                i++;
-            } else {
-                j++;
+    return false;
+}
+
+quint64 PhraseAndIterator::advance(quint64 candidate)
+{
+    VectorPositionInfoIterator* lead = m_iterators[m_order[0]];
+
+    while (candidate) {
+        bool allEqual = true;
+        for (int k = 1; k < m_order.size(); k++) {
+            const quint64 id = m_iterators[m_order[k]]->skipTo(candidate);
+            if (id == 0) {
+                m_docId = 0;
+                return 0;
+            }
+            if (id != candidate) {
+                candidate = lead->skipTo(id);
+                allEqual = false;
+                break;
             }
         }
 
-        vec = finalVec;
+        if (allEqual) {
+            if (checkIfPositionsMatch()) {
+                m_docId = candidate;
+                return m_docId;
+            }
+            candidate = lead->next();
+        }
     }
 
-    return !vec.isEmpty();
+    m_docId = 0;
+    return 0;
 }
 
 quint64 PhraseAndIterator::next()
@@ -93,30 +153,18 @@ quint64 PhraseAndIterator::next()
         return 0;
     }
 
-    if (m_iterators[0]->next() == 0) {
+    return advance(m_iterators[m_order[0]]->next());
+}
+
+quint64 PhraseAndIterator::skipTo(quint64 docId)
+{
+    if (m_iterators.isEmpty()) {
         m_docId = 0;
         return 0;
     }
-
-    m_docId = m_iterators[0]->docId();
-
-    for (int i = 1; i < m_iterators.size(); i++) {
-        PostingIterator* iter = m_iterators[i];
-        if (iter->docId() == 0 && iter->next() == 0) {
-            m_docId = 0;
-            return 0;
-        }
-
-        iter->skipTo(m_docId);
-
-        if (m_docId != iter->docId()) {
-            return next();
-        }
+    if (m_docId && m_docId >= docId) {
+        return m_docId;
     }
 
-    if (checkIfPositionsMatch())
-        return m_docId;
-    else
-        return next();
+    return advance(m_iterators[m_order[0]]->skipTo(docId));
 }
-
@@ -28,6 +28,13 @@
 
 namespace Baloo {
 
+/**
+ * Matches the documents in which the terms of the iterators follow each
+ * other, in the order of the iterators. The documents are driven by the
+ * rarest term, and the positions by the term with the fewest positions
+ * in the document, galloping through the others. Nothing is allocated
+ * per document.
+ */
 class BALOO_ENGINE_EXPORT PhraseAndIterator : public PostingIterator
 {
 public:
@@ -36,12 +43,24 @@ public:
 
     quint64 next() override;
     quint64 docId() const override;
+    quint64 skipTo(quint64 docId) override;
+    quint64 cost() const override;
 
 private:
+    /*
+     * Finds the first document from \p candidate on, which has to be the
+     * current id of the rarest iterator, that contains the phrase
+     */
+    quint64 advance(quint64 candidate);
+    bool checkIfPositionsMatch();
+
+    // In phrase order, so the index is the offset of the term
     QVector<VectorPositionInfoIterator*> m_iterators;
+    // The indexes into m_iterators, rarest first
+    QVector<int> m_order;
+    // Where the position search of every term stopped
+    QVector<int> m_cursors;
     quint64 m_docId;
-
-    bool checkIfPositionsMatch();
 };
 }
 
@@ -22,17 +22,29 @@
 #include "positiondb.h"
 #include "positioncodec.h"
 #include "positioninfo.h"
+#include "postingdeltadb.h"
 #include "postingiterator.h"
 #include "vectorpositioninfoiterator.h"
 
 using namespace Baloo;
 
 PositionDB::PositionDB(MDB_dbi dbi, MDB_txn* txn)
+    : PositionDB(dbi, 0, txn)
+{
+}
+
+PositionDB::PositionDB(MDB_dbi dbi, MDB_dbi deltaDbi, MDB_txn* txn)
     : m_txn(txn)
     , m_dbi(dbi)
+    , m_deltaDbi(0)
 {
     Q_ASSERT(txn != nullptr);
     Q_ASSERT(dbi != 0);
+
+    // Only look for deltas if there are any, which is the common case
+    if (deltaDbi && PostingDeltaDB(deltaDbi, txn).size()) {
+        m_deltaDbi = deltaDbi;
+    }
 }
 
 PositionDB::~PositionDB()
@@ -93,19 +105,33 @@ QVector<PositionInfo> PositionDB::get(const QByteArray& term)
     key.mv_size = term.size();
     key.mv_data = static_cast<void*>(const_cast<char*>(term.constData()));
 
+    QVector<PositionInfo> list;
     MDB_val val{0, nullptr};
     int rc = mdb_get(m_txn, m_dbi, &key, &val);
-    if (rc) {
-        if (rc != MDB_NOTFOUND) {
-            qCDebug(ENGINE) << "PositionDB::get" << term << mdb_strerror(rc);
-        }
-        return QVector<PositionInfo>();
+    if (rc == 0) {
+        QByteArray data = QByteArray::fromRawData(static_cast<char*>(val.mv_data), val.mv_size);
+
+        PositionCodec codec;
+        list = codec.decode(data);
+    } else if (rc != MDB_NOTFOUND) {
+        qCDebug(ENGINE) << "PositionDB::get" << term << mdb_strerror(rc);
     }
 
-    QByteArray data = QByteArray::fromRawData(static_cast<char*>(val.mv_data), val.mv_size);
+    applyDeltas(term, list);
+    return list;
+}
 
-    PositionCodec codec;
-    return codec.decode(data);
+void PositionDB::applyDeltas(const QByteArray& term, QVector<PositionInfo>& list) const
+{
+    if (!m_deltaDbi) {
+        return;
+    }
+
+    PostingDeltaDB deltaDb(m_deltaDbi, m_txn);
+    const QVector<PostingDeltaDB::Delta> deltas = deltaDb.get(term);
+    for (const PostingDeltaDB::Delta& delta : deltas) {
+        PostingDeltaDB::applyPositions(list, delta);
+    }
 }
 
 void PositionDB::del(const QByteArray& term)
@@ -136,14 +162,23 @@ VectorPositionInfoIterator* PositionDB::iter(const QByteArray& term)
 
     MDB_val val{0, nullptr};
     int rc = mdb_get(m_txn, m_dbi, &key, &val);
-    if (rc) {
+    if (rc && (rc != MDB_NOTFOUND || !m_deltaDbi)) {
         qCDebug(ENGINE) << "PositionDB::iter" << term << mdb_strerror(rc);
         return nullptr;
     }
 
     PositionCodec codec;
-    QByteArray ba(static_cast<char*>(val.mv_data), val.mv_size);
-    return new VectorPositionInfoIterator(codec.decode(ba));
+    QVector<PositionInfo> list;
+    if (rc == 0) {
+        QByteArray ba(static_cast<char*>(val.mv_data), val.mv_size);
+        list = codec.decode(ba);
+    }
+
+    applyDeltas(term, list);
+    if (list.isEmpty()) {
+        return nullptr;
+    }
+    return new VectorPositionInfoIterator(list);
 }
 
 QMap<QByteArray, QVector<PositionInfo>> PositionDB::toTestMap() const
@@ -163,7 +198,8 @@ QMap<QByteArray, QVector<PositionInfo>> PositionDB::toTestMap() const
         }
 
         const QByteArray ba(static_cast<char*>(key.mv_data), key.mv_size);
-        const QVector<PositionInfo> vinfo = PositionCodec().decode(QByteArray(static_cast<char*>(val.mv_data), val.mv_size));
+        QVector<PositionInfo> vinfo = PositionCodec().decode(QByteArray(static_cast<char*>(val.mv_data), val.mv_size));
+        applyDeltas(ba, vinfo);
         map.insert(ba, vinfo);
     }
 
@@ -33,10 +33,16 @@ namespace Baloo {
 class PositionInfo;
 class VectorPositionInfoIterator;
 
+/**
+ * When given the dbi of a PostingDeltaDB, get and iter return the lists
+ * with the positions of the pending deltas applied. put and del only
+ * touch the main database.
+ */
 class BALOO_ENGINE_EXPORT PositionDB
 {
 public:
     explicit PositionDB(MDB_dbi dbi, MDB_txn* txn);
+    PositionDB(MDB_dbi dbi, MDB_dbi deltaDbi, MDB_txn* txn);
     ~PositionDB();
 
     static MDB_dbi create(MDB_txn* txn);
@@ -50,8 +56,11 @@ public:
 
     QMap<QByteArray, QVector<PositionInfo>> toTestMap() const;
 private:
+    void applyDeltas(const QByteArray& term, QVector<PositionInfo>& list) const;
+
     MDB_txn* m_txn;
     MDB_dbi m_dbi;
+    MDB_dbi m_deltaDbi;
 };
 
 }
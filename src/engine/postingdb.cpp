@@ -20,17 +20,58 @@
 
 #include "enginedebug.h"
 #include "postingdb.h"
+#include "postingdeltadb.h"
 #include "orpostingiterator.h"
+#include "vectorpostingiterator.h"
 #include "postingcodec.h"
+#include "gallopsearch.h"
+#include "levenshteinautomaton.h"
+#include "regexpliterals.h"
+
+#include <limits>
 
 using namespace Baloo;
 
+namespace {
+// An expansion to at most this many terms is always merged lazily,
+const int streamingMaxTerms = 8;
+// and one to more than this many is always united up front.
+const int eagerMinTerms = 1024;
+// In between, it is united up front when the lists are short on average,
+// as then setting up the iterators and the heap costs more than the ids.
+const int eagerMaxAverageIds = 256;
+
+bool preferEagerUnion(int termCount, qint64 totalIds)
+{
+    if (termCount <= streamingMaxTerms) {
+        return false;
+    }
+    if (termCount > eagerMinTerms) {
+        return true;
+    }
+    return totalIds <= static_cast<qint64>(termCount) * eagerMaxAverageIds;
+}
+}
+
 PostingDB::PostingDB(MDB_dbi dbi, MDB_txn* txn)
+    : PostingDB(dbi, 0, txn)
+{
+}
+
+PostingDB::PostingDB(MDB_dbi dbi, MDB_dbi deltaDbi, MDB_txn* txn)
     : m_txn(txn)
     , m_dbi(dbi)
+    , m_deltaDbi(0)
+    , m_firstId(0)
+    , m_lastId(std::numeric_limits<quint64>::max())
 {
     Q_ASSERT(txn != nullptr);
     Q_ASSERT(dbi != 0);
+
+    // Only look for deltas if there are any, which is the common case
+    if (deltaDbi && PostingDeltaDB(deltaDbi, txn).size()) {
+        m_deltaDbi = deltaDbi;
+    }
 }
 
 PostingDB::~PostingDB()
@@ -100,10 +141,43 @@ PostingList PostingDB::get(const QByteArray& term)
         return PostingList();
     }
 
-    QByteArray arr = QByteArray::fromRawData(static_cast<char*>(val.mv_data), val.mv_size);
+    return decode(term, val);
+}
 
-    PostingCodec codec;
-    return codec.decode(arr);
+void PostingDB::applyDeltas(const QByteArray& term, PostingList& list) const
+{
+    if (!m_deltaDbi) {
+        return;
+    }
+
+    PostingDeltaDB deltaDb(m_deltaDbi, m_txn);
+    const QVector<PostingDeltaDB::Delta> deltas = deltaDb.get(term);
+    for (const PostingDeltaDB::Delta& delta : deltas) {
+        if (isRanged()) {
+            PostingDeltaDB::apply(list, PostingDeltaDB::slice(delta, m_firstId, m_lastId));
+        } else {
+            PostingDeltaDB::apply(list, delta);
+        }
+    }
+}
+
+void PostingDB::setIdRange(quint64 first, quint64 last)
+{
+    m_firstId = first;
+    m_lastId = last;
+}
+
+bool PostingDB::isRanged() const
+{
+    return m_firstId > 0 || m_lastId < std::numeric_limits<quint64>::max();
+}
+
+PostingList PostingDB::decode(const QByteArray& term, const MDB_val& val) const
+{
+    const QByteArray arr = QByteArray::fromRawData(static_cast<char*>(val.mv_data), val.mv_size);
+    PostingList list = isRanged() ? PostingCodec().decode(arr, m_firstId, m_lastId) : PostingCodec().decode(arr);
+    applyDeltas(term, list);
+    return list;
 }
 
 void PostingDB::del(const QByteArray& term)
@@ -152,6 +226,10 @@ public:
     DBPostingIterator(void* data, uint size);
     quint64 docId() const override;
     quint64 next() override;
+    quint64 skipTo(quint64 docId) override;
+    quint64 cost() const override {
+        return m_vec.size() - qBound(0, m_pos, m_vec.size());
+    }
 
 private:
     const QVector<quint64> m_vec;
@@ -171,6 +249,74 @@ PostingIterator* PostingDB::iter(const QByteArray& term)
         return nullptr;
     }
 
+    return termIter(term, val);
+}
+
+quint64 PostingDB::documentCount(const QByteArray& term)
+{
+    MDB_val key;
+    key.mv_size = term.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(term.constData()));
+
+    MDB_val val;
+    int rc = mdb_get(m_txn, m_dbi, &key, &val);
+    if (rc) {
+        if (rc != MDB_NOTFOUND) {
+            qCDebug(ENGINE) << "PostingDB::documentCount" << term << mdb_strerror(rc);
+        }
+        return 0;
+    }
+
+    quint64 count = val.mv_size / sizeof(quint64);
+    if (m_deltaDbi) {
+        PostingDeltaDB deltaDb(m_deltaDbi, m_txn);
+        if (deltaDb.count(term)) {
+            const QVector<PostingDeltaDB::Delta> deltas = deltaDb.get(term);
+            for (const PostingDeltaDB::Delta& delta : deltas) {
+                count += delta.added.size();
+            }
+        }
+    }
+    return count;
+}
+
+quint64 PostingDB::prefixDocumentCount(const QByteArray& prefix)
+{
+    Q_ASSERT(!prefix.isEmpty());
+
+    MDB_val key;
+    key.mv_size = prefix.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(prefix.constData()));
+
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_dbi, &cursor);
+
+    quint64 count = 0;
+    MDB_val val;
+    int rc = mdb_cursor_get(cursor, &key, &val, MDB_SET_RANGE);
+    while (rc == 0) {
+        const QByteArray arr = QByteArray::fromRawData(static_cast<char*>(key.mv_data), key.mv_size);
+        if (!arr.startsWith(prefix)) {
+            break;
+        }
+        count += val.mv_size / sizeof(quint64);
+        rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
+    }
+
+    if (rc != 0 && rc != MDB_NOTFOUND) {
+        qCWarning(ENGINE) << "PostingDB::prefixDocumentCount" << mdb_strerror(rc);
+    }
+
+    mdb_cursor_close(cursor);
+    return count;
+}
+
+PostingIterator* PostingDB::termIter(const QByteArray& term, const MDB_val& val)
+{
+    if (m_deltaDbi || isRanged()) {
+        return new VectorPostingIterator(decode(term, val));
+    }
+
     return new DBPostingIterator(val.mv_data, val.mv_size);
 }
 
@@ -203,6 +349,17 @@ quint64 DBPostingIterator::next()
     return m_vec[m_pos];
 }
 
+quint64 DBPostingIterator::skipTo(quint64 docId)
+{
+    m_pos = gallopSearch(m_vec, qMax(m_pos, 0), docId);
+    if (m_pos >= m_vec.size()) {
+        m_pos = m_vec.size();
+        return 0;
+    }
+
+    return m_vec[m_pos];
+}
+
 template <typename Validator>
 PostingIterator* PostingDB::iter(const QByteArray& prefix, Validator validate)
 {
@@ -215,7 +372,9 @@ PostingIterator* PostingDB::iter(const QByteArray& prefix, Validator validate)
     MDB_cursor* cursor;
     mdb_cursor_open(m_txn, m_dbi, &cursor);
 
-    QVector<PostingIterator*> termIterators;
+    // The values stay valid until the transaction changes something
+    QVector<QPair<QByteArray, MDB_val>> matches;
+    qint64 totalIds = 0;
 
     MDB_val val;
     int rc = mdb_cursor_get(cursor, &key, &val, MDB_SET_RANGE);
@@ -225,7 +384,8 @@ PostingIterator* PostingDB::iter(const QByteArray& prefix, Validator validate)
             break;
         }
         if (validate(arr)) {
-            termIterators << new DBPostingIterator(val.mv_data, val.mv_size);
+            matches.append(qMakePair(arr, val));
+            totalIds += val.mv_size / sizeof(quint64);
         }
         rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
     }
@@ -235,12 +395,55 @@ PostingIterator* PostingDB::iter(const QByteArray& prefix, Validator validate)
     }
 
     mdb_cursor_close(cursor);
-    if (termIterators.isEmpty()) {
+    return matchesIter(matches, totalIds);
+}
+
+PostingIterator* PostingDB::matchesIter(const QVector<QPair<QByteArray, MDB_val>>& matches, qint64 totalIds)
+{
+    if (matches.isEmpty()) {
         return nullptr;
     }
+
+    if (preferEagerUnion(matches.size(), totalIds)) {
+        return unite(matches, totalIds);
+    }
+
+    QVector<PostingIterator*> termIterators;
+    termIterators.reserve(matches.size());
+    for (const auto& match : qAsConst(matches)) {
+        termIterators << termIter(match.first, match.second);
+    }
     return new OrPostingIterator(termIterators);
 }
 
+PostingIterator* PostingDB::unite(const QVector<QPair<QByteArray, MDB_val>>& matches, qint64 totalIds)
+{
+    // All the lists are copied straight into one buffer, without
+    // decoding them into an iterator each
+    QVector<quint64> ids;
+    if (!isRanged()) {
+        ids.reserve(static_cast<int>(totalIds));
+    }
+    for (const auto& match : matches) {
+        const MDB_val& val = match.second;
+        if (m_deltaDbi || isRanged()) {
+            ids += decode(match.first, val);
+            continue;
+        }
+
+        const int count = val.mv_size / sizeof(quint64);
+        const int size = ids.size();
+        ids.resize(size + count);
+        memcpy(ids.data() + size, val.mv_data, count * sizeof(quint64));
+    }
+
+    ids = OrPostingIterator::sortUnique(std::move(ids));
+    if (ids.isEmpty()) {
+        return nullptr;
+    }
+    return new VectorPostingIterator(ids);
+}
+
 PostingIterator* PostingDB::prefixIter(const QByteArray& prefix)
 {
     auto validate = [] (const QByteArray& arr) {
@@ -252,13 +455,110 @@ PostingIterator* PostingDB::prefixIter(const QByteArray& prefix)
 
 PostingIterator* PostingDB::regexpIter(const QRegularExpression& regexp, const QByteArray& prefix)
 {
+    const RegExpLiterals literals(regexp);
+
     int prefixLen = prefix.length();
-    auto validate = [&regexp, prefixLen] (const QByteArray& arr) {
-        QString term = QString::fromUtf8(arr.mid(prefixLen));
+    auto validate = [&regexp, &literals, prefixLen] (const QByteArray& arr) {
+        const QByteArray subject = QByteArray::fromRawData(arr.constData() + prefixLen, arr.length() - prefixLen);
+        // Cheaper than decoding the term and running the expression
+        if (!literals.mayMatch(subject)) {
+            return false;
+        }
+        QString term = QString::fromUtf8(subject);
         return regexp.match(term).hasMatch();
     };
 
-    return iter(prefix, validate);
+    // Only the terms starting with the text the expression is anchored to are read
+    const QByteArray start = prefix + literals.prefix();
+
+    return iter(start, validate);
+}
+
+QVector<QPair<QByteArray, MDB_val>> PostingDB::fuzzyMatches(const QByteArray& prefix, const QByteArray& word,
+                                                            int distance, qint64* totalIds)
+{
+    const LevenshteinAutomaton automaton(word, distance);
+
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_dbi, &cursor);
+
+    // The values stay valid until the transaction changes something
+    QVector<QPair<QByteArray, MDB_val>> matches;
+    *totalIds = 0;
+
+    MDB_val key;
+    MDB_val val;
+    int rc;
+    if (prefix.isEmpty()) {
+        rc = mdb_cursor_get(cursor, &key, &val, MDB_FIRST);
+    } else {
+        key.mv_size = prefix.size();
+        key.mv_data = static_cast<void*>(const_cast<char*>(prefix.constData()));
+        rc = mdb_cursor_get(cursor, &key, &val, MDB_SET_RANGE);
+    }
+
+    QByteArray next;
+    while (rc == 0) {
+        const QByteArray arr(static_cast<char*>(key.mv_data), key.mv_size);
+        if (!arr.startsWith(prefix)) {
+            break;
+        }
+
+        // The words in the text are lower case, the terms starting with
+        // an upper case letter belong to properties
+        if (prefix.isEmpty() && arr.at(0) >= 'A' && arr.at(0) <= 'Z') {
+            next = QByteArray(1, 'Z' + 1);
+            key.mv_size = next.size();
+            key.mv_data = static_cast<void*>(next.data());
+            rc = mdb_cursor_get(cursor, &key, &val, MDB_SET_RANGE);
+            continue;
+        }
+
+        int deadEnd = -1;
+        const QByteArray subject = QByteArray::fromRawData(arr.constData() + prefix.size(), arr.size() - prefix.size());
+        if (automaton.matches(subject, &deadEnd)) {
+            matches.append(qMakePair(arr, val));
+            *totalIds += val.mv_size / sizeof(quint64);
+        } else if (deadEnd >= 0) {
+            // No term starting like this one can match, so continue
+            // with the first term sorted after all of them
+            next = arr.left(prefix.size() + deadEnd);
+            while (next.size() > prefix.size() && static_cast<uchar>(next.at(next.size() - 1)) == 0xff) {
+                next.chop(1);
+            }
+            if (next.size() == prefix.size()) {
+                break;
+            }
+            next[next.size() - 1] = next.at(next.size() - 1) + 1;
+
+            key.mv_size = next.size();
+            key.mv_data = static_cast<void*>(next.data());
+            rc = mdb_cursor_get(cursor, &key, &val, MDB_SET_RANGE);
+            continue;
+        }
+        rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
+    }
+
+    if (rc != 0 && rc != MDB_NOTFOUND) {
+        qCWarning(ENGINE) << "PostingDB::fuzzyMatches" << mdb_strerror(rc);
+    }
+
+    mdb_cursor_close(cursor);
+    return matches;
+}
+
+PostingIterator* PostingDB::fuzzyIter(const QByteArray& prefix, const QByteArray& word, int distance)
+{
+    qint64 totalIds = 0;
+    const auto matches = fuzzyMatches(prefix, word, distance, &totalIds);
+    return matchesIter(matches, totalIds);
+}
+
+quint64 PostingDB::fuzzyDocumentCount(const QByteArray& prefix, const QByteArray& word, int distance)
+{
+    qint64 totalIds = 0;
+    fuzzyMatches(prefix, word, distance, &totalIds);
+    return totalIds;
 }
 
 PostingIterator* PostingDB::compIter(const QByteArray& prefix, qlonglong comVal, PostingDB::Comparator com)
@@ -289,7 +589,8 @@ QMap<QByteArray, PostingList> PostingDB::toTestMap() const
         }
 
         const QByteArray ba(static_cast<char*>(key.mv_data), key.mv_size);
-        const PostingList plist = PostingCodec().decode(QByteArray(static_cast<char*>(val.mv_data), val.mv_size));
+        PostingList plist = PostingCodec().decode(QByteArray(static_cast<char*>(val.mv_data), val.mv_size));
+        applyDeltas(ba, plist);
         map.insert(ba, plist);
     }
 
@@ -25,6 +25,7 @@
 
 #include <QByteArray>
 #include <QVector>
+#include <QPair>
 #include <QRegularExpression>
 
 #include <lmdb.h>
@@ -36,11 +37,15 @@ typedef QVector<quint64> PostingList;
 /**
  * The PostingDB is the main database that maps <term> -> <id1> <id2> <id2> ...
  * This is used to do to lookup ids when searching for a <term>.
+ *
+ * When given the dbi of a PostingDeltaDB, all the lookups return the lists
+ * with the pending deltas applied. put and del only touch the main database.
  */
 class BALOO_ENGINE_EXPORT PostingDB
 {
 public:
     PostingDB(MDB_dbi, MDB_txn* txn);
+    PostingDB(MDB_dbi dbi, MDB_dbi deltaDbi, MDB_txn* txn);
     ~PostingDB();
 
     static MDB_dbi create(MDB_txn* txn);
@@ -50,16 +55,56 @@ public:
     PostingList get(const QByteArray& term);
     void del(const QByteArray& term);
 
+    /**
+     * Only the ids from \p first to \p last are decoded by the lookups
+     * done afterwards. The lists are cut down before they are merged,
+     * so that a query split into ranges only does the work of its range.
+     */
+    void setIdRange(quint64 first, quint64 last);
+
     PostingIterator* iter(const QByteArray& term);
     PostingIterator* prefixIter(const QByteArray& term);
+
+    /**
+     * Iterates over the documents containing a term which starts with
+     * \p prefix and matches \p regexp after it. The literal text the
+     * expression requires narrows down the terms it is run on.
+     */
     PostingIterator* regexpIter(const QRegularExpression& regexp, const QByteArray& prefix);
 
+    /**
+     * Iterates over the documents containing a term which starts with
+     * \p prefix and is at most \p distance edits away from \p word after
+     * it. The terms are walked in order, jumping over every range of
+     * terms whose start is already too far away from \p word.
+     */
+    PostingIterator* fuzzyIter(const QByteArray& prefix, const QByteArray& word, int distance);
+
     enum Comparator {
         LessEqual,
         GreaterEqual
     };
     PostingIterator* compIter(const QByteArray& prefix, qlonglong val, Comparator com);
 
+    /**
+     * The number of documents containing \p term, read from the size of
+     * its posting list without decoding it. The ids added by pending deltas
+     * are counted as well, so this is an upper bound.
+     */
+    quint64 documentCount(const QByteArray& term);
+
+    /**
+     * The number of documents containing each term starting with \p prefix,
+     * summed over the terms, without decoding any posting list
+     */
+    quint64 prefixDocumentCount(const QByteArray& prefix);
+
+    /**
+     * The number of documents containing each term fuzzyIter() matches,
+     * summed over the terms
+     */
+    quint64 fuzzyDocumentCount(const QByteArray& prefix, const QByteArray& word, int distance);
+
     QVector<QByteArray> fetchTermsStartingWith(const QByteArray& term);
 
     QMap<QByteArray, PostingList> toTestMap() const;
@@ -67,8 +112,20 @@ private:
     template <typename Validator>
     PostingIterator* iter(const QByteArray& prefix, Validator validate);
 
+    QVector<QPair<QByteArray, MDB_val>> fuzzyMatches(const QByteArray& prefix, const QByteArray& word, int distance, qint64* totalIds);
+
+    PostingIterator* matchesIter(const QVector<QPair<QByteArray, MDB_val>>& matches, qint64 totalIds);
+    PostingIterator* termIter(const QByteArray& term, const MDB_val& val);
+    PostingIterator* unite(const QVector<QPair<QByteArray, MDB_val>>& matches, qint64 totalIds);
+    PostingList decode(const QByteArray& term, const MDB_val& val) const;
+    void applyDeltas(const QByteArray& term, PostingList& list) const;
+    bool isRanged() const;
+
     MDB_txn* m_txn;
     MDB_dbi m_dbi;
+    MDB_dbi m_deltaDbi;
+    quint64 m_firstId;
+    quint64 m_lastId;
 };
 
 
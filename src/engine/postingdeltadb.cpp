@@ -0,0 +1,449 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "enginedebug.h"
+#include "postingdeltadb.h"
+#include "positioncodec.h"
+
+#include <QtEndian>
+
+#include <algorithm>
+#include <iterator>
+
+using namespace Baloo;
+
+namespace {
+
+const int seqSize = sizeof(quint32);
+
+// Set in the count of added ids when the delta carries positions, in which
+// case the count of removed ids and the positions follow
+const quint32 hasPositionsFlag = 0x80000000;
+
+QByteArray deltaKey(const QByteArray& term, quint32 seq)
+{
+    QByteArray key;
+    key.reserve(term.size() + 1 + seqSize);
+    key.append(term);
+    key.append('\0');
+
+    // Big endian, so the deltas of a term are sorted by sequence
+    uchar buf[seqSize];
+    qToBigEndian(seq, buf);
+    key.append(reinterpret_cast<const char*>(buf), seqSize);
+    return key;
+}
+
+bool isDeltaKeyOf(const MDB_val& key, const QByteArray& prefix)
+{
+    return key.mv_size == static_cast<size_t>(prefix.size() + seqSize)
+        && memcmp(key.mv_data, prefix.constData(), prefix.size()) == 0;
+}
+
+}
+
+bool PostingDeltaDB::Delta::operator==(const Delta& rhs) const
+{
+    // PositionInfo only compares the ids
+    auto samePositions = [](const PositionInfo& lhs, const PositionInfo& rhs) {
+        return lhs.docId == rhs.docId && lhs.positions == rhs.positions;
+    };
+    return added == rhs.added && removed == rhs.removed && positions.size() == rhs.positions.size()
+        && std::equal(positions.cbegin(), positions.cend(), rhs.positions.cbegin(), samePositions);
+}
+
+PostingDeltaDB::PostingDeltaDB(MDB_dbi dbi, MDB_txn* txn)
+    : m_txn(txn)
+    , m_dbi(dbi)
+{
+    Q_ASSERT(txn != nullptr);
+    Q_ASSERT(dbi != 0);
+}
+
+PostingDeltaDB::~PostingDeltaDB()
+{
+}
+
+MDB_dbi PostingDeltaDB::create(MDB_txn* txn)
+{
+    MDB_dbi dbi = 0;
+    int rc = mdb_dbi_open(txn, "postingdeltadb", MDB_CREATE, &dbi);
+    if (rc) {
+        qCWarning(ENGINE) << "PostingDeltaDB::create" << mdb_strerror(rc);
+        return 0;
+    }
+
+    return dbi;
+}
+
+MDB_dbi PostingDeltaDB::open(MDB_txn* txn)
+{
+    MDB_dbi dbi = 0;
+    int rc = mdb_dbi_open(txn, "postingdeltadb", 0, &dbi);
+    if (rc) {
+        // Databases created by older versions do not have it
+        qCDebug(ENGINE) << "PostingDeltaDB::open" << mdb_strerror(rc);
+        return 0;
+    }
+
+    return dbi;
+}
+
+void PostingDeltaDB::append(const QByteArray& term, const Delta& delta)
+{
+    Q_ASSERT(!term.isEmpty());
+
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_dbi, &cursor);
+
+    // The first key after all the deltas of the term
+    QByteArray prefix = term;
+    prefix.append('\1');
+
+    MDB_val key;
+    key.mv_size = prefix.size();
+    key.mv_data = static_cast<void*>(prefix.data());
+
+    int rc = mdb_cursor_get(cursor, &key, nullptr, MDB_SET_RANGE);
+    if (rc == 0) {
+        rc = mdb_cursor_get(cursor, &key, nullptr, MDB_PREV);
+    } else if (rc == MDB_NOTFOUND) {
+        rc = mdb_cursor_get(cursor, &key, nullptr, MDB_LAST);
+    }
+
+    prefix[prefix.size() - 1] = '\0';
+    quint32 seq = 0;
+    if (rc == 0 && isDeltaKeyOf(key, prefix)) {
+        seq = qFromBigEndian<quint32>(static_cast<const uchar*>(key.mv_data) + prefix.size()) + 1;
+    }
+    mdb_cursor_close(cursor);
+
+    const QByteArray newKey = deltaKey(term, seq);
+    const QByteArray arr = encode(delta);
+
+    key.mv_size = newKey.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(newKey.constData()));
+
+    MDB_val val;
+    val.mv_size = arr.size();
+    val.mv_data = static_cast<void*>(const_cast<char*>(arr.constData()));
+
+    rc = mdb_put(m_txn, m_dbi, &key, &val, 0);
+    if (rc) {
+        qCWarning(ENGINE) << "PostingDeltaDB::append" << mdb_strerror(rc);
+    }
+}
+
+int PostingDeltaDB::count(const QByteArray& term)
+{
+    Q_ASSERT(!term.isEmpty());
+
+    QByteArray prefix = term;
+    prefix.append('\0');
+
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_dbi, &cursor);
+
+    MDB_val key;
+    key.mv_size = prefix.size();
+    key.mv_data = static_cast<void*>(prefix.data());
+
+    int count = 0;
+    int rc = mdb_cursor_get(cursor, &key, nullptr, MDB_SET_RANGE);
+    while (rc == 0 && isDeltaKeyOf(key, prefix)) {
+        count++;
+        rc = mdb_cursor_get(cursor, &key, nullptr, MDB_NEXT);
+    }
+
+    mdb_cursor_close(cursor);
+    return count;
+}
+
+QVector<PostingDeltaDB::Delta> PostingDeltaDB::get(const QByteArray& term)
+{
+    Q_ASSERT(!term.isEmpty());
+
+    QByteArray prefix = term;
+    prefix.append('\0');
+
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_dbi, &cursor);
+
+    MDB_val key;
+    key.mv_size = prefix.size();
+    key.mv_data = static_cast<void*>(prefix.data());
+
+    QVector<Delta> deltas;
+    MDB_val val;
+    int rc = mdb_cursor_get(cursor, &key, &val, MDB_SET_RANGE);
+    while (rc == 0 && isDeltaKeyOf(key, prefix)) {
+        deltas << decode(QByteArray::fromRawData(static_cast<char*>(val.mv_data), val.mv_size));
+        rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
+    }
+    if (rc != 0 && rc != MDB_NOTFOUND) {
+        qCDebug(ENGINE) << "PostingDeltaDB::get" << term << mdb_strerror(rc);
+    }
+
+    mdb_cursor_close(cursor);
+    return deltas;
+}
+
+void PostingDeltaDB::del(const QByteArray& term)
+{
+    Q_ASSERT(!term.isEmpty());
+
+    QByteArray prefix = term;
+    prefix.append('\0');
+
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_dbi, &cursor);
+
+    MDB_val key;
+    key.mv_size = prefix.size();
+    key.mv_data = static_cast<void*>(prefix.data());
+
+    int rc = mdb_cursor_get(cursor, &key, nullptr, MDB_SET_RANGE);
+    while (rc == 0 && isDeltaKeyOf(key, prefix)) {
+        rc = mdb_cursor_del(cursor, 0);
+        if (rc) {
+            break;
+        }
+
+        key.mv_size = prefix.size();
+        key.mv_data = static_cast<void*>(prefix.data());
+        rc = mdb_cursor_get(cursor, &key, nullptr, MDB_SET_RANGE);
+    }
+    if (rc != 0 && rc != MDB_NOTFOUND) {
+        qCDebug(ENGINE) << "PostingDeltaDB::del" << term << mdb_strerror(rc);
+    }
+
+    mdb_cursor_close(cursor);
+}
+
+uint PostingDeltaDB::size() const
+{
+    MDB_stat stat;
+    int rc = mdb_stat(m_txn, m_dbi, &stat);
+    if (rc) {
+        qCDebug(ENGINE) << "PostingDeltaDB::size" << mdb_strerror(rc);
+        return 0;
+    }
+
+    return stat.ms_entries;
+}
+
+QVector<QByteArray> PostingDeltaDB::fetchTerms(int maxTerms)
+{
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_dbi, &cursor);
+
+    QVector<QByteArray> terms;
+    MDB_val key = {0, nullptr};
+    int rc = mdb_cursor_get(cursor, &key, nullptr, MDB_FIRST);
+    while (rc == 0 && terms.size() < maxTerms) {
+        if (key.mv_size > static_cast<size_t>(seqSize + 1)) {
+            const QByteArray term(static_cast<char*>(key.mv_data), key.mv_size - seqSize - 1);
+            if (terms.isEmpty() || terms.last() != term) {
+                terms << term;
+            }
+        }
+        rc = mdb_cursor_get(cursor, &key, nullptr, MDB_NEXT);
+    }
+    if (rc != 0 && rc != MDB_NOTFOUND) {
+        qCDebug(ENGINE) << "PostingDeltaDB::fetchTerms" << mdb_strerror(rc);
+    }
+
+    mdb_cursor_close(cursor);
+    return terms;
+}
+
+void PostingDeltaDB::apply(PostingList& list, const Delta& delta)
+{
+    PostingList remaining;
+    if (delta.removed.isEmpty()) {
+        remaining = list;
+    } else {
+        remaining.reserve(list.size());
+        std::set_difference(list.cbegin(), list.cend(), delta.removed.cbegin(), delta.removed.cend(),
+                            std::back_inserter(remaining));
+    }
+
+    if (delta.added.isEmpty()) {
+        list = remaining;
+        return;
+    }
+
+    PostingList result;
+    result.reserve(remaining.size() + delta.added.size());
+    std::set_union(remaining.cbegin(), remaining.cend(), delta.added.cbegin(), delta.added.cend(),
+                   std::back_inserter(result));
+    list = result;
+}
+
+void PostingDeltaDB::applyPositions(QVector<PositionInfo>& list, const Delta& delta)
+{
+    // Deltas written before they carried positions leave them alone, those
+    // were written to the PositionDB directly
+    if (delta.positions.isEmpty()) {
+        return;
+    }
+
+    QVector<PositionInfo> result;
+    result.reserve(list.size() + delta.positions.size());
+
+    auto changedIt = delta.positions.cbegin();
+    const auto changedEnd = delta.positions.cend();
+
+    for (const PositionInfo& info : qAsConst(list)) {
+        for (; changedIt != changedEnd && changedIt->docId < info.docId; ++changedIt) {
+            if (!changedIt->positions.isEmpty()) {
+                result.append(*changedIt);
+            }
+        }
+
+        if (changedIt != changedEnd && changedIt->docId == info.docId) {
+            if (!changedIt->positions.isEmpty()) {
+                result.append(*changedIt);
+            }
+            ++changedIt;
+        } else {
+            result.append(info);
+        }
+    }
+    for (; changedIt != changedEnd; ++changedIt) {
+        if (!changedIt->positions.isEmpty()) {
+            result.append(*changedIt);
+        }
+    }
+
+    list = result;
+}
+
+PostingDeltaDB::Delta PostingDeltaDB::slice(const Delta& delta, quint64 first, quint64 last)
+{
+    auto sliced = [first, last](const PostingList& list) {
+        const auto begin = std::lower_bound(list.cbegin(), list.cend(), first);
+        const auto end = std::upper_bound(begin, list.cend(), last);
+        return list.mid(begin - list.cbegin(), end - begin);
+    };
+
+    Delta result;
+    result.added = sliced(delta.added);
+    result.removed = sliced(delta.removed);
+
+    const auto begin = std::lower_bound(delta.positions.cbegin(), delta.positions.cend(), PositionInfo(first));
+    const auto end = std::upper_bound(begin, delta.positions.cend(), PositionInfo(last));
+    result.positions = delta.positions.mid(begin - delta.positions.cbegin(), end - begin);
+    return result;
+}
+
+QByteArray PostingDeltaDB::encode(const Delta& delta)
+{
+    // Without positions, the records are the same as before they existed
+    const bool hasPositions = !delta.positions.isEmpty();
+    const quint32 addedCount = delta.added.size() | (hasPositions ? hasPositionsFlag : 0);
+
+    QByteArray arr;
+    arr.reserve(2 * sizeof(quint32) + (delta.added.size() + delta.removed.size()) * sizeof(quint64));
+    arr.append(reinterpret_cast<const char*>(&addedCount), sizeof(quint32));
+    if (hasPositions) {
+        const quint32 removedCount = delta.removed.size();
+        arr.append(reinterpret_cast<const char*>(&removedCount), sizeof(quint32));
+    }
+    arr.append(reinterpret_cast<const char*>(delta.added.constData()), delta.added.size() * sizeof(quint64));
+    arr.append(reinterpret_cast<const char*>(delta.removed.constData()), delta.removed.size() * sizeof(quint64));
+    if (hasPositions) {
+        arr.append(PositionCodec().encode(delta.positions));
+    }
+    return arr;
+}
+
+PostingDeltaDB::Delta PostingDeltaDB::decode(const QByteArray& arr)
+{
+    Delta delta;
+    if (arr.size() < static_cast<int>(sizeof(quint32))) {
+        return delta;
+    }
+
+    const char* data = arr.constData();
+    const char* end = data + arr.size();
+    quint32 addedCount;
+    memcpy(&addedCount, data, sizeof(quint32));
+    data += sizeof(quint32);
+
+    const bool hasPositions = addedCount & hasPositionsFlag;
+    addedCount &= ~hasPositionsFlag;
+
+    quint32 removedCount;
+    if (hasPositions) {
+        if (end - data < static_cast<int>(sizeof(quint32))) {
+            qCWarning(ENGINE) << "PostingDeltaDB: corrupt delta";
+            return delta;
+        }
+        memcpy(&removedCount, data, sizeof(quint32));
+        data += sizeof(quint32);
+    } else {
+        removedCount = (end - data) / sizeof(quint64) - qMin<quint32>(addedCount, (end - data) / sizeof(quint64));
+    }
+
+    const quint64 idsSize = (static_cast<quint64>(addedCount) + removedCount) * sizeof(quint64);
+    if (idsSize > static_cast<quint64>(end - data)) {
+        qCWarning(ENGINE) << "PostingDeltaDB: corrupt delta";
+        return delta;
+    }
+
+    delta.added.resize(addedCount);
+    memcpy(delta.added.data(), data, addedCount * sizeof(quint64));
+    data += addedCount * sizeof(quint64);
+
+    delta.removed.resize(removedCount);
+    memcpy(delta.removed.data(), data, removedCount * sizeof(quint64));
+    data += removedCount * sizeof(quint64);
+
+    if (hasPositions) {
+        delta.positions = PositionCodec().decode(QByteArray::fromRawData(data, end - data));
+    }
+    return delta;
+}
+
+QMap<QByteArray, QVector<PostingDeltaDB::Delta>> PostingDeltaDB::toTestMap() const
+{
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_dbi, &cursor);
+
+    MDB_val key = {0, nullptr};
+    MDB_val val;
+
+    QMap<QByteArray, QVector<Delta>> map;
+    while (1) {
+        int rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
+        if (rc) {
+            qCDebug(ENGINE) << "PostingDeltaDB::toTestMap" << mdb_strerror(rc);
+            break;
+        }
+
+        const QByteArray term(static_cast<char*>(key.mv_data), key.mv_size - seqSize - 1);
+        map[term] << decode(QByteArray::fromRawData(static_cast<char*>(val.mv_data), val.mv_size));
+    }
+
+    mdb_cursor_close(cursor);
+    return map;
+}
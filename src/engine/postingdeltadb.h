@@ -0,0 +1,124 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef BALOO_POSTINGDELTADB_H
+#define BALOO_POSTINGDELTADB_H
+
+#include "postingdb.h"
+#include "positioninfo.h"
+
+#include <QMap>
+
+namespace Baloo {
+
+/**
+ * The PostingDeltaDB holds small changes to the posting lists of the PostingDB,
+ * so that adding a few documents to a term with a long posting list does not
+ * require rewriting the whole list.
+ *
+ * Every record is keyed by <term> '\0' <sequence>, so the deltas of a term are
+ * next to each other and sorted in the order they were written. Readers apply
+ * them on top of the PostingDB list, and compaction eventually folds them into
+ * it.
+ *
+ * A delta also carries the positions it changes, which are applied on top of
+ * the PositionDB list of the term in the same way.
+ */
+class BALOO_ENGINE_EXPORT PostingDeltaDB
+{
+public:
+    struct Delta {
+        PostingList added;
+        PostingList removed;
+        // Sorted by id, replacing the positions of the documents. Those of
+        // a document listed without any are dropped.
+        QVector<PositionInfo> positions;
+
+        bool operator==(const Delta& rhs) const;
+    };
+
+    PostingDeltaDB(MDB_dbi dbi, MDB_txn* txn);
+    ~PostingDeltaDB();
+
+    static MDB_dbi create(MDB_txn* txn);
+    static MDB_dbi open(MDB_txn* txn);
+
+    /**
+     * Stores \p delta after all the existing deltas of \p term
+     */
+    void append(const QByteArray& term, const Delta& delta);
+
+    /**
+     * The number of deltas stored for \p term
+     */
+    int count(const QByteArray& term);
+
+    /**
+     * All the deltas of \p term, oldest first
+     */
+    QVector<Delta> get(const QByteArray& term);
+
+    /**
+     * Removes all the deltas of \p term
+     */
+    void del(const QByteArray& term);
+
+    /**
+     * The number of delta records over all terms
+     */
+    uint size() const;
+
+    /**
+     * Returns up to \p maxTerms terms which have deltas, in key order
+     */
+    QVector<QByteArray> fetchTerms(int maxTerms);
+
+    /**
+     * Applies \p delta to the sorted \p list
+     */
+    static void apply(PostingList& list, const Delta& delta);
+
+    /**
+     * Applies the position changes of \p delta to the sorted \p list
+     */
+    static void applyPositions(QVector<PositionInfo>& list, const Delta& delta);
+
+    /**
+     * Only keeps the ids of \p delta from \p first to \p last, for
+     * applying it to a list which was only decoded for that range
+     */
+    static Delta slice(const Delta& delta, quint64 first, quint64 last);
+
+    static QByteArray encode(const Delta& delta);
+    static Delta decode(const QByteArray& arr);
+
+    QMap<QByteArray, QVector<Delta>> toTestMap() const;
+
+private:
+    MDB_txn* m_txn;
+    MDB_dbi m_dbi;
+};
+
+}
+
+Q_DECLARE_TYPEINFO(Baloo::PostingDeltaDB::Delta, Q_MOVABLE_TYPE);
+
+#endif // BALOO_POSTINGDELTADB_H
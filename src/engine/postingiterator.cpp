@@ -20,6 +20,8 @@
 
 #include "postingiterator.h"
 
+#include <limits>
+
 using namespace Baloo;
 
 PostingIterator::~PostingIterator()
@@ -28,8 +30,16 @@ PostingIterator::~PostingIterator()
 
 quint64 PostingIterator::skipTo(quint64 id)
 {
+    if (!docId() && !next()) {
+        return 0;
+    }
     while (docId() && docId() < id) {
         next();
     }
     return docId();
 }
+
+quint64 PostingIterator::cost() const
+{
+    return std::numeric_limits<quint64>::max();
+}
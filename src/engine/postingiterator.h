@@ -39,7 +39,21 @@ public:
 
     virtual quint64 next() = 0;
     virtual quint64 docId() const = 0;
+
+    /**
+     * Moves to the first document whose id is not less than \p docId and
+     * returns it, or 0 if there is none. An iterator which has not been
+     * started yet is started by it, so it can take the place of the first
+     * call to next().
+     */
     virtual quint64 skipTo(quint64 docId);
+
+    /**
+     * An estimate of the number of documents left to iterate over, used
+     * to pick the iterator which drives an intersection. Iterators which
+     * cannot tell without doing the work return the largest value.
+     */
+    virtual quint64 cost() const;
 };
 }
 
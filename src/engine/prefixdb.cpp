@@ -0,0 +1,728 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "enginedebug.h"
+#include "prefixdb.h"
+#include "documentdb.h"
+#include "vectorpostingiterator.h"
+#include "postingcodec.h"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+
+using namespace Baloo;
+
+namespace {
+// The lengths of the stored prefixes, in characters
+const int minPrefixLength = 3;
+const int maxPrefixLength = 5;
+
+// A prefix is stored once it expands to more than this many terms
+const int prefixMinTerms = 1024;
+
+// A union is rewritten once it has this many deltas
+const int prefixMaxDeltas = 32;
+
+// Filling in the PrefixDB stops after going through this many terms, even
+// when it has not found many prefixes to store
+const int buildMaxTerms = 100000;
+
+// The key of the term a pending build continues from
+const QByteArray buildStateKey = QByteArrayLiteral("next");
+
+bool isCharacterStart(char c)
+{
+    // UTF-8 continuation bytes look like 10xxxxxx
+    return (static_cast<uchar>(c) & 0xC0) != 0x80;
+}
+}
+
+PrefixDB::PrefixDB(MDB_dbi dbi, MDB_txn* txn)
+    : PrefixDB(dbi, 0, txn)
+{
+}
+
+PrefixDB::PrefixDB(MDB_dbi dbi, MDB_dbi deltaDbi, MDB_txn* txn)
+    : m_txn(txn)
+    , m_dbi(dbi)
+    , m_deltaDbi(deltaDbi)
+    , m_firstId(0)
+    , m_lastId(std::numeric_limits<quint64>::max())
+{
+    Q_ASSERT(txn != nullptr);
+    Q_ASSERT(dbi != 0);
+}
+
+PrefixDB::~PrefixDB()
+{
+}
+
+MDB_dbi PrefixDB::create(MDB_txn* txn)
+{
+    MDB_dbi dbi = 0;
+    int rc = mdb_dbi_open(txn, "prefixdb", MDB_CREATE, &dbi);
+    if (rc) {
+        qCWarning(ENGINE) << "PrefixDB::create" << mdb_strerror(rc);
+        return 0;
+    }
+
+    return dbi;
+}
+
+MDB_dbi PrefixDB::open(MDB_txn* txn)
+{
+    MDB_dbi dbi = 0;
+    int rc = mdb_dbi_open(txn, "prefixdb", 0, &dbi);
+    if (rc) {
+        // Databases created by older versions do not have it
+        qCDebug(ENGINE) << "PrefixDB::open" << mdb_strerror(rc);
+        return 0;
+    }
+
+    return dbi;
+}
+
+MDB_dbi PrefixDB::createDeltas(MDB_txn* txn)
+{
+    MDB_dbi dbi = 0;
+    int rc = mdb_dbi_open(txn, "prefixdeltadb", MDB_CREATE, &dbi);
+    if (rc) {
+        qCWarning(ENGINE) << "PrefixDB::createDeltas" << mdb_strerror(rc);
+        return 0;
+    }
+
+    return dbi;
+}
+
+MDB_dbi PrefixDB::openDeltas(MDB_txn* txn)
+{
+    MDB_dbi dbi = 0;
+    int rc = mdb_dbi_open(txn, "prefixdeltadb", 0, &dbi);
+    if (rc) {
+        // Databases created by older versions do not have it
+        qCDebug(ENGINE) << "PrefixDB::openDeltas" << mdb_strerror(rc);
+        return 0;
+    }
+
+    return dbi;
+}
+
+MDB_dbi PrefixDB::createBuildState(MDB_txn* txn)
+{
+    MDB_dbi dbi = 0;
+    int rc = mdb_dbi_open(txn, "prefixbuilddb", MDB_CREATE, &dbi);
+    if (rc) {
+        qCWarning(ENGINE) << "PrefixDB::createBuildState" << mdb_strerror(rc);
+        return 0;
+    }
+
+    // Starts with the first term
+    MDB_val key;
+    key.mv_size = buildStateKey.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(buildStateKey.constData()));
+    MDB_val val{0, nullptr};
+    rc = mdb_put(txn, dbi, &key, &val, 0);
+    if (rc) {
+        qCWarning(ENGINE) << "PrefixDB::createBuildState put" << mdb_strerror(rc);
+    }
+
+    return dbi;
+}
+
+MDB_dbi PrefixDB::openBuildState(MDB_txn* txn)
+{
+    MDB_dbi dbi = 0;
+    int rc = mdb_dbi_open(txn, "prefixbuilddb", 0, &dbi);
+    if (rc) {
+        // Only there once a build has been started
+        qCDebug(ENGINE) << "PrefixDB::openBuildState" << mdb_strerror(rc);
+        return 0;
+    }
+
+    return dbi;
+}
+
+void PrefixDB::put(const QByteArray& prefix, const PostingList& list)
+{
+    Q_ASSERT(!prefix.isEmpty());
+    Q_ASSERT(!list.isEmpty());
+
+    MDB_val key;
+    key.mv_size = prefix.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(prefix.constData()));
+
+    PostingCodec codec;
+    QByteArray arr = codec.encode(list);
+
+    MDB_val val;
+    val.mv_size = arr.size();
+    val.mv_data = static_cast<void*>(arr.data());
+
+    int rc = mdb_put(m_txn, m_dbi, &key, &val, 0);
+    if (rc) {
+        qCWarning(ENGINE) << "PrefixDB::put" << mdb_strerror(rc);
+    }
+
+    if (m_deltaDbi) {
+        PostingDeltaDB(m_deltaDbi, m_txn).del(prefix);
+    }
+}
+
+PostingList PrefixDB::get(const QByteArray& prefix)
+{
+    Q_ASSERT(!prefix.isEmpty());
+
+    MDB_val key;
+    key.mv_size = prefix.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(prefix.constData()));
+
+    MDB_val val{0, nullptr};
+    int rc = mdb_get(m_txn, m_dbi, &key, &val);
+    if (rc) {
+        if (rc != MDB_NOTFOUND) {
+            qCDebug(ENGINE) << "PrefixDB::get" << prefix << mdb_strerror(rc);
+        }
+        return PostingList();
+    }
+
+    QByteArray arr = QByteArray::fromRawData(static_cast<char*>(val.mv_data), val.mv_size);
+    PostingList list = isRanged() ? PostingCodec().decode(arr, m_firstId, m_lastId) : PostingCodec().decode(arr);
+    applyDeltas(prefix, list);
+    return list;
+}
+
+void PrefixDB::setIdRange(quint64 first, quint64 last)
+{
+    m_firstId = first;
+    m_lastId = last;
+}
+
+bool PrefixDB::isRanged() const
+{
+    return m_firstId > 0 || m_lastId < std::numeric_limits<quint64>::max();
+}
+
+void PrefixDB::applyDeltas(const QByteArray& prefix, PostingList& list) const
+{
+    if (!m_deltaDbi) {
+        return;
+    }
+
+    const QVector<PostingDeltaDB::Delta> deltas = PostingDeltaDB(m_deltaDbi, m_txn).get(prefix);
+    for (const PostingDeltaDB::Delta& delta : deltas) {
+        if (isRanged()) {
+            PostingDeltaDB::apply(list, PostingDeltaDB::slice(delta, m_firstId, m_lastId));
+        } else {
+            PostingDeltaDB::apply(list, delta);
+        }
+    }
+}
+
+bool PrefixDB::contains(const QByteArray& prefix)
+{
+    Q_ASSERT(!prefix.isEmpty());
+
+    MDB_val key;
+    key.mv_size = prefix.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(prefix.constData()));
+
+    MDB_val val{0, nullptr};
+    int rc = mdb_get(m_txn, m_dbi, &key, &val);
+    if (rc) {
+        if (rc != MDB_NOTFOUND) {
+            qCDebug(ENGINE) << "PrefixDB::contains" << prefix << mdb_strerror(rc);
+        }
+        return false;
+    }
+
+    return true;
+}
+
+void PrefixDB::del(const QByteArray& prefix)
+{
+    Q_ASSERT(!prefix.isEmpty());
+
+    MDB_val key;
+    key.mv_size = prefix.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(prefix.constData()));
+
+    int rc = mdb_del(m_txn, m_dbi, &key, nullptr);
+    if (rc != 0 && rc != MDB_NOTFOUND) {
+        qCDebug(ENGINE) << "PrefixDB::del" << prefix << mdb_strerror(rc);
+    }
+
+    if (m_deltaDbi) {
+        PostingDeltaDB(m_deltaDbi, m_txn).del(prefix);
+    }
+}
+
+void PrefixDB::update(const QByteArray& prefix, const PostingDeltaDB::Delta& delta)
+{
+    Q_ASSERT(!prefix.isEmpty());
+
+    if (m_deltaDbi) {
+        PostingDeltaDB deltaDb(m_deltaDbi, m_txn);
+        if (deltaDb.count(prefix) < prefixMaxDeltas) {
+            deltaDb.append(prefix, delta);
+            return;
+        }
+    }
+
+    PostingList list = get(prefix);
+    PostingDeltaDB::apply(list, delta);
+    if (!list.isEmpty()) {
+        put(prefix, list);
+    } else {
+        del(prefix);
+    }
+}
+
+bool PrefixDB::compactDeltas(int maxPrefixes)
+{
+    if (!m_deltaDbi) {
+        return false;
+    }
+
+    PostingDeltaDB deltaDb(m_deltaDbi, m_txn);
+    const QVector<QByteArray> prefixes = deltaDb.fetchTerms(maxPrefixes);
+    for (const QByteArray& prefix : prefixes) {
+        // Also drops the deltas of prefixes which are not stored anymore
+        const PostingList list = get(prefix);
+        if (!list.isEmpty()) {
+            put(prefix, list);
+        } else {
+            del(prefix);
+        }
+    }
+
+    return deltaDb.size() > 0;
+}
+
+uint PrefixDB::deltaCount() const
+{
+    if (!m_deltaDbi) {
+        return 0;
+    }
+
+    return PostingDeltaDB(m_deltaDbi, m_txn).size();
+}
+
+qint64 PrefixDB::documentCount(const QByteArray& prefix)
+{
+    Q_ASSERT(!prefix.isEmpty());
+
+    MDB_val key;
+    key.mv_size = prefix.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(prefix.constData()));
+
+    MDB_val val{0, nullptr};
+    int rc = mdb_get(m_txn, m_dbi, &key, &val);
+    if (rc) {
+        if (rc != MDB_NOTFOUND) {
+            qCDebug(ENGINE) << "PrefixDB::documentCount" << prefix << mdb_strerror(rc);
+        }
+        return -1;
+    }
+
+    return val.mv_size / sizeof(quint64);
+}
+
+PostingIterator* PrefixDB::iter(const QByteArray& prefix)
+{
+    const PostingList list = get(prefix);
+    if (list.isEmpty()) {
+        // The unions are never stored empty, but can be within the id range
+        return isRanged() && contains(prefix) ? new VectorPostingIterator(list) : nullptr;
+    }
+
+    return new VectorPostingIterator(list);
+}
+
+bool PrefixDB::isIndexable(const QByteArray& prefix)
+{
+    const int length = std::count_if(prefix.cbegin(), prefix.cend(), isCharacterStart);
+    return length >= minPrefixLength && length <= maxPrefixLength;
+}
+
+QVector<QByteArray> PrefixDB::prefixesOf(const QByteArray& term)
+{
+    QVector<QByteArray> prefixes;
+
+    // Every character start is the end of the prefix before it
+    int length = 0;
+    for (int i = 0; i <= term.size(); i++) {
+        if (i < term.size() && !isCharacterStart(term.at(i))) {
+            continue;
+        }
+        if (length >= minPrefixLength) {
+            prefixes << term.left(i);
+        }
+        if (length == maxPrefixLength) {
+            break;
+        }
+        length++;
+    }
+
+    return prefixes;
+}
+
+int PrefixDB::minTermCount()
+{
+    return prefixMinTerms;
+}
+
+QMap<QByteArray, PostingList> PrefixDB::toTestMap() const
+{
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_dbi, &cursor);
+
+    MDB_val key = {0, nullptr};
+    MDB_val val;
+
+    QMap<QByteArray, PostingList> map;
+    while (1) {
+        int rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
+        if (rc) {
+            qCDebug(ENGINE) << "PrefixDB::toTestMap" << mdb_strerror(rc);
+            break;
+        }
+
+        const QByteArray ba(static_cast<char*>(key.mv_data), key.mv_size);
+        PostingList list = PostingCodec().decode(QByteArray(static_cast<char*>(val.mv_data), val.mv_size));
+        applyDeltas(ba, list);
+        map.insert(ba, list);
+    }
+
+    mdb_cursor_close(cursor);
+    return map;
+}
+
+//
+// Updater
+//
+PrefixUpdater::PrefixUpdater(const DatabaseDbis& dbis, MDB_txn* txn)
+    : m_dbis(dbis)
+    , m_txn(txn)
+{
+}
+
+void PrefixUpdater::update(const QByteArray& term, const PostingDeltaDB::Delta& delta)
+{
+    if (!m_dbis.prefixDbi) {
+        return;
+    }
+
+    const QVector<QByteArray> prefixes = PrefixDB::prefixesOf(term);
+    for (const QByteArray& prefix : prefixes) {
+        if (!isStored(prefix)) {
+            continue;
+        }
+        if (!delta.added.isEmpty()) {
+            m_added[prefix] += delta.added;
+        }
+        if (!delta.removed.isEmpty()) {
+            m_removed[prefix] += delta.removed;
+        }
+    }
+}
+
+void PrefixUpdater::termCreated(const QByteArray& term)
+{
+    if (!m_dbis.prefixDbi) {
+        return;
+    }
+
+    const QVector<QByteArray> prefixes = PrefixDB::prefixesOf(term);
+    for (const QByteArray& prefix : prefixes) {
+        if (!isStored(prefix)) {
+            m_grown.insert(prefix);
+        }
+    }
+}
+
+void PrefixUpdater::termDeleted(const QByteArray& term)
+{
+    if (!m_dbis.prefixDbi) {
+        return;
+    }
+
+    const QVector<QByteArray> prefixes = PrefixDB::prefixesOf(term);
+    for (const QByteArray& prefix : prefixes) {
+        if (isStored(prefix)) {
+            m_shrunk.insert(prefix);
+        }
+    }
+}
+
+void PrefixUpdater::apply()
+{
+    if (!m_dbis.prefixDbi) {
+        return;
+    }
+
+    PrefixDB prefixDb(m_dbis.prefixDbi, m_dbis.prefixDeltaDbi, m_txn);
+    const int minTerms = PrefixDB::minTermCount();
+
+    // Building a prefix from the posting lists already includes all the changes
+    for (const QByteArray& prefix : qAsConst(m_grown)) {
+        if (countTerms(prefix, minTerms + 1) > minTerms) {
+            build(prefix);
+        }
+    }
+    for (const QByteArray& prefix : qAsConst(m_shrunk)) {
+        if (countTerms(prefix, minTerms / 2) < minTerms / 2) {
+            prefixDb.del(prefix);
+            m_added.remove(prefix);
+            m_removed.remove(prefix);
+        }
+    }
+
+    QSet<QByteArray> prefixes;
+    for (auto it = m_added.cbegin(); it != m_added.cend(); ++it) {
+        prefixes.insert(it.key());
+    }
+    for (auto it = m_removed.cbegin(); it != m_removed.cend(); ++it) {
+        prefixes.insert(it.key());
+    }
+
+    for (const QByteArray& prefix : qAsConst(prefixes)) {
+        PostingDeltaDB::Delta delta;
+        delta.added = m_added.value(prefix);
+        std::sort(delta.added.begin(), delta.added.end());
+        delta.added.erase(std::unique(delta.added.begin(), delta.added.end()), delta.added.end());
+
+        // An id only leaves the union with the last of its terms
+        PostingList removed = m_removed.value(prefix);
+        std::sort(removed.begin(), removed.end());
+        removed.erase(std::unique(removed.begin(), removed.end()), removed.end());
+        for (quint64 id : qAsConst(removed)) {
+            if (!hasTerm(id, prefix)) {
+                delta.removed.append(id);
+            }
+        }
+
+        if (!delta.added.isEmpty() || !delta.removed.isEmpty()) {
+            prefixDb.update(prefix, delta);
+        }
+    }
+
+    m_stored.clear();
+    m_added.clear();
+    m_removed.clear();
+    m_grown.clear();
+    m_shrunk.clear();
+    m_documentTerms.clear();
+}
+
+bool PrefixUpdater::buildNext(int maxPrefixes)
+{
+    Q_ASSERT(maxPrefixes > 0);
+    if (!m_dbis.prefixDbi || !m_dbis.prefixBuildDbi) {
+        return false;
+    }
+
+    MDB_val key;
+    key.mv_size = buildStateKey.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(buildStateKey.constData()));
+    MDB_val val{0, nullptr};
+    int rc = mdb_get(m_txn, m_dbis.prefixBuildDbi, &key, &val);
+    if (rc) {
+        // No build pending
+        if (rc != MDB_NOTFOUND) {
+            qCWarning(ENGINE) << "PrefixUpdater::buildNext" << mdb_strerror(rc);
+        }
+        return false;
+    }
+    // Copied, the value is gone once the state is written again
+    const QByteArray from(static_cast<char*>(val.mv_data), val.mv_size);
+
+    QByteArray next;
+    if (!buildFrom(from, maxPrefixes, &next)) {
+        return false;
+    }
+    if (next.isEmpty()) {
+        rc = mdb_del(m_txn, m_dbis.prefixBuildDbi, &key, nullptr);
+        if (rc) {
+            qCWarning(ENGINE) << "PrefixUpdater::buildNext del" << mdb_strerror(rc);
+        }
+        return false;
+    }
+
+    val.mv_size = next.size();
+    val.mv_data = static_cast<void*>(const_cast<char*>(next.constData()));
+    rc = mdb_put(m_txn, m_dbis.prefixBuildDbi, &key, &val, 0);
+    if (rc) {
+        qCWarning(ENGINE) << "PrefixUpdater::buildNext put" << mdb_strerror(rc);
+        return false;
+    }
+    return true;
+}
+
+bool PrefixUpdater::buildFrom(const QByteArray& from, int maxPrefixes, QByteArray* next)
+{
+    const int minTerms = PrefixDB::minTermCount();
+    const int lengths = maxPrefixLength - minPrefixLength + 1;
+
+    // The terms are sorted, so the ones sharing a prefix come one after
+    // the other. Their number is counted for each prefix length.
+    QByteArray current[lengths];
+    int counts[lengths] = {};
+    QVector<QByteArray> prefixes;
+    int termCount = 0;
+
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_dbis.postingDbi, &cursor);
+
+    MDB_val key = {0, nullptr};
+    int rc;
+    if (from.isEmpty()) {
+        rc = mdb_cursor_get(cursor, &key, nullptr, MDB_FIRST);
+    } else {
+        key.mv_size = from.size();
+        key.mv_data = static_cast<void*>(const_cast<char*>(from.constData()));
+        rc = mdb_cursor_get(cursor, &key, nullptr, MDB_SET_RANGE);
+    }
+    while (true) {
+        QVector<QByteArray> termPrefixes;
+        bool end = rc != 0;
+        if (!end) {
+            const QByteArray term = QByteArray::fromRawData(static_cast<char*>(key.mv_data), key.mv_size);
+            termPrefixes = PrefixDB::prefixesOf(term);
+
+            // Only stops where none of the prefixes goes on, so that the
+            // next call counts all the terms of the ones it sees
+            const bool boundary = termPrefixes.isEmpty() || termPrefixes.first() != current[0];
+            if (boundary && (prefixes.size() >= maxPrefixes || termCount >= buildMaxTerms)) {
+                *next = QByteArray(term.constData(), term.size());
+                termPrefixes.clear();
+                end = true;
+            }
+            termCount++;
+        }
+
+        for (int i = 0; i < lengths; i++) {
+            const QByteArray prefix = i < termPrefixes.size() ? termPrefixes[i] : QByteArray();
+            if (prefix == current[i]) {
+                if (!prefix.isEmpty()) {
+                    counts[i]++;
+                }
+                continue;
+            }
+            if (counts[i] > minTerms) {
+                prefixes << current[i];
+            }
+            // Deep copies, the key points into the map
+            current[i] = QByteArray(prefix.constData(), prefix.size());
+            counts[i] = prefix.isEmpty() ? 0 : 1;
+        }
+
+        if (end) {
+            break;
+        }
+        rc = mdb_cursor_get(cursor, &key, nullptr, MDB_NEXT);
+    }
+    mdb_cursor_close(cursor);
+    if (rc && rc != MDB_NOTFOUND) {
+        qCWarning(ENGINE) << "PrefixUpdater::buildFrom" << mdb_strerror(rc);
+        return false;
+    }
+
+    for (const QByteArray& prefix : qAsConst(prefixes)) {
+        build(prefix);
+    }
+    qCDebug(ENGINE) << "PrefixUpdater::buildFrom stored" << prefixes.size() << "prefixes, continuing at" << *next;
+    return true;
+}
+
+bool PrefixUpdater::isStored(const QByteArray& prefix)
+{
+    auto it = m_stored.constFind(prefix);
+    if (it != m_stored.constEnd()) {
+        return it.value();
+    }
+
+    const bool stored = PrefixDB(m_dbis.prefixDbi, m_txn).contains(prefix);
+    m_stored.insert(prefix, stored);
+    return stored;
+}
+
+bool PrefixUpdater::hasTerm(quint64 id, const QByteArray& prefix)
+{
+    auto it = m_documentTerms.find(id);
+    if (it == m_documentTerms.end()) {
+        QVector<QByteArray> terms;
+        for (MDB_dbi dbi : {m_dbis.docTermsDbi, m_dbis.docFilenameTermsDbi, m_dbis.docXattrTermsDbi}) {
+            terms += DocumentDB(dbi, m_txn).get(id);
+        }
+        it = m_documentTerms.insert(id, terms);
+    }
+
+    const QVector<QByteArray>& terms = it.value();
+    return std::any_of(terms.cbegin(), terms.cend(), [&prefix](const QByteArray& term) {
+        return term.startsWith(prefix);
+    });
+}
+
+int PrefixUpdater::countTerms(const QByteArray& prefix, int limit)
+{
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_dbis.postingDbi, &cursor);
+
+    MDB_val key;
+    key.mv_size = prefix.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(prefix.constData()));
+
+    int count = 0;
+    int rc = mdb_cursor_get(cursor, &key, nullptr, MDB_SET_RANGE);
+    while (rc == 0 && count < limit) {
+        const QByteArray term = QByteArray::fromRawData(static_cast<char*>(key.mv_data), key.mv_size);
+        if (!term.startsWith(prefix)) {
+            break;
+        }
+        count++;
+        rc = mdb_cursor_get(cursor, &key, nullptr, MDB_NEXT);
+    }
+    if (rc != 0 && rc != MDB_NOTFOUND) {
+        qCDebug(ENGINE) << "PrefixUpdater::countTerms" << prefix << mdb_strerror(rc);
+    }
+
+    mdb_cursor_close(cursor);
+    return count;
+}
+
+void PrefixUpdater::build(const QByteArray& prefix)
+{
+    PostingDB postingDb(m_dbis.postingDbi, m_dbis.postingDeltaDbi, m_txn);
+    std::unique_ptr<PostingIterator> it(postingDb.prefixIter(prefix));
+
+    PostingList list;
+    while (it && it->next()) {
+        list.append(it->docId());
+    }
+
+    PrefixDB prefixDb(m_dbis.prefixDbi, m_dbis.prefixDeltaDbi, m_txn);
+    if (!list.isEmpty()) {
+        prefixDb.put(prefix, list);
+    }
+    m_added.remove(prefix);
+    m_removed.remove(prefix);
+}
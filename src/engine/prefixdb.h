@@ -0,0 +1,208 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef BALOO_PREFIXDB_H
+#define BALOO_PREFIXDB_H
+
+#include "postingdb.h"
+#include "postingdeltadb.h"
+#include "databasedbis.h"
+
+#include <QHash>
+#include <QSet>
+
+namespace Baloo {
+
+/**
+ * The PrefixDB maps a short prefix to the union of the posting lists of
+ * all the terms starting with it. Only prefixes of 3 to 5 characters
+ * which expand to a lot of terms are stored, so that typing the first
+ * letters of a word does not have to merge thousands of posting lists.
+ *
+ * Commits only append the changes to the unions as deltas, kept in a
+ * PostingDeltaDB of their own, and a union is rewritten once enough of
+ * them have piled up or when the deltas are compacted.
+ *
+ * The database is optional, databases created by older versions do not have it.
+ * A prefix which is not stored is expanded over the PostingDB instead, so
+ * the unions can be filled in after the database has been created.
+ */
+class BALOO_ENGINE_EXPORT PrefixDB
+{
+public:
+    PrefixDB(MDB_dbi dbi, MDB_txn* txn);
+    PrefixDB(MDB_dbi dbi, MDB_dbi deltaDbi, MDB_txn* txn);
+    ~PrefixDB();
+
+    static MDB_dbi create(MDB_txn* txn);
+    static MDB_dbi open(MDB_txn* txn);
+
+    /**
+     * The database holding the deltas of the unions
+     */
+    static MDB_dbi createDeltas(MDB_txn* txn);
+    static MDB_dbi openDeltas(MDB_txn* txn);
+
+    /**
+     * Databases created by older versions get the PrefixDB filled in a
+     * few prefixes at a time, see PrefixUpdater::buildNext. Until all the
+     * terms have been gone through, the term to continue from is kept in
+     * a database of its own. createBuildState() starts a new build.
+     */
+    static MDB_dbi createBuildState(MDB_txn* txn);
+    static MDB_dbi openBuildState(MDB_txn* txn);
+
+    /**
+     * Replaces the union stored for \p prefix, along with its deltas
+     */
+    void put(const QByteArray& prefix, const PostingList& list);
+    PostingList get(const QByteArray& prefix);
+    bool contains(const QByteArray& prefix);
+    void del(const QByteArray& prefix);
+
+    /**
+     * Applies \p delta to the union stored for \p prefix. Unless the
+     * prefix already has many deltas, it is only appended to them.
+     */
+    void update(const QByteArray& prefix, const PostingDeltaDB::Delta& delta);
+
+    /**
+     * Folds the deltas of up to \p maxPrefixes prefixes into their unions.
+     * Returns true if there are still deltas left.
+     */
+    bool compactDeltas(int maxPrefixes);
+
+    /**
+     * The number of delta records over all prefixes
+     */
+    uint deltaCount() const;
+
+    /**
+     * Only the ids from \p first to \p last are decoded by the lookups
+     * done afterwards. See PostingDB::setIdRange
+     */
+    void setIdRange(quint64 first, quint64 last);
+
+    /**
+     * Returns an iterator over the union stored for \p prefix, or nullptr
+     * if it is not stored
+     */
+    PostingIterator* iter(const QByteArray& prefix);
+
+    /**
+     * The size of the union stored for \p prefix, or -1 if it is not stored.
+     * The deltas are not taken into account.
+     */
+    qint64 documentCount(const QByteArray& prefix);
+
+    /**
+     * Returns true if \p prefix has the length of the stored prefixes
+     */
+    static bool isIndexable(const QByteArray& prefix);
+
+    /**
+     * The prefixes of \p term which can be stored, shortest first.
+     * The lengths are counted in UTF-8 characters.
+     */
+    static QVector<QByteArray> prefixesOf(const QByteArray& term);
+
+    /**
+     * A prefix is stored once it expands to more than this many terms,
+     * and dropped again when it expands to less than half of them
+     */
+    static int minTermCount();
+
+    QMap<QByteArray, PostingList> toTestMap() const;
+
+private:
+    void applyDeltas(const QByteArray& prefix, PostingList& list) const;
+    bool isRanged() const;
+
+    MDB_txn* m_txn;
+    MDB_dbi m_dbi;
+    MDB_dbi m_deltaDbi;
+    quint64 m_firstId;
+    quint64 m_lastId;
+};
+
+/**
+ * Collects how a commit changes the posting lists and applies the
+ * changes to the stored prefixes
+ */
+class BALOO_ENGINE_EXPORT PrefixUpdater
+{
+public:
+    PrefixUpdater(const DatabaseDbis& dbis, MDB_txn* txn);
+
+    /**
+     * The ids of \p delta were added to and removed from the posting list
+     * of \p term. The ids do not need to have actually been in the list or
+     * not before.
+     */
+    void update(const QByteArray& term, const PostingDeltaDB::Delta& delta);
+
+    /**
+     * \p term got its first id
+     */
+    void termCreated(const QByteArray& term);
+
+    /**
+     * \p term lost its last id
+     */
+    void termDeleted(const QByteArray& term);
+
+    /**
+     * Writes the changes into the PrefixDB. The posting lists and the
+     * terms of the documents need to be up to date.
+     */
+    void apply();
+
+    /**
+     * Stores the prefixes which expand to enough terms, continuing through
+     * the terms where the previous call stopped, and stopping once about
+     * \p maxPrefixes of them have been stored. Fills in the PrefixDB of
+     * databases created before it existed. Returns true if there are
+     * still terms left.
+     */
+    bool buildNext(int maxPrefixes);
+
+private:
+    bool buildFrom(const QByteArray& from, int maxPrefixes, QByteArray* next);
+    bool isStored(const QByteArray& prefix);
+    bool hasTerm(quint64 id, const QByteArray& prefix);
+    int countTerms(const QByteArray& prefix, int limit);
+    void build(const QByteArray& prefix);
+
+    DatabaseDbis m_dbis;
+    MDB_txn* m_txn;
+
+    QHash<QByteArray, bool> m_stored;
+    QHash<QByteArray, PostingList> m_added;
+    QHash<QByteArray, PostingList> m_removed;
+    QSet<QByteArray> m_grown;
+    QSet<QByteArray> m_shrunk;
+
+    QHash<quint64, QVector<QByteArray>> m_documentTerms;
+};
+
+}
+
+#endif // BALOO_PREFIXDB_H
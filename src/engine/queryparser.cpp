@@ -40,6 +40,26 @@ namespace {
 
         return false;
     }
+
+    // Returns the number of edits asked for by a "~" or "~2" right after
+    // the word ending at \p pos, or 0 if there is none. \p markerEnd is
+    // set to the position right after it.
+    int fuzzyMarker(const QString& text, int pos, int* markerEnd) {
+        if (pos >= text.size() || text[pos] != QLatin1Char('~'))
+            return 0;
+
+        int distance = 1;
+        int i = pos + 1;
+        if (i < text.size() && (text[i] == QLatin1Char('1') || text[i] == QLatin1Char('2'))) {
+            distance = text[i].digitValue();
+            i++;
+        }
+        if (i < text.size() && !text[i].isSpace())
+            return 0;
+
+        *markerEnd = i;
+        return distance;
+    }
 }
 
 EngineQuery QueryParser::parseQuery(const QString& text_, const QString& prefix)
@@ -59,10 +79,17 @@ EngineQuery QueryParser::parseQuery(const QString& text_, const QString& prefix)
     bool inDoubleQuotes = false;
     bool inSingleQuotes = false;
     bool inPhrase = false;
+    bool inFuzzyMarker = false;
 
     QTextBoundaryFinder bf(QTextBoundaryFinder::Word, text);
     for (; bf.position() != -1; bf.toNextBoundary()) {
         if (bf.boundaryReasons() & QTextBoundaryFinder::StartOfItem) {
+            // The distance in "word~2" is not a word of its own
+            if (bf.position() < end) {
+                inFuzzyMarker = true;
+                continue;
+            }
+
             //
             // Check the previous delimiter
             int pos = bf.position();
@@ -107,6 +134,10 @@ EngineQuery QueryParser::parseQuery(const QString& text_, const QString& prefix)
             continue;
         }
         else if (bf.boundaryReasons() & QTextBoundaryFinder::EndOfItem) {
+            if (inFuzzyMarker) {
+                inFuzzyMarker = false;
+                continue;
+            }
             end = bf.position();
 
             QString str = text.mid(start, end - start);
@@ -129,6 +160,19 @@ EngineQuery QueryParser::parseQuery(const QString& text_, const QString& prefix)
             position++;
             if (inDoubleQuotes || inSingleQuotes || inPhrase) {
                 phraseQueries << EngineQuery(arr, position);
+                continue;
+            }
+
+            int markerEnd = end;
+            int distance = fuzzyMarker(text_, end, &markerEnd);
+            if (distance) {
+                end = markerEnd;
+                // A word of a single character would match everything
+                distance = qMin(distance, str.size() - 1);
+            }
+
+            if (distance > 0) {
+                queries << EngineQuery(prefix.toUtf8(), str.toUtf8(), distance, position);
             }
             else {
                 if (m_autoExpandSize && arr.size() >= m_autoExpandSize) {
@@ -33,6 +33,10 @@ class BALOO_ENGINE_EXPORT QueryParser
 public:
     QueryParser();
 
+    /**
+     * A word followed by "~" also matches the words one edit away from it,
+     * and one followed by "~2" those two edits away.
+     */
     EngineQuery parseQuery(const QString& str, const QString& prefix = QString());
 
     /**
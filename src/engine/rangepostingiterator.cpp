@@ -0,0 +1,75 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "rangepostingiterator.h"
+
+using namespace Baloo;
+
+RangePostingIterator::RangePostingIterator(PostingIterator* it, quint64 first, quint64 last)
+    : m_it(it)
+    , m_first(first)
+    , m_last(last)
+    , m_docId(0)
+    , m_started(false)
+{
+    Q_ASSERT(it);
+    Q_ASSERT(first <= last);
+}
+
+RangePostingIterator::~RangePostingIterator()
+{
+    delete m_it;
+}
+
+quint64 RangePostingIterator::docId() const
+{
+    return m_docId;
+}
+
+quint64 RangePostingIterator::next()
+{
+    quint64 id = 0;
+    if (!m_started) {
+        m_started = true;
+        id = m_it->skipTo(m_first);
+    } else if (m_docId) {
+        id = m_it->next();
+    }
+
+    m_docId = bounded(id);
+    return m_docId;
+}
+
+quint64 RangePostingIterator::skipTo(quint64 docId)
+{
+    if (m_started && (!m_docId || m_docId >= docId)) {
+        return m_docId;
+    }
+
+    m_started = true;
+    m_docId = bounded(m_it->skipTo(qMax(docId, m_first)));
+    return m_docId;
+}
+
+quint64 RangePostingIterator::cost() const
+{
+    return m_it->cost();
+}
@@ -0,0 +1,62 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef BALOO_RANGEPOSTINGITERATOR_H
+#define BALOO_RANGEPOSTINGITERATOR_H
+
+#include "postingiterator.h"
+
+namespace Baloo {
+
+/**
+ * Iterates over the ids of another iterator from \p first to \p last
+ * (inclusive). The ids before \p first are skipped with skipTo, so that
+ * a query can be split into ranges which are run separately.
+ */
+class BALOO_ENGINE_EXPORT RangePostingIterator : public PostingIterator
+{
+public:
+    /**
+     * Takes ownership of \p it
+     */
+    RangePostingIterator(PostingIterator* it, quint64 first, quint64 last);
+    ~RangePostingIterator() override;
+
+    quint64 next() override;
+    quint64 docId() const override;
+    quint64 skipTo(quint64 docId) override;
+    quint64 cost() const override;
+
+private:
+    quint64 bounded(quint64 id) const {
+        return id <= m_last ? id : 0;
+    }
+
+    PostingIterator* m_it;
+    quint64 m_first;
+    quint64 m_last;
+    quint64 m_docId;
+    bool m_started;
+};
+
+}
+
+#endif // BALOO_RANGEPOSTINGITERATOR_H
@@ -0,0 +1,226 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "regexpliterals.h"
+
+using namespace Baloo;
+
+namespace {
+// Returns the position right after the character class starting at \p pos,
+// or -1 if it is not closed
+int skipClass(const QString& pattern, int pos)
+{
+    Q_ASSERT(pattern[pos] == QLatin1Char('['));
+    int i = pos + 1;
+    if (i < pattern.size() && pattern[i] == QLatin1Char('^')) {
+        i++;
+    }
+    // A leading ] is part of the class
+    if (i < pattern.size() && pattern[i] == QLatin1Char(']')) {
+        i++;
+    }
+    while (i < pattern.size() && pattern[i] != QLatin1Char(']')) {
+        if (pattern[i] == QLatin1Char('\\')) {
+            i++;
+        }
+        i++;
+    }
+    return i < pattern.size() ? i + 1 : -1;
+}
+
+// Returns the position right after the group starting at \p pos,
+// or -1 if it is not closed
+int skipGroup(const QString& pattern, int pos)
+{
+    Q_ASSERT(pattern[pos] == QLatin1Char('('));
+    int depth = 0;
+    int i = pos;
+    while (i < pattern.size()) {
+        const QChar c = pattern[i];
+        if (c == QLatin1Char('\\')) {
+            i += 2;
+            continue;
+        }
+        if (c == QLatin1Char('[')) {
+            i = skipClass(pattern, i);
+            if (i < 0) {
+                return -1;
+            }
+            continue;
+        }
+        if (c == QLatin1Char('(')) {
+            depth++;
+        } else if (c == QLatin1Char(')') && --depth == 0) {
+            return i + 1;
+        }
+        i++;
+    }
+    return -1;
+}
+}
+
+RegExpLiterals::RegExpLiterals(const QRegularExpression& regexp)
+{
+    const QRegularExpression::PatternOptions unsupported = QRegularExpression::CaseInsensitiveOption
+        | QRegularExpression::ExtendedPatternSyntaxOption;
+    if (!regexp.isValid() || (regexp.patternOptions() & unsupported)) {
+        return;
+    }
+
+    const QString pattern = regexp.pattern();
+    // Alternatives make every literal optional, and inline options or
+    // lookarounds change what the rest of the pattern means
+    if (pattern.contains(QLatin1Char('|')) || pattern.contains(QLatin1String("(?"))
+        || pattern.contains(QLatin1String("\\Q"))) {
+        return;
+    }
+
+    parse(pattern);
+}
+
+void RegExpLiterals::parse(const QString& pattern)
+{
+    auto fail = [this]() {
+        m_prefix.clear();
+        m_required.clear();
+    };
+
+    int i = 0;
+    bool runAtStart = false;
+    if (pattern.startsWith(QLatin1Char('^'))) {
+        runAtStart = true;
+        i = 1;
+    } else if (pattern.startsWith(QLatin1String("\\A"))) {
+        runAtStart = true;
+        i = 2;
+    }
+
+    // The literal text matched by the consecutive atoms so far
+    QString run;
+    auto endRun = [&]() {
+        if (!run.isEmpty()) {
+            const QByteArray text = run.toUtf8();
+            if (runAtStart) {
+                m_prefix = text;
+            }
+            m_required << text;
+            run.clear();
+        }
+        runAtStart = false;
+    };
+
+    while (i < pattern.size()) {
+        const QChar c = pattern[i];
+
+        // The literal matched by the atom at i, if any
+        QString literal;
+        int atomEnd = i + 1;
+        if (c == QLatin1Char('\\')) {
+            if (i + 1 >= pattern.size()) {
+                return fail();
+            }
+            // These take operands, like \x41, \cA, \012, \p{L} or \k<name>,
+            // which are not matched literally
+            const QChar escaped = pattern[i + 1];
+            if (escaped.isDigit() || QStringLiteral("xcoNpPQgk").contains(escaped)) {
+                return fail();
+            }
+            // The other letters are classes or anchors
+            if (!escaped.isLetterOrNumber()) {
+                literal = escaped;
+            }
+            atomEnd = i + 2;
+        } else if (c == QLatin1Char('[')) {
+            atomEnd = skipClass(pattern, i);
+        } else if (c == QLatin1Char('(')) {
+            atomEnd = skipGroup(pattern, i);
+        } else if (c == QLatin1Char('^') || c == QLatin1Char('$')) {
+            endRun();
+            i++;
+            continue;
+        } else if (c == QLatin1Char('*') || c == QLatin1Char('+') || c == QLatin1Char('?')
+                   || c == QLatin1Char('{') || c == QLatin1Char(')')) {
+            return fail();
+        } else if (c != QLatin1Char('.')) {
+            literal = c;
+            // A quantifier applies to the whole character
+            if (c.isHighSurrogate() && i + 1 < pattern.size() && pattern[i + 1].isLowSurrogate()) {
+                literal += pattern[i + 1];
+                atomEnd = i + 2;
+            }
+        }
+        if (atomEnd < 0) {
+            return fail();
+        }
+
+        // The quantifier of the atom
+        int next = atomEnd;
+        bool optional = false;
+        bool repeated = false;
+        if (next < pattern.size()) {
+            const QChar q = pattern[next];
+            if (q == QLatin1Char('*') || q == QLatin1Char('?')) {
+                optional = true;
+                next++;
+            } else if (q == QLatin1Char('+')) {
+                repeated = true;
+                next++;
+            } else if (q == QLatin1Char('{')) {
+                const int close = pattern.indexOf(QLatin1Char('}'), next);
+                bool ok = false;
+                const int min = close < 0 ? 0 : pattern.mid(next + 1, close - next - 1).section(QLatin1Char(','), 0, 0).toInt(&ok);
+                if (!ok) {
+                    return fail();
+                }
+                optional = min == 0;
+                repeated = true;
+                next = close + 1;
+            }
+            // Lazy and possessive quantifiers
+            if ((optional || repeated) && next < pattern.size()
+                && (pattern[next] == QLatin1Char('?') || pattern[next] == QLatin1Char('+'))) {
+                next++;
+            }
+        }
+
+        if (!literal.isEmpty() && !optional) {
+            run += literal;
+            // The text after a repeated character does not follow the run
+            if (repeated) {
+                endRun();
+            }
+        } else {
+            endRun();
+        }
+        i = next;
+    }
+    endRun();
+}
+
+bool RegExpLiterals::mayMatch(const QByteArray& text) const
+{
+    for (const QByteArray& literal : m_required) {
+        if (!text.contains(literal)) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,75 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef BALOO_REGEXPLITERALS_H
+#define BALOO_REGEXPLITERALS_H
+
+#include "engine_export.h"
+
+#include <QByteArray>
+#include <QRegularExpression>
+#include <QVector>
+
+namespace Baloo {
+
+/**
+ * The literal text which every match of a regular expression contains,
+ * so that the terms which cannot match are skipped without running the
+ * expression on them. The analysis is conservative: patterns using
+ * alternatives, lookarounds, inline options or case insensitive matching
+ * require nothing.
+ */
+class BALOO_ENGINE_EXPORT RegExpLiterals
+{
+public:
+    explicit RegExpLiterals(const QRegularExpression& regexp);
+
+    /**
+     * The text every match starts with, when the expression is
+     * anchored to the start of the subject. In UTF-8.
+     */
+    QByteArray prefix() const {
+        return m_prefix;
+    }
+
+    /**
+     * The pieces of text every match contains, in UTF-8
+     */
+    QVector<QByteArray> required() const {
+        return m_required;
+    }
+
+    /**
+     * Returns false if \p text cannot match, because it lacks
+     * one of the required pieces
+     */
+    bool mayMatch(const QByteArray& text) const;
+
+private:
+    void parse(const QString& pattern);
+
+    QByteArray m_prefix;
+    QVector<QByteArray> m_required;
+};
+
+}
+
+#endif // BALOO_REGEXPLITERALS_H
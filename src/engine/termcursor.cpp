@@ -0,0 +1,114 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "enginedebug.h"
+#include "termcursor.h"
+
+using namespace Baloo;
+
+TermCursor::TermCursor(MDB_dbi dbi, MDB_txn* txn)
+    : m_cursor(nullptr)
+    , m_found(false)
+{
+    Q_ASSERT(txn != nullptr);
+    Q_ASSERT(dbi != 0);
+
+    int rc = mdb_cursor_open(txn, dbi, &m_cursor);
+    if (rc) {
+        qCWarning(ENGINE) << "TermCursor" << mdb_strerror(rc);
+        m_cursor = nullptr;
+    }
+}
+
+TermCursor::~TermCursor()
+{
+    if (m_cursor) {
+        mdb_cursor_close(m_cursor);
+    }
+}
+
+QByteArray TermCursor::seek(const QByteArray& term)
+{
+    Q_ASSERT(!term.isEmpty());
+
+    m_term = term;
+    m_found = false;
+    if (!m_cursor) {
+        return QByteArray();
+    }
+
+    MDB_val key;
+    key.mv_size = term.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(term.constData()));
+
+    MDB_val val{0, nullptr};
+    int rc = mdb_cursor_get(m_cursor, &key, &val, MDB_SET_KEY);
+    if (rc) {
+        if (rc != MDB_NOTFOUND) {
+            qCDebug(ENGINE) << "TermCursor::seek" << term << mdb_strerror(rc);
+        }
+        return QByteArray();
+    }
+
+    m_found = true;
+    return QByteArray::fromRawData(static_cast<char*>(val.mv_data), val.mv_size);
+}
+
+void TermCursor::put(const QByteArray& value)
+{
+    Q_ASSERT(!m_term.isEmpty());
+    Q_ASSERT(!value.isEmpty());
+    if (!m_cursor) {
+        return;
+    }
+
+    MDB_val key;
+    key.mv_size = m_term.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(m_term.constData()));
+
+    MDB_val val;
+    val.mv_size = value.size();
+    val.mv_data = static_cast<void*>(const_cast<char*>(value.constData()));
+
+    // When the cursor is already on the term, the record is replaced where
+    // it is. LMDB overwrites the data in place if the size is unchanged.
+    int rc = mdb_cursor_put(m_cursor, &key, &val, m_found ? MDB_CURRENT : 0);
+    if (rc) {
+        qCWarning(ENGINE) << "TermCursor::put" << mdb_strerror(rc);
+        return;
+    }
+    m_found = true;
+}
+
+void TermCursor::del()
+{
+    Q_ASSERT(!m_term.isEmpty());
+    if (!m_cursor || !m_found) {
+        return;
+    }
+
+    int rc = mdb_cursor_del(m_cursor, 0);
+    if (rc) {
+        qCDebug(ENGINE) << "TermCursor::del" << m_term << mdb_strerror(rc);
+        return;
+    }
+    m_found = false;
+}
@@ -0,0 +1,77 @@
+/*
+ * This file is part of the KDE Baloo project.
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef BALOO_TERMCURSOR_H
+#define BALOO_TERMCURSOR_H
+
+#include "engine_export.h"
+
+#include <QByteArray>
+#include <lmdb.h>
+
+namespace Baloo {
+
+/**
+ * A write cursor over one of the term keyed databases, i.e. the PostingDB
+ * or the PositionDB.
+ *
+ * It is meant for updating a large number of terms in key order. Every
+ * lookup starts from the pages the cursor already holds, and the updates
+ * replace the record the cursor is positioned on instead of searching for
+ * the key again.
+ */
+class BALOO_ENGINE_EXPORT TermCursor
+{
+public:
+    TermCursor(MDB_dbi dbi, MDB_txn* txn);
+    ~TermCursor();
+
+    /**
+     * Positions the cursor on \p term and returns its current value, or
+     * an empty array if the term does not exist.
+     *
+     * The returned array points into the memory map, and is only valid
+     * until the next call to put or del.
+     */
+    QByteArray seek(const QByteArray& term);
+
+    /**
+     * Stores \p value for the term last passed to seek.
+     */
+    void put(const QByteArray& value);
+
+    /**
+     * Removes the term last passed to seek, if it exists.
+     */
+    void del();
+
+private:
+    TermCursor(const TermCursor&) = delete;
+    TermCursor& operator=(const TermCursor&) = delete;
+
+    MDB_cursor* m_cursor;
+    QByteArray m_term;
+    bool m_found;
+};
+
+}
+
+#endif // BALOO_TERMCURSOR_H
@@ -20,6 +20,9 @@
 
 #include "transaction.h"
 #include "postingdb.h"
+#include "postingdeltadb.h"
+#include "prefixdb.h"
+#include "changelogdb.h"
 #include "documentdb.h"
 #include "documenturldb.h"
 #include "documentiddb.h"
@@ -41,13 +44,17 @@
 
 #include "enginedebug.h"
 
+#include <QElapsedTimer>
 #include <QFile>
 #include <QFileInfo>
 
+#include <algorithm>
+#include <limits>
+
 using namespace Baloo;
 
 Transaction::Transaction(const Database& db, Transaction::TransactionType type)
-    : m_dbis(db.m_dbis)
+    : m_dbis(db.currentDbis())
     , m_env(db.m_env)
     , m_writeTrans(nullptr)
 {
@@ -154,6 +161,20 @@ DocumentTimeDB::TimeInfo Transaction::documentTimeInfo(quint64 id) const
     return docTimeDb.get(id);
 }
 
+QVector<quint64> Transaction::documentIdRangeStarts(int count) const
+{
+    Q_ASSERT(m_txn);
+
+    DocumentTimeDB docTimeDb(m_dbis.docTimeDbi, m_txn);
+    return docTimeDb.rangeStarts(count);
+}
+
+void Transaction::setDocumentIdRange(quint64 first, quint64 last)
+{
+    m_firstId = first;
+    m_lastId = last;
+}
+
 QByteArray Transaction::documentData(quint64 id) const
 {
     Q_ASSERT(m_txn);
@@ -174,6 +195,38 @@ bool Transaction::hasChanges() const
     return m_writeTrans->hasChanges();
 }
 
+void Transaction::flush()
+{
+    Q_ASSERT(m_txn);
+    if (!m_writeTrans) {
+        qCWarning(ENGINE) << "m_writeTrans is null";
+        return;
+    }
+
+    m_writeTrans->commit();
+}
+
+void Transaction::setMemoryBudget(qint64 bytes)
+{
+    Q_ASSERT(m_txn);
+    if (!m_writeTrans) {
+        qCWarning(ENGINE) << "m_writeTrans is null";
+        return;
+    }
+
+    m_writeTrans->setMemoryBudget(bytes);
+}
+
+qint64 Transaction::pendingBytes() const
+{
+    return m_writeTrans ? m_writeTrans->pendingBytes() : 0;
+}
+
+qint64 Transaction::uncommittedBytes() const
+{
+    return m_writeTrans ? m_writeTrans->uncommittedBytes() : 0;
+}
+
 QVector<quint64> Transaction::fetchPhaseOneIds(int size) const
 {
     Q_ASSERT(m_txn);
@@ -187,10 +240,39 @@ QVector<QByteArray> Transaction::fetchTermsStartingWith(const QByteArray& term)
 {
     Q_ASSERT(term.size() > 0);
 
-    PostingDB postingDb(m_dbis.postingDbi, m_txn);
+    PostingDB postingDb(m_dbis.postingDbi, m_dbis.postingDeltaDbi, m_txn);
     return postingDb.fetchTermsStartingWith(term);
 }
 
+bool Transaction::changesSince(quint64 txnId, QVector<QByteArray>* terms, bool* documents) const
+{
+    Q_ASSERT(m_txn);
+    terms->clear();
+    *documents = false;
+
+    const quint64 lastTxnId = mdb_txn_id(m_txn);
+    if (txnId >= lastTxnId) {
+        return txnId == lastTxnId;
+    }
+    if (!m_dbis.changeLogDbi) {
+        return false;
+    }
+
+    ChangeLogDB changeLogDb(m_dbis.changeLogDbi, m_txn);
+    for (quint64 id = txnId + 1; id <= lastTxnId; id++) {
+        ChangeLogDB::Changes changes;
+        if (!changeLogDb.get(id, &changes)) {
+            return false;
+        }
+        *terms << changes.terms;
+        *documents |= changes.documents;
+    }
+
+    std::sort(terms->begin(), terms->end());
+    terms->erase(std::unique(terms->begin(), terms->end()), terms->end());
+    return true;
+}
+
 uint Transaction::phaseOneSize() const
 {
     Q_ASSERT(m_txn);
@@ -293,6 +375,44 @@ void Transaction::replaceDocument(const Document& doc, DocumentOperations operat
     m_writeTrans->replaceDocument(doc, operations);
 }
 
+bool Transaction::compactPostingDeltas(int maxTerms)
+{
+    Q_ASSERT(m_txn);
+    Q_ASSERT(maxTerms > 0);
+    if (!m_writeTrans) {
+        qCWarning(ENGINE) << "m_writeTrans is null";
+        return false;
+    }
+
+    return m_writeTrans->compactPostingDeltas(maxTerms);
+}
+
+bool Transaction::buildPrefixes(int maxPrefixes)
+{
+    Q_ASSERT(m_txn);
+    Q_ASSERT(maxPrefixes > 0);
+    if (!m_writeTrans) {
+        qCWarning(ENGINE) << "m_writeTrans is null";
+        return false;
+    }
+    Q_ASSERT(!m_writeTrans->hasChanges());
+
+    return PrefixUpdater(m_dbis, m_txn).buildNext(maxPrefixes);
+}
+
+uint Transaction::postingDeltaCount() const
+{
+    Q_ASSERT(m_txn);
+    uint count = 0;
+    if (m_dbis.postingDeltaDbi) {
+        count += PostingDeltaDB(m_dbis.postingDeltaDbi, m_txn).size();
+    }
+    if (m_dbis.prefixDbi) {
+        count += PrefixDB(m_dbis.prefixDbi, m_dbis.prefixDeltaDbi, m_txn).deltaCount();
+    }
+    return count;
+}
+
 void Transaction::commit()
 {
     Q_ASSERT(m_txn);
@@ -302,12 +422,25 @@ void Transaction::commit()
     }
 
     m_writeTrans->commit();
+    m_commitStats = m_writeTrans->stats();
     delete m_writeTrans;
     m_writeTrans = nullptr;
 
+    MDB_envinfo before;
+    mdb_env_info(m_env, &before);
+
+    // Includes syncing the data to disk
+    QElapsedTimer timer;
+    timer.start();
     int rc = mdb_txn_commit(m_txn);
+    m_commitStats.add(CommitStats::CommitTime, timer.nsecsElapsed() / 1000);
+
     if (rc) {
         qCWarning(ENGINE) << "Transaction::commit" << mdb_strerror(rc);
+    } else {
+        MDB_envinfo after;
+        mdb_env_info(m_env, &after);
+        m_commitStats.add(CommitStats::NewPages, static_cast<qint64>(after.me_last_pgno) - static_cast<qint64>(before.me_last_pgno));
     }
 
     m_txn = nullptr;
@@ -330,14 +463,26 @@ void Transaction::abort()
 
 PostingIterator* Transaction::postingIterator(const EngineQuery& query) const
 {
-    PostingDB postingDb(m_dbis.postingDbi, m_txn);
-    PositionDB positionDb(m_dbis.positionDBi, m_txn);
+    PostingDB postingDb(m_dbis.postingDbi, m_dbis.postingDeltaDbi, m_txn);
+    postingDb.setIdRange(m_firstId, m_lastId);
+    PositionDB positionDb(m_dbis.positionDBi, m_dbis.postingDeltaDbi, m_txn);
 
     if (query.leaf()) {
         if (query.op() == EngineQuery::Equal) {
             return postingDb.iter(query.term());
         } else if (query.op() == EngineQuery::StartsWith) {
+            // Heavy prefixes have their union precomputed
+            if (m_dbis.prefixDbi && PrefixDB::isIndexable(query.term())) {
+                PrefixDB prefixDb(m_dbis.prefixDbi, m_dbis.prefixDeltaDbi, m_txn);
+                prefixDb.setIdRange(m_firstId, m_lastId);
+                if (PostingIterator* it = prefixDb.iter(query.term())) {
+                    return it;
+                }
+            }
             return postingDb.prefixIter(query.term());
+        } else if (query.op() == EngineQuery::Fuzzy) {
+            const QByteArray term = query.term();
+            return postingDb.fuzzyIter(term.left(query.prefixSize()), term.mid(query.prefixSize()), query.distance());
         } else {
             Q_ASSERT(0);
         }
@@ -395,7 +540,8 @@ PostingIterator* Transaction::postingIterator(const EngineQuery& query) const
 
 PostingIterator* Transaction::postingCompIterator(const QByteArray& prefix, qlonglong value, PostingDB::Comparator com) const
 {
-    PostingDB postingDb(m_dbis.postingDbi, m_txn);
+    PostingDB postingDb(m_dbis.postingDbi, m_dbis.postingDeltaDbi, m_txn);
+    postingDb.setIdRange(m_firstId, m_lastId);
     return postingDb.compIter(prefix, value, com);
 }
 
@@ -411,10 +557,73 @@ PostingIterator* Transaction::mTimeRangeIter(quint32 beginTime, quint32 endTime)
     return mTimeDb.iterRange(beginTime, endTime);
 }
 
+QVector<MTimeDB::Entry> Transaction::newestDocuments(int count, const MTimeDB::Entry& after) const
+{
+    MTimeDB mTimeDb(m_dbis.mtimeDbi, m_txn);
+    return mTimeDb.newest(count, after);
+}
+
 PostingIterator* Transaction::docUrlIter(quint64 id) const
 {
     DocumentUrlDB docUrlDb(m_dbis.idTreeDbi, m_dbis.idFilenameDbi, m_txn);
-    return docUrlDb.iter(id);
+    return docUrlDb.iter(id, m_firstId, m_lastId);
+}
+
+quint64 Transaction::documentCount(const EngineQuery& query) const
+{
+    Q_ASSERT(m_txn);
+
+    PostingDB postingDb(m_dbis.postingDbi, m_dbis.postingDeltaDbi, m_txn);
+
+    if (query.leaf()) {
+        if (query.op() == EngineQuery::Equal) {
+            return postingDb.documentCount(query.term());
+        } else if (query.op() == EngineQuery::StartsWith) {
+            if (m_dbis.prefixDbi && PrefixDB::isIndexable(query.term())) {
+                PrefixDB prefixDb(m_dbis.prefixDbi, m_dbis.prefixDeltaDbi, m_txn);
+                const qint64 count = prefixDb.documentCount(query.term());
+                if (count >= 0) {
+                    return count;
+                }
+            }
+            return postingDb.prefixDocumentCount(query.term());
+        } else if (query.op() == EngineQuery::Fuzzy) {
+            const QByteArray term = query.term();
+            return postingDb.fuzzyDocumentCount(term.left(query.prefixSize()), term.mid(query.prefixSize()), query.distance());
+        } else {
+            Q_ASSERT(0);
+            return 0;
+        }
+    }
+
+    const auto subQueries = query.subQueries();
+    if (subQueries.isEmpty()) {
+        return 0;
+    }
+
+    if (query.op() == EngineQuery::Or) {
+        quint64 count = 0;
+        for (const EngineQuery& q : subQueries) {
+            count += documentCount(q);
+        }
+        return count;
+    }
+
+    // And and Phrase match at most as many as their rarest part
+    quint64 count = std::numeric_limits<quint64>::max();
+    for (const EngineQuery& q : subQueries) {
+        count = qMin(count, documentCount(q));
+        if (!count) {
+            break;
+        }
+    }
+    return count;
+}
+
+quint64 Transaction::mTimeRangeCount(quint32 beginTime, quint32 endTime) const
+{
+    MTimeDB mTimeDb(m_dbis.mtimeDbi, m_txn);
+    return mTimeDb.documentCount(beginTime, endTime);
 }
 
 QVector<quint64> Transaction::exec(const EngineQuery& query, int limit) const
@@ -479,6 +688,10 @@ DatabaseSize Transaction::dbSize()
     DatabaseSize dbSize;
     dbSize.postingDb = dbiSize(m_txn, m_dbis.postingDbi);
     dbSize.positionDb = dbiSize(m_txn, m_dbis.positionDBi);
+    dbSize.postingDeltaDb = m_dbis.postingDeltaDbi ? dbiSize(m_txn, m_dbis.postingDeltaDbi) : 0;
+    dbSize.prefixDb = m_dbis.prefixDbi ? dbiSize(m_txn, m_dbis.prefixDbi) : 0;
+    dbSize.prefixDb += m_dbis.prefixDeltaDbi ? dbiSize(m_txn, m_dbis.prefixDeltaDbi) : 0;
+    dbSize.changeLog = m_dbis.changeLogDbi ? dbiSize(m_txn, m_dbis.changeLogDbi) : 0;
     dbSize.docTerms = dbiSize(m_txn, m_dbis.docTermsDbi);
     dbSize.docFilenameTerms = dbiSize(m_txn, m_dbis.docFilenameTermsDbi);
     dbSize.docXattrTerms = dbiSize(m_txn, m_dbis.docXattrTermsDbi);
@@ -494,7 +707,7 @@ DatabaseSize Transaction::dbSize()
 
     dbSize.mtimeDb = dbiSize(m_txn, m_dbis.mtimeDbi);
 
-    dbSize.expectedSize = dbSize.postingDb + dbSize.positionDb + dbSize.docTerms + dbSize.docFilenameTerms
+    dbSize.expectedSize = dbSize.postingDb + dbSize.positionDb + dbSize.postingDeltaDb + dbSize.prefixDb + dbSize.changeLog + dbSize.docTerms + dbSize.docFilenameTerms
                   + dbSize.docXattrTerms + dbSize.idTree + dbSize.idFilename + dbSize.docTime
                   + dbSize.docData + dbSize.contentIndexingIds + dbSize.failedIds + dbSize.mtimeDb;
 
@@ -514,7 +727,7 @@ void Transaction::checkFsTree()
     DocumentDB documentXattrTermsDB(m_dbis.docXattrTermsDbi, m_txn);
     DocumentDB documentFileNameTermsDB(m_dbis.docFilenameTermsDbi, m_txn);
     DocumentUrlDB docUrlDb(m_dbis.idTreeDbi, m_dbis.idFilenameDbi, m_txn);
-    PostingDB postingDb(m_dbis.postingDbi, m_txn);
+    PostingDB postingDb(m_dbis.postingDbi, m_dbis.postingDeltaDbi, m_txn);
 
     const auto map = postingDb.toTestMap();
 
@@ -586,7 +799,7 @@ void Transaction::checkTermsDbinPostingDb()
     DocumentDB documentTermsDB(m_dbis.docTermsDbi, m_txn);
     DocumentDB documentXattrTermsDB(m_dbis.docXattrTermsDbi, m_txn);
     DocumentDB documentFileNameTermsDB(m_dbis.docFilenameTermsDbi, m_txn);
-    PostingDB postingDb(m_dbis.postingDbi, m_txn);
+    PostingDB postingDb(m_dbis.postingDbi, m_dbis.postingDeltaDbi, m_txn);
 
     // Iterate over each document, and fetch all terms
     // check if each term maps to its own id in the posting db
@@ -621,7 +834,7 @@ void Transaction::checkPostingDbinTermsDb()
     DocumentDB documentTermsDB(m_dbis.docTermsDbi, m_txn);
     DocumentDB documentXattrTermsDB(m_dbis.docXattrTermsDbi, m_txn);
     DocumentDB documentFileNameTermsDB(m_dbis.docFilenameTermsDbi, m_txn);
-    PostingDB postingDb(m_dbis.postingDbi, m_txn);
+    PostingDB postingDb(m_dbis.postingDbi, m_dbis.postingDeltaDbi, m_txn);
 
     QMap<QByteArray, PostingList> map = postingDb.toTestMap();
     QMapIterator<QByteArray, PostingList> it(map);
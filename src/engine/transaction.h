@@ -27,6 +27,7 @@
 #include "writetransaction.h"
 #include "documenttimedb.h"
 #include <functional>
+#include <limits>
 
 #include <lmdb.h>
 
@@ -69,20 +70,61 @@ public:
 
     DocumentTimeDB::TimeInfo documentTimeInfo(quint64 id) const;
 
+    /**
+     * The first ids of up to \p count ranges splitting the documents,
+     * so that a query can be run on each range separately
+     */
+    QVector<quint64> documentIdRangeStarts(int count) const;
+
+    /**
+     * Only the documents with ids from \p first to \p last are returned
+     * by the posting and folder iterators created afterwards. The posting
+     * lists are cut down before they are merged, so that each part of a
+     * query split by documentIdRangeStarts only decodes its own range.
+     */
+    void setDocumentIdRange(quint64 first, quint64 last);
+
     QVector<quint64> exec(const EngineQuery& query, int limit = -1) const;
 
     PostingIterator* postingIterator(const EngineQuery& query) const;
     PostingIterator* postingCompIterator(const QByteArray& prefix, qlonglong value, PostingDB::Comparator com) const;
     PostingIterator* mTimeIter(quint32 mtime, MTimeDB::Comparator com) const;
     PostingIterator* mTimeRangeIter(quint32 beginTime, quint32 endTime) const;
+
+    /**
+     * Lists up to \p count documents, the most recently modified first,
+     * continuing after \p after. See MTimeDB::newest
+     */
+    QVector<MTimeDB::Entry> newestDocuments(int count, const MTimeDB::Entry& after = MTimeDB::Entry()) const;
     PostingIterator* docUrlIter(quint64 id) const;
 
+    /**
+     * Estimates the number of documents matched by \p query, from the sizes
+     * of the posting lists and without decoding them. Only returns 0 when
+     * nothing matches.
+     */
+    quint64 documentCount(const EngineQuery& query) const;
+
+    /**
+     * Estimates the number of documents with an mtime between \p beginTime
+     * and \p endTime (inclusive)
+     */
+    quint64 mTimeRangeCount(quint32 beginTime, quint32 endTime) const;
+
     QVector<quint64> fetchPhaseOneIds(int size) const;
     uint phaseOneSize() const;
     uint size() const;
 
     QVector<QByteArray> fetchTermsStartingWith(const QByteArray& term) const;
 
+    /**
+     * Collects the sorted terms changed by the transactions committed after
+     * \p txnId, up to the one this transaction reads, and whether they
+     * changed which documents there are, their urls or their mtimes.
+     * Returns false when that is not known, see ChangeLogDB.
+     */
+    bool changesSince(quint64 txnId, QVector<QByteArray>* terms, bool* documents) const;
+
     //
     // Introspecing document data
     //
@@ -99,6 +141,34 @@ public:
     void abort();
     bool hasChanges() const;
 
+    /**
+     * The statistics of the last commit, including the time spent
+     * in mdb_txn_commit and the pages it added to the database file
+     */
+    CommitStats commitStats() const {
+        return m_commitStats;
+    }
+
+    /**
+     * Writes the pending changes into the LMDB transaction without
+     * committing it, which frees the memory they use.
+     */
+    void flush();
+
+    /**
+     * Limits the memory used by pending changes, see WriteTransaction::setMemoryBudget
+     */
+    void setMemoryBudget(qint64 bytes);
+
+    /**
+     * The budget used by the indexers, which may add or remove a large
+     * number of documents in a single transaction
+     */
+    static const qint64 defaultMemoryBudget = 64 * 1024 * 1024;
+
+    qint64 pendingBytes() const;
+    qint64 uncommittedBytes() const;
+
     //
     // Write Methods
     //
@@ -116,6 +186,28 @@ public:
     }
 
     void replaceDocument(const Document& doc, DocumentOperations operations);
+
+    /**
+     * Folds the posting deltas of up to \p maxTerms terms into the main
+     * PostingDB, and those of up to \p maxTerms prefixes into the PrefixDB.
+     * Returns true if there are still deltas left.
+     */
+    bool compactPostingDeltas(int maxTerms);
+
+    /**
+     * Stores about \p maxPrefixes more of the prefixes which expand to many
+     * terms, for databases created before the PrefixDB existed. Until it is
+     * done, the prefixes which are not stored yet are expanded over the
+     * PostingDB. Has to be called before anything else is changed in the
+     * transaction. Returns true if there are still terms left to go through.
+     */
+    bool buildPrefixes(int maxPrefixes);
+
+    /**
+     * The number of delta records, those of the stored prefixes included
+     */
+    uint postingDeltaCount() const;
+
     void setPhaseOne(quint64 id);
     void removePhaseOne(quint64 id);
 
@@ -127,10 +219,13 @@ public:
 private:
     Transaction(const Transaction& rhs) = delete;
 
-    const DatabaseDbis& m_dbis;
+    DatabaseDbis m_dbis;
     MDB_txn *m_txn = nullptr;
     MDB_env *m_env = nullptr;
     WriteTransaction *m_writeTrans = nullptr;
+    CommitStats m_commitStats;
+    quint64 m_firstId = 0;
+    quint64 m_lastId = std::numeric_limits<quint64>::max();
 
     friend class DatabaseSanitizerImpl;
     friend class DBState; // for testing
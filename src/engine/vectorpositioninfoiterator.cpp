@@ -20,6 +20,7 @@
 
 #include "vectorpositioninfoiterator.h"
 #include "positioninfo.h"
+#include "gallopsearch.h"
 
 using namespace Baloo;
 
@@ -41,6 +42,20 @@ quint64 VectorPositionInfoIterator::next()
     return m_vector[m_pos].docId;
 }
 
+quint64 VectorPositionInfoIterator::skipTo(quint64 docId)
+{
+    m_pos = gallopSearch(m_vector, qMax(m_pos, 0), docId, [](const PositionInfo& info) {
+        return info.docId;
+    });
+    if (m_pos >= m_vector.size()) {
+        m_pos = m_vector.size();
+        m_vector.clear();
+        return 0;
+    }
+
+    return m_vector[m_pos].docId;
+}
+
 quint64 VectorPositionInfoIterator::docId() const
 {
     if (m_pos < 0 || m_pos >= m_vector.size()) {
@@ -50,14 +65,17 @@ quint64 VectorPositionInfoIterator::docId() const
     return m_vector[m_pos].docId;
 }
 
-QVector<uint> VectorPositionInfoIterator::positions()
+const QVector<uint>& VectorPositionInfoIterator::positions() const
 {
+    static const QVector<uint> noPositions;
     if (m_pos < 0 || m_pos >= m_vector.size()) {
-        return QVector<uint>();
+        return noPositions;
     }
 
     return m_vector[m_pos].positions;
 }
 
-
-
+quint64 VectorPositionInfoIterator::cost() const
+{
+    return m_vector.size() - qBound(0, m_pos, m_vector.size());
+}
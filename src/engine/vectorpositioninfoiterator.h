@@ -33,7 +33,14 @@ public:
 
     quint64 docId() const override;
     quint64 next() override;
-    QVector<uint> positions();
+    quint64 skipTo(quint64 docId) override;
+    quint64 cost() const override;
+
+    /**
+     * The positions in the current document. The reference is valid
+     * until the iterator moves.
+     */
+    const QVector<uint>& positions() const;
 
 private:
     QVector<PositionInfo> m_vector;
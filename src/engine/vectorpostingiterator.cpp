@@ -19,6 +19,7 @@
  */
 
 #include "vectorpostingiterator.h"
+#include "gallopsearch.h"
 
 using namespace Baloo;
 
@@ -48,3 +49,20 @@ quint64 VectorPostingIterator::next()
     m_pos++;
     return m_values[m_pos];
 }
+
+quint64 VectorPostingIterator::skipTo(quint64 docId)
+{
+    m_pos = gallopSearch(m_values, qMax(m_pos, 0), docId);
+    if (m_pos >= m_values.size()) {
+        m_pos = m_values.size();
+        m_values.clear();
+        return 0;
+    }
+
+    return m_values[m_pos];
+}
+
+quint64 VectorPostingIterator::cost() const
+{
+    return m_values.size() - qBound(0, m_pos, m_values.size());
+}
@@ -31,11 +31,29 @@
 #include "documentdatadb.h"
 #include "mtimedb.h"
 #include "idutils.h"
+#include "termcursor.h"
+#include "postingdeltadb.h"
+#include "prefixdb.h"
+#include "changelogdb.h"
+#include "postingcodec.h"
+#include "positioncodec.h"
+#include "enginedebug.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMap>
+#include <QPair>
+
+#include <algorithm>
+#include <memory>
 
 using namespace Baloo;
 
 void WriteTransaction::addDocument(const Document& doc)
 {
+    QElapsedTimer timer;
+    timer.start();
+
     quint64 id = doc.id();
 
     DocumentDB documentTermsDB(m_dbis.docTermsDbi, m_txn);
@@ -57,6 +75,7 @@ void WriteTransaction::addDocument(const Document& doc)
     if (!docUrlDB.put(id, doc.url())) {
         return;
     }
+    m_documentsChanged = true;
 
     QVector<QByteArray> docTerms = addTerms(id, doc.m_terms);
     documentTermsDB.put(id, docTerms);
@@ -84,25 +103,21 @@ void WriteTransaction::addDocument(const Document& doc)
     if (!doc.m_data.isEmpty()) {
         docDataDB.put(id, doc.m_data);
     }
+
+    m_stats.add(CommitStats::DocumentTime, timer.nsecsElapsed() / 1000);
+    flushIfOverBudget();
 }
 
 QVector<QByteArray> WriteTransaction::addTerms(quint64 id, const QMap<QByteArray, Document::TermData>& terms)
 {
     QVector<QByteArray> termList;
     termList.reserve(terms.size());
-    m_pendingOperations.reserve(m_pendingOperations.size() + terms.size());
 
-    QMapIterator<QByteArray, Document::TermData> it(terms);
-    while (it.hasNext()) {
-        const QByteArray& term = it.next().key();
-        termList.append(term);
-
-        Operation op;
-        op.type = AddId;
-        op.data.docId = id;
-        op.data.positions = it.value().positions;
-
-        m_pendingOperations[term].append(op);
+    // The positions are packed straight into the pending operations,
+    // without holding on to the TermData of the document
+    for (auto it = terms.cbegin(); it != terms.cend(); ++it) {
+        termList.append(it.key());
+        m_pendingOperations.add(it.key(), id, it.value().positions);
     }
 
     return termList;
@@ -111,6 +126,9 @@ QVector<QByteArray> WriteTransaction::addTerms(quint64 id, const QMap<QByteArray
 
 void WriteTransaction::removeDocument(quint64 id)
 {
+    QElapsedTimer timer;
+    timer.start();
+
     DocumentDB documentTermsDB(m_dbis.docTermsDbi, m_txn);
     DocumentDB documentXattrTermsDB(m_dbis.docXattrTermsDbi, m_txn);
     DocumentDB documentFileNameTermsDB(m_dbis.docFilenameTermsDbi, m_txn);
@@ -124,6 +142,7 @@ void WriteTransaction::removeDocument(quint64 id)
     removeTerms(id, documentTermsDB.get(id));
     removeTerms(id, documentXattrTermsDB.get(id));
     removeTerms(id, documentFileNameTermsDB.get(id));
+    m_documentsChanged = true;
 
     documentTermsDB.del(id);
     documentXattrTermsDB.del(id);
@@ -141,36 +160,48 @@ void WriteTransaction::removeDocument(quint64 id)
     mtimeDB.del(info.mTime, id);
 
     docDataDB.del(id);
+
+    m_stats.add(CommitStats::DocumentTime, timer.nsecsElapsed() / 1000);
+    flushIfOverBudget();
 }
 
 void WriteTransaction::removeTerms(quint64 id, const QVector<QByteArray>& terms)
 {
     for (const QByteArray& term : terms) {
-        Operation op;
-        op.type = RemoveId;
-        op.data.docId = id;
-
-        m_pendingOperations[term].append(op);
+        m_pendingOperations.remove(term, id);
     }
 }
 
-void WriteTransaction::removeRecursively(quint64 parentId)
+void WriteTransaction::flushIfOverBudget()
 {
-    DocumentUrlDB docUrlDB(m_dbis.idTreeDbi, m_dbis.idFilenameDbi, m_txn);
+    if (m_memoryBudget > 0 && m_pendingOperations.memoryUsage() > m_memoryBudget) {
+        commit();
+    }
+}
 
+namespace {
+
+// The number of documents removeRecursively removes in one go
+const int removalBatchSize = 10000;
+
+/*
+ * Appends the ids of the subtree below \p parentId to \p ids, every
+ * folder after its children
+ */
+void collectSubtree(const DocumentUrlDB& docUrlDB, quint64 parentId, QVector<quint64>& ids)
+{
     const QVector<quint64> children = docUrlDB.getChildren(parentId);
     for (quint64 id : children) {
         if (id) {
-            removeRecursively(id);
+            collectSubtree(docUrlDB, id, ids);
         }
     }
-    removeDocument(parentId);
+    ids.append(parentId);
 }
 
-bool WriteTransaction::removeRecursively(quint64 parentId, std::function<bool(quint64)> shouldDelete)
+bool collectSubtree(const DocumentUrlDB& docUrlDB, quint64 parentId,
+                    const std::function<bool(quint64)>& shouldDelete, QVector<quint64>& ids)
 {
-    DocumentUrlDB docUrlDB(m_dbis.idTreeDbi, m_dbis.idFilenameDbi, m_txn);
-
     if (parentId && !shouldDelete(parentId)) {
         return false;
     }
@@ -178,18 +209,324 @@ bool WriteTransaction::removeRecursively(quint64 parentId, std::function<bool(qu
     bool isEmpty = true;
     const QVector<quint64> children = docUrlDB.getChildren(parentId);
     for (quint64 id : children) {
-        isEmpty &= removeRecursively(id, shouldDelete);
+        isEmpty &= collectSubtree(docUrlDB, id, shouldDelete, ids);
+    }
+
+    if (isEmpty && parentId) {
+        ids.append(parentId);
+    }
+    return isEmpty;
+}
+
+/*
+ * Removes the sorted \p ids from the sorted \p list
+ */
+template <typename T, typename Id>
+void removeSortedIds(QVector<T>& list, const QVector<quint64>& ids, Id idOf)
+{
+    auto it = ids.cbegin();
+    const auto end = ids.cend();
+    auto last = std::remove_if(list.begin(), list.end(), [&](const T& item) {
+        const quint64 id = idOf(item);
+        while (it != end && *it < id) {
+            ++it;
+        }
+        return it != end && *it == id;
+    });
+    list.erase(last, list.end());
+}
+
+/*
+ * Whether any of \p deltas changes positions
+ */
+bool hasPositions(const QVector<PostingDeltaDB::Delta>& deltas)
+{
+    return std::any_of(deltas.cbegin(), deltas.cend(), [](const PostingDeltaDB::Delta& delta) {
+        return !delta.positions.isEmpty();
+    });
+}
+
+/*
+ * Deletes the records of the sorted \p ids from an integer keyed database.
+ * A single cursor walks the database, so neighbouring records are found
+ * on the pages it already holds.
+ */
+void deleteSortedIds(MDB_txn* txn, MDB_dbi dbi, const QVector<quint64>& ids)
+{
+    MDB_cursor* cursor;
+    int rc = mdb_cursor_open(txn, dbi, &cursor);
+    if (rc) {
+        qCWarning(ENGINE) << "WriteTransaction::deleteSortedIds" << mdb_strerror(rc);
+        return;
     }
-    // refetch
-    if (isEmpty && docUrlDB.getChildren(parentId).isEmpty()) {
-        removeDocument(parentId);
-        return true;
+
+    for (quint64 id : ids) {
+        MDB_val key;
+        key.mv_size = sizeof(quint64);
+        key.mv_data = static_cast<void*>(&id);
+
+        MDB_val val{0, nullptr};
+        rc = mdb_cursor_get(cursor, &key, &val, MDB_SET);
+        if (rc == MDB_NOTFOUND) {
+            continue;
+        }
+        if (!rc) {
+            rc = mdb_cursor_del(cursor, 0);
+        }
+        if (rc) {
+            qCWarning(ENGINE) << "WriteTransaction::deleteSortedIds" << id << mdb_strerror(rc);
+            break;
+        }
     }
-    return false;
+
+    mdb_cursor_close(cursor);
+}
+
+}
+
+void WriteTransaction::removeRecursively(quint64 parentId)
+{
+    DocumentUrlDB docUrlDB(m_dbis.idTreeDbi, m_dbis.idFilenameDbi, m_txn);
+
+    QVector<quint64> ids;
+    collectSubtree(docUrlDB, parentId, ids);
+    removeDocuments(ids);
+}
+
+bool WriteTransaction::removeRecursively(quint64 parentId, std::function<bool(quint64)> shouldDelete)
+{
+    DocumentUrlDB docUrlDB(m_dbis.idTreeDbi, m_dbis.idFilenameDbi, m_txn);
+
+    QVector<quint64> ids;
+    const bool isEmpty = collectSubtree(docUrlDB, parentId, shouldDelete, ids);
+    removeDocuments(ids);
+    return isEmpty;
+}
+
+void WriteTransaction::removeDocuments(const QVector<quint64>& ids)
+{
+    // Every batch is a prefix of the list, so a folder is never removed
+    // before its children
+    for (int i = 0; i < ids.size(); i += removalBatchSize) {
+        QVector<quint64> batch = ids.mid(i, removalBatchSize);
+        std::sort(batch.begin(), batch.end());
+        batch.erase(std::unique(batch.begin(), batch.end()), batch.end());
+        batch.removeAll(0);
+        if (!batch.isEmpty()) {
+            removeDocumentBatch(batch);
+        }
+    }
+}
+
+void WriteTransaction::removeDocumentBatch(const QVector<quint64>& ids)
+{
+    // The removal sets below are applied to what is stored, so anything
+    // still pending has to be written first
+    if (!m_pendingOperations.isEmpty()) {
+        commit();
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    DocumentDB documentTermsDB(m_dbis.docTermsDbi, m_txn);
+    DocumentDB documentXattrTermsDB(m_dbis.docXattrTermsDbi, m_txn);
+    DocumentDB documentFileNameTermsDB(m_dbis.docFilenameTermsDbi, m_txn);
+    DocumentTimeDB docTimeDB(m_dbis.docTimeDbi, m_txn);
+    IdFilenameDB idFilenameDB(m_dbis.idFilenameDbi, m_txn);
+    IdTreeDB idTreeDB(m_dbis.idTreeDbi, m_txn);
+    DocumentUrlDB docUrlDB(m_dbis.idTreeDbi, m_dbis.idFilenameDbi, m_txn);
+
+    //
+    // Gather one removal set per term. The ids are visited in order,
+    // so every set is sorted.
+    //
+    QHash<QByteArray, QVector<quint64>> removals;
+    QVector<QPair<quint32, quint64>> mtimes;
+    mtimes.reserve(ids.size());
+    m_documentsChanged = true;
+
+    for (quint64 id : ids) {
+        for (DocumentDB* db : {&documentTermsDB, &documentXattrTermsDB, &documentFileNameTermsDB}) {
+            const QVector<QByteArray> terms = db->get(id);
+            for (const QByteArray& term : terms) {
+                QVector<quint64>& set = removals[term];
+                if (set.isEmpty() || set.last() != id) {
+                    set.append(id);
+                }
+            }
+        }
+
+        mtimes.append(qMakePair(docTimeDB.get(id).mTime, id));
+    }
+
+    m_stats.add(CommitStats::DocumentTime, timer.nsecsElapsed() / 1000);
+
+    PrefixUpdater prefixUpdater(m_dbis, m_txn);
+
+    //
+    // Apply the sets, walking the terms in key order
+    //
+    {
+        qint64 postingNsecs = 0;
+        qint64 positionNsecs = 0;
+        timer.restart();
+
+        TermCursor postingCursor(m_dbis.postingDbi, m_txn);
+        TermCursor positionCursor(m_dbis.positionDBi, m_txn);
+        PostingCodec postingCodec;
+        PositionCodec positionCodec;
+
+        std::unique_ptr<PostingDeltaDB> deltaDb;
+        if (m_dbis.postingDeltaDbi) {
+            deltaDb.reset(new PostingDeltaDB(m_dbis.postingDeltaDbi, m_txn));
+            if (deltaDb->size() == 0) {
+                deltaDb.reset();
+            }
+        }
+
+        QVector<QByteArray> terms = removals.keys().toVector();
+        std::sort(terms.begin(), terms.end());
+
+        for (const QByteArray& term : qAsConst(terms)) {
+            const QVector<quint64>& set = removals[term];
+            m_changedTerms.insert(term);
+
+            const qint64 termStart = timer.nsecsElapsed();
+            const QByteArray stored = postingCursor.seek(term);
+            m_stats.add(CommitStats::PostingBytesRead, stored.size());
+
+            PostingList list = postingCodec.decode(stored);
+            QVector<PostingDeltaDB::Delta> deltas;
+            if (deltaDb) {
+                deltas = deltaDb->get(term);
+                for (const PostingDeltaDB::Delta& delta : qAsConst(deltas)) {
+                    PostingDeltaDB::apply(list, delta);
+                }
+            }
+
+            const bool hadIds = !list.isEmpty();
+            removeSortedIds(list, set, [](quint64 id) { return id; });
+            if (!list.isEmpty()) {
+                const QByteArray encoded = postingCodec.encode(list);
+                postingCursor.put(encoded);
+                m_stats.add(CommitStats::PostingBytesWritten, encoded.size());
+            } else {
+                postingCursor.del();
+            }
+
+            if (m_dbis.prefixDbi) {
+                PostingDeltaDB::Delta delta;
+                delta.removed = set;
+                prefixUpdater.update(term, delta);
+                if (hadIds && list.isEmpty()) {
+                    prefixUpdater.termDeleted(term);
+                }
+            }
+            if (!deltas.isEmpty()) {
+                deltaDb->del(term);
+            }
+
+            const qint64 positionStart = timer.nsecsElapsed();
+            postingNsecs += positionStart - termStart;
+
+            // The positions of the deltas just folded have to be kept
+            const bool deltaPositions = hasPositions(deltas);
+            const QByteArray positions = positionCursor.seek(term);
+            m_stats.add(CommitStats::PositionBytesRead, positions.size());
+            if (!positions.isEmpty() || deltaPositions) {
+                QVector<PositionInfo> positionList = positionCodec.decode(positions);
+                for (const PostingDeltaDB::Delta& delta : qAsConst(deltas)) {
+                    PostingDeltaDB::applyPositions(positionList, delta);
+                }
+                const int size = positionList.size();
+                removeSortedIds(positionList, set, [](const PositionInfo& info) { return info.docId; });
+                if (positionList.isEmpty()) {
+                    positionCursor.del();
+                } else if (positionList.size() != size || deltaPositions) {
+                    const QByteArray encoded = positionCodec.encode(positionList);
+                    positionCursor.put(encoded);
+                    m_stats.add(CommitStats::PositionBytesWritten, encoded.size());
+                }
+            }
+            positionNsecs += timer.nsecsElapsed() - positionStart;
+        }
+
+        m_stats.add(CommitStats::Terms, terms.size());
+        m_stats.add(CommitStats::PostingTime, postingNsecs / 1000);
+        m_stats.add(CommitStats::PositionTime, positionNsecs / 1000);
+    }
+
+    timer.restart();
+
+    //
+    // Delete the per document records
+    //
+    deleteSortedIds(m_txn, m_dbis.docTermsDbi, ids);
+    deleteSortedIds(m_txn, m_dbis.docXattrTermsDbi, ids);
+    deleteSortedIds(m_txn, m_dbis.docFilenameTermsDbi, ids);
+    deleteSortedIds(m_txn, m_dbis.docTimeDbi, ids);
+    deleteSortedIds(m_txn, m_dbis.docDataDbi, ids);
+    deleteSortedIds(m_txn, m_dbis.contentIndexingDbi, ids);
+    deleteSortedIds(m_txn, m_dbis.failedIdDbi, ids);
+
+    std::sort(mtimes.begin(), mtimes.end());
+    {
+        MTimeDB mtimeDB(m_dbis.mtimeDbi, m_txn);
+        for (const auto& mtime : qAsConst(mtimes)) {
+            mtimeDB.del(mtime.first, mtime.second);
+        }
+    }
+
+    //
+    // Unlink the subtrees from the folders which stay. The children of
+    // every removed folder are removed as well, so only the topmost
+    // removed documents are listed in a remaining folder.
+    //
+    QMap<quint64, QVector<quint64>> topDocuments;
+    for (quint64 id : ids) {
+        const IdFilenameDB::FilePath path = idFilenameDB.get(id);
+        if (path.name.isEmpty()) {
+            continue;
+        }
+        if (!std::binary_search(ids.cbegin(), ids.cend(), path.parentId)) {
+            topDocuments[path.parentId].append(id);
+        }
+    }
+
+    deleteSortedIds(m_txn, m_dbis.idTreeDbi, ids);
+
+    for (auto it = topDocuments.cbegin(); it != topDocuments.cend(); ++it) {
+        // All but one are taken out of the folder here. The last one goes
+        // through DocumentUrlDB, which also removes the folders left empty.
+        QVector<quint64> top = it.value();
+        const quint64 last = top.takeLast();
+        if (!top.isEmpty()) {
+            QVector<quint64> children = idTreeDB.get(it.key());
+            removeSortedIds(children, top, [](quint64 id) { return id; });
+            idTreeDB.put(it.key(), children);
+        }
+
+        docUrlDB.del(last, [&docTimeDB](quint64 id) {
+            return !docTimeDB.contains(id);
+        });
+    }
+
+    deleteSortedIds(m_txn, m_dbis.idFilenameDbi, ids);
+
+    m_stats.add(CommitStats::DocumentTime, timer.nsecsElapsed() / 1000);
+
+    // Only now are the documents gone, so their ids leave the prefixes
+    timer.restart();
+    prefixUpdater.apply();
+    m_stats.add(CommitStats::PostingTime, timer.nsecsElapsed() / 1000);
 }
 
 void WriteTransaction::replaceDocument(const Document& doc, DocumentOperations operations)
 {
+    QElapsedTimer timer;
+    timer.start();
+
     DocumentDB documentTermsDB(m_dbis.docTermsDbi, m_txn);
     DocumentDB documentXattrTermsDB(m_dbis.docXattrTermsDbi, m_txn);
     DocumentDB documentFileNameTermsDB(m_dbis.docFilenameTermsDbi, m_txn);
@@ -244,6 +581,7 @@ void WriteTransaction::replaceDocument(const Document& doc, DocumentOperations o
         if (info.mTime != doc.m_mTime) {
             mtimeDB.del(info.mTime, id);
             mtimeDB.put(doc.m_mTime, id);
+            m_documentsChanged = true;
         }
 
         info.mTime = doc.m_mTime;
@@ -263,79 +601,519 @@ void WriteTransaction::replaceDocument(const Document& doc, DocumentOperations o
         docUrlDB.replace(id, doc.url(), [&docTimeDB](quint64 id) {
             return !docTimeDB.contains(id);
         });;
+        m_documentsChanged = true;
     }
+
+    m_stats.add(CommitStats::DocumentTime, timer.nsecsElapsed() / 1000);
+    flushIfOverBudget();
 }
 
 QVector< QByteArray > WriteTransaction::replaceTerms(quint64 id, const QVector<QByteArray>& prevTerms,
                                                      const QMap<QByteArray, Document::TermData>& terms)
 {
-    m_pendingOperations.reserve(m_pendingOperations.size() + prevTerms.size());
-    for (const QByteArray& term : prevTerms) {
-        Operation op;
-        op.type = RemoveId;
-        op.data.docId = id;
+    QVector<QByteArray> sortedPrevTerms = prevTerms;
+    if (!std::is_sorted(sortedPrevTerms.cbegin(), sortedPrevTerms.cend())) {
+        std::sort(sortedPrevTerms.begin(), sortedPrevTerms.end());
+    }
+
+    QVector<QByteArray> termList;
+    termList.reserve(terms.size());
+
+    // Only the terms which come or go change a posting list. The terms
+    // the document keeps merely get their positions replaced, which is a
+    // no-op on commit when they are the same.
+    auto prevIt = sortedPrevTerms.cbegin();
+    const auto prevEnd = sortedPrevTerms.cend();
+    for (auto it = terms.cbegin(); it != terms.cend(); ++it) {
+        const QByteArray& term = it.key();
+        while (prevIt != prevEnd && *prevIt < term) {
+            m_pendingOperations.remove(*prevIt++, id);
+        }
+
+        termList.append(term);
+        if (prevIt != prevEnd && *prevIt == term) {
+            m_pendingOperations.replacePositions(term, id, it.value().positions);
+            ++prevIt;
+        } else {
+            m_pendingOperations.add(term, id, it.value().positions);
+        }
+    }
+    while (prevIt != prevEnd) {
+        m_pendingOperations.remove(*prevIt++, id);
+    }
+
+    return termList;
+}
+
+namespace {
+
+// Changes to the lists of terms in at least this many documents are written
+// as deltas,
+const int deltaMinListSize = 1024;
+// as long as they touch at most this fraction of the list,
+const int deltaMaxChangeRatio = 16;
+// and the term does not already have this many deltas.
+const int deltaMaxCount = 32;
+
+// The number of transactions the ChangeLogDB goes back
+const quint64 changeLogSize = 64;
+
+/*
+ * The net effect of all the pending operations of one term on one document
+ */
+struct TermChange {
+    quint64 id;
+    // The posting list is changed for the id
+    bool touchesPosting;
+    // The id ends up in the posting list
+    bool present;
+    // The stored positions of the id are removed
+    bool dropPositions;
+    // The positions below are stored for the id
+    bool hasPositions;
+    const uint* positions;
+    int positionCount;
+};
+
+/*
+ * Folds the operations, which are in the order they were queued, into one
+ * change per document. The result is sorted by document id.
+ */
+QVector<TermChange> collapseOperations(QVector<PendingTermOperations::Operation> operations)
+{
+    std::stable_sort(operations.begin(), operations.end(),
+                     [](const PendingTermOperations::Operation& a, const PendingTermOperations::Operation& b) {
+        return a.docId < b.docId;
+    });
+
+    QVector<TermChange> changes;
+    changes.reserve(operations.size());
+    for (const PendingTermOperations::Operation& op : qAsConst(operations)) {
+        if (changes.isEmpty() || changes.last().id != op.docId) {
+            changes.append({op.docId, false, false, false, false, nullptr, 0});
+        }
+
+        TermChange& change = changes.last();
+        if (op.type == PendingTermOperations::AddId) {
+            change.touchesPosting = true;
+            change.present = true;
+            // Like an insert into the position list, the first positions win
+            if (op.positionCount && !change.hasPositions) {
+                change.hasPositions = true;
+                change.positions = op.positions;
+                change.positionCount = op.positionCount;
+            }
+        } else if (op.type == PendingTermOperations::ReplacePositions) {
+            change.dropPositions = true;
+            change.hasPositions = op.positionCount > 0;
+            change.positions = op.positions;
+            change.positionCount = op.positionCount;
+        } else {
+            change.touchesPosting = true;
+            change.present = false;
+            change.dropPositions = true;
+            change.hasPositions = false;
+            change.positions = nullptr;
+            change.positionCount = 0;
+        }
+    }
+
+    return changes;
+}
+
+PostingList mergePostings(const PostingList& list, const QVector<TermChange>& changes)
+{
+    PostingList result;
+    result.reserve(list.size() + changes.size());
+
+    auto it = list.cbegin();
+    const auto end = list.cend();
+    for (const TermChange& change : changes) {
+        if (!change.touchesPosting) {
+            continue;
+        }
+        while (it != end && *it < change.id) {
+            result.append(*it++);
+        }
+        if (it != end && *it == change.id) {
+            ++it;
+        }
+        if (change.present) {
+            result.append(change.id);
+        }
+    }
+    while (it != end) {
+        result.append(*it++);
+    }
+
+    return result;
+}
+
+/*
+ * The ids the changes add to and remove from the posting list
+ */
+PostingDeltaDB::Delta postingDelta(const QVector<TermChange>& changes)
+{
+    PostingDeltaDB::Delta delta;
+    for (const TermChange& change : changes) {
+        if (!change.touchesPosting) {
+            continue;
+        }
+        if (change.present) {
+            delta.added.append(change.id);
+        } else {
+            delta.removed.append(change.id);
+        }
+    }
+    return delta;
+}
 
-        m_pendingOperations[term].append(op);
+/*
+ * The positions the changes replace, a removed id is listed without any.
+ * Unlike mergePositions, new positions always replace the stored ones, as
+ * those are not known.
+ */
+QVector<PositionInfo> positionDelta(const QVector<TermChange>& changes)
+{
+    QVector<PositionInfo> positions;
+    for (const TermChange& change : changes) {
+        if (!change.dropPositions && !change.hasPositions) {
+            continue;
+        }
+        PositionInfo info(change.id);
+        if (change.hasPositions) {
+            info.positions.resize(change.positionCount);
+            std::copy(change.positions, change.positions + change.positionCount, info.positions.begin());
+        }
+        positions.append(info);
     }
+    return positions;
+}
+
+/*
+ * Drops the entries of the sorted \p positions which would not change the
+ * sorted \p list
+ */
+void dropUnchangedPositions(QVector<PositionInfo>& positions, const QVector<PositionInfo>& list)
+{
+    auto it = list.cbegin();
+    const auto end = list.cend();
+    auto last = std::remove_if(positions.begin(), positions.end(), [&](const PositionInfo& info) {
+        while (it != end && it->docId < info.docId) {
+            ++it;
+        }
+        if (it != end && it->docId == info.docId) {
+            return it->positions == info.positions;
+        }
+        return info.positions.isEmpty();
+    });
+    positions.erase(last, positions.end());
+}
+
+/*
+ * Merges the position changes into \p list. \p changed is set if the
+ * result differs from \p list.
+ */
+QVector<PositionInfo> mergePositions(const QVector<PositionInfo>& list, const QVector<TermChange>& changes,
+                                     bool* changed)
+{
+    QVector<PositionInfo> result;
+    result.reserve(list.size() + changes.size());
+    *changed = false;
+
+    auto it = list.cbegin();
+    const auto end = list.cend();
+    for (const TermChange& change : changes) {
+        if (!change.dropPositions && !change.hasPositions) {
+            continue;
+        }
+        while (it != end && it->docId < change.id) {
+            result.append(*it++);
+        }
+
+        if (it != end && it->docId == change.id) {
+            if (!change.dropPositions) {
+                // Existing positions are only replaced after a removal
+                result.append(*it++);
+                continue;
+            }
+            if (change.hasPositions && it->positions.size() == change.positionCount
+                && std::equal(change.positions, change.positions + change.positionCount, it->positions.cbegin())) {
+                result.append(*it++);
+                continue;
+            }
+            *changed = true;
+            ++it;
+        } else if (change.hasPositions) {
+            *changed = true;
+        }
+        if (change.hasPositions) {
+            PositionInfo info(change.id);
+            info.positions.resize(change.positionCount);
+            std::copy(change.positions, change.positions + change.positionCount, info.positions.begin());
+            result.append(info);
+        }
+    }
+    while (it != end) {
+        result.append(*it++);
+    }
+
+    return result;
+}
 
-    return addTerms(id, terms);
 }
 
 void WriteTransaction::commit()
 {
-    PostingDB postingDB(m_dbis.postingDbi, m_txn);
-    PositionDB positionDB(m_dbis.positionDBi, m_txn);
+    TermCursor postingCursor(m_dbis.postingDbi, m_txn);
+    TermCursor positionCursor(m_dbis.positionDBi, m_txn);
+    PostingCodec postingCodec;
+    PositionCodec positionCodec;
+
+    std::unique_ptr<PostingDeltaDB> deltaDb;
+    bool hasDeltas = false;
+    if (m_dbis.postingDeltaDbi) {
+        deltaDb.reset(new PostingDeltaDB(m_dbis.postingDeltaDbi, m_txn));
+        hasDeltas = deltaDb->size() > 0;
+    }
+
+    PrefixUpdater prefixUpdater(m_dbis, m_txn);
 
-    QHashIterator<QByteArray, QVector<Operation> > iter(m_pendingOperations);
-    while (iter.hasNext()) {
-        iter.next();
+    QElapsedTimer timer;
+    timer.start();
+    qint64 postingNsecs = 0;
+    qint64 positionNsecs = 0;
 
-        const QByteArray& term = iter.key();
-        const QVector<Operation> operations = iter.value();
+    // Walk the terms in key order, so both cursors only ever move forward
+    // and the pages are touched sequentially
+    const QVector<int> terms = m_pendingOperations.sortedTerms();
+    for (int slot : terms) {
+        const qint64 termStart = timer.nsecsElapsed();
+        const QByteArray term = m_pendingOperations.term(slot);
+        const QVector<TermChange> changes = collapseOperations(m_pendingOperations.operations(slot));
 
-        PostingList list = postingDB.get(term);
+        const int postingChanges = std::count_if(changes.cbegin(), changes.cend(), [](const TermChange& change) {
+            return change.touchesPosting;
+        });
+        const bool touchesPositions = std::any_of(changes.cbegin(), changes.cend(), [](const TermChange& change) {
+            return change.dropPositions || change.hasPositions;
+        });
 
-        bool fetchedPositionList = false;
-        QVector<PositionInfo> positionList;
+        const QByteArray stored = postingCursor.seek(term);
+        m_stats.add(CommitStats::PostingBytesRead, stored.size());
+        const int storedSize = stored.size() / sizeof(quint64);
+        const int deltaCount = hasDeltas ? deltaDb->count(term) : 0;
 
-        for (const Operation& op : operations) {
-            quint64 id = op.data.docId;
+        // A small change to the lists of a common term is only recorded as
+        // a delta, positions included
+        if (deltaDb && storedSize >= deltaMinListSize && changes.size() * deltaMaxChangeRatio <= storedSize
+            && deltaCount < deltaMaxCount) {
+            PostingDeltaDB::Delta delta = postingDelta(changes);
+            delta.positions = positionDelta(changes);
 
-            if (op.type == AddId) {
-                sortedIdInsert(list, id);
+            const qint64 positionStart = timer.nsecsElapsed();
+            postingNsecs += positionStart - termStart;
 
-                if (!op.data.positions.isEmpty()) {
-                    if (!fetchedPositionList) {
-                        positionList = positionDB.get(term);
-                        fetchedPositionList = true;
+            // Re-extracted documents mostly come with the same positions,
+            // which are left out
+            if (!delta.positions.isEmpty()) {
+                const QByteArray storedPositions = positionCursor.seek(term);
+                m_stats.add(CommitStats::PositionBytesRead, storedPositions.size());
+
+                QVector<PositionInfo> list = positionCodec.decode(storedPositions);
+                if (deltaCount > 0) {
+                    const QVector<PostingDeltaDB::Delta> deltas = deltaDb->get(term);
+                    for (const PostingDeltaDB::Delta& prev : deltas) {
+                        PostingDeltaDB::applyPositions(list, prev);
                     }
-                    sortedIdInsert(positionList, op.data);
                 }
+                dropUnchangedPositions(delta.positions, list);
+                positionNsecs += timer.nsecsElapsed() - positionStart;
+            }
+
+            if (!delta.added.isEmpty() || !delta.removed.isEmpty() || !delta.positions.isEmpty()) {
+                deltaDb->append(term, delta);
+                hasDeltas = true;
+                m_changedTerms.insert(term);
+                m_stats.add(CommitStats::PostingBytesWritten,
+                            (delta.added.size() + delta.removed.size()) * sizeof(quint64));
+                prefixUpdater.update(term, delta);
             }
-            else {
-                sortedIdRemove(list, id);
-                if (!fetchedPositionList) {
-                    positionList = positionDB.get(term);
-                    fetchedPositionList = true;
+            continue;
+        }
+
+        QVector<PostingDeltaDB::Delta> deltas;
+        if (deltaCount > 0) {
+            deltas = deltaDb->get(term);
+        }
+
+        // Terms the documents keep only have their positions replaced
+        if (postingChanges > 0 || !deltas.isEmpty()) {
+            PostingList list = postingCodec.decode(stored);
+            for (const PostingDeltaDB::Delta& delta : qAsConst(deltas)) {
+                PostingDeltaDB::apply(list, delta);
+            }
+
+            const PostingList merged = mergePostings(list, changes);
+            if (!merged.isEmpty()) {
+                const QByteArray encoded = postingCodec.encode(merged);
+                postingCursor.put(encoded);
+                m_stats.add(CommitStats::PostingBytesWritten, encoded.size());
+            } else {
+                postingCursor.del();
+            }
+
+            if (!deltas.isEmpty()) {
+                deltaDb->del(term);
+            }
+            if (postingChanges > 0) {
+                m_changedTerms.insert(term);
+            }
+
+            if (m_dbis.prefixDbi) {
+                prefixUpdater.update(term, postingDelta(changes));
+                if (list.isEmpty() && !merged.isEmpty()) {
+                    prefixUpdater.termCreated(term);
+                } else if (!list.isEmpty() && merged.isEmpty()) {
+                    prefixUpdater.termDeleted(term);
                 }
-                sortedIdRemove(positionList, PositionInfo(id));
             }
         }
 
+        const qint64 positionStart = timer.nsecsElapsed();
+        postingNsecs += positionStart - termStart;
+
+        // The positions of the folded deltas are folded along
+        const bool deltaPositions = hasPositions(deltas);
+        if (touchesPositions || deltaPositions) {
+            const QByteArray storedPositions = positionCursor.seek(term);
+            m_stats.add(CommitStats::PositionBytesRead, storedPositions.size());
+
+            QVector<PositionInfo> list = positionCodec.decode(storedPositions);
+            for (const PostingDeltaDB::Delta& delta : qAsConst(deltas)) {
+                PostingDeltaDB::applyPositions(list, delta);
+            }
+
+            bool changed = false;
+            const QVector<PositionInfo> positionList = mergePositions(list, changes, &changed);
+            if (changed) {
+                m_changedTerms.insert(term);
+            }
+            // Re-extracted documents mostly come with the same positions
+            if (changed || deltaPositions) {
+                if (!positionList.isEmpty()) {
+                    const QByteArray encoded = positionCodec.encode(positionList);
+                    positionCursor.put(encoded);
+                    m_stats.add(CommitStats::PositionBytesWritten, encoded.size());
+                } else {
+                    positionCursor.del();
+                }
+            }
+            positionNsecs += timer.nsecsElapsed() - positionStart;
+        }
+    }
+
+    m_stats.add(CommitStats::Terms, terms.size());
+    m_stats.add(CommitStats::PostingTime, postingNsecs / 1000);
+    m_stats.add(CommitStats::PositionTime, positionNsecs / 1000);
+
+    // The terms of the documents are already up to date
+    timer.restart();
+    prefixUpdater.apply();
+    m_stats.add(CommitStats::PostingTime, timer.nsecsElapsed() / 1000);
+
+    m_flushedBytes += m_pendingOperations.memoryUsage();
+    m_pendingOperations.clear();
+
+    // Also written when nothing changed, a transaction without a record
+    // could have changed anything
+    if (m_dbis.changeLogDbi) {
+        writeChangeLog();
+    }
+}
+
+void WriteTransaction::writeChangeLog()
+{
+    ChangeLogDB::Changes changes;
+    changes.terms.reserve(m_changedTerms.size());
+    for (const QByteArray& term : qAsConst(m_changedTerms)) {
+        changes.terms.append(term);
+    }
+    std::sort(changes.terms.begin(), changes.terms.end());
+    changes.documents = m_documentsChanged;
+
+    const quint64 txnId = mdb_txn_id(m_txn);
+    ChangeLogDB changeLogDb(m_dbis.changeLogDbi, m_txn);
+    changeLogDb.put(txnId, changes);
+    if (txnId > changeLogSize) {
+        changeLogDb.prune(txnId - changeLogSize);
+    }
+}
+
+bool WriteTransaction::compactPostingDeltas(int maxTerms)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    bool moreRemaining = false;
+    if (m_dbis.prefixDbi) {
+        PrefixDB prefixDb(m_dbis.prefixDbi, m_dbis.prefixDeltaDbi, m_txn);
+        moreRemaining = prefixDb.compactDeltas(maxTerms);
+    }
+
+    if (!m_dbis.postingDeltaDbi) {
+        m_stats.add(CommitStats::PostingTime, timer.nsecsElapsed() / 1000);
+        return moreRemaining;
+    }
+
+    PostingDeltaDB deltaDb(m_dbis.postingDeltaDbi, m_txn);
+    const QVector<QByteArray> terms = deltaDb.fetchTerms(maxTerms);
+
+    TermCursor postingCursor(m_dbis.postingDbi, m_txn);
+    TermCursor positionCursor(m_dbis.positionDBi, m_txn);
+    PostingCodec postingCodec;
+    PositionCodec positionCodec;
+
+    for (const QByteArray& term : terms) {
+        const QByteArray stored = postingCursor.seek(term);
+        m_stats.add(CommitStats::PostingBytesRead, stored.size());
+
+        PostingList list = postingCodec.decode(stored);
+        const QVector<PostingDeltaDB::Delta> deltas = deltaDb.get(term);
+        for (const PostingDeltaDB::Delta& delta : deltas) {
+            PostingDeltaDB::apply(list, delta);
+        }
+
         if (!list.isEmpty()) {
-            postingDB.put(term, list);
+            const QByteArray encoded = postingCodec.encode(list);
+            postingCursor.put(encoded);
+            m_stats.add(CommitStats::PostingBytesWritten, encoded.size());
         } else {
-            postingDB.del(term);
+            postingCursor.del();
         }
 
-        if (fetchedPositionList) {
+        if (hasPositions(deltas)) {
+            const QByteArray positions = positionCursor.seek(term);
+            m_stats.add(CommitStats::PositionBytesRead, positions.size());
+
+            QVector<PositionInfo> positionList = positionCodec.decode(positions);
+            for (const PostingDeltaDB::Delta& delta : deltas) {
+                PostingDeltaDB::applyPositions(positionList, delta);
+            }
+
             if (!positionList.isEmpty()) {
-                positionDB.put(term, positionList);
+                const QByteArray encoded = positionCodec.encode(positionList);
+                positionCursor.put(encoded);
+                m_stats.add(CommitStats::PositionBytesWritten, encoded.size());
             } else {
-                positionDB.del(term);
+                positionCursor.del();
             }
         }
+        deltaDb.del(term);
     }
 
-    m_pendingOperations.clear();
+    m_stats.add(CommitStats::Terms, terms.size());
+    m_stats.add(CommitStats::PostingTime, timer.nsecsElapsed() / 1000);
+
+    return moreRemaining || deltaDb.size() > 0;
 }
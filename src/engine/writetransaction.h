@@ -26,6 +26,9 @@
 #include "documentoperations.h"
 #include "databasedbis.h"
 #include "documenturldb.h"
+#include "pendingtermoperations.h"
+#include "commitstats.h"
+#include <QSet>
 #include <functional>
 
 namespace Baloo {
@@ -60,20 +63,59 @@ public:
     bool removeRecursively(quint64 parentId, std::function<bool(quint64)> shouldDelete);
 
     void replaceDocument(const Document& doc, DocumentOperations operations);
+
+    /**
+     * Writes all the pending term operations into the LMDB transaction.
+     * The transaction itself is not committed.
+     */
     void commit();
 
+    /**
+     * Folds the posting deltas of up to \p maxTerms terms into the PostingDB,
+     * and those of up to \p maxTerms prefixes into the PrefixDB.
+     * Returns true if there are still deltas left.
+     */
+    bool compactPostingDeltas(int maxTerms);
+
     bool hasChanges() const {
         return !m_pendingOperations.isEmpty();
     }
-    enum OperationType {
-        AddId,
-        RemoveId
-    };
-    struct Operation {
-        OperationType type;
-        PositionInfo data;
-    };
 
+    /**
+     * Sets the approximate amount of memory in bytes the pending term
+     * operations may use. When a document operation takes them over the
+     * budget, they are written into the LMDB transaction right away
+     * instead of waiting for commit. 0, the default, means no limit.
+     */
+    void setMemoryBudget(qint64 bytes) {
+        m_memoryBudget = bytes;
+    }
+    qint64 memoryBudget() const {
+        return m_memoryBudget;
+    }
+
+    /**
+     * The approximate memory used by the pending term operations
+     */
+    qint64 pendingBytes() const {
+        return m_pendingOperations.memoryUsage();
+    }
+
+    /**
+     * The approximate amount of term data queued since the transaction
+     * started, including what has already been written into it.
+     */
+    qint64 uncommittedBytes() const {
+        return m_flushedBytes + m_pendingOperations.memoryUsage();
+    }
+
+    /**
+     * What has been written into the LMDB transaction so far,
+     * and how long it took
+     */
+    const CommitStats& stats() const {
+        return m_stats;
+    }
 private:
     /*
      * Adds an 'addId' operation to the pending queue for each term.
@@ -84,13 +126,32 @@ private:
                                      const QMap<QByteArray, Document::TermData>& terms);
     void removeTerms(quint64 id, const QVector<QByteArray>& terms);
 
-    QHash<QByteArray, QVector<Operation> > m_pendingOperations;
+    /*
+     * Removes the documents \p ids, which are listed with every folder
+     * after its children. Instead of going through the pending operations,
+     * the ids are taken out of each posting list with a single update.
+     */
+    void removeDocuments(const QVector<quint64>& ids);
+    void removeDocumentBatch(const QVector<quint64>& sortedIds);
+
+    void flushIfOverBudget();
+
+    /*
+     * Records what the transaction has changed so far in the ChangeLogDB
+     */
+    void writeChangeLog();
+
+    PendingTermOperations m_pendingOperations;
+    qint64 m_flushedBytes = 0;
+    qint64 m_memoryBudget = 0;
+    CommitStats m_stats;
+
+    QSet<QByteArray> m_changedTerms;
+    bool m_documentsChanged = false;
 
     MDB_txn* m_txn;
     DatabaseDbis m_dbis;
 };
 }
 
-Q_DECLARE_TYPEINFO(Baloo::WriteTransaction::Operation, Q_MOVABLE_TYPE);
-
 #endif // BALOO_WRITETRANSACTION_H
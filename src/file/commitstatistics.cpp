@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "commitstatistics.h"
+
+#include <QMutexLocker>
+
+using namespace Baloo;
+
+CommitStatistics::CommitStatistics()
+    : m_windowSize(256)
+{
+}
+
+void CommitStatistics::setWindowSize(int commits)
+{
+    QMutexLocker lock(&m_mutex);
+    m_windowSize = commits;
+}
+
+void CommitStatistics::record(const QString& source, const CommitStats& stats)
+{
+    QMutexLocker lock(&m_mutex);
+    QList<CommitStats>& commits = m_commits[source];
+    commits.append(stats);
+    while (commits.size() > m_windowSize) {
+        commits.removeFirst();
+    }
+}
+
+int CommitStatistics::bucket(qint64 value)
+{
+    int bucket = 0;
+    while (value > 0) {
+        value >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+QVariantMap CommitStatistics::histograms() const
+{
+    QMutexLocker lock(&m_mutex);
+
+    QVariantMap map;
+    for (auto it = m_commits.cbegin(); it != m_commits.cend(); ++it) {
+        for (int m = 0; m < CommitStats::MetricCount; m++) {
+            const auto metric = static_cast<CommitStats::Metric>(m);
+
+            QList<uint> counts;
+            for (const CommitStats& stats : it.value()) {
+                const int b = bucket(stats.value(metric));
+                while (counts.size() <= b) {
+                    counts.append(0);
+                }
+                counts[b]++;
+            }
+
+            map.insert(it.key() + QLatin1Char('/') + CommitStats::metricName(metric), QVariant::fromValue(counts));
+        }
+    }
+    return map;
+}
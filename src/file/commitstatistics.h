@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef BALOO_COMMITSTATISTICS_H
+#define BALOO_COMMITSTATISTICS_H
+
+#include "commitstats.h"
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QVariantMap>
+
+namespace Baloo {
+
+/**
+ * Keeps the statistics of the most recent commits of each writer,
+ * so that slow commits can be told apart from the usual ones.
+ *
+ * The statistics are recorded from the writer threads.
+ */
+class CommitStatistics
+{
+public:
+    CommitStatistics();
+
+    void record(const QString& source, const CommitStats& stats);
+
+    /**
+     * The commits kept for every source
+     */
+    void setWindowSize(int commits);
+
+    /**
+     * Histograms of the recent commits. The keys are "source/metric", and
+     * every value is a list of counts, where bucket 0 holds the zeros and
+     * bucket i the values in [2^(i-1), 2^i).
+     */
+    QVariantMap histograms() const;
+
+    static int bucket(qint64 value);
+
+private:
+    mutable QMutex m_mutex;
+    QHash<QString, QList<CommitStats>> m_commits;
+    int m_windowSize;
+};
+}
+
+#endif // BALOO_COMMITSTATISTICS_H
@@ -51,6 +51,7 @@ App::App(QObject* parent)
     , m_inputStream(&m_input)
     , m_outputStream(stdout)
     , m_tr(nullptr)
+    , m_overlay(fileIndexDbPath())
 {
     m_input.open(STDIN_FILENO, QIODevice::ReadOnly | QIODevice::Unbuffered );
     m_inputStream.setByteOrder(QDataStream::BigEndian);
@@ -117,8 +118,10 @@ void App::processNextFile()
 
     } else {
         m_tr->commit();
+        const CommitStats stats = m_tr->commitStats();
         delete m_tr;
         m_tr = nullptr;
+        m_overlay.clear();
 
         /*
         * TODO we're already sending out each file as we start we can simply send out a done
@@ -139,6 +142,7 @@ void App::processNextFile()
 
         // Enable the SocketNotifier for the next batch
         m_notifyNewData.setEnabled(true);
+        m_outputStream << "C " << stats.toByteArray() << endl;
         m_outputStream << "B" << endl;
     }
 }
@@ -205,4 +209,5 @@ void App::index(Transaction* tr, const QString& url, quint64 id)
         tr->replaceDocument(result.document(), DocumentTerms | DocumentData);
     }
     tr->removePhaseOne(doc.id());
+    m_overlay.add(result.document());
 }
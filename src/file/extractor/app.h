@@ -35,6 +35,7 @@
 #include <KFileMetaData/ExtractorCollection>
 
 #include "database.h"
+#include "overlayindex.h"
 #include "../fileindexerconfig.h"
 #include "idlestatemonitor.h"
 
@@ -72,6 +73,9 @@ private:
     QVector<quint64> m_ids;
     QStringList m_updatedFiles;
     Transaction* m_tr;
+
+    // Lets queries find the files of the batch before it is committed
+    OverlayIndex m_overlay;
 };
 
 }
@@ -86,6 +86,10 @@ void ExtractorProcess::slotIndexingFile()
             Q_EMIT finishedIndexingFile(arg);
             break;
 
+        case 'C':
+            Q_EMIT committed(arg.toLatin1());
+            break;
+
         case 'B':
             Q_EMIT done();
             break;
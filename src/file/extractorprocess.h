@@ -43,6 +43,11 @@ Q_SIGNALS:
     void done();
     void failed();
 
+    /**
+     * The extractor committed a batch, see CommitStats::toByteArray
+     */
+    void committed(const QByteArray& stats);
+
 private Q_SLOTS:
     void slotIndexingFile();
 
@@ -20,6 +20,7 @@
 #include "filecontentindexer.h"
 #include "filecontentindexerprovider.h"
 #include "extractorprocess.h"
+#include "commitstatistics.h"
 
 #include <QEventLoop>
 #include <QElapsedTimer>
@@ -51,6 +52,11 @@ void FileContentIndexer::run()
     ExtractorProcess process;
     connect(&process, &ExtractorProcess::startedIndexingFile, this, &FileContentIndexer::slotStartedIndexingFile);
     connect(&process, &ExtractorProcess::finishedIndexingFile, this, &FileContentIndexer::slotFinishedIndexingFile);
+    connect(&process, &ExtractorProcess::committed, &process, [this](const QByteArray& stats) {
+        if (m_commitStatistics) {
+            m_commitStatistics->record(QStringLiteral("extractor"), CommitStats::fromByteArray(stats));
+        }
+    });
 
     m_stop.store(false);
     auto batchSize = m_batchSize;
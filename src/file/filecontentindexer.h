@@ -32,6 +32,7 @@
 namespace Baloo {
 
 class FileContentIndexerProvider;
+class CommitStatistics;
 
 class FileContentIndexer : public QObject, public QRunnable
 {
@@ -50,6 +51,13 @@ public:
         m_stop.store(true);
     }
 
+    /**
+     * Records the commits of the extractor in \p statistics
+     */
+    void setCommitStatistics(CommitStatistics* statistics) {
+        m_commitStatistics = statistics;
+    }
+
 public Q_SLOTS:
     Q_SCRIPTABLE void registerMonitor(const QDBusMessage& message);
     Q_SCRIPTABLE void unregisterMonitor(const QDBusMessage& message);
@@ -72,6 +80,7 @@ private:
     FileContentIndexerProvider* m_provider;
 
     QAtomicInt m_stop;
+    CommitStatistics* m_commitStatistics = nullptr;
 
     QString m_currentFile;
 
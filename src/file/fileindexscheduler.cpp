@@ -28,6 +28,9 @@
 #include "filecontentindexerprovider.h"
 #include "unindexedfileindexer.h"
 #include "indexcleaner.h"
+#include "postingdeltacompactor.h"
+#include "prefixindexbuilder.h"
+#include "indexwriter.h"
 
 #include "fileindexerconfig.h"
 
@@ -37,23 +40,38 @@
 
 using namespace Baloo;
 
-FileIndexScheduler::FileIndexScheduler(Database* db, FileIndexerConfig* config, QObject* parent)
+FileIndexScheduler::FileIndexScheduler(Database* db, IndexWriter* writer, FileIndexerConfig* config, QObject* parent)
     : QObject(parent)
     , m_db(db)
+    , m_indexWriter(writer)
     , m_config(config)
     , m_provider(db)
     , m_contentIndexer(nullptr)
     , m_indexerState(Idle)
     , m_timeEstimator(config, this)
+    , m_runningProducers(0)
     , m_checkUnindexedFiles(false)
     , m_checkStaleIndexEntries(false)
+    , m_compactPostingDeltas(true)
+    , m_buildPrefixes(true)
     , m_isGoingIdle(false)
     , m_isSuspended(false)
 {
     Q_ASSERT(db);
+    Q_ASSERT(writer);
     Q_ASSERT(config);
 
-    m_threadPool.setMaxThreadCount(1);
+    // One thread for each of the new, modified and xattr indexers
+    m_threadPool.setMaxThreadCount(3);
+
+    // The indexers wait for their own changes, but the writer also commits
+    // the moves, which may leave new deltas behind
+    connect(m_indexWriter, &IndexWriter::committed, this, [this] {
+        m_compactPostingDeltas = true;
+        if (isIndexerIdle()) {
+            QTimer::singleShot(0, this, &FileIndexScheduler::scheduleIndexing);
+        }
+    });
 
     connect(&m_powerMonitor, &PowerStateMonitor::powerManagementStatusChanged,
             this, &FileIndexScheduler::powerManagementStatusChanged);
@@ -64,6 +82,8 @@ FileIndexScheduler::FileIndexScheduler(Database* db, FileIndexerConfig* config,
 
     m_contentIndexer = new FileContentIndexer(m_config, &m_provider, this);
     m_contentIndexer->setAutoDelete(false);
+    m_contentIndexer->setCommitStatistics(&m_commitStatistics);
+    m_indexWriter->setCommitStatistics(&m_commitStatistics);
     connect(m_contentIndexer, &FileContentIndexer::done, this,
             &FileIndexScheduler::runnerFinished);
     connect(m_contentIndexer, &FileContentIndexer::newBatchTime, &m_timeEstimator,
@@ -104,35 +124,39 @@ void FileIndexScheduler::scheduleIndexing()
         return;
     }
 
-    if (!m_newFiles.isEmpty()) {
-        auto runnable = new NewFileIndexer(m_db, m_config, m_newFiles);
-        connect(runnable, &NewFileIndexer::done, this, &FileIndexScheduler::runnerFinished);
+    if (!m_newFiles.isEmpty() || !m_modifiedFiles.isEmpty() || !m_xattrFiles.isEmpty()) {
+        // None of these write to the database themselves, so they do
+        // not have to wait for each other
+        if (!m_xattrFiles.isEmpty()) {
+            auto runnable = new XAttrIndexer(m_indexWriter, m_config, m_xattrFiles);
+            connect(runnable, &XAttrIndexer::done, this, &FileIndexScheduler::producerFinished);
+
+            m_threadPool.start(runnable);
+            m_runningProducers++;
+            m_xattrFiles.clear();
+            m_indexerState = XAttrFiles;
+        }
 
-        m_threadPool.start(runnable);
-        m_newFiles.clear();
-        m_indexerState = NewFiles;
-        Q_EMIT stateChanged(m_indexerState);
-        return;
-    }
+        if (!m_modifiedFiles.isEmpty()) {
+            auto runnable = new ModifiedFileIndexer(m_db, m_indexWriter, m_config, m_modifiedFiles);
+            connect(runnable, &ModifiedFileIndexer::done, this, &FileIndexScheduler::producerFinished);
 
-    if (!m_modifiedFiles.isEmpty()) {
-        auto runnable = new ModifiedFileIndexer(m_db, m_config, m_modifiedFiles);
-        connect(runnable, &ModifiedFileIndexer::done, this, &FileIndexScheduler::runnerFinished);
+            m_threadPool.start(runnable);
+            m_runningProducers++;
+            m_modifiedFiles.clear();
+            m_indexerState = ModifiedFiles;
+        }
 
-        m_threadPool.start(runnable);
-        m_modifiedFiles.clear();
-        m_indexerState = ModifiedFiles;
-        Q_EMIT stateChanged(m_indexerState);
-        return;
-    }
+        if (!m_newFiles.isEmpty()) {
+            auto runnable = new NewFileIndexer(m_indexWriter, m_config, m_newFiles);
+            connect(runnable, &NewFileIndexer::done, this, &FileIndexScheduler::producerFinished);
 
-    if (!m_xattrFiles.isEmpty()) {
-        auto runnable = new XAttrIndexer(m_db, m_config, m_xattrFiles);
-        connect(runnable, &XAttrIndexer::done, this, &FileIndexScheduler::runnerFinished);
+            m_threadPool.start(runnable);
+            m_runningProducers++;
+            m_newFiles.clear();
+            m_indexerState = NewFiles;
+        }
 
-        m_threadPool.start(runnable);
-        m_xattrFiles.clear();
-        m_indexerState = XAttrFiles;
         Q_EMIT stateChanged(m_indexerState);
         return;
     }
@@ -149,7 +173,7 @@ void FileIndexScheduler::scheduleIndexing()
     // This has to be above content indexing, because there can be files that
     // should not be indexed in the DB (i.e. if config was changed)
     if (m_checkStaleIndexEntries) {
-        auto runnable = new IndexCleaner(m_db, m_config);
+        auto runnable = new IndexCleaner(m_db, m_indexWriter, m_config);
         connect(runnable, &IndexCleaner::done, this, &FileIndexScheduler::runnerFinished);
 
         m_threadPool.start(runnable);
@@ -177,6 +201,37 @@ void FileIndexScheduler::scheduleIndexing()
         return;
     }
 
+    // Fold the deltas of the small commits into the posting lists
+    if (m_compactPostingDeltas) {
+        auto runnable = new PostingDeltaCompactor(m_db, &m_commitStatistics);
+        connect(runnable, &PostingDeltaCompactor::done, this, [this](bool moreRemaining) {
+            m_compactPostingDeltas = moreRemaining;
+            runnerFinished();
+        });
+
+        m_threadPool.start(runnable);
+        m_compactPostingDeltas = false;
+        m_indexerState = PostingDeltaCompaction;
+        Q_EMIT stateChanged(m_indexerState);
+        return;
+    }
+
+    // Fill in the prefixes of a database created by an older version,
+    // until then they are expanded over the terms at query time
+    if (m_buildPrefixes) {
+        auto runnable = new PrefixIndexBuilder(m_db, &m_commitStatistics);
+        connect(runnable, &PrefixIndexBuilder::done, this, [this](bool moreRemaining) {
+            m_buildPrefixes = moreRemaining;
+            runnerFinished();
+        });
+
+        m_threadPool.start(runnable);
+        m_buildPrefixes = false;
+        m_indexerState = PrefixIndexBuild;
+        Q_EMIT stateChanged(m_indexerState);
+        return;
+    }
+
     if (m_indexerState != Idle) {
         m_indexerState = Idle;
         Q_EMIT stateChanged(m_indexerState);
@@ -256,6 +311,11 @@ void FileIndexScheduler::setSuspend(bool suspend)
     }
 }
 
+QVariantMap FileIndexScheduler::getCommitStatistics()
+{
+    return m_commitStatistics.histograms();
+}
+
 uint FileIndexScheduler::getRemainingTime()
 {
     if (m_indexerState != ContentIndexing) {
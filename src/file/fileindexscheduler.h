@@ -29,12 +29,14 @@
 #include "powerstatemonitor.h"
 #include "indexerstate.h"
 #include "timeestimator.h"
+#include "commitstatistics.h"
 
 namespace Baloo {
 
 class Database;
 class FileIndexerConfig;
 class FileContentIndexer;
+class IndexWriter;
 
 class FileIndexScheduler : public QObject
 {
@@ -43,7 +45,7 @@ class FileIndexScheduler : public QObject
 
     Q_PROPERTY(int state READ state NOTIFY stateChanged)
 public:
-    FileIndexScheduler(Database* db, FileIndexerConfig* config, QObject* parent = nullptr);
+    FileIndexScheduler(Database* db, IndexWriter* writer, FileIndexerConfig* config, QObject* parent = nullptr);
     ~FileIndexScheduler() override;
     int state() const { return m_indexerState; }
 
@@ -79,10 +81,24 @@ public Q_SLOTS:
     }
 
     void runnerFinished() {
+        // Anything but the compaction itself may have written new deltas
+        if (m_indexerState != PostingDeltaCompaction) {
+            m_compactPostingDeltas = true;
+        }
         m_isGoingIdle = true;
         QTimer::singleShot(0, this, &FileIndexScheduler::scheduleIndexing);
     }
 
+    /**
+     * The new, modified and xattr indexers run in parallel. The state
+     * moves on once the last of them is done.
+     */
+    void producerFinished() {
+        if (--m_runningProducers == 0) {
+            runnerFinished();
+        }
+    }
+
     void handleFileRemoved(const QString& file);
 
     void updateConfig();
@@ -97,6 +113,13 @@ public Q_SLOTS:
     Q_SCRIPTABLE void checkStaleIndexEntries();
     Q_SCRIPTABLE uint getBatchSize();
 
+    /**
+     * Histograms of the recent commits of the indexer, the content
+     * extractor, the compactor and the prefix builder, see
+     * CommitStatistics::histograms
+     */
+    Q_SCRIPTABLE QVariantMap getCommitStatistics();
+
 private Q_SLOTS:
     void powerManagementStatusChanged(bool isOnBattery);
 
@@ -109,6 +132,7 @@ private:
     }
 
     Database* m_db;
+    IndexWriter* m_indexWriter;
     FileIndexerConfig* m_config;
 
     QStringList m_newFiles;
@@ -124,9 +148,14 @@ private:
 
     IndexerState m_indexerState;
     TimeEstimator m_timeEstimator;
+    CommitStatistics m_commitStatistics;
+
+    int m_runningProducers;
 
     bool m_checkUnindexedFiles;
     bool m_checkStaleIndexEntries;
+    bool m_compactPostingDeltas;
+    bool m_buildPrefixes;
     bool m_isGoingIdle;
     bool m_isSuspended;
 };
@@ -27,6 +27,7 @@ class KInotify;
 namespace Baloo
 {
 class Database;
+class IndexWriter;
 class MetadataMover;
 class FileIndexerConfig;
 class PendingFileQueue;
@@ -41,6 +42,11 @@ public:
     FileWatch(Database* db, FileIndexerConfig* config, Baloo::MainHub *dbusInterface, QObject* parent = nullptr);
     ~FileWatch();
 
+    /**
+     * Hands the metadata changes of moved and removed files to \p writer
+     */
+    void setIndexWriter(IndexWriter* writer);
+
 public Q_SLOTS:
     /**
      * To be called whenever the list of indexed folders changes. This is done because
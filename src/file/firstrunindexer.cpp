@@ -27,8 +27,17 @@
 
 #include <QMimeDatabase>
 
+#include <memory>
+
 using namespace Baloo;
 
+namespace {
+// Once this much term data has been written into a transaction, it is
+// committed and a new one is started. This bounds the dirty pages LMDB
+// has to keep around, and the work lost if we get interrupted.
+const qint64 commitThreshold = 256 * 1024 * 1024;
+}
+
 FirstRunIndexer::FirstRunIndexer(Database* db, FileIndexerConfig* config, const QStringList& folders)
     : m_db(db)
     , m_config(config)
@@ -52,7 +61,8 @@ void FirstRunIndexer::run()
         : BasicIndexingJob::MarkForContentIndexing;
 
     for (const QString& folder : qAsConst(m_folders)) {
-        Transaction tr(m_db, Transaction::ReadWrite);
+        std::unique_ptr<Transaction> tr(new Transaction(m_db, Transaction::ReadWrite));
+        tr->setMemoryBudget(Transaction::defaultMemoryBudget);
 
         FilteredDirIterator it(m_config, folder);
         while (!it.next().isEmpty()) {
@@ -76,15 +86,22 @@ void FirstRunIndexer::run()
             // Hence we are checking before.
             // FIXME: Silently ignore hard links!
             //
-            if (tr.hasDocument(job.document().id())) {
+            if (tr->hasDocument(job.document().id())) {
                 continue;
             }
-            tr.addDocument(job.document());
+            tr->addDocument(job.document());
+
+            // Every document is complete at this point, and the parent folders
+            // have always been added before their children, so this is a safe
+            // point to commit
+            if (tr->uncommittedBytes() > commitThreshold) {
+                tr->commit();
+                tr.reset(new Transaction(m_db, Transaction::ReadWrite));
+                tr->setMemoryBudget(Transaction::defaultMemoryBudget);
+            }
         }
 
-        // FIXME: This would consume too much memory. We should make some more commits
-        //        based on how much memory we consume
-        tr.commit();
+        tr->commit();
     }
 
     m_config->setInitialRun(false);
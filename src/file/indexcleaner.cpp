@@ -23,19 +23,25 @@
 #include "database.h"
 #include "transaction.h"
 #include "idutils.h"
+#include "indexwriter.h"
 
 #include "baloodebug.h"
 
 #include <QFile>
 #include <QMimeDatabase>
+#include <QSet>
+
+#include <functional>
 
 using namespace Baloo;
 
-IndexCleaner::IndexCleaner(Database* db, FileIndexerConfig* config)
+IndexCleaner::IndexCleaner(Database* db, IndexWriter* writer, FileIndexerConfig* config)
     : m_db(db)
+    , m_writer(writer)
     , m_config(config)
 {
     Q_ASSERT(db);
+    Q_ASSERT(writer);
     Q_ASSERT(config);
 }
 
@@ -43,7 +49,9 @@ void IndexCleaner::run()
 {
     QMimeDatabase mimeDb;
 
-    Transaction tr(m_db, Transaction::ReadWrite);
+    // The checks below touch the file system, so they are done on a read
+    // transaction. The writer only gets to remove what was found stale.
+    Transaction tr(m_db, Transaction::ReadOnly);
 
     auto shouldDelete = [&](quint64 id) {
         if (!id) {
@@ -72,21 +80,51 @@ void IndexCleaner::run()
         return false;
     };
 
+    // Like WriteTransaction::removeRecursively, only descend into the
+    // folders which should be deleted
+    QSet<quint64> staleIds;
+    std::function<void(quint64)> collectStale = [&](quint64 id) {
+        if (!shouldDelete(id)) {
+            return;
+        }
+        staleIds.insert(id);
+        const QVector<quint64> children = tr.childrenDocumentId(id);
+        for (quint64 child : children) {
+            collectStale(child);
+        }
+    };
+
+    QVector<quint64> folderIds;
     const auto includeFolders = m_config->includeFolders();
     for (const QString& folder : includeFolders) {
         quint64 id = filePathToId(QFile::encodeName(folder));
         if (id > 0) {
-            tr.removeRecursively(id, shouldDelete);
+            collectStale(id);
+            folderIds << id;
         }
     }
     const auto excludeFolders = m_config->excludeFolders();
     for (const QString& folder : excludeFolders) {
         quint64 id = filePathToId(QFile::encodeName(folder));
         if (id > 0 && tr.hasDocument(id)) {
-            tr.removeRecursively(id, shouldDelete);
+            collectStale(id);
+            folderIds << id;
         }
     }
-    tr.commit();
+    tr.abort();
+
+    if (!staleIds.isEmpty()) {
+        m_writer->submit([folderIds, staleIds](Transaction& tr) {
+            auto isStale = [&staleIds](quint64 id) {
+                return staleIds.contains(id);
+            };
+            for (quint64 id : folderIds) {
+                tr.removeRecursively(id, isStale);
+            }
+        });
+    }
 
+    // The content indexer must not see the stale entries
+    m_writer->waitForCommitted();
     Q_EMIT done();
 }
@@ -27,12 +27,13 @@ namespace Baloo {
 
 class Database;
 class FileIndexerConfig;
+class IndexWriter;
 
 class IndexCleaner : public QObject, public QRunnable
 {
     Q_OBJECT
 public:
-    IndexCleaner(Database* db, FileIndexerConfig* config);
+    IndexCleaner(Database* db, IndexWriter* writer, FileIndexerConfig* config);
     void run() override;
 
 Q_SIGNALS:
@@ -40,6 +41,7 @@ Q_SIGNALS:
 
 private:
     Database* m_db;
+    IndexWriter* m_writer;
     FileIndexerConfig* m_config;
 };
 }
@@ -37,6 +37,8 @@ enum IndexerState {
         UnindexedFileCheck,
         StaleIndexEntriesClean,
         LowPowerIdle,
+        PostingDeltaCompaction,
+        PrefixIndexBuild,
 };
 
 inline QString stateString(IndexerState state)
@@ -73,6 +75,12 @@ inline QString stateString(IndexerState state)
     case LowPowerIdle:
         status = i18n("Idle (Powersave)");
         break;
+    case PostingDeltaCompaction:
+        status = i18n("Merging index updates");
+        break;
+    case PrefixIndexBuild:
+        status = i18n("Building the prefix index");
+        break;
     }
     return status;
 }
@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+
+#include "indexwriter.h"
+
+#include "database.h"
+#include "transaction.h"
+#include "commitstatistics.h"
+#include "baloodebug.h"
+
+#include <QElapsedTimer>
+#include <QMutexLocker>
+
+#include <memory>
+
+using namespace Baloo;
+
+namespace {
+// A group which queued this much term data is committed early
+const qint64 commitThreshold = 256 * 1024 * 1024;
+}
+
+IndexWriter::IndexWriter(Database* db, QObject* parent)
+    : QThread(parent)
+    , m_db(db)
+    , m_submitted(0)
+    , m_committed(0)
+    , m_maxBatchSize(1000)
+    , m_maxLatency(500)
+    , m_flushRequested(false)
+    , m_finished(false)
+    , m_commitStatistics(nullptr)
+{
+    Q_ASSERT(db);
+}
+
+IndexWriter::~IndexWriter()
+{
+    finish();
+}
+
+void IndexWriter::setMaxBatchSize(int mutations)
+{
+    QMutexLocker lock(&m_mutex);
+    m_maxBatchSize = qMax(1, mutations);
+}
+
+void IndexWriter::setMaxLatency(int msecs)
+{
+    QMutexLocker lock(&m_mutex);
+    m_maxLatency = qMax(0, msecs);
+}
+
+void IndexWriter::setCommitStatistics(CommitStatistics* statistics)
+{
+    QMutexLocker lock(&m_mutex);
+    m_commitStatistics = statistics;
+}
+
+void IndexWriter::submit(const Mutation& mutation)
+{
+    QMutexLocker lock(&m_mutex);
+    if (m_finished) {
+        qCWarning(BALOO) << "IndexWriter: dropping a mutation submitted after finish";
+        return;
+    }
+
+    m_queue.append(mutation);
+    m_submitted++;
+
+    // The writer only needs to wake up for a new group, or a full one
+    if (m_queue.size() == 1 || m_queue.size() >= m_maxBatchSize) {
+        m_queueCondition.wakeOne();
+    }
+
+    if (!isRunning()) {
+        start();
+    }
+}
+
+void IndexWriter::waitForCommitted()
+{
+    QMutexLocker lock(&m_mutex);
+    const quint64 target = m_submitted;
+    while (m_committed < target) {
+        // Do not let the pending group wait out its latency
+        m_flushRequested = true;
+        m_queueCondition.wakeOne();
+        m_committedCondition.wait(&m_mutex);
+    }
+}
+
+void IndexWriter::finish()
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        m_finished = true;
+        m_queueCondition.wakeOne();
+    }
+    wait();
+}
+
+void IndexWriter::run()
+{
+    QMutexLocker lock(&m_mutex);
+    while (true) {
+        while (m_queue.isEmpty() && !m_finished) {
+            m_queueCondition.wait(&m_mutex);
+        }
+        if (m_queue.isEmpty()) {
+            break;
+        }
+
+        // Give the other producers a chance to join the group
+        QElapsedTimer timer;
+        timer.start();
+        while (!m_finished && !m_flushRequested && m_queue.size() < m_maxBatchSize) {
+            const qint64 remaining = m_maxLatency - timer.elapsed();
+            if (remaining <= 0) {
+                break;
+            }
+            m_queueCondition.wait(&m_mutex, remaining);
+        }
+
+        QVector<Mutation> batch;
+        batch.swap(m_queue);
+        m_flushRequested = false;
+        CommitStatistics* statistics = m_commitStatistics;
+        lock.unlock();
+
+        auto commit = [statistics](Transaction* tr) {
+            tr->commit();
+            if (statistics) {
+                statistics->record(QStringLiteral("indexer"), tr->commitStats());
+            }
+        };
+
+        std::unique_ptr<Transaction> tr(new Transaction(m_db, Transaction::ReadWrite));
+        tr->setMemoryBudget(Transaction::defaultMemoryBudget);
+        for (const Mutation& mutation : qAsConst(batch)) {
+            mutation(*tr);
+
+            if (tr->uncommittedBytes() > commitThreshold) {
+                commit(tr.get());
+                tr.reset(new Transaction(m_db, Transaction::ReadWrite));
+                tr->setMemoryBudget(Transaction::defaultMemoryBudget);
+            }
+        }
+        commit(tr.get());
+        tr.reset();
+
+        Q_EMIT committed(batch.size());
+
+        lock.relock();
+        m_committed += batch.size();
+        m_committedCondition.wakeAll();
+    }
+}
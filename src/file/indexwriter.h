@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+
+#ifndef BALOO_INDEXWRITER_H
+#define BALOO_INDEXWRITER_H
+
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+
+#include <functional>
+
+namespace Baloo {
+
+class Database;
+class Transaction;
+class CommitStatistics;
+
+/**
+ * The single writer of baloo_file.
+ *
+ * The indexers hand their changes to the database over as mutations,
+ * instead of each opening a write transaction of their own. A dedicated
+ * thread collects the mutations of all of them and applies them in
+ * group commits, once enough are queued or the oldest one has waited
+ * long enough. Submitting never waits for the database, so the indexers
+ * can run in parallel.
+ *
+ * A mutation is applied in the write transaction of its group. Anything
+ * it reads from the transaction includes the changes queued before it.
+ */
+class IndexWriter : public QThread
+{
+    Q_OBJECT
+public:
+    typedef std::function<void(Transaction&)> Mutation;
+
+    explicit IndexWriter(Database* db, QObject* parent = nullptr);
+    ~IndexWriter() override;
+
+    /**
+     * Queues \p mutation, and starts the writer thread if needed
+     */
+    void submit(const Mutation& mutation);
+
+    /**
+     * Blocks until every mutation submitted so far has been committed
+     */
+    void waitForCommitted();
+
+    /**
+     * Commits the queued mutations and stops the writer thread.
+     * Mutations submitted afterwards are dropped.
+     */
+    void finish();
+
+    /**
+     * A group is committed once it has \p mutations
+     */
+    void setMaxBatchSize(int mutations);
+
+    /**
+     * A group is committed at the latest \p msecs after its first mutation
+     * was submitted
+     */
+    void setMaxLatency(int msecs);
+
+    /**
+     * Records every commit in \p statistics
+     */
+    void setCommitStatistics(CommitStatistics* statistics);
+
+Q_SIGNALS:
+    /**
+     * Emitted from the writer thread after a group of \p mutations
+     * has been committed
+     */
+    void committed(int mutations);
+
+protected:
+    void run() override;
+
+private:
+    Database* m_db;
+
+    QMutex m_mutex;
+    QWaitCondition m_queueCondition;
+    QWaitCondition m_committedCondition;
+
+    QVector<Mutation> m_queue;
+    quint64 m_submitted;
+    quint64 m_committed;
+
+    int m_maxBatchSize;
+    int m_maxLatency;
+    bool m_flushRequested;
+    bool m_finished;
+    CommitStatistics* m_commitStatistics;
+};
+
+}
+
+#endif // BALOO_INDEXWRITER_H
@@ -30,12 +30,15 @@ using namespace Baloo;
 MainHub::MainHub(Database* db, FileIndexerConfig* config)
     : m_db(db)
     , m_config(config)
+    , m_indexWriter(db)
     , m_fileWatcher(db, config, this)
-    , m_fileIndexScheduler(db, config, this)
+    , m_fileIndexScheduler(db, &m_indexWriter, config, this)
 {
     Q_ASSERT(db);
     Q_ASSERT(config);
 
+    m_fileWatcher.setIndexWriter(&m_indexWriter);
+
     connect(&m_fileWatcher, &FileWatch::indexNewFile, &m_fileIndexScheduler, &FileIndexScheduler::indexNewFile);
     connect(&m_fileWatcher, &FileWatch::indexModifiedFile, &m_fileIndexScheduler, &FileIndexScheduler::indexModifiedFile);
     connect(&m_fileWatcher, &FileWatch::indexXAttr, &m_fileIndexScheduler, &FileIndexScheduler::indexXAttrFile);
@@ -60,6 +63,13 @@ MainHub::MainHub(Database* db, FileIndexerConfig* config)
     QTimer::singleShot(0, &m_fileWatcher, &FileWatch::watchIndexedFolders);
 }
 
+MainHub::~MainHub()
+{
+    // The queued mutations refer to the file watcher, so they have to be
+    // committed before it goes away
+    m_indexWriter.finish();
+}
+
 void MainHub::quit() const
 {
     QCoreApplication::instance()->quit();
@@ -24,6 +24,7 @@
 
 #include "filewatch.h"
 #include "fileindexscheduler.h"
+#include "indexwriter.h"
 
 
 namespace Baloo {
@@ -37,6 +38,7 @@ class MainHub : public QObject
     Q_CLASSINFO("D-Bus Interface", "org.kde.baloo.main")
 public:
     MainHub(Database* db, FileIndexerConfig* config);
+    ~MainHub() override;
 
 public Q_SLOTS:
     Q_SCRIPTABLE void quit() const;
@@ -47,6 +49,8 @@ private:
     Database* m_db;
     FileIndexerConfig* m_config;
 
+    // Declared first, everything below submits to it
+    IndexWriter m_indexWriter;
     FileWatch m_fileWatcher;
     FileIndexScheduler m_fileIndexScheduler;
 
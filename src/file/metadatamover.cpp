@@ -22,6 +22,7 @@
 #include "transaction.h"
 #include "basicindexingjob.h"
 #include "idutils.h"
+#include "indexwriter.h"
 #include "mainhub.h"
 #include "baloodebug.h"
 
@@ -35,6 +36,7 @@ using namespace Baloo;
 MetadataMover::MetadataMover(Database* db, QObject* parent)
     : QObject(parent)
     , m_db(db)
+    , m_writer(nullptr)
 {
     m_serviceWatcher.setConnection(QDBusConnection::sessionBus());
     m_serviceWatcher.setWatchMode(QDBusServiceWatcher::WatchForUnregistration);
@@ -48,6 +50,18 @@ MetadataMover::~MetadataMover()
 {
 }
 
+void MetadataMover::setIndexWriter(IndexWriter* writer)
+{
+    if (m_writer) {
+        disconnect(m_writer, nullptr, this, nullptr);
+    }
+    m_writer = writer;
+    if (m_writer) {
+        // Runs in the writer thread, before the next group is applied
+        connect(m_writer, &IndexWriter::committed, this, &MetadataMover::notifyCommittedMoves, Qt::DirectConnection);
+    }
+}
+
 bool MetadataMover::hasWatcher() const
 {
     return !m_watcherApplications.isEmpty();
@@ -71,35 +85,75 @@ void MetadataMover::moveFileMetadata(const QString& from, const QString& to)
     Q_ASSERT(!from.isEmpty() && from != QLatin1String("/"));
     Q_ASSERT(!to.isEmpty() && to != QLatin1String("/"));
 
+    const bool notify = hasWatcher();
+    qCDebug(BALOO) << "MetadataMover::moveFileMetadata" << (notify ? "has watcher" : "has no watcher");
+
+    if (m_writer) {
+        m_writer->submit([this, from, to, notify](Transaction& tr) {
+            const QList<QString> filesList = moveMetadata(&tr, from, to, notify);
+            if (notify) {
+                // The watchers are only told once the move is committed
+                m_uncommittedMoves.append({from, to, filesList});
+            }
+        });
+        return;
+    }
+
     Transaction tr(m_db, Transaction::ReadWrite);
+    const QList<QString> filesList = moveMetadata(&tr, from, to, notify);
+    tr.commit();
 
-    quint64 id = tr.documentId(QFile::encodeName(from));
+    if (notify) {
+        notifyWatchers(from, to, filesList);
+    }
+}
+
+void MetadataMover::notifyCommittedMoves()
+{
+    if (m_uncommittedMoves.isEmpty()) {
+        return;
+    }
+
+    QVector<Move> moves;
+    moves.swap(m_uncommittedMoves);
+    // The watchers are talked to from the thread they were registered in
+    QMetaObject::invokeMethod(this, [this, moves] {
+        for (const Move& move : moves) {
+            notifyWatchers(move.from, move.to, move.filesList);
+        }
+    }, Qt::QueuedConnection);
+}
+
+QList<QString> MetadataMover::moveMetadata(Transaction* tr, const QString& from, const QString& to, bool listFiles)
+{
+    quint64 id = tr->documentId(QFile::encodeName(from));
     QList<QString> filesList;
-    qCDebug(BALOO) << "MetadataMover::moveFileMetadata" << (hasWatcher() ? "has watcher" : "has no watcher");
     qCDebug(BALOO) << "MetadataMover::moveFileMetadata" << "id" << id;
-    if (id && hasWatcher()) {
-        buildRecursiveList(id, filesList, tr);
+    if (id && listFiles) {
+        buildRecursiveList(id, filesList, *tr);
     }
 
     // We do NOT get deleted messages for overwritten files! Thus, we
     // have to remove all metadata for overwritten files first.
-    removeMetadata(&tr, to);
+    removeMetadata(tr, to);
 
     // and finally update the old statements
-    updateMetadata(&tr, from, to);
+    updateMetadata(tr, from, to);
 
-    tr.commit();
-
-    if (hasWatcher()) {
-        qCDebug(BALOO) << "MetadataMover::moveFileMetadata" << "notifyWatchers" << filesList;
-        notifyWatchers(from, to, filesList);
-    }
+    return filesList;
 }
 
 void MetadataMover::removeFileMetadata(const QString& file)
 {
     Q_ASSERT(!file.isEmpty() && file != QLatin1String("/"));
 
+    if (m_writer) {
+        m_writer->submit([this, file](Transaction& tr) {
+            removeMetadata(&tr, file);
+        });
+        return;
+    }
+
     Transaction tr(m_db, Transaction::ReadWrite);
     removeMetadata(&tr, file);
     tr.commit();
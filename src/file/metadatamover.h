@@ -23,6 +23,7 @@
 #include <QObject>
 #include <QDBusServiceWatcher>
 #include <QMap>
+#include <QVector>
 
 class OrgKdeBalooWatcherApplicationInterface;
 
@@ -42,6 +43,7 @@ namespace Baloo
 {
 
 class Database;
+class IndexWriter;
 class Transaction;
 
 class MetadataMover : public QObject
@@ -54,6 +56,12 @@ public:
 
     bool hasWatcher() const;
 
+    /**
+     * Hands the changes to \p writer instead of committing them right
+     * away. The signals are then emitted from the writer thread.
+     */
+    void setIndexWriter(IndexWriter* writer);
+
 public Q_SLOTS:
     void moveFileMetadata(const QString& from, const QString& to);
     void removeFileMetadata(const QString& file);
@@ -88,13 +96,35 @@ private:
      */
     void updateMetadata(Transaction* tr, const QString& from, const QString& to);
 
+    /**
+     * Moves the metadata of \p from to \p to. Returns the files below \p from
+     * if \p listFiles is set.
+     */
+    QList<QString> moveMetadata(Transaction* tr, const QString& from, const QString& to, bool listFiles);
+
     void notifyWatchers(const QString &from, const QString &to, const QList<QString> &filesList);
 
+    /**
+     * Hands the moves of the group the writer has just committed
+     * over to the watchers
+     */
+    void notifyCommittedMoves();
+
+    struct Move {
+        QString from;
+        QString to;
+        QList<QString> filesList;
+    };
+    // The moves applied by the writer which are not committed yet,
+    // only used from the writer thread
+    QVector<Move> m_uncommittedMoves;
+
     QMap<QString, org::kde::BalooWatcherApplication*> m_watcherApplications;
 
     QDBusServiceWatcher m_serviceWatcher;
 
     Database* m_db;
+    IndexWriter* m_writer;
 };
 }
 
@@ -21,6 +21,7 @@
 #include "basicindexingjob.h"
 #include "fileindexerconfig.h"
 #include "idutils.h"
+#include "indexwriter.h"
 
 #include "database.h"
 #include "transaction.h"
@@ -32,12 +33,15 @@
 
 using namespace Baloo;
 
-ModifiedFileIndexer::ModifiedFileIndexer(Database* db, const FileIndexerConfig* config, const QStringList& files)
+ModifiedFileIndexer::ModifiedFileIndexer(Database* db, IndexWriter* writer, const FileIndexerConfig* config,
+                                         const QStringList& files)
     : m_db(db)
+    , m_writer(writer)
     , m_config(config)
     , m_files(files)
 {
     Q_ASSERT(m_db);
+    Q_ASSERT(m_writer);
     Q_ASSERT(m_config);
     Q_ASSERT(!m_files.isEmpty());
 }
@@ -48,7 +52,8 @@ void ModifiedFileIndexer::run()
     BasicIndexingJob::IndexingLevel level = m_config->onlyBasicIndexing() ? BasicIndexingJob::NoLevel
         : BasicIndexingJob::MarkForContentIndexing;
 
-    Transaction tr(m_db, Transaction::ReadWrite);
+    // Only used to skip unchanged files, the changes go through the writer
+    Transaction tr(m_db, Transaction::ReadOnly);
 
     for (const QString& filePath : qAsConst(m_files)) {
         Q_ASSERT(!filePath.endsWith('/'));
@@ -99,20 +104,24 @@ void ModifiedFileIndexer::run()
             continue;
         }
 
-        // we can get modified events for files which do not exist
-        // cause Baloo was not running and missed those events
-        if (tr.hasDocument(job.document().id())) {
-            if (cTimeChanged) {
-                tr.replaceDocument(job.document(), XAttrTerms | DocumentTime | FileNameTerms | DocumentUrl);
-            } else {
-                tr.replaceDocument(job.document(), DocumentTime);
+        const Document doc = job.document();
+        m_writer->submit([doc, cTimeChanged](Transaction& tr) {
+            // we can get modified events for files which do not exist
+            // cause Baloo was not running and missed those events
+            if (tr.hasDocument(doc.id())) {
+                if (cTimeChanged) {
+                    tr.replaceDocument(doc, XAttrTerms | DocumentTime | FileNameTerms | DocumentUrl);
+                } else {
+                    tr.replaceDocument(doc, DocumentTime);
+                }
             }
-        }
-        else {
-            tr.addDocument(job.document());
-        }
+            else {
+                tr.addDocument(doc);
+            }
+        });
     }
 
-    tr.commit();
+    // The content indexer only sees the documents once they are committed
+    m_writer->waitForCommitted();
     Q_EMIT done();
 }
@@ -28,12 +28,13 @@ namespace Baloo {
 
 class Database;
 class FileIndexerConfig;
+class IndexWriter;
 
 class ModifiedFileIndexer : public QObject, public QRunnable
 {
     Q_OBJECT
 public:
-    ModifiedFileIndexer(Database* db, const FileIndexerConfig* config, const QStringList& files);
+    ModifiedFileIndexer(Database* db, IndexWriter* writer, const FileIndexerConfig* config, const QStringList& files);
 
     void run() override;
 
@@ -42,6 +43,7 @@ Q_SIGNALS:
 
 private:
     Database* m_db;
+    IndexWriter* m_writer;
     const FileIndexerConfig* m_config;
     QStringList m_files;
 };
@@ -20,8 +20,8 @@
 #include "newfileindexer.h"
 #include "basicindexingjob.h"
 #include "fileindexerconfig.h"
+#include "indexwriter.h"
 
-#include "database.h"
 #include "transaction.h"
 
 #include <QMimeDatabase>
@@ -29,12 +29,12 @@
 
 using namespace Baloo;
 
-NewFileIndexer::NewFileIndexer(Database* db, const FileIndexerConfig* config, const QStringList& newFiles)
-    : m_db(db)
+NewFileIndexer::NewFileIndexer(IndexWriter* writer, const FileIndexerConfig* config, const QStringList& newFiles)
+    : m_writer(writer)
     , m_config(config)
     , m_files(newFiles)
 {
-    Q_ASSERT(m_db);
+    Q_ASSERT(m_writer);
     Q_ASSERT(m_config);
     Q_ASSERT(!m_files.isEmpty());
 }
@@ -45,8 +45,6 @@ void NewFileIndexer::run()
     BasicIndexingJob::IndexingLevel level = m_config->onlyBasicIndexing() ? BasicIndexingJob::NoLevel
         : BasicIndexingJob::MarkForContentIndexing;
 
-    Transaction tr(m_db, Transaction::ReadWrite);
-
     for (const QString& filePath : qAsConst(m_files)) {
         Q_ASSERT(!filePath.endsWith(QLatin1Char('/')));
 
@@ -79,14 +77,17 @@ void NewFileIndexer::run()
             continue;
         }
 
-        // The same file can be sent twice though it shouldn't be.
-        // Lets just silently ignore it instead of crashing
-        if (tr.hasDocument(job.document().id())) {
-            continue;
-        }
-        tr.addDocument(job.document());
+        const Document doc = job.document();
+        m_writer->submit([doc](Transaction& tr) {
+            // The same file can be sent twice though it shouldn't be.
+            // Lets just silently ignore it instead of crashing
+            if (!tr.hasDocument(doc.id())) {
+                tr.addDocument(doc);
+            }
+        });
     }
 
-    tr.commit();
+    // The content indexer only sees the documents once they are committed
+    m_writer->waitForCommitted();
     Q_EMIT done();
 }
@@ -26,8 +26,8 @@
 
 namespace Baloo {
 
-class Database;
 class FileIndexerConfig;
+class IndexWriter;
 
 /**
  * Does not check the folder path or the mtime of the file
@@ -36,7 +36,7 @@ class NewFileIndexer : public QObject, public QRunnable
 {
     Q_OBJECT
 public:
-    NewFileIndexer(Database* db, const FileIndexerConfig* config, const QStringList& newFiles);
+    NewFileIndexer(IndexWriter* writer, const FileIndexerConfig* config, const QStringList& newFiles);
 
     void run() override;
 
@@ -44,7 +44,7 @@ Q_SIGNALS:
     void done();
 
 private:
-    Database* m_db;
+    IndexWriter* m_writer;
     const FileIndexerConfig* m_config;
     QStringList m_files;
 };
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "postingdeltacompactor.h"
+
+#include "database.h"
+#include "transaction.h"
+#include "commitstatistics.h"
+
+#include "baloodebug.h"
+
+using namespace Baloo;
+
+namespace {
+// The number of terms folded in a single transaction
+const int termsPerRun = 2000;
+}
+
+PostingDeltaCompactor::PostingDeltaCompactor(Database* db, CommitStatistics* statistics)
+    : m_db(db)
+    , m_commitStatistics(statistics)
+{
+    Q_ASSERT(db);
+}
+
+void PostingDeltaCompactor::run()
+{
+    {
+        Transaction tr(m_db, Transaction::ReadOnly);
+        if (!tr.postingDeltaCount()) {
+            Q_EMIT done(false);
+            return;
+        }
+    }
+
+    Transaction tr(m_db, Transaction::ReadWrite);
+    const bool moreRemaining = tr.compactPostingDeltas(termsPerRun);
+    tr.commit();
+    if (m_commitStatistics) {
+        m_commitStatistics->record(QStringLiteral("compactor"), tr.commitStats());
+    }
+
+    qCDebug(BALOO) << "Compacted posting deltas, more remaining:" << moreRemaining;
+    Q_EMIT done(moreRemaining);
+}
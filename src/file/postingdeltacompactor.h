@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef BALOO_POSTINGDELTACOMPACTOR_H
+#define BALOO_POSTINGDELTACOMPACTOR_H
+
+#include <QRunnable>
+#include <QObject>
+
+namespace Baloo {
+
+class Database;
+class CommitStatistics;
+
+/**
+ * Folds the deltas written by small commits back into the PostingDB.
+ * Every run handles a bounded number of terms, so that the scheduler
+ * can interleave it with more important work.
+ */
+class PostingDeltaCompactor : public QObject, public QRunnable
+{
+    Q_OBJECT
+public:
+    explicit PostingDeltaCompactor(Database* db, CommitStatistics* statistics = nullptr);
+    void run() override;
+
+Q_SIGNALS:
+    void done(bool moreRemaining);
+
+private:
+    Database* m_db;
+    CommitStatistics* m_commitStatistics;
+};
+}
+
+#endif // BALOO_POSTINGDELTACOMPACTOR_H
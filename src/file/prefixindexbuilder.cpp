@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "prefixindexbuilder.h"
+
+#include "database.h"
+#include "transaction.h"
+#include "commitstatistics.h"
+
+#include "baloodebug.h"
+
+using namespace Baloo;
+
+namespace {
+// The number of prefixes stored in a single transaction
+const int prefixesPerRun = 200;
+}
+
+PrefixIndexBuilder::PrefixIndexBuilder(Database* db, CommitStatistics* statistics)
+    : m_db(db)
+    , m_commitStatistics(statistics)
+{
+    Q_ASSERT(db);
+}
+
+void PrefixIndexBuilder::run()
+{
+    Transaction tr(m_db, Transaction::ReadWrite);
+    const bool moreRemaining = tr.buildPrefixes(prefixesPerRun);
+    tr.commit();
+    if (m_commitStatistics) {
+        m_commitStatistics->record(QStringLiteral("prefixes"), tr.commitStats());
+    }
+
+    qCDebug(BALOO) << "Built prefixes, more remaining:" << moreRemaining;
+    Q_EMIT done(moreRemaining);
+}
@@ -46,6 +46,7 @@ void UnindexedFileIndexer::run()
 
     for (const QString& includeFolder : includeFolders) {
         Transaction tr(m_db, Transaction::ReadWrite);
+        tr.setMemoryBudget(Transaction::defaultMemoryBudget);
         UnIndexedFileIterator it(m_config, &tr, includeFolder);
 
         while (!it.next().isEmpty()) {
@@ -20,20 +20,20 @@
 #include "xattrindexer.h"
 #include "basicindexingjob.h"
 #include "fileindexerconfig.h"
+#include "indexwriter.h"
 
-#include "database.h"
 #include "transaction.h"
 
 #include <QMimeDatabase>
 
 using namespace Baloo;
 
-XAttrIndexer::XAttrIndexer(Database* db, const FileIndexerConfig* config, const QStringList& files)
-    : m_db(db)
+XAttrIndexer::XAttrIndexer(IndexWriter* writer, const FileIndexerConfig* config, const QStringList& files)
+    : m_writer(writer)
     , m_config(config)
     , m_files(files)
 {
-    Q_ASSERT(m_db);
+    Q_ASSERT(m_writer);
     Q_ASSERT(m_config);
     Q_ASSERT(!m_files.isEmpty());
 }
@@ -44,8 +44,6 @@ void XAttrIndexer::run()
     BasicIndexingJob::IndexingLevel level = m_config->onlyBasicIndexing() ? BasicIndexingJob::NoLevel
         : BasicIndexingJob::MarkForContentIndexing;
 
-    Transaction tr(m_db, Transaction::ReadWrite);
-
     for (const QString& filePath : qAsConst(m_files)) {
         Q_ASSERT(!filePath.endsWith(QLatin1Char('/')));
 
@@ -65,17 +63,21 @@ void XAttrIndexer::run()
             continue;
         }
 
-        // FIXME: This slightly defeats the point of having separate indexers
-        //        But we can get xattr changes of a file, even when it doesn't exist
-        //        cause we missed its creation somehow
-        if (!tr.hasDocument(job.document().id())) {
-            tr.addDocument(job.document());
-            continue;
-        }
+        const Document doc = job.document();
+        m_writer->submit([doc](Transaction& tr) {
+            // FIXME: This slightly defeats the point of having separate indexers
+            //        But we can get xattr changes of a file, even when it doesn't exist
+            //        cause we missed its creation somehow
+            if (!tr.hasDocument(doc.id())) {
+                tr.addDocument(doc);
+                return;
+            }
 
-        tr.replaceDocument(job.document(), XAttrTerms | DocumentTime | FileNameTerms | DocumentUrl);
+            tr.replaceDocument(doc, XAttrTerms | DocumentTime | FileNameTerms | DocumentUrl);
+        });
     }
 
-    tr.commit();
+    // The state only moves on once the changes are committed
+    m_writer->waitForCommitted();
     Q_EMIT done();
 }
@@ -26,14 +26,14 @@
 
 namespace Baloo {
 
-class Database;
 class FileIndexerConfig;
+class IndexWriter;
 
 class XAttrIndexer : public QObject, public QRunnable
 {
     Q_OBJECT
 public:
-    XAttrIndexer(Database* db, const FileIndexerConfig* config, const QStringList& files);
+    XAttrIndexer(IndexWriter* writer, const FileIndexerConfig* config, const QStringList& files);
 
     void run() override;
 
@@ -41,7 +41,7 @@ Q_SIGNALS:
     void done();
 
 private:
-    Database* m_db;
+    IndexWriter* m_writer;
     const FileIndexerConfig* m_config;
     QStringList m_files;
 };
@@ -20,7 +20,7 @@
 
 #include "advancedqueryparser.h"
 
-#include <QStringList>
+#include <QVector>
 #include <QStack>
 #include <QDate>
 
@@ -30,10 +30,19 @@ AdvancedQueryParser::AdvancedQueryParser()
 {
 }
 
-static QStringList lex(const QString& text)
+namespace {
+struct Token {
+    QString text;
+    // Starts with a quoted string, so "NOT" or "-foo" are not negations
+    bool quoted;
+};
+}
+
+static QVector<Token> lex(const QString& text)
 {
-    QStringList tokenList;
+    QVector<Token> tokenList;
     QString token;
+    bool tokenQuoted = false;
     bool inQuotes = false;
 
     for (int i = 0, end = text.size(); i != end; ++i) {
@@ -44,41 +53,47 @@ static QStringList lex(const QString& text)
             inQuotes = !inQuotes;
         } else if (inQuotes) {
             // Don't do any processing in strings
+            if (token.isEmpty()) {
+                tokenQuoted = true;
+            }
             token.append(c);
         } else if (c.isSpace()) {
             // Spaces end tokens
             if (!token.isEmpty()) {
-                tokenList.append(token);
+                tokenList.append({token, tokenQuoted});
                 token.clear();
             }
         } else if (c == QLatin1Char('(') || c == QLatin1Char(')')) {
             // Parentheses end tokens, and are tokens by themselves
             if (!token.isEmpty()) {
-                tokenList.append(token);
+                tokenList.append({token, tokenQuoted});
                 token.clear();
             }
-            tokenList.append(c);
+            tokenList.append({QString(c), false});
         } else if (c == QLatin1Char('>') || c == QLatin1Char('<') || c == QLatin1Char(':') || c == QLatin1Char('=')) {
             // Operators end tokens
             if (!token.isEmpty()) {
-                tokenList.append(token);
+                tokenList.append({token, tokenQuoted});
                 token.clear();
             }
             // accept '=' after any of the above
             if (text.at(i + 1) == QLatin1Char('=')) {
-                tokenList.append(text.mid(i, 2));
+                tokenList.append({text.mid(i, 2), false});
                 i++;
             } else {
-                tokenList.append(c);
+                tokenList.append({QString(c), false});
             }
         } else {
             // Simply extend the current token
+            if (token.isEmpty()) {
+                tokenQuoted = false;
+            }
             token.append(c);
         }
     }
 
     if (!token.isEmpty()) {
-        tokenList.append(token);
+        tokenList.append({token, tokenQuoted});
     }
 
     return tokenList;
@@ -122,15 +137,19 @@ Term AdvancedQueryParser::parse(const QString& text)
     // The parser does not do any look-ahead but has to store some state
     QStack<Term> stack;
     QStack<Term::Operation> ops;
+    QStack<bool> negatedGroups;
     Term termInConstruction;
     bool valueExpected = false;
+    bool negateNext = false;
 
     stack.push(Term());
     ops.push(Term::And);
 
     // Lex the input string
-    QStringList tokens = lex(text);
-    for (const QString &token : tokens) {
+    const QVector<Token> tokens = lex(text);
+    for (const Token &t : tokens) {
+        const QString &token = t.text;
+
         // If a key and an operator have been parsed, now is time for a value
         if (valueExpected) {
             // When the parser encounters a literal, it puts it in the value of
@@ -169,6 +188,10 @@ Term AdvancedQueryParser::parse(const QString& text)
             }
             ops.top() = Term::Or;
             continue;
+        } else if (!t.quoted && (token == QLatin1String("NOT") || token == QLatin1String("-"))) {
+            // Applies to the following term or group
+            negateNext = true;
+            continue;
         }
 
         // Handle the different comparators (and braces)
@@ -205,6 +228,8 @@ Term AdvancedQueryParser::parse(const QString& text)
 
                 stack.push(Term());
                 ops.push(Term::And);
+                negatedGroups.push(negateNext);
+                negateNext = false;
                 termInConstruction = Term();
 
                 continue;
@@ -218,8 +243,12 @@ Term AdvancedQueryParser::parse(const QString& text)
 
                     // stack.pop() is the term that has just been closed. Append
                     // it to the term just above it.
+                    Term closedTerm = stack.pop();
+                    if (negatedGroups.pop() && !closedTerm.isEmpty()) {
+                        closedTerm.setNegation(true);
+                    }
                     ops.pop();
-                    addTermToStack(stack, stack.pop(), ops.top());
+                    addTermToStack(stack, closedTerm, ops.top());
                     ops.top() = Term::And;
                     termInConstruction = Term();
                 }
@@ -241,7 +270,15 @@ Term AdvancedQueryParser::parse(const QString& text)
                 ops.top() = Term::And;
             }
 
-            termInConstruction = Term(QString(), token);
+            // "-foo" is the short form of "NOT foo"
+            if (!t.quoted && token.size() > 1 && token.at(0) == QLatin1Char('-')) {
+                termInConstruction = Term(QString(), token.mid(1));
+                negateNext = true;
+            } else {
+                termInConstruction = Term(QString(), token);
+            }
+            termInConstruction.setNegation(negateNext);
+            negateNext = false;
         }
     }
 
@@ -47,6 +47,7 @@ public:
         m_monthFilter = 0;
         m_dayFilter = 0;
         m_sortingOption = SortAuto;
+        m_threadCount = 1;
     }
     Term m_term;
 
@@ -61,6 +62,10 @@ public:
 
     SortingOption m_sortingOption;
     QString m_includeFolder;
+    int m_threadCount;
+
+    // Parses the search string, and adds the filters to the term
+    Term searchTerm();
 };
 
 Query::Query()
@@ -175,47 +180,74 @@ QString Query::includeFolder() const
     return d->m_includeFolder;
 }
 
+void Query::setThreadCount(int count)
+{
+    d->m_threadCount = count;
+}
+
+int Query::threadCount() const
+{
+    return d->m_threadCount;
+}
+
 void Query::setIncludeFolder(const QString& folder)
 {
     d->m_includeFolder = folder;
 }
 
-ResultIterator Query::exec()
+Term Query::Private::searchTerm()
 {
-    if (!d->m_searchString.isEmpty()) {
-        if (d->m_term.isValid()) {
+    if (!m_searchString.isEmpty()) {
+        if (m_term.isValid()) {
             qCDebug(BALOO) << "Term already set";
         }
         AdvancedQueryParser parser;
-        d->m_term = parser.parse(d->m_searchString);
+        m_term = parser.parse(m_searchString);
     }
 
-    Term term(d->m_term);
-    if (!d->m_types.isEmpty()) {
-        for (const QString& type : qAsConst(d->m_types)) {
+    Term term(m_term);
+    if (!m_types.isEmpty()) {
+        for (const QString& type : qAsConst(m_types)) {
             term = term && Term(QStringLiteral("type"), type);
         }
     }
 
-    if (!d->m_includeFolder.isEmpty()) {
-        term = term && Term(QStringLiteral("includefolder"), d->m_includeFolder);
+    if (!m_includeFolder.isEmpty()) {
+        term = term && Term(QStringLiteral("includefolder"), m_includeFolder);
     }
 
-    if (d->m_yearFilter || d->m_monthFilter || d->m_dayFilter) {
-        QByteArray ba = QByteArray::number(d->m_yearFilter);
-        if (d->m_monthFilter < 10)
+    if (m_yearFilter || m_monthFilter || m_dayFilter) {
+        QByteArray ba = QByteArray::number(m_yearFilter);
+        if (m_monthFilter < 10)
             ba += '0';
-        ba += QByteArray::number(d->m_monthFilter);
-        if (d->m_dayFilter < 10)
+        ba += QByteArray::number(m_monthFilter);
+        if (m_dayFilter < 10)
             ba += '0';
-        ba += QByteArray::number(d->m_dayFilter);
+        ba += QByteArray::number(m_dayFilter);
 
         term = term && Term(QStringLiteral("modified"), ba, Term::Equal);
     }
 
+    return term;
+}
+
+ResultIterator Query::exec()
+{
+    const Term term = d->searchTerm();
+
+    // The results are resolved as the iterator is advanced
+    SearchStore* searchStore = new SearchStore();
+    searchStore->setThreadCount(d->m_threadCount);
+    searchStore->start(term, d->m_offset, d->m_limit, d->m_sortingOption == SortAuto);
+    return ResultIterator(searchStore);
+}
+
+QString Query::explain()
+{
+    const Term term = d->searchTerm();
+
     SearchStore searchStore;
-    QStringList result = searchStore.exec(term, d->m_offset, d->m_limit, d->m_sortingOption == SortAuto);
-    return ResultIterator(result);
+    return searchStore.explain(term, d->m_offset, d->m_limit, d->m_sortingOption == SortAuto);
 }
 
 QByteArray Query::toJSON()
@@ -59,6 +59,11 @@ namespace Baloo {
  * @example -
  * "type:Audio title:Fix" -> Look for Audio files which contains the title "Fix" in its title.
  *
+ * @example -
+ * "colour~ filename:recipe~2" -> Look for files containing a word at most one edit away from
+ * "colour", such as "color", and with a file name containing a word at most two edits away
+ * from "recipe".
+ *
  * The Query Parser recognizes a large number of properties. These property names can be looked
  * up in KFileMetaData::Property::Property. The type of the file can mentioned with the property
  * 'type' or 'kind'.
@@ -140,8 +145,29 @@ public:
     void setIncludeFolder(const QString& folder);
     QString includeFolder() const;
 
+    /**
+     * Queries which go through a lot of documents, such as unlimited or
+     * sorted ones, can be run on up to \p count threads, each one matching
+     * a range of the documents. 0 uses one thread per core. By default,
+     * the query runs in the calling thread.
+     *
+     * @since 5.63
+     */
+    void setThreadCount(int count);
+    int threadCount() const;
+
     ResultIterator exec();
 
+    /**
+     * Runs the query and describes the plan used for it, one step per
+     * line, with the number of documents each step was estimated to
+     * match and the number it actually produced. Meant for debugging
+     * slow queries.
+     *
+     * @since 5.63
+     */
+    QString explain();
+
     QByteArray toJSON();
     static Query fromJSON(const QByteArray& arr);
 
@@ -0,0 +1,169 @@
+/*
+ * This file is part of the KDE Baloo Project
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "querycache.h"
+#include "term.h"
+
+#include <QGlobalStatic>
+#include <QStringList>
+
+#include <algorithm>
+
+using namespace Baloo;
+
+namespace {
+// About 8 MiB of ids
+const int defaultMaxIds = 1 << 20;
+
+void collectKeys(const Term& term, QStringList& keys)
+{
+    const QList<Term> subTerms = term.subTerms();
+    for (const Term& t : subTerms) {
+        // (a AND b) AND c is the same as a AND b AND c
+        if (t.operation() == term.operation() && !t.isNegated()) {
+            collectKeys(t, keys);
+        } else {
+            keys << QueryCache::key(t);
+        }
+    }
+}
+
+QString quoted(const QString& str)
+{
+    return QString::number(str.size()) + QLatin1Char(':') + str;
+}
+}
+
+Q_GLOBAL_STATIC(QueryCache, s_queryCache)
+
+QueryCache::QueryCache()
+    : m_cache(defaultMaxIds)
+{
+}
+
+QueryCache* QueryCache::instance()
+{
+    return s_queryCache;
+}
+
+QString QueryCache::key(const Term& term)
+{
+    const QString negation = term.isNegated() ? QStringLiteral("!") : QString();
+
+    if (term.operation() == Term::And || term.operation() == Term::Or) {
+        QStringList keys;
+        collectKeys(term, keys);
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+        if (keys.size() == 1) {
+            return negation + keys.first();
+        }
+
+        const QLatin1Char op(term.operation() == Term::And ? '&' : '|');
+        return negation + op + QLatin1Char('(') + keys.join(QLatin1Char(',')) + QLatin1Char(')');
+    }
+
+    const QVariant value = term.value();
+    return negation + quoted(term.property().toLower())
+           + QString::number(static_cast<int>(term.comparator()))
+           + quoted(QString::fromLatin1(value.typeName()))
+           + quoted(value.toString());
+}
+
+bool QueryCache::Dependencies::changedBy(const QVector<QByteArray>& changedTerms, bool documentsChanged) const
+{
+    if (documents && documentsChanged) {
+        return true;
+    }
+
+    for (const QByteArray& term : changedTerms) {
+        if (std::binary_search(terms.cbegin(), terms.cend(), term)) {
+            return true;
+        }
+    }
+
+    // The first changed term which is not before the prefix is the only
+    // one to check
+    for (const QByteArray& prefix : prefixes) {
+        auto it = std::lower_bound(changedTerms.cbegin(), changedTerms.cend(), prefix);
+        if (it != changedTerms.cend() && it->startsWith(prefix)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool QueryCache::lookup(const QString& key, quint64 txnId, const ChangesSince& changesSince, QVector<quint64>* ids)
+{
+    QMutexLocker locker(&m_mutex);
+
+    Entry* entry = m_cache.object(key);
+    if (!entry) {
+        return false;
+    }
+
+    // Stored by a query which read a newer snapshot
+    if (entry->txnId > txnId) {
+        return false;
+    }
+
+    if (entry->txnId < txnId) {
+        QVector<QByteArray> terms;
+        bool documents = false;
+        if (!changesSince || !changesSince(entry->txnId, &terms, &documents)
+            || entry->dependencies.changedBy(terms, documents)) {
+            m_cache.remove(key);
+            return false;
+        }
+        // Nothing the query read has changed, so the next lookups only
+        // have to check what is committed from now on
+        entry->txnId = txnId;
+    }
+
+    *ids = entry->ids;
+    return true;
+}
+
+void QueryCache::insert(const QString& key, quint64 txnId, const Dependencies& dependencies, const QVector<quint64>& ids)
+{
+    QMutexLocker locker(&m_mutex);
+    m_cache.insert(key, new Entry{txnId, dependencies, ids}, qMax(ids.size(), 1));
+}
+
+void QueryCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_cache.clear();
+}
+
+int QueryCache::maxIds() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_cache.maxCost();
+}
+
+void QueryCache::setMaxIds(int maxIds)
+{
+    QMutexLocker locker(&m_mutex);
+    m_cache.setMaxCost(maxIds);
+}
@@ -0,0 +1,112 @@
+/*
+ * This file is part of the KDE Baloo Project
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BALOO_QUERYCACHE_H
+#define BALOO_QUERYCACHE_H
+
+#include <QCache>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+#include <functional>
+
+namespace Baloo {
+
+class Term;
+
+/**
+ * A process-local cache of the documents matched by recently run queries.
+ *
+ * The results are stored along with the id of the last transaction which
+ * had been committed to the database when the query ran, and with what
+ * the query read. When transactions have been committed since, what they
+ * changed is looked up in the ChangeLogDB, and the results are only
+ * dropped if it is something the query read.
+ */
+class QueryCache
+{
+public:
+    QueryCache();
+
+    static QueryCache* instance();
+
+    /**
+     * A string which is the same for equivalent terms, whatever the order
+     * and nesting of their subterms
+     */
+    static QString key(const Term& term);
+
+    /**
+     * What the results of a query depend on
+     */
+    struct Dependencies {
+        // Sorted
+        QVector<QByteArray> terms;
+        // Every term starting with one of them
+        QVector<QByteArray> prefixes;
+        // Which documents there are, their urls and their mtimes
+        bool documents = false;
+
+        /**
+         * Whether changes to the sorted \p changedTerms, and to the
+         * documents if \p documentsChanged, can change the results
+         */
+        bool changedBy(const QVector<QByteArray>& changedTerms, bool documentsChanged) const;
+    };
+
+    /**
+     * Lists the sorted terms changed by the transactions committed after
+     * \p txnId and whether the documents changed, see Transaction::changesSince.
+     * Returns false when that is not known.
+     */
+    typedef std::function<bool(quint64 txnId, QVector<QByteArray>* terms, bool* documents)> ChangesSince;
+
+    /**
+     * Fills \p ids with the sorted ids matched by the query \p key, if they
+     * are still valid for the transaction \p txnId. Results stored for an
+     * older transaction are checked against \p changesSince.
+     */
+    bool lookup(const QString& key, quint64 txnId, const ChangesSince& changesSince, QVector<quint64>* ids);
+    void insert(const QString& key, quint64 txnId, const Dependencies& dependencies, const QVector<quint64>& ids);
+    void clear();
+
+    /**
+     * The number of ids kept, summed over all the queries
+     */
+    int maxIds() const;
+    void setMaxIds(int maxIds);
+
+private:
+    struct Entry {
+        quint64 txnId;
+        Dependencies dependencies;
+        QVector<quint64> ids;
+    };
+
+    mutable QMutex m_mutex;
+    QCache<QString, Entry> m_cache;
+};
+
+}
+
+#endif // BALOO_QUERYCACHE_H
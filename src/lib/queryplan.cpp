@@ -0,0 +1,140 @@
+/*
+ * This file is part of the KDE Baloo Project
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "queryplan.h"
+#include "postingiterator.h"
+
+using namespace Baloo;
+
+namespace {
+// Counts the distinct ids handed out by another iterator
+class CountingPostingIterator : public PostingIterator
+{
+public:
+    CountingPostingIterator(PostingIterator* it, qint64* count)
+        : m_it(it)
+        , m_count(count)
+        , m_last(0)
+    {
+    }
+
+    ~CountingPostingIterator() override {
+        delete m_it;
+    }
+
+    quint64 next() override {
+        return counted(m_it->next());
+    }
+
+    quint64 docId() const override {
+        return m_it->docId();
+    }
+
+    quint64 skipTo(quint64 docId) override {
+        return counted(m_it->skipTo(docId));
+    }
+
+    quint64 cost() const override {
+        return m_it->cost();
+    }
+
+private:
+    quint64 counted(quint64 id) {
+        if (id && id != m_last) {
+            (*m_count)++;
+            m_last = id;
+        }
+        return id;
+    }
+
+    PostingIterator* m_it;
+    qint64* m_count;
+    quint64 m_last;
+};
+}
+
+QueryPlan::QueryPlan(const QString& description, quint64 estimate)
+    : m_description(description)
+    , m_estimate(estimate)
+    , m_actual(-1)
+{
+}
+
+QueryPlan::~QueryPlan()
+{
+    qDeleteAll(m_children);
+}
+
+QString QueryPlan::description() const
+{
+    return m_description;
+}
+
+quint64 QueryPlan::estimate() const
+{
+    return m_estimate;
+}
+
+qint64 QueryPlan::actual() const
+{
+    return m_actual;
+}
+
+QueryPlan* QueryPlan::addChild(const QString& description, quint64 estimate)
+{
+    QueryPlan* child = new QueryPlan(description, estimate);
+    m_children << child;
+    return child;
+}
+
+QVector<QueryPlan*> QueryPlan::children() const
+{
+    return m_children;
+}
+
+PostingIterator* QueryPlan::count(PostingIterator* it)
+{
+    m_actual = 0;
+    if (!it) {
+        return nullptr;
+    }
+    return new CountingPostingIterator(it, &m_actual);
+}
+
+QString QueryPlan::toString() const
+{
+    QString out;
+    print(out, 0);
+    return out;
+}
+
+void QueryPlan::print(QString& out, int depth) const
+{
+    out += QString(depth * 2, QLatin1Char(' ')) + m_description;
+    out += QStringLiteral(" (estimated: %1, actual: %2)\n")
+               .arg(m_estimate)
+               .arg(m_actual < 0 ? QStringLiteral("not run") : QString::number(m_actual));
+
+    for (const QueryPlan* child : m_children) {
+        child->print(out, depth + 1);
+    }
+}
@@ -0,0 +1,81 @@
+/*
+ * This file is part of the KDE Baloo Project
+ * Copyright (C) 2019  Baloo Developers <kde-devel@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BALOO_QUERYPLAN_H
+#define BALOO_QUERYPLAN_H
+
+#include <QString>
+#include <QVector>
+
+namespace Baloo {
+
+class PostingIterator;
+
+/**
+ * A step of the plan chosen to run a query, with the number of documents
+ * it was estimated to match and, once the query has run, the number of
+ * documents it actually produced.
+ */
+class QueryPlan
+{
+public:
+    QueryPlan(const QString& description, quint64 estimate);
+    ~QueryPlan();
+
+    QString description() const;
+    quint64 estimate() const;
+
+    /**
+     * The number of documents produced by the iterator given to count(),
+     * or -1 if this step has not been run
+     */
+    qint64 actual() const;
+
+    /**
+     * Adds a step below this one. The plan keeps ownership of it.
+     */
+    QueryPlan* addChild(const QString& description, quint64 estimate);
+    QVector<QueryPlan*> children() const;
+
+    /**
+     * Wraps \p it so that the documents it produces are counted as the
+     * actual number of this step. The plan has to outlive the iterator.
+     */
+    PostingIterator* count(PostingIterator* it);
+
+    /**
+     * The plan as an indented tree, one step per line
+     */
+    QString toString() const;
+
+private:
+    void print(QString& out, int depth) const;
+
+    QString m_description;
+    quint64 m_estimate;
+    qint64 m_actual;
+    QVector<QueryPlan*> m_children;
+};
+
+}
+
+#endif // BALOO_QUERYPLAN_H
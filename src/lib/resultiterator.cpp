@@ -23,6 +23,8 @@
 #include "resultiterator.h"
 #include "searchstore.h"
 
+#include <QStringList>
+
 
 using namespace Baloo;
 
@@ -34,22 +36,47 @@ public:
     ~ResultIteratorPrivate() {
     }
 
+    /*
+     * Fetches all the remaining results from the store, the current one
+     * included, so that they can be shared with a copy
+     */
+    void fetchAll() {
+        if (!store) {
+            return;
+        }
+
+        const QString current = store->filePath();
+        if (!current.isEmpty()) {
+            results << current;
+        }
+        while (store->next()) {
+            results << store->filePath();
+        }
+        pos = current.isEmpty() ? -1 : 0;
+        store.reset();
+    }
+
+    // Resolves the results one at a time
+    QScopedPointer<SearchStore> store;
+
     QStringList results;
     int pos;
 };
 
-ResultIterator::ResultIterator(const QStringList& results)
+ResultIterator::ResultIterator(SearchStore* store)
     : d(new ResultIteratorPrivate)
 {
-    d->results = results;
-    d->pos = -1;
+    d->store.reset(store);
 }
 
 // TODO Remove for KF6
 ResultIterator::ResultIterator(const ResultIterator& rhs)
     : d(new ResultIteratorPrivate)
 {
+    // A running query cannot be shared
+    rhs.d->fetchAll();
     d->results = rhs.d->results;
+    d->pos = rhs.d->pos;
 }
 
 
@@ -66,12 +93,20 @@ ResultIterator::~ResultIterator()
 
 bool ResultIterator::next()
 {
+    if (d->store) {
+        return d->store->next();
+    }
+
     d->pos++;
     return d->pos < d->results.size();
 }
 
 QString ResultIterator::filePath() const
 {
+    if (d->store) {
+        return d->store->filePath();
+    }
+
     Q_ASSERT(d->pos >= 0 && d->pos < d->results.size());
     return d->results.at(d->pos);
 }
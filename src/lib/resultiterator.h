@@ -51,7 +51,7 @@ public:
     QString filePath() const;
 
 private:
-    ResultIterator(const QStringList& results);
+    ResultIterator(SearchStore* store);
     ResultIteratorPrivate* d;
 
     friend class Query;
@@ -30,24 +30,194 @@
 #include "queryparser.h"
 #include "termgenerator.h"
 #include "andpostingiterator.h"
+#include "andnotpostingiterator.h"
 #include "orpostingiterator.h"
+#include "filterpostingiterator.h"
+#include "rangepostingiterator.h"
+#include "vectorpostingiterator.h"
+#include "overlayindex.h"
 #include "idutils.h"
+#include "querycache.h"
+#include "queryplan.h"
 
 #include <QStandardPaths>
 #include <QFile>
 #include <QFileInfo>
+#include <QSet>
+#include <QDebug>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
 
 #include <KFileMetaData/PropertyInfo>
 #include <KFileMetaData/TypeInfo>
 #include <KFileMetaData/Types>
 
 #include <algorithm>
+#include <limits>
 #include <tuple>
+#include <vector>
 
 using namespace Baloo;
 
+namespace {
+// Adds the documents which have been indexed, but not committed yet
+PostingIterator* unite(PostingIterator* dbIter, PostingIterator* overlayIter)
+{
+    if (!overlayIter) {
+        return dbIter;
+    }
+    if (!dbIter) {
+        return overlayIter;
+    }
+    return new OrPostingIterator({dbIter, overlayIter});
+}
+
+// The most recently modified first, and the higher id for the same
+// mtime, which is the order the MTimeDB lists them in
+bool newerThan(const std::pair<quint64, quint32>& lhs, const std::pair<quint64, quint32>& rhs)
+{
+    return lhs.second > rhs.second || (lhs.second == rhs.second && lhs.first > rhs.first);
+}
+
+// Reading the MTimeDB in order is a lot cheaper than looking up the mtime
+// of each result, so walking it pays off when the newest documents are
+// likely to contain the k results, i.e. when the query is not too selective
+const quint64 mtimeScanFactor = 4;
+
+bool preferMTimeOrder(quint64 cost, quint64 totalDocs, int k)
+{
+    if (!cost || !totalDocs) {
+        return false;
+    }
+
+    const quint64 expectedScan = static_cast<quint64>(k) * totalDocs / cost;
+    return expectedScan < cost * mtimeScanFactor;
+}
+
+// Removes the documents matched by any of \p excluded from \p include
+PostingIterator* exclude(PostingIterator* include, QVector<PostingIterator*> excluded)
+{
+    if (!include) {
+        qDeleteAll(excluded);
+        return nullptr;
+    }
+    excluded.removeAll(nullptr);
+    if (excluded.isEmpty()) {
+        return include;
+    }
+
+    PostingIterator* excludedIter = excluded.size() == 1 ? excluded.first() : new OrPostingIterator(excluded);
+    return new AndNotPostingIterator(include, excludedIter);
+}
+
+// Counts the documents produced by \p it when the query is explained
+PostingIterator* counted(QueryPlan* step, PostingIterator* it)
+{
+    return step ? step->count(it) : it;
+}
+
+// The terms and prefixes \p query reads
+void collectQueryDependencies(const EngineQuery& query, QueryCache::Dependencies* deps)
+{
+    if (!query.leaf()) {
+        const QVector<EngineQuery> subQueries = query.subQueries();
+        for (const EngineQuery& q : subQueries) {
+            collectQueryDependencies(q, deps);
+        }
+        return;
+    }
+
+    switch (query.op()) {
+    case EngineQuery::Equal:
+        deps->terms << query.term();
+        break;
+    case EngineQuery::StartsWith:
+        deps->prefixes << query.term();
+        break;
+    case EngineQuery::Fuzzy:
+        deps->prefixes << query.term().left(query.prefixSize());
+        break;
+    default:
+        Q_ASSERT(0);
+    }
+}
+
+quint64 overlayCount(PostingIterator* it)
+{
+    QScopedPointer<PostingIterator> iter(it);
+    return iter ? iter->cost() : 0;
+}
+
+// Listing a folder walks its whole subtree, so its size is only counted up
+// to a limit. Larger folders are assumed to be as large as the index.
+const quint64 folderSizeLimit = 4096;
+
+quint64 folderSize(Transaction* tr, quint64 id)
+{
+    QVector<quint64> pending = {id};
+    quint64 count = 0;
+    while (!pending.isEmpty()) {
+        if (++count > folderSizeLimit) {
+            return tr->size();
+        }
+        pending << tr->childrenDocumentId(pending.takeLast());
+    }
+    return count;
+}
+
+// Checking a folder or an mtime for each document costs a few lookups, so
+// it is only done when it spares listing a lot more documents
+const quint64 checkFactor = 4;
+
+// Below this, starting the threads costs more than going through the results
+const quint64 rangedMinCost = 10000;
+
+// Matches a query against one range of the document ids
+class RangeQuery : public QRunnable
+{
+public:
+    RangeQuery(Database* db, std::function<PostingIterator*(Transaction*)> construct, quint64 first, quint64 last)
+        : m_db(db)
+        , m_construct(construct)
+        , m_first(first)
+        , m_last(last)
+    {
+        setAutoDelete(false);
+    }
+
+    void run() override {
+        // LMDB read transactions are tied to the thread which began them
+        Transaction tr(m_db, Transaction::ReadOnly);
+        tr.setDocumentIdRange(m_first, m_last);
+        PostingIterator* it = m_construct(&tr);
+        if (!it) {
+            return;
+        }
+
+        // The mtime iterators are not cut down to the range by the Transaction
+        RangePostingIterator range(it, m_first, m_last);
+        while (const quint64 id = range.next()) {
+            m_ids << id;
+        }
+    }
+
+    QVector<quint64> ids() const {
+        return m_ids;
+    }
+
+private:
+    Database* m_db;
+    std::function<PostingIterator*(Transaction*)> m_construct;
+    quint64 m_first;
+    quint64 m_last;
+    QVector<quint64> m_ids;
+};
+}
+
 SearchStore::SearchStore()
     : m_db(nullptr)
+    , m_overlay(fileIndexDbPath())
 {
     m_db = globalDatabaseInstance();
     if (!m_db->open(Database::ReadOnlyDatabase)) {
@@ -69,73 +239,296 @@ SearchStore::~SearchStore()
 // Return the result with-in [offset, offset + limit)
 QStringList SearchStore::exec(const Term& term, uint offset, int limit, bool sortResults)
 {
-    if (!m_db || !m_db->isOpen()) {
-        return QStringList();
+    QStringList results;
+    if (!start(term, offset, limit, sortResults)) {
+        return results;
     }
 
-    Transaction tr(m_db, Transaction::ReadOnly);
-    QScopedPointer<PostingIterator> it(constructQuery(&tr, term));
-    if (!it) {
-        return QStringList();
+    while (next()) {
+        results << m_filePath;
     }
+    return results;
+}
 
-    if (sortResults) {
-        QVector<std::pair<quint64, quint32>> resultIds;
-        while (it->next()) {
-            quint64 id = it->docId();
-            quint32 mtime = tr.documentTimeInfo(id).mTime;
-            resultIds << std::pair<quint64, quint32>{id, mtime};
+bool SearchStore::start(const Term& term, uint offset, int limit, bool sortResults)
+{
+    finish();
+    if (!m_db || !m_db->isOpen()) {
+        return false;
+    }
 
-            Q_ASSERT(id > 0);
-        }
+    // Read before the transaction begins, so that its snapshot is at
+    // least as recent as what the cached results are stored for
+    const quint64 txnId = m_db->lastTxnId();
+    m_tr.reset(new Transaction(m_db, Transaction::ReadOnly));
+    m_overlay.load();
+    m_sources = DatabaseSource;
+
+    QScopedPointer<PostingIterator> it;
+    QVector<quint64> cachedIds;
+    // Only the results of the database are cached, the documents which have
+    // not been committed yet are not covered by the txn id and are merged
+    // in on every run
+    const QString cacheKey = QueryCache::key(term);
+    auto changesSince = [this](quint64 since, QVector<QByteArray>* terms, bool* documents) {
+        return m_tr->changesSince(since, terms, documents);
+    };
+    const bool cached = !cacheKey.isEmpty() && QueryCache::instance()->lookup(cacheKey, txnId, changesSince, &cachedIds);
 
-        // Not enough results within range, no need to sort.
-        if (offset >= static_cast<uint>(resultIds.size())) {
-            return QStringList();
+    // The number of results which have to be ranked
+    const int k = limit < 0 ? -1 : static_cast<int>(qMin<qint64>(qint64(offset) + limit, INT_MAX));
+
+    // Estimated from the sizes of the posting lists, so that a query which
+    // is going to be split into ranges is not also built up front
+    const quint64 cost = cached ? cachedIds.size() : estimate(m_tr.data(), term);
+    const bool walkMTimes = sortResults && k > 0 && preferMTimeOrder(cost, m_tr->size(), k);
+
+    // When all the results are going to be fetched, they are matched on
+    // several threads at once
+    const int threads = threadCount();
+    const bool ranged = threads > 1 && !cached && !walkMTimes && limit != 0
+        && (sortResults || limit < 0) && cost >= rangedMinCost;
+
+    if (cached) {
+        if (!cachedIds.isEmpty()) {
+            it.reset(new VectorPostingIterator(cachedIds));
         }
+    } else {
+        if (ranged) {
+            const QVector<quint64> ids = execInRanges(term, threads);
+            if (!ids.isEmpty()) {
+                it.reset(new VectorPostingIterator(ids));
+            }
+            m_ranged = true;
+        } else {
+            it.reset(constructQuery(m_tr.data(), term));
+        }
+        if (!cacheKey.isEmpty()) {
+            if (!it) {
+                QueryCache::instance()->insert(cacheKey, txnId, dependencies(term), QVector<quint64>());
+            } else if (m_overlay.isEmpty() || walkMTimes) {
+                // Stored once the iterator has been drained by nextId()
+                m_cacheKey = cacheKey;
+                m_cacheTxnId = txnId;
+                m_cacheDependencies = dependencies(term);
+            } else {
+                // Stored right away, what is handed out has the documents
+                // which have not been committed yet merged in
+                QVector<quint64> ids;
+                while (const quint64 id = it->next()) {
+                    ids << id;
+                }
+                QueryCache::instance()->insert(cacheKey, txnId, dependencies(term), ids);
+                it.reset(ids.isEmpty() ? nullptr : new VectorPostingIterator(ids));
+            }
+        }
+    }
+
+    QScopedPointer<PostingIterator> overlayIt(constructOverlayQuery(term));
+    if (overlayIt && !walkMTimes) {
+        // The committed versions of those documents are outdated
+        it.reset(unite(exclude(it.take(), {m_overlay.mTimeIter(0, MTimeDB::GreaterEqual)}), overlayIt.take()));
+    }
+
+    if ((!it && !overlayIt) || limit == 0) {
+        finish();
+        return false;
+    }
 
-        auto compFunc = [](const std::pair<quint64, quint32>& lhs,
-                           const std::pair<quint64, quint32>& rhs) {
-            return lhs.second > rhs.second;
-        };
+    m_remaining = limit < 0 ? UINT_MAX : limit;
 
-        std::sort(resultIds.begin(), resultIds.end(), compFunc);
-        if (limit < 0) {
-            limit = resultIds.size();
+    if (!sortResults) {
+        // Skipped lazily by the first call to next()
+        m_skip = offset;
+        m_iter.reset(it.take());
+        return true;
+    }
+
+    if (walkMTimes) {
+        // Does not go through all the results
+        m_cacheKey.clear();
+        m_sortedIds = newestMatches(m_tr.data(), term, it.take(), overlayIt.take(), k);
+    } else {
+        m_sortedIds = sortByMTime(m_tr.data(), it.data(), k);
+    }
+    m_sortedPos = static_cast<int>(qMin<uint>(offset, m_sortedIds.size())) - 1;
+    m_sorted = true;
+    return true;
+}
+
+bool SearchStore::next()
+{
+    m_filePath.clear();
+    if (!m_tr || !m_remaining) {
+        finish();
+        return false;
+    }
+
+    while (m_filePath.isEmpty()) {
+        quint64 id = 0;
+        if (m_sorted) {
+            if (++m_sortedPos < m_sortedIds.size()) {
+                id = m_sortedIds[m_sortedPos];
+            }
+        } else {
+            while (m_skip && nextId(m_iter.data())) {
+                m_skip--;
+            }
+            m_skip = 0;
+            id = nextId(m_iter.data());
         }
 
-        QStringList results;
-        const uint end = qMin(static_cast<uint>(resultIds.size()), offset + static_cast<uint>(limit));
-        results.reserve(end - offset);
-        for (uint i = offset; i < end; i++) {
-            const quint64 id = resultIds[i].first;
-            const QString filePath = tr.documentUrl(id);
+        if (!id) {
+            finish();
+            return false;
+        }
 
-            results << filePath;
+        if (m_overlay.contains(id)) {
+            m_filePath = QFile::decodeName(m_overlay.documentUrl(id));
+        } else {
+            m_filePath = m_tr->documentUrl(id);
         }
+        // The threads of a ranged query read their own snapshots, which
+        // can have a document removed or added since this one was taken
+        Q_ASSERT(m_ranged || !m_filePath.isEmpty());
+    }
 
-        return results;
+    m_remaining--;
+    return true;
+}
+
+QString SearchStore::filePath() const
+{
+    return m_filePath;
+}
+
+void SearchStore::setThreadCount(int count)
+{
+    m_threadCount = qMax(count, 0);
+}
+
+int SearchStore::threadCount() const
+{
+    return m_threadCount ? m_threadCount : QThread::idealThreadCount();
+}
+
+QVector<quint64> SearchStore::execInRanges(const Term& term, int rangeCount)
+{
+    QVector<quint64> starts = m_tr->documentIdRangeStarts(rangeCount);
+    if (starts.isEmpty()) {
+        starts << 1;
     }
-    else {
-        QStringList results;
-        uint ulimit = limit < 0 ? UINT_MAX : limit;
+    starts[0] = 1;
 
-        while (offset && it->next()) {
-            offset--;
-        }
+    // Only the database is queried. Reads the prefixes, which are not
+    // changed while the query runs.
+    Q_ASSERT(m_sources == DatabaseSource);
+    auto construct = [this, &term](Transaction* tr) {
+        return constructQuery(tr, term);
+    };
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(starts.size());
+
+    QVector<RangeQuery*> queries;
+    queries.reserve(starts.size());
+    for (int i = 0; i < starts.size(); i++) {
+        const quint64 last = i + 1 < starts.size() ? starts[i + 1] - 1 : std::numeric_limits<quint64>::max();
+        RangeQuery* query = new RangeQuery(m_db, construct, starts[i], last);
+        queries << query;
+        pool.start(query);
+    }
+    pool.waitForDone();
+
+    QVector<quint64> ids;
+    for (const RangeQuery* query : qAsConst(queries)) {
+        ids << query->ids();
+    }
+    qDeleteAll(queries);
+    return ids;
+}
+
+QString SearchStore::explain(const Term& term, uint offset, int limit, bool sortResults)
+{
+    finish();
+    if (!m_db || !m_db->isOpen()) {
+        return QString();
+    }
 
-        while (ulimit && it->next()) {
-            quint64 id = it->docId();
-            Q_ASSERT(id > 0);
+    Transaction tr(m_db, Transaction::ReadOnly);
+    m_overlay.load();
 
-            results << tr.documentUrl(it->docId());
-            Q_ASSERT(!results.last().isEmpty());
+    // Always planned and run, the QueryCache is not looked up
+    const quint64 cost = estimate(&tr, term);
+    QueryPlan plan(QStringLiteral("results"), cost);
+    QScopedPointer<PostingIterator> it(plan.count(constructQuery(&tr, term, &plan)));
+
+    const int k = limit < 0 ? -1 : static_cast<int>(qMin<qint64>(qint64(offset) + limit, INT_MAX));
+    QString order;
+    if (!sortResults) {
+        order = QStringLiteral("unsorted");
+    } else if (k < 0) {
+        order = QStringLiteral("all results sorted by mtime");
+    } else if (it && preferMTimeOrder(cost, tr.size(), k)) {
+        order = QStringLiteral("newest %1 found by walking the mtimes").arg(k);
+    } else {
+        order = QStringLiteral("newest %1 kept while going through the results").arg(k);
+    }
 
-            ulimit--;
+    if (it) {
+        while (it->next()) {
         }
+    }
+    it.reset();
 
-        return results;
+    return plan.toString() + QStringLiteral("order: ") + order + QLatin1Char('\n');
+}
+
+void SearchStore::finish()
+{
+    m_iter.reset();
+    m_tr.reset();
+    m_sortedIds.clear();
+    m_sortedPos = -1;
+    m_sorted = false;
+    m_skip = 0;
+    m_remaining = 0;
+    m_ranged = false;
+    m_sources = AllSources;
+    m_cacheKey.clear();
+    m_cacheDependencies = QueryCache::Dependencies();
+    m_collectedIds.clear();
+}
+
+PostingIterator* SearchStore::constructOverlayQuery(const Term& term)
+{
+    if (m_overlay.isEmpty()) {
+        return nullptr;
     }
+
+    const int sources = m_sources;
+    m_sources = OverlaySource;
+    PostingIterator* it = constructQuery(m_tr.data(), term);
+    m_sources = sources;
+    return it;
+}
+
+quint64 SearchStore::nextId(PostingIterator* it)
+{
+    const quint64 id = it->next();
+    if (m_cacheKey.isEmpty()) {
+        return id;
+    }
+
+    if (id) {
+        m_collectedIds << id;
+    } else {
+        QueryCache::instance()->insert(m_cacheKey, m_cacheTxnId, m_cacheDependencies, m_collectedIds);
+        m_cacheKey.clear();
+        m_cacheDependencies = QueryCache::Dependencies();
+        m_collectedIds.clear();
+    }
+    return id;
 }
 
 QByteArray SearchStore::fetchPrefix(const QByteArray& property) const
@@ -156,41 +549,248 @@ QByteArray SearchStore::fetchPrefix(const QByteArray& property) const
 
 }
 
-PostingIterator* SearchStore::constructQuery(Transaction* tr, const Term& term)
+PostingIterator* SearchStore::constructQuery(Transaction* tr, const Term& term, QueryPlan* plan)
 {
     Q_ASSERT(tr);
 
-    if (term.operation() == Term::And || term.operation() == Term::Or) {
+    if (term.isNegated()) {
+        Term positive(term);
+        positive.setNegation(false);
+
+        QueryPlan* step = plan ? plan->addChild(QStringLiteral("NOT"), estimate(tr, term)) : nullptr;
+        PostingIterator* all = constructAllDocumentsQuery(tr, step);
+        return counted(step, exclude(all, {constructQuery(tr, positive, step)}));
+    }
+
+    if (term.operation() == Term::And) {
+        return constructAndQuery(tr, term, plan);
+    }
+
+    if (term.operation() == Term::Or) {
+        QueryPlan* step = plan ? plan->addChild(QStringLiteral("OR"), estimate(tr, term)) : nullptr;
+
         const QList<Term> subTerms = term.subTerms();
         QVector<PostingIterator*> vec;
         vec.reserve(subTerms.size());
-
         for (const Term& t : subTerms) {
-            auto iterator = constructQuery(tr, t);
             // constructQuery returns a nullptr to signal an empty list
-            if (iterator) {
+            if (auto iterator = constructQuery(tr, t, step)) {
                 vec << iterator;
-            } else if (term.operation() == Term::And) {
-                return nullptr;
             }
         }
 
         if (vec.isEmpty()) {
-            return nullptr;
+            return counted(step, nullptr);
         } else if (vec.size() == 1) {
-            return vec.takeFirst();
+            return counted(step, vec.takeFirst());
+        }
+        return counted(step, new OrPostingIterator(vec));
+    }
+
+    return constructLeafQuery(tr, leafAccess(term), plan);
+}
+
+PostingIterator* SearchStore::constructAndQuery(Transaction* tr, const Term& term, QueryPlan* plan)
+{
+    struct Part {
+        Term term;
+        Access access;
+        quint64 estimate = 0;
+        bool check = false;
+    };
+
+    const QList<Term> subTerms = term.subTerms();
+    QVector<Part> parts;
+    parts.reserve(subTerms.size());
+
+    // The negated parts are subtracted from the rest in one pass,
+    // instead of each being inverted against all the documents
+    QList<Term> excludedTerms;
+
+    for (const Term& t : subTerms) {
+        if (t.isNegated()) {
+            Term positive(t);
+            positive.setNegation(false);
+            excludedTerms << positive;
+            continue;
         }
 
-        if (term.operation() == Term::And) {
-            return new AndPostingIterator(vec);
+        Part part;
+        part.term = t;
+        if (t.operation() == Term::None) {
+            part.access = leafAccess(t);
+            part.estimate = estimate(tr, part.access);
         } else {
-            return new OrPostingIterator(vec);
+            part.estimate = estimate(tr, t);
         }
+        parts << part;
     }
 
-    if (term.value().isNull()) {
+    if (parts.isEmpty() && excludedTerms.isEmpty()) {
         return nullptr;
     }
+
+    // The rarest parts are looked up first, so that an empty one
+    // spares looking up the others
+    std::stable_sort(parts.begin(), parts.end(), [](const Part& lhs, const Part& rhs) {
+        return lhs.estimate < rhs.estimate;
+    });
+
+    auto checkable = [](const Part& part) {
+        return part.term.operation() == Term::None
+            && (part.access.kind == Access::Folder || part.access.kind == Access::MTime);
+    };
+
+    quint64 driverEstimate = 0;
+    bool hasDriver = false;
+    for (const Part& part : qAsConst(parts)) {
+        if (!checkable(part) && (!hasDriver || part.estimate < driverEstimate)) {
+            driverEstimate = part.estimate;
+            hasDriver = true;
+        }
+    }
+    if (hasDriver) {
+        for (Part& part : parts) {
+            part.check = checkable(part) && driverEstimate * checkFactor < part.estimate;
+        }
+    }
+
+    const quint64 andEstimate = parts.isEmpty() ? tr->size() : parts.first().estimate;
+    QueryPlan* step = plan ? plan->addChild(QStringLiteral("AND"), andEstimate) : nullptr;
+
+    QVector<PostingIterator*> vec;
+    vec.reserve(parts.size());
+    for (int i = 0; i < parts.size(); i++) {
+        const Part& part = parts[i];
+        if (part.check) {
+            continue;
+        }
+
+        PostingIterator* iterator = part.term.operation() == Term::None
+            ? constructLeafQuery(tr, part.access, step)
+            : constructQuery(tr, part.term, step);
+        if (!iterator) {
+            qDeleteAll(vec);
+            if (step) {
+                // Nothing can match, the remaining parts are not looked up
+                for (int j = i + 1; j < parts.size(); j++) {
+                    const Part& skipped = parts[j];
+                    const QString description = skipped.term.operation() == Term::None
+                        ? describe(skipped.access) : QStringLiteral("subquery");
+                    step->addChild(description, skipped.estimate);
+                }
+            }
+            return counted(step, nullptr);
+        }
+        vec << iterator;
+    }
+
+    PostingIterator* include = nullptr;
+    if (vec.isEmpty()) {
+        include = constructAllDocumentsQuery(tr, step);
+    } else if (vec.size() == 1) {
+        include = vec.first();
+    } else {
+        include = new AndPostingIterator(vec);
+    }
+
+    for (const Part& part : qAsConst(parts)) {
+        if (!part.check) {
+            continue;
+        }
+        QueryPlan* checkStep = step ? step->addChild(describe(part.access) + QStringLiteral(", checked per document"), part.estimate) : nullptr;
+        const Access access = part.access;
+        include = counted(checkStep, new FilterPostingIterator(include, [this, tr, access](quint64 id) {
+            return matches(tr, access, id);
+        }));
+    }
+
+    if (!excludedTerms.isEmpty()) {
+        QueryPlan* excludedStep = nullptr;
+        if (step) {
+            quint64 excludedEstimate = 0;
+            for (const Term& t : qAsConst(excludedTerms)) {
+                excludedEstimate += estimate(tr, t);
+            }
+            excludedStep = step->addChild(QStringLiteral("excluding"), excludedEstimate);
+        }
+
+        QVector<PostingIterator*> excluded;
+        for (const Term& t : qAsConst(excludedTerms)) {
+            excluded << constructQuery(tr, t, excludedStep);
+        }
+        include = exclude(include, excluded);
+    }
+
+    return counted(step, include);
+}
+
+PostingIterator* SearchStore::constructLeafQuery(Transaction* tr, const Access& access, QueryPlan* plan)
+{
+    QueryPlan* step = plan ? plan->addChild(describe(access), estimate(tr, access)) : nullptr;
+    return counted(step, fetch(tr, access));
+}
+
+QueryCache::Dependencies SearchStore::dependencies(const Term& term)
+{
+    QueryCache::Dependencies deps;
+    collectDependencies(term, &deps);
+
+    std::sort(deps.terms.begin(), deps.terms.end());
+    deps.terms.erase(std::unique(deps.terms.begin(), deps.terms.end()), deps.terms.end());
+    return deps;
+}
+
+void SearchStore::collectDependencies(const Term& term, QueryCache::Dependencies* deps)
+{
+    // Inverted against all the documents
+    if (term.isNegated()) {
+        deps->documents = true;
+    }
+
+    if (term.operation() == Term::And || term.operation() == Term::Or) {
+        const QList<Term> subTerms = term.subTerms();
+        bool hasPositive = false;
+        for (const Term& t : subTerms) {
+            // Only subtracted from the other parts of an AND
+            if (term.operation() == Term::And && t.isNegated()) {
+                Term positive(t);
+                positive.setNegation(false);
+                collectDependencies(positive, deps);
+            } else {
+                collectDependencies(t, deps);
+                hasPositive = true;
+            }
+        }
+        if (!hasPositive) {
+            deps->documents = true;
+        }
+        return;
+    }
+
+    const Access access = leafAccess(term);
+    switch (access.kind) {
+    case Access::Empty:
+        break;
+    case Access::Index:
+        collectQueryDependencies(access.query, deps);
+        break;
+    case Access::Comparison:
+        deps->prefixes << access.prefix;
+        break;
+    case Access::Folder:
+    case Access::MTime:
+        deps->documents = true;
+        break;
+    }
+}
+
+SearchStore::Access SearchStore::leafAccess(const Term& term)
+{
+    Access access;
+    if (term.value().isNull()) {
+        return access;
+    }
     Q_ASSERT(term.value().isValid());
     Q_ASSERT(term.comparator() != Term::Auto);
     Q_ASSERT(term.comparator() == Term::Contains ? term.value().type() == QVariant::String : true);
@@ -199,26 +799,30 @@ PostingIterator* SearchStore::constructQuery(Transaction* tr, const Term& term)
     const QByteArray property = term.property().toLower().toUtf8();
 
     if (property == "type" || property == "kind") {
-        EngineQuery q = constructTypeQuery(value.toString());
-        return tr->postingIterator(q);
+        access.kind = Access::Index;
+        access.query = constructTypeQuery(value.toString());
+        return access;
     }
     else if (property == "includefolder") {
         const QByteArray folder = QFile::encodeName(QFileInfo(value.toString()).canonicalFilePath());
 
         if (folder.isEmpty()) {
-            return nullptr;
+            return access;
         }
         if (!folder.startsWith('/')) {
-            return nullptr;
+            return access;
         }
 
         quint64 id = filePathToId(folder);
         if (!id) {
             qDebug() << "Folder" << value.toString() << "does not exist";
-            return nullptr;
+            return access;
         }
 
-        return tr->docUrlIter(id);
+        access.kind = Access::Folder;
+        access.folder = folder;
+        access.folderId = id;
+        return access;
     }
     else if (property == "modified" || property == "mtime") {
         if (value.type() == QVariant::ByteArray) {
@@ -244,47 +848,53 @@ PostingIterator* SearchStore::constructQuery(Transaction* tr, const Term& term)
                 endDate.setDate(endDate.year(), endDate.month(), endDate.daysInMonth());
             }
 
-            return tr->mTimeRangeIter(QDateTime(startDate).toSecsSinceEpoch(), QDateTime(endDate, QTime(23, 59, 59)).toSecsSinceEpoch());
+            access.kind = Access::MTime;
+            access.beginTime = QDateTime(startDate).toSecsSinceEpoch();
+            access.endTime = QDateTime(endDate, QTime(23, 59, 59)).toSecsSinceEpoch();
+            return access;
         }
         else if (value.type() == QVariant::Date || value.type() == QVariant::DateTime) {
             const QDateTime dt = value.toDateTime();
-            return constructMTimeQuery(tr, dt, term.comparator());
+            return mTimeAccess(dt, term.comparator());
         }
         else {
             Q_ASSERT_X(0, "SearchStore::constructQuery", "modified property must contain date/datetime values");
+            return access;
         }
     } else if (property == "tag") {
         if (term.comparator() == Term::Equal) {
             const QByteArray prefix = "TAG-";
-            EngineQuery q = EngineQuery(prefix + value.toByteArray());
-            return tr->postingIterator(q);
+            access.kind = Access::Index;
+            access.query = EngineQuery(prefix + value.toByteArray());
         } else if (term.comparator() == Term::Contains) {
             const QByteArray prefix = "TA";
-            EngineQuery q = constructEqualsQuery(prefix, value.toString());
-            return tr->postingIterator(q);
+            access.kind = Access::Index;
+            access.query = constructEqualsQuery(prefix, value.toString());
         } else {
             Q_ASSERT(0);
-            return nullptr;
         }
+        return access;
     }
 
     QByteArray prefix;
     if (!property.isEmpty()) {
         prefix = fetchPrefix(property);
         if (prefix.isEmpty()) {
-            return nullptr;
+            return access;
         }
     }
 
     auto com = term.comparator();
     if (com == Term::Contains) {
-        EngineQuery q = constructContainsQuery(prefix, value.toString());
-        return tr->postingIterator(q);
+        access.kind = Access::Index;
+        access.query = constructContainsQuery(prefix, value.toString());
+        return access;
     }
 
     if (com == Term::Equal) {
-        EngineQuery q = constructEqualsQuery(prefix, value.toString());
-        return tr->postingIterator(q);
+        access.kind = Access::Index;
+        access.query = constructEqualsQuery(prefix, value.toString());
+        return access;
     }
 
     QVariant val = term.value();
@@ -304,17 +914,191 @@ PostingIterator* SearchStore::constructQuery(Transaction* tr, const Term& term)
         }
         else {
             Q_ASSERT(0);
-            return nullptr;
+            return access;
         }
 
-        return tr->postingCompIterator(prefix, intVal, pcom);
+        access.kind = Access::Comparison;
+        access.prefix = prefix;
+        access.value = intVal;
+        access.comparator = pcom;
     } else {
         qDebug() << "Comparison must be with an integer";
     }
 
+    return access;
+}
+
+SearchStore::Access SearchStore::mTimeAccess(const QDateTime& dt, Term::Comparator com)
+{
+    Q_ASSERT(dt.isValid());
+    const quint32 timet = dt.toSecsSinceEpoch();
+    const quint32 maxTime = std::numeric_limits<quint32>::max();
+
+    Access access;
+    access.kind = Access::MTime;
+    if (com == Term::Equal) {
+        access.beginTime = timet;
+        access.endTime = QDateTime(dt.date().addDays(1)).toSecsSinceEpoch() - 1;
+    }
+    else if (com == Term::GreaterEqual) {
+        access.beginTime = timet;
+        access.endTime = maxTime;
+    } else if (com == Term::Greater) {
+        if (timet == maxTime) {
+            return Access();
+        }
+        access.beginTime = timet + 1;
+        access.endTime = maxTime;
+    } else if (com == Term::LessEqual) {
+        access.beginTime = 0;
+        access.endTime = timet;
+    } else if (com == Term::Less) {
+        if (!timet) {
+            return Access();
+        }
+        access.beginTime = 0;
+        access.endTime = timet - 1;
+    } else {
+        Q_ASSERT_X(0, "SearchStore::constructQuery", "mtime query must contain a valid comparator");
+        return Access();
+    }
+
+    return access;
+}
+
+PostingIterator* SearchStore::fetch(Transaction* tr, const Access& access)
+{
+    const bool database = m_sources & DatabaseSource;
+    const bool overlay = m_sources & OverlaySource;
+
+    switch (access.kind) {
+    case Access::Empty:
+        return nullptr;
+    case Access::Index:
+        return unite(database ? tr->postingIterator(access.query) : nullptr,
+                     overlay ? m_overlay.postingIterator(access.query) : nullptr);
+    case Access::Comparison:
+        return unite(database ? tr->postingCompIterator(access.prefix, access.value, access.comparator) : nullptr,
+                     overlay ? m_overlay.postingCompIterator(access.prefix, access.value, access.comparator) : nullptr);
+    case Access::Folder:
+        return unite(database ? tr->docUrlIter(access.folderId) : nullptr,
+                     overlay ? m_overlay.folderIter(access.folder) : nullptr);
+    case Access::MTime:
+        return unite(database ? tr->mTimeRangeIter(access.beginTime, access.endTime) : nullptr,
+                     overlay ? m_overlay.mTimeRangeIter(access.beginTime, access.endTime) : nullptr);
+    }
     return nullptr;
 }
 
+QString SearchStore::describe(const Access& access) const
+{
+    switch (access.kind) {
+    case Access::Empty:
+        return QStringLiteral("nothing");
+    case Access::Index: {
+        QString query;
+        QDebug(&query).nospace() << access.query;
+        return QStringLiteral("index ") + query;
+    }
+    case Access::Comparison:
+        return QStringLiteral("values of %1 %2 %3")
+            .arg(QString::fromUtf8(access.prefix),
+                 access.comparator == PostingDB::GreaterEqual ? QStringLiteral(">=") : QStringLiteral("<="),
+                 QString::number(access.value));
+    case Access::Folder:
+        return QStringLiteral("folder ") + QFile::decodeName(access.folder);
+    case Access::MTime:
+        return QStringLiteral("mtime from %1 to %2").arg(access.beginTime).arg(access.endTime);
+    }
+    return QString();
+}
+
+bool SearchStore::matches(Transaction* tr, const Access& access, quint64 id)
+{
+    if (access.kind == Access::Folder) {
+        if (id == access.folderId) {
+            return true;
+        }
+        const QByteArray url = documentUrl(tr, id);
+        const QByteArray folder = access.folder.endsWith('/') ? access.folder : access.folder + '/';
+        return url.startsWith(folder);
+    }
+
+    if (access.kind == Access::MTime) {
+        const quint32 mtime = documentMTime(tr, id);
+        return mtime >= access.beginTime && mtime <= access.endTime;
+    }
+
+    Q_ASSERT_X(0, "SearchStore::matches", "only folder and mtime restrictions can be checked");
+    return false;
+}
+
+QByteArray SearchStore::documentUrl(Transaction* tr, quint64 id) const
+{
+    if (m_overlay.contains(id)) {
+        return m_overlay.documentUrl(id);
+    }
+    return tr->documentUrl(id);
+}
+
+quint32 SearchStore::documentMTime(Transaction* tr, quint64 id) const
+{
+    if (m_overlay.contains(id)) {
+        return m_overlay.documentMTime(id);
+    }
+    return tr->documentTimeInfo(id).mTime;
+}
+
+quint64 SearchStore::estimate(Transaction* tr, const Access& access)
+{
+    switch (access.kind) {
+    case Access::Empty:
+        return 0;
+    case Access::Index:
+        return tr->documentCount(access.query) + overlayCount(m_overlay.postingIterator(access.query));
+    case Access::Comparison:
+        // Not known without going through the values
+        return tr->size();
+    case Access::Folder:
+        return folderSize(tr, access.folderId) + overlayCount(m_overlay.folderIter(access.folder));
+    case Access::MTime:
+        return tr->mTimeRangeCount(access.beginTime, access.endTime)
+            + overlayCount(m_overlay.mTimeRangeIter(access.beginTime, access.endTime));
+    }
+    return 0;
+}
+
+quint64 SearchStore::estimate(Transaction* tr, const Term& term)
+{
+    const quint64 total = tr->size();
+    if (term.isNegated()) {
+        Term positive(term);
+        positive.setNegation(false);
+        return total - qMin(total, estimate(tr, positive));
+    }
+
+    const QList<Term> subTerms = term.subTerms();
+    if (term.operation() == Term::And) {
+        quint64 count = total;
+        for (const Term& t : subTerms) {
+            if (!t.isNegated()) {
+                count = qMin(count, estimate(tr, t));
+            }
+        }
+        return count;
+    }
+
+    if (term.operation() == Term::Or) {
+        quint64 count = 0;
+        for (const Term& t : subTerms) {
+            count += estimate(tr, t);
+        }
+        return qMin(count, total);
+    }
+
+    return estimate(tr, leafAccess(term));
+}
+
 EngineQuery SearchStore::constructContainsQuery(const QByteArray& prefix, const QString& value)
 {
     QueryParser parser;
@@ -364,32 +1148,131 @@ EngineQuery SearchStore::constructTypeQuery(const QString& value)
     return EngineQuery('T' + QByteArray::number(num));
 }
 
-PostingIterator* SearchStore::constructMTimeQuery(Transaction* tr, const QDateTime& dt, Term::Comparator com)
+PostingIterator* SearchStore::constructAllDocumentsQuery(Transaction* tr, QueryPlan* plan)
 {
-    Q_ASSERT(dt.isValid());
-    quint32 timet = dt.toSecsSinceEpoch();
-
-    MTimeDB::Comparator mtimeCom;
-    if (com == Term::Equal) {
-        mtimeCom = MTimeDB::Equal;
-        quint32 end = QDateTime(dt.date().addDays(1)).toSecsSinceEpoch() - 1;
+    QueryPlan* step = plan ? plan->addChild(QStringLiteral("all documents"), tr->size()) : nullptr;
+    return counted(step, unite((m_sources & DatabaseSource) ? tr->mTimeIter(0, MTimeDB::GreaterEqual) : nullptr,
+                               (m_sources & OverlaySource) ? m_overlay.mTimeIter(0, MTimeDB::GreaterEqual) : nullptr));
+}
 
-        return tr->mTimeRangeIter(timet, end);
+QVector<quint64> SearchStore::sortByMTime(Transaction* tr, PostingIterator* it, int k)
+{
+    // Keeps the k newest ones in a heap, with the oldest one on top
+    std::vector<std::pair<quint64, quint32>> resultIds;
+    while (const quint64 id = nextId(it)) {
+        const std::pair<quint64, quint32> result{id, documentMTime(tr, id)};
+        if (k < 0 || static_cast<int>(resultIds.size()) < k) {
+            resultIds.push_back(result);
+            if (k > 0) {
+                std::push_heap(resultIds.begin(), resultIds.end(), newerThan);
+            }
+        } else if (newerThan(result, resultIds.front())) {
+            std::pop_heap(resultIds.begin(), resultIds.end(), newerThan);
+            resultIds.back() = result;
+            std::push_heap(resultIds.begin(), resultIds.end(), newerThan);
+        }
     }
-    else if (com == Term::GreaterEqual) {
-        mtimeCom = MTimeDB::GreaterEqual;
-    } else if (com == Term::Greater) {
-        timet++;
-        mtimeCom = MTimeDB::GreaterEqual;
-    } else if (com == Term::LessEqual) {
-        mtimeCom = MTimeDB::LessEqual;
-    } else if (com == Term::Less) {
-        mtimeCom = MTimeDB::LessEqual;
-        timet--;
+
+    if (k < 0) {
+        std::sort(resultIds.begin(), resultIds.end(), newerThan);
     } else {
-        Q_ASSERT_X(0, "SearchStore::constructQuery", "mtime query must contain a valid comparator");
-        return nullptr;
+        std::sort_heap(resultIds.begin(), resultIds.end(), newerThan);
+    }
+
+    QVector<quint64> ids;
+    ids.reserve(resultIds.size());
+    for (const auto& result : resultIds) {
+        ids << result.first;
+    }
+    return ids;
+}
+
+QVector<quint64> SearchStore::newestMatches(Transaction* tr, const Term& term, PostingIterator* it,
+                                            PostingIterator* overlayIt, int k)
+{
+    QScopedPointer<PostingIterator> iter(it);
+
+    // Only a few documents have not been committed yet, so they are
+    // ranked with the heap and merged in as the MTimeDB is walked
+    QVector<std::pair<quint64, quint32>> overlayResults;
+    if (overlayIt) {
+        QScopedPointer<PostingIterator> overlayIter(overlayIt);
+        const QVector<quint64> ids = sortByMTime(tr, overlayIter.data(), k);
+        for (quint64 id : ids) {
+            overlayResults.append({id, documentMTime(tr, id)});
+        }
+    }
+    int overlayPos = 0;
+
+    QVector<quint64> results;
+    if (iter) {
+        const quint64 totalDocs = tr->size();
+        const quint64 expectedScan = static_cast<quint64>(k) * totalDocs / qMax<quint64>(iter->cost(), 1);
+        int batchSize = static_cast<int>(qBound<quint64>(k, 2 * expectedScan, INT_MAX / 2));
+
+        MTimeDB::Entry position;
+        while (results.size() < k) {
+            const QVector<MTimeDB::Entry> batch = tr->newestDocuments(batchSize, position);
+            if (batch.isEmpty()) {
+                break;
+            }
+            position = batch.last();
+
+            // The iterator only moves forward, so it is rebuilt for every batch
+            if (!iter) {
+                iter.reset(constructQuery(tr, term));
+                if (!iter) {
+                    break;
+                }
+            }
+
+            QVector<quint64> candidates;
+            candidates.reserve(batch.size());
+            for (const MTimeDB::Entry& entry : batch) {
+                // Outdated by the version which has not been committed yet
+                if (!m_overlay.contains(entry.docId)) {
+                    candidates << entry.docId;
+                }
+            }
+            std::sort(candidates.begin(), candidates.end());
+
+            QSet<quint64> matches;
+            for (quint64 id : qAsConst(candidates)) {
+                const quint64 docId = iter->skipTo(id);
+                if (!docId) {
+                    break;
+                }
+                if (docId == id) {
+                    matches << id;
+                }
+            }
+            iter.reset();
+
+            for (const MTimeDB::Entry& entry : batch) {
+                if (!matches.remove(entry.docId)) {
+                    continue;
+                }
+                const std::pair<quint64, quint32> result{entry.docId, entry.mtime};
+                while (results.size() < k && overlayPos < overlayResults.size()
+                       && newerThan(overlayResults[overlayPos], result)) {
+                    results << overlayResults[overlayPos++].first;
+                }
+                if (results.size() == k) {
+                    break;
+                }
+                results << entry.docId;
+                if (results.size() == k) {
+                    break;
+                }
+            }
+
+            batchSize = batchSize > INT_MAX / 2 ? INT_MAX : batchSize * 2;
+        }
+    }
+
+    while (results.size() < k && overlayPos < overlayResults.size()) {
+        results << overlayResults[overlayPos++].first;
     }
 
-    return tr->mTimeIter(timet, mtimeCom);
+    return results;
 }
@@ -26,15 +26,20 @@
 #include <QString>
 #include <QDateTime>
 #include <QHash>
+#include <QScopedPointer>
+#include <functional>
 #include "term.h"
+#include "enginequery.h"
+#include "overlayindex.h"
+#include "querycache.h"
 
 namespace Baloo {
 
 class Term;
 class Database;
 class Transaction;
-class EngineQuery;
 class PostingIterator;
+class QueryPlan;
 
 class SearchStore
 {
@@ -44,20 +49,176 @@ public:
 
     QStringList exec(const Term& term, uint offset, int limit, bool sortResults);
 
+    /**
+     * Starts running the query \p term. The results are then resolved one
+     * at a time with next(), within a read transaction which stays open
+     * until the last result has been fetched, another query is started or
+     * the SearchStore is destroyed.
+     *
+     * Returns false if there are no results.
+     */
+    bool start(const Term& term, uint offset, int limit, bool sortResults);
+    bool next();
+    QString filePath() const;
+
+    /**
+     * Runs the query \p term and describes how it was done: the steps the
+     * planner chose, with the number of documents each of them was
+     * estimated to match and the number it actually produced.
+     */
+    QString explain(const Term& term, uint offset, int limit, bool sortResults);
+
+    /**
+     * Queries which go through a lot of documents are run on up to \p count
+     * threads, each one matching a range of the document ids in its own
+     * read transaction. 0 uses one thread per core, 1 (the default) runs
+     * every query in the calling thread.
+     */
+    void setThreadCount(int count);
+    int threadCount() const;
+
 private:
     QByteArray fetchPrefix(const QByteArray& property) const;
+    void finish();
 
     Database* m_db;
     QHash<QByteArray, QByteArray> m_prefixes;
+    OverlayIndex m_overlay;
+
+    // The state of the running query
+    QScopedPointer<Transaction> m_tr;
+    QScopedPointer<PostingIterator> m_iter;
+    QVector<quint64> m_sortedIds;
+    int m_sortedPos = -1;
+    bool m_sorted = false;
+    uint m_skip = 0;
+    uint m_remaining = 0;
+    QString m_filePath;
+    bool m_ranged = false;
+    int m_threadCount = 1;
+
+    /*
+     * Where the leaves of a query are looked up. Queries are run on the
+     * database and on the documents which have not been committed yet
+     * separately, the latter replacing their committed versions, so that
+     * the results of the database can be cached.
+     */
+    enum Source {
+        DatabaseSource = 1,
+        OverlaySource = 2,
+        AllSources = DatabaseSource | OverlaySource
+    };
+    int m_sources = AllSources;
+
+    /*
+     * Runs \p term on the documents which have not been committed yet
+     */
+    PostingIterator* constructOverlayQuery(const Term& term);
+
+    /*
+     * Runs \p term separately on up to \p rangeCount ranges of the
+     * document ids, and returns the ids it matches in order
+     */
+    QVector<quint64> execInRanges(const Term& term, int rangeCount);
+
+    /*
+     * Advances \p it, collecting the ids for the QueryCache. They are
+     * stored once all of them have gone through.
+     */
+    quint64 nextId(PostingIterator* it);
+
+    QString m_cacheKey;
+    quint64 m_cacheTxnId = 0;
+    QueryCache::Dependencies m_cacheDependencies;
+    QVector<quint64> m_collectedIds;
 
-    PostingIterator* constructQuery(Transaction* tr, const Term& term);
+    /*
+     * How the documents matched by a term without subterms are looked up
+     */
+    struct Access {
+        enum Kind {
+            Empty,
+            Index,
+            Comparison,
+            Folder,
+            MTime
+        };
+        Kind kind = Empty;
+        EngineQuery query;
+        QByteArray prefix;
+        qlonglong value = 0;
+        PostingDB::Comparator comparator = PostingDB::GreaterEqual;
+        QByteArray folder;
+        quint64 folderId = 0;
+        quint32 beginTime = 0;
+        quint32 endTime = 0;
+    };
+
+    Access leafAccess(const Term& term);
+
+    /*
+     * The terms, prefixes and document data the results of \p term are
+     * read from, for checking them against later commits
+     */
+    QueryCache::Dependencies dependencies(const Term& term);
+    void collectDependencies(const Term& term, QueryCache::Dependencies* deps);
+    Access mTimeAccess(const QDateTime& dt, Term::Comparator com);
+    PostingIterator* fetch(Transaction* tr, const Access& access);
+    QString describe(const Access& access) const;
+
+    /*
+     * Folder and mtime restrictions can also be checked for each document
+     * found by the rest of the query, instead of being listed
+     */
+    bool matches(Transaction* tr, const Access& access, quint64 id);
+
+    /*
+     * The url and mtime of a document, those of the version which has
+     * not been committed yet if there is one
+     */
+    QByteArray documentUrl(Transaction* tr, quint64 id) const;
+    quint32 documentMTime(Transaction* tr, quint64 id) const;
+
+    /*
+     * The number of documents a term is expected to match, without
+     * going through the posting lists
+     */
+    quint64 estimate(Transaction* tr, const Access& access);
+    quint64 estimate(Transaction* tr, const Term& term);
+
+    /*
+     * When \p plan is given, the steps of the query are added to it
+     * and count the documents they produce
+     */
+    PostingIterator* constructQuery(Transaction* tr, const Term& term, QueryPlan* plan = nullptr);
+    PostingIterator* constructAndQuery(Transaction* tr, const Term& term, QueryPlan* plan);
+    PostingIterator* constructLeafQuery(Transaction* tr, const Access& access, QueryPlan* plan);
 
     EngineQuery constructContainsQuery(const QByteArray& prefix, const QString& value);
     EngineQuery constructEqualsQuery(const QByteArray& prefix, const QString& value);
     EngineQuery constructTypeQuery(const QString& type);
 
     PostingIterator* constructRatingQuery(Transaction* tr, int rating);
-    PostingIterator* constructMTimeQuery(Transaction* tr, const QDateTime& dt, Term::Comparator com);
+    PostingIterator* constructAllDocumentsQuery(Transaction* tr, QueryPlan* plan = nullptr);
+
+    /**
+     * Returns the ids matched by \p it, the most recently modified first.
+     * When \p k is not negative, only the k newest ones are kept.
+     */
+    QVector<quint64> sortByMTime(Transaction* tr, PostingIterator* it, int k);
+
+    /**
+     * Returns the k most recently modified documents matched by \p term,
+     * by walking the MTimeDB from the newest document down and checking
+     * the candidates against the query. Takes ownership of \p it, which
+     * has been constructed from \p term on the database.
+     *
+     * The documents which have not been committed yet are matched by
+     * \p overlayIt, which is also taken ownership of. They are ranked
+     * on their own and merged into the walk.
+     */
+    QVector<quint64> newestMatches(Transaction* tr, const Term& term, PostingIterator* it,
+                                   PostingIterator* overlayIt, int k);
 };
 
 }
@@ -118,13 +118,14 @@ Term::Term(const Term& lhs, Term::Operation op, const Term& rhs)
 {
     d->m_op = op;
 
-    if (lhs.operation() == op) {
+    // A negated group cannot be merged into its parent
+    if (lhs.operation() == op && !lhs.isNegated()) {
         d->m_subTerms << lhs.subTerms();
     } else {
         d->m_subTerms << lhs;
     }
 
-    if (rhs.operation() == op) {
+    if (rhs.operation() == op && !rhs.isNegated()) {
         d->m_subTerms << rhs.subTerms();
     } else {
         d->m_subTerms << rhs;
@@ -251,6 +252,13 @@ QVariant Term::userData(const QString& name) const
 QVariantMap Term::toVariantMap() const
 {
     QVariantMap map;
+    if (d->m_isNegated) {
+        Term positive(*this);
+        positive.setNegation(false);
+        map[QStringLiteral("$not")] = QVariant(positive.toVariantMap());
+        return map;
+    }
+
     if (d->m_op != None) {
         QVariantList variantList;
         for (const Term& term : qAsConst(d->m_subTerms)) {
@@ -325,6 +333,12 @@ Term Term::fromVariantMap(const QVariantMap& map)
     if (map.size() != 1)
         return Term();
 
+    if (map.contains(QLatin1String("$not"))) {
+        Term term = Term::fromVariantMap(map.value(QStringLiteral("$not")).toMap());
+        term.setNegation(true);
+        return term;
+    }
+
     Term term;
 
     QString andOrString;
@@ -451,6 +465,9 @@ namespace {
 
 QDebug operator <<(QDebug d, const Baloo::Term& t)
 {
+    if (t.isNegated()) {
+        d << "NOT";
+    }
     if (t.subTerms().isEmpty()) {
         d << QStringLiteral("(%1 %2 %3(%4))").arg(t.property(),
                                                   comparatorToString(t.comparator()),
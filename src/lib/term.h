@@ -64,6 +64,9 @@ public:
      * For Strings - Contains
      * For DateTime - Contains
      * For any other type - Equals
+     *
+     * With Contains, a word of \p value followed by "~" or "~2" also
+     * matches the words one or two edits away from it.
      */
     Term(const QString& property, const QVariant& value, Comparator c = Auto);
 
@@ -79,8 +82,8 @@ public:
     bool isValid() const;
 
     /**
-     * Negate this term. Negation only applies for Equal or Contains
-     * For other Comparators you must invert it yourself
+     * Negate this term, so that it matches every document the term
+     * itself does not match. This applies to groups of terms as well.
      */
     void setNegation(bool isNegated);
 
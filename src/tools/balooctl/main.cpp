@@ -30,15 +30,23 @@
 #include <QProcess>
 #include <QTextStream>
 #include <QFileInfo>
+#include <QDir>
 #include <QLocale>
 
 #include <QDBusConnection>
 #include <QDBusConnectionInterface>
+#include <QDBusArgument>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
 
 #include "global.h"
 #include "database.h"
 #include "transaction.h"
 #include "databasesize.h"
+#include "databasearchive.h"
+#include "commitstats.h"
 
 #include "indexer.h"
 #include "indexerconfig.h"
@@ -53,12 +61,50 @@
 
 using namespace Baloo;
 
+QString formatStatsValue(qint64 value, CommitStats::Unit unit, const KFormat& format)
+{
+    switch (unit) {
+    case CommitStats::Bytes:
+        return format.formatByteSize(value, 1);
+    case CommitStats::Microseconds:
+        if (value < 1000) {
+            return QString::number(value) + QStringLiteral("us");
+        } else if (value < 1000 * 1000) {
+            return QString::number(value / 1000) + QStringLiteral("ms");
+        }
+        return QString::number(value / (1000 * 1000)) + QStringLiteral("s");
+    case CommitStats::Count:
+        break;
+    }
+    return QString::number(value);
+}
+
 void start()
 {
     const QString exe = QStandardPaths::findExecutable(QStringLiteral("baloo_file"));
     QProcess::startDetached(exe);
 }
 
+bool stopIndexer(org::kde::baloo::main& mainInterface, QTextStream& out)
+{
+    mainInterface.quit();
+    out << "Stopping the File Indexer ...";
+    for (int i = 5 * 60; i; --i) {
+        QCoreApplication::processEvents();
+        if (!mainInterface.isValid()) {
+            break;
+        }
+        out << "." << flush;
+        QThread::msleep(200);
+    }
+    if (!mainInterface.isValid()) {
+        out << " - done\n";
+        return true;
+    }
+    out << " - failed to stop!\n";
+    return false;
+}
+
 int main(int argc, char* argv[])
 {
     QCoreApplication app(argc, argv);
@@ -84,6 +130,9 @@ int main(int argc, char* argv[])
     parser.addPositionalArgument(QStringLiteral("monitor"), i18n("Monitor the file indexer"));
     parser.addPositionalArgument(QStringLiteral("indexSize"), i18n("Display the disk space used by index"));
     parser.addPositionalArgument(QStringLiteral("failed"), i18n("Display files which could not be indexed"));
+    parser.addPositionalArgument(QStringLiteral("export"), i18n("Write a snapshot of the index to the specified file"));
+    parser.addPositionalArgument(QStringLiteral("import"), i18n("Replace the index with the snapshot in the specified file"));
+    parser.addPositionalArgument(QStringLiteral("stats"), i18n("Display statistics of the indexer, use 'stats commits' for the recent commits"));
 
     QString statusFormatDescription = i18nc("Format to use for status command, %1|%2|%3 are option values, %4 is a CLI command",
                                             "Output format <%1|%2|%3>.\nThe default format is \"%1\".\nOnly applies to \"%4\"",
@@ -157,23 +206,8 @@ int main(int argc, char* argv[])
     if (command == QLatin1String("purge")) {
         bool running = mainInterface.isValid();
 
-        if (running) {
-            mainInterface.quit();
-            out << "Stopping the File Indexer ...";
-            for (int i = 5 * 60; i; --i) {
-                QCoreApplication::processEvents();
-                if (!mainInterface.isValid()) {
-                    break;
-                }
-                out << "." << flush;
-                QThread::msleep(200);
-            }
-            if (!mainInterface.isValid()) {
-                out << " - done\n";
-            } else {
-                out << " - failed to stop!\n";
-                return 1;
-            }
+        if (running && !stopIndexer(mainInterface, out)) {
+            return 1;
         }
 
         const QString path = fileIndexDbPath() + QStringLiteral("/index");
@@ -333,6 +367,9 @@ int main(int argc, char* argv[])
         out << "Used:      " << format.formatByteSize(totalDataSize, 2) << "\n\n";
         prFunc(QStringLiteral("PostingDB"), size.postingDb);
         prFunc(QStringLiteral("PositionDB"), size.positionDb);
+        prFunc(QStringLiteral("PostingDeltaDB"), size.postingDeltaDb);
+        prFunc(QStringLiteral("PrefixDB"), size.prefixDb);
+        prFunc(QStringLiteral("ChangeLog"), size.changeLog);
         prFunc(QStringLiteral("DocTerms"), size.docTerms);
         prFunc(QStringLiteral("DocFilenameTerms"), size.docFilenameTerms);
         prFunc(QStringLiteral("DocXattrTerms"), size.docXattrTerms);
@@ -347,11 +384,170 @@ int main(int argc, char* argv[])
         return 0;
     }
 
+    if (command == QLatin1String("export")) {
+        if (parser.positionalArguments().size() < 2) {
+            out << "Please enter a filename to export to\n";
+            return 1;
+        }
+
+        Database *db = globalDatabaseInstance();
+        if (!db->open(Database::ReadOnlyDatabase)) {
+            out << "Baloo Index could not be opened\n";
+            return 1;
+        }
+
+        QFile file(parser.positionalArguments().at(1));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            out << "Could not open " << file.fileName() << ": " << file.errorString() << "\n";
+            return 1;
+        }
+
+        DatabaseArchive archive(db);
+        if (!archive.exportTo(&file)) {
+            out << "Export failed: " << archive.errorString() << "\n";
+            file.remove();
+            return 1;
+        }
+
+        out << "Exported the index to " << file.fileName() << "\n";
+        return 0;
+    }
+
+    if (command == QLatin1String("import")) {
+        if (parser.positionalArguments().size() < 2) {
+            out << "Please enter a filename to import from\n";
+            return 1;
+        }
+
+        QFile file(parser.positionalArguments().at(1));
+        if (!file.open(QIODevice::ReadOnly)) {
+            out << "Could not open " << file.fileName() << ": " << file.errorString() << "\n";
+            return 1;
+        }
+
+        bool running = mainInterface.isValid();
+        if (running && !stopIndexer(mainInterface, out)) {
+            return 1;
+        }
+
+        // The archive is imported next to the index, which is only
+        // replaced once the whole archive has been read and verified
+        const QString path = fileIndexDbPath() + QStringLiteral("/index");
+        const QString importDir = fileIndexDbPath() + QStringLiteral("/import");
+        QDir(importDir).removeRecursively();
+
+        QHash<quint32, quint32> deviceIdMap;
+        {
+            Database db(importDir);
+            if (!db.open(Database::CreateDatabase)) {
+                out << "Baloo Index could not be created\n";
+                QDir(importDir).removeRecursively();
+                return 1;
+            }
+
+            DatabaseArchive archive(&db);
+            if (!archive.importFrom(&file)) {
+                out << "Import failed: " << archive.errorString() << "\n";
+                QDir(importDir).removeRecursively();
+                return 1;
+            }
+            deviceIdMap = archive.deviceIdMap();
+        }
+
+        if (::rename(QFile::encodeName(importDir + QStringLiteral("/index")).constData(), QFile::encodeName(path).constData()) != 0) {
+            out << "Could not replace the index: " << QString::fromLocal8Bit(strerror(errno)) << "\n";
+            QDir(importDir).removeRecursively();
+            return 1;
+        }
+        QDir(importDir).removeRecursively();
+
+        for (auto it = deviceIdMap.cbegin(); it != deviceIdMap.cend(); ++it) {
+            out << "Moved device " << it.key() << " to " << it.value() << "\n";
+        }
+        out << "Imported the index from " << file.fileName() << "\n";
+
+        if (running) {
+            start();
+            out << "Restarting the File Indexer\n";
+        }
+
+        return 0;
+    }
+
     if (command == QLatin1String("monitor")) {
         MonitorCommand mon;
         return mon.exec(parser);
     }
 
+    if (command == QLatin1String("stats")) {
+        if (parser.positionalArguments().value(1) != QLatin1String("commits")) {
+            out << "Please specify the statistics to display: commits\n";
+            return 1;
+        }
+
+        if (!schedulerinterface.isValid()) {
+            out << "Baloo File Indexer is not running\n";
+            return 1;
+        }
+
+        QDBusPendingReply<QVariantMap> reply = schedulerinterface.getCommitStatistics();
+        reply.waitForFinished();
+        if (reply.isError()) {
+            out << "Could not fetch the statistics: " << reply.error().message() << "\n";
+            return 1;
+        }
+
+        const QVariantMap histograms = reply.value();
+        QStringList sources;
+        for (auto it = histograms.cbegin(); it != histograms.cend(); ++it) {
+            const QString source = it.key().section(QLatin1Char('/'), 0, 0);
+            if (!sources.contains(source)) {
+                sources << source;
+            }
+        }
+
+        if (sources.isEmpty()) {
+            out << "No commits have been recorded yet\n";
+            return 0;
+        }
+
+        // Every bucket is shown with the largest value it holds
+        KFormat format(QLocale::system());
+        for (const QString& source : qAsConst(sources)) {
+            auto histogram = [&](CommitStats::Metric metric) {
+                const QString key = source + QLatin1Char('/') + CommitStats::metricName(metric);
+                return qdbus_cast<QList<uint>>(histograms.value(key));
+            };
+
+            uint commits = 0;
+            const QList<uint> termCounts = histogram(CommitStats::Terms);
+            for (uint count : termCounts) {
+                commits += count;
+            }
+            out << source << " (" << commits << " commits)\n";
+
+            for (int m = 0; m < CommitStats::MetricCount; m++) {
+                const auto metric = static_cast<CommitStats::Metric>(m);
+                const QList<uint> counts = histogram(metric);
+
+                out << "  ";
+                out.setFieldWidth(22);
+                out.setFieldAlignment(QTextStream::AlignLeft);
+                out << CommitStats::metricName(metric);
+                out.setFieldWidth(0);
+                for (int i = 0; i < counts.size(); i++) {
+                    if (!counts[i]) {
+                        continue;
+                    }
+                    const qint64 upper = i ? (Q_INT64_C(1) << i) - 1 : 0;
+                    out << " <=" << formatStatsValue(upper, CommitStats::metricUnit(metric), format) << ":" << counts[i];
+                }
+                out << "\n";
+            }
+        }
+        return 0;
+    }
+
     /*
      TODO: Make separate executable
      if (command == QLatin1String("checkDb")) {
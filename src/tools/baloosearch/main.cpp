@@ -59,6 +59,11 @@ int main(int argc, char* argv[])
     parser.addOption(QCommandLineOption(QStringList() << QStringLiteral("d") << QStringLiteral("directory"),
                                         i18n("Limit search to specified directory"),
                                         i18n("directory")));
+    parser.addOption(QCommandLineOption(QStringList() << QStringLiteral("e") << QStringLiteral("explain"),
+                                        i18n("Show how the query is run, instead of the results")));
+    parser.addOption(QCommandLineOption(QStringList() << QStringLiteral("j") << QStringLiteral("jobs"),
+                                        i18n("The number of threads to match the documents on, 0 for one per core"),
+                                        i18n("jobs")));
     parser.addPositionalArgument(i18n("query"), i18n("List of words to query for"));
     parser.addHelpOption();
     parser.addVersionOption();
@@ -90,6 +95,8 @@ int main(int argc, char* argv[])
     query.setSearchString(queryStr);
     query.setLimit(queryLimit);
     query.setOffset(offset);
+    if (parser.isSet(QStringLiteral("jobs")))
+        query.setThreadCount(parser.value(QStringLiteral("jobs")).toInt());
 
     if (parser.isSet(QStringLiteral("directory"))) {
         QString folderName = parser.value(QStringLiteral("directory"));
@@ -99,6 +106,12 @@ int main(int argc, char* argv[])
     QElapsedTimer timer;
     timer.start();
 
+    if (parser.isSet(QStringLiteral("explain"))) {
+        out << query.explain();
+        err << i18n("Elapsed: %1 msecs", timer.nsecsElapsed() / 1000000.0) << endl;
+        return 0;
+    }
+
     Baloo::ResultIterator iter = query.exec();
     while (iter.next()) {
         const QString filePath = iter.filePath();